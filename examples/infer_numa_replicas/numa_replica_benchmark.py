@@ -0,0 +1,140 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+"""Inference throughput of data parallel replicas pinned to NUMA nodes.
+
+The batch is split into one replica per socket. Every op of a replica carries
+the `_numa_node` attr, as set by XPUAutoShard on CPU devices with
+`ITEX_SHARDING_CPU_NUMA=1`, so its kernels run on the threads of one socket
+and the activations and reordered weights it writes stay in local memory.
+Each socket count is measured in a new process, since the thread pools of the
+NUMA nodes are created once per process.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+
+def build_replica(input_shape, width, depth):
+    import tensorflow as tf
+    inputs = tf.keras.Input(shape=input_shape)
+    x = inputs
+    for _ in range(depth):
+        x = tf.keras.layers.Conv2D(width, 3, padding="same", use_bias=False)(x)
+        x = tf.keras.layers.BatchNormalization()(x)
+        x = tf.keras.layers.ReLU()(x)
+    x = tf.keras.layers.GlobalAveragePooling2D()(x)
+    outputs = tf.keras.layers.Dense(1000)(x)
+    return tf.keras.Model(inputs, outputs)
+
+
+def measure(args):
+    """Runs in the child process, prints the throughput as JSON."""
+    import numpy as np
+    import tensorflow as tf
+    from tensorflow.core.framework import attr_value_pb2
+
+    num_replicas = args.sockets
+    input_shape = (args.image_size, args.image_size, 3)
+    # One copy of the weights per replica, so that each socket reads its own.
+    replicas = [build_replica(input_shape, args.width, args.depth)
+                for _ in range(num_replicas)]
+    for replica in replicas[1:]:
+        replica.set_weights(replicas[0].get_weights())
+
+    @tf.function
+    def infer(images):
+        shards = tf.split(images, num_replicas)
+        outputs = []
+        for node, (replica, shard) in enumerate(zip(replicas, shards)):
+            attr = {"_numa_node": attr_value_pb2.AttrValue(i=node)}
+            # pylint: disable=protected-access
+            with tf.compat.v1.get_default_graph()._attr_scope(attr):
+                outputs.append(replica(shard, training=False))
+        return tf.concat(outputs, 0)
+
+    batch = args.batch_size_per_socket * num_replicas
+    images = tf.constant(
+        np.random.rand(batch, *input_shape).astype(np.float32))
+    for _ in range(args.warmup):
+        infer(images).numpy()
+    start = time.time()
+    for _ in range(args.steps):
+        infer(images).numpy()
+    elapsed = time.time() - start
+    print(json.dumps({"sockets": num_replicas,
+                      "batch_size": batch,
+                      "images_per_sec": batch * args.steps / elapsed}))
+
+
+def num_numa_nodes():
+    node_dir = "/sys/devices/system/node"
+    if not os.path.isdir(node_dir):
+        return 1
+    nodes = [d for d in os.listdir(node_dir)
+             if d.startswith("node") and d[4:].isdigit()]
+    return max(1, len(nodes))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--sockets", type=int, default=0,
+                        help="Measure this socket count only (internal).")
+    parser.add_argument("--max_sockets", type=int, default=num_numa_nodes())
+    parser.add_argument("--batch_size_per_socket", type=int, default=32)
+    parser.add_argument("--image_size", type=int, default=112)
+    parser.add_argument("--width", type=int, default=64)
+    parser.add_argument("--depth", type=int, default=8)
+    parser.add_argument("--warmup", type=int, default=5)
+    parser.add_argument("--steps", type=int, default=20)
+    parser.add_argument("--output", default="",
+                        help="Write the results to this JSON file.")
+    args = parser.parse_args()
+
+    if args.sockets > 0:
+        measure(args)
+        return
+
+    env = dict(os.environ)
+    # oneDNN primitives only run on the pinned threads with the Eigen thread
+    # pool, the OpenMP runtime of oneDNN is not NUMA aware.
+    env.setdefault("ITEX_OMP_THREADPOOL", "0")
+    results = []
+    for sockets in range(1, args.max_sockets + 1):
+        cmd = [sys.executable, __file__, "--sockets", str(sockets)]
+        for name in ("batch_size_per_socket", "image_size", "width", "depth",
+                     "warmup", "steps"):
+            cmd += ["--" + name, str(getattr(args, name))]
+        out = subprocess.run(cmd, env=env, check=True, stdout=subprocess.PIPE,
+                             universal_newlines=True).stdout
+        results.append(json.loads(out.strip().splitlines()[-1]))
+
+    base = results[0]["images_per_sec"]
+    print("%8s %10s %16s %8s" % ("sockets", "batch", "images/sec", "scaling"))
+    for r in results:
+        print("%8d %10d %16.1f %7.2fx" % (r["sockets"], r["batch_size"],
+                                          r["images_per_sec"],
+                                          r["images_per_sec"] / base))
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(results, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
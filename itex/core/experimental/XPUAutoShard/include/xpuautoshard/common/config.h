@@ -22,6 +22,7 @@ namespace as {
 enum StrategyKind {
   CPU_HOST,
   HEURISTIC,
+  // Batch split and stage numbers searched with the analytic cost model.
   LEARNED,
 };
 
@@ -38,6 +39,59 @@ struct HeuristicsConfig {
   int64_t batch_grain_size_;
 };
 
+/**
+ * @brief Options of the search-based tuner used by the LEARNED strategy.
+ *
+ */
+struct TunerConfig {
+  TunerConfig()
+      : time_budget_ms_(200),
+        beam_width_(4),
+        max_stages_(8),
+        batch_units_(64) {}
+
+  /**
+   * @brief Wall time allowed for the search, in milliseconds.
+   *
+   * @return int64_t
+   */
+  int64_t getTimeBudgetMs() const { return time_budget_ms_; }
+  void setTimeBudgetMs(int64_t time_budget_ms) {
+    time_budget_ms_ = time_budget_ms;
+  }
+
+  /**
+   * @brief Number of best plans kept and expanded in each search round.
+   *
+   * @return int64_t
+   */
+  int64_t getBeamWidth() const { return beam_width_; }
+  void setBeamWidth(int64_t beam_width) { beam_width_ = beam_width; }
+
+  /**
+   * @brief Upper bound of the number of stages per device.
+   *
+   * @return int64_t
+   */
+  int64_t getMaxStages() const { return max_stages_; }
+  void setMaxStages(int64_t max_stages) { max_stages_ = max_stages; }
+
+  /**
+   * @brief The global batch is split among devices in multiples of
+   * 1 / `batch_units`.
+   *
+   * @return int64_t
+   */
+  int64_t getBatchUnits() const { return batch_units_; }
+  void setBatchUnits(int64_t batch_units) { batch_units_ = batch_units; }
+
+ private:
+  int64_t time_budget_ms_;
+  int64_t beam_width_;
+  int64_t max_stages_;
+  int64_t batch_units_;
+};
+
 struct ShardingConfig {
   ShardingConfig()
       : strategy_kind_(StrategyKind::CPU_HOST),
@@ -50,6 +104,9 @@ struct ShardingConfig {
     return heuristics_config_;
   }
 
+  TunerConfig& getTunerConfig() { return tuner_config_; }
+  const TunerConfig& getTunerConfig() const { return tuner_config_; }
+
   void setStrategyKind(StrategyKind strategy_kind) {
     strategy_kind_ = strategy_kind;
   }
@@ -90,6 +147,7 @@ struct ShardingConfig {
 
  private:
   HeuristicsConfig heuristics_config_;
+  TunerConfig tuner_config_;
   StrategyKind strategy_kind_;
   bool use_nccl_comm_backend_;
   bool use_multi_stage_join_;
@@ -140,12 +140,26 @@ class Device {
 
   void setNumStages(size_t num_stages) { num_stages_ = num_stages; }
 
+  /**
+   * @brief NUMA node the device is pinned to. Only applies to CPU devices
+   * that share a host, each replica then runs on the threads and memory of
+   * one socket.
+   *
+   * @return int NUMA node or NO_NUMA_NODE if the device is not pinned.
+   */
+  int getNumaNode() const { return numa_node_; }
+
+  void setNumaNode(int numa_node) { numa_node_ = numa_node; }
+
+  static constexpr int NO_NUMA_NODE = -1;
+
  private:
   DeviceId id_;
   std::string name_;
   float score_;
   // TODO(itex): hard-code score temporarily, to be replaced with cost model.
   size_t num_stages_;
+  int numa_node_ = NO_NUMA_NODE;
   DeviceComputeCapability device_comp_cap_;
 };
 
@@ -54,7 +54,7 @@ const Device& DeviceInfo::getDevice(DeviceId id) const {
 
 bool Device::operator==(const Device& rhs) const {
   return getId() == rhs.getId() && getName() == rhs.getName() &&
-         getScore() == rhs.getScore();
+         getScore() == rhs.getScore() && getNumaNode() == rhs.getNumaNode();
 }
 
 bool Device::operator!=(const Device& rhs) const { return !(*this == rhs); }
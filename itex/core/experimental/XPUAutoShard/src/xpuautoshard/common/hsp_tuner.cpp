@@ -15,6 +15,14 @@ limitations under the License.
 
 #include "xpuautoshard/common/hsp_tuner.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include "xpuautoshard/common/analytic_cost_model.h"
+
 namespace as {
 
 HspAnnotationRef HspTuner::tune(GraphRef graph) {
@@ -35,4 +43,301 @@ HspAnnotationRef HspTuner::tune(GraphRef graph) {
   return best_annotation;
 }
 
+namespace {
+
+// Used for the devices without a configured compute capability: ballpark
+// figures of a server CPU socket and of a data center GPU tile.
+const DeviceComputeCapability kNominalCpuCapability(
+    /*float_OPS=*/2e12f, /*bfloat16_OPS=*/8e12f, /*float16_OPS=*/4e12f,
+    /*int8_OPS=*/16e12f, /*mem_bandwidth_triad=*/2e11f);
+const DeviceComputeCapability kNominalGpuCapability(
+    /*float_OPS=*/20e12f, /*bfloat16_OPS=*/200e12f, /*float16_OPS=*/200e12f,
+    /*int8_OPS=*/400e12f, /*mem_bandwidth_triad=*/1e12f);
+
+// Seconds to launch an op, paid once per stage.
+constexpr float kCpuOpLaunchTime = 2e-6f;
+constexpr float kGpuOpLaunchTime = 10e-6f;
+
+bool isCpuDevice(const Device& device) {
+  return device.isCpuHost() || device.getName().find("CPU") == 0;
+}
+
+DeviceComputeCapability getComputeCapability(const Device& device) {
+  const auto& cap = device.getComputeCapability();
+  const auto& nominal =
+      isCpuDevice(device) ? kNominalCpuCapability : kNominalGpuCapability;
+  auto pick = [](float value, float nominal_value) {
+    return value > 0 ? value : nominal_value;
+  };
+  return DeviceComputeCapability(
+      pick(cap.getFloatOPS(), nominal.getFloatOPS()),
+      pick(cap.getBfloat16OPS(), nominal.getBfloat16OPS()),
+      pick(cap.getFloat16OPS(), nominal.getFloat16OPS()),
+      pick(cap.getInt8OPS(), nominal.getInt8OPS()),
+      pick(cap.getMemBandwidthTriad(), nominal.getMemBandwidthTriad()));
+}
+
+}  // anonymous namespace
+
+DeviceInfo ShardingPlan::applyTo(const DeviceInfo& device_info) const {
+  DeviceInfo result(/*add_cpu_host=*/false);
+  for (auto device : device_info.getDevices()) {
+    for (size_t i = 0; i < devices_.size(); i++) {
+      if (devices_[i].id == device.getId()) {
+        device.setScore(getBatchRatio(i));
+        device.setNumStages(devices_[i].num_stages);
+      }
+    }
+    result.addDevice(device);
+  }
+  return result;
+}
+
+bool ShardingPlan::isMultiStage() const {
+  return std::any_of(
+      devices_.begin(), devices_.end(),
+      [](const DevicePlan& device) { return device.num_stages > 1; });
+}
+
+std::string ShardingPlan::toString() const {
+  std::stringstream ss;
+  for (size_t i = 0; i < devices_.size(); i++) {
+    if (i > 0) {
+      ss << ", ";
+    }
+    ss << devices_[i].name << ": batch " << devices_[i].batch_units << "/"
+       << total_batch_units_ << ", stages " << devices_[i].num_stages;
+  }
+  return ss.str();
+}
+
+ShardingPlanCostModel::ShardingPlanCostModel(GraphRef graph,
+                                             const DeviceInfo& device_info) {
+  AnalyticComputeCharacterizer characterizer;
+  auto&& graph_ch = characterizer.characterize(graph);
+  size_t num_ops = 0;
+  for (OpDescRef op_desc : *graph->getBreadthFirstIterRange()) {
+    (void)op_desc;
+    num_ops++;
+  }
+
+  for (auto&& device : device_info.getDevices()) {
+    AnalyticCostModel cost_model(getComputeCapability(device));
+    if (auto quan_ch =
+            downcastRef<QuantitativeComputeCharacteristics>(graph_ch)) {
+      auto&& compute_ch = makeRef<QuantitativeComputeCharacteristics>(*quan_ch);
+      compute_ch->setMemoryLoadBytes(0);
+      compute_ch->setMemoryStoreBytes(0);
+      auto&& memory_ch = makeRef<QuantitativeComputeCharacteristics>();
+      memory_ch->setMemoryLoadBytes(quan_ch->getMemoryLoadBytes());
+      memory_ch->setMemoryStoreBytes(quan_ch->getMemoryStoreBytes());
+      compute_time_.push_back(cost_model.evaluateTime(compute_ch));
+      memory_time_.push_back(cost_model.evaluateTime(memory_ch));
+      float op_launch_time =
+          isCpuDevice(device) ? kCpuOpLaunchTime : kGpuOpLaunchTime;
+      stage_overhead_.push_back(num_ops * op_launch_time);
+    } else {
+      // Shapes are unknown: only the relative speed of the devices is known,
+      // so stages don't change the estimated time.
+      compute_time_.push_back(cost_model.evaluateTime(graph_ch));
+      memory_time_.push_back(0);
+      stage_overhead_.push_back(0);
+    }
+  }
+}
+
+float ShardingPlanCostModel::getStepTime(const ShardingPlan& plan) const {
+  float step_time = 0;
+  for (size_t i = 0; i < plan.getDevices().size(); i++) {
+    float ratio = plan.getBatchRatio(i);
+    float num_stages = plan.getDevices()[i].num_stages;
+    float compute_time = ratio * compute_time_[i];
+    float memory_time = ratio * memory_time_[i];
+    float device_time = std::max(compute_time, memory_time) +
+                        std::min(compute_time, memory_time) / num_stages +
+                        num_stages * stage_overhead_[i];
+    step_time = std::max(step_time, device_time);
+  }
+  return step_time;
+}
+
+SearchHspTuner::SearchHspTuner(GraphRef graph, const DeviceInfo& device_info,
+                               const TunerConfig& tuner_config)
+    : SearchHspTuner(makeRef<ShardingPlanCostModel>(graph, device_info),
+                     device_info, tuner_config) {}
+
+SearchHspTuner::SearchHspTuner(ShardingPlanCostModelRef cost_model,
+                               const DeviceInfo& device_info,
+                               const TunerConfig& tuner_config)
+    : device_info_(device_info),
+      tuner_config_(tuner_config),
+      cost_model_(cost_model),
+      best_step_time_(std::numeric_limits<float>::max()),
+      num_evaluated_(0),
+      converged_(false) {
+  int64_t total_units = std::max<int64_t>(tuner_config_.getBatchUnits(),
+                                          device_info_.getNumDevices());
+  std::vector<ShardingPlan::DevicePlan> by_speed;
+  std::vector<ShardingPlan::DevicePlan> even;
+  std::vector<float> speeds;
+  float total_speed = 0;
+  for (auto&& device : device_info_.getDevices()) {
+    float device_time = cost_model_->getDeviceTime(speeds.size());
+    speeds.push_back(device_time > 0 ? 1 / device_time : 1);
+    total_speed += speeds.back();
+    by_speed.push_back({device.getId(), device.getName(), 1, 1});
+    even.push_back({device.getId(), device.getName(), 1, 1});
+  }
+  if (by_speed.empty()) {
+    converged_ = true;
+    return;
+  }
+
+  // Every device gets at least one unit, the fastest one gets the rest.
+  auto distribute = [&](std::vector<ShardingPlan::DevicePlan>* devices,
+                        const std::vector<float>& weights, float total_weight) {
+    int64_t assigned = 0;
+    size_t fastest = 0;
+    for (size_t i = 0; i < devices->size(); i++) {
+      (*devices)[i].batch_units = std::max<int64_t>(
+          1, std::floor(total_units * weights[i] / total_weight));
+      assigned += (*devices)[i].batch_units;
+      if (weights[i] > weights[fastest]) {
+        fastest = i;
+      }
+    }
+    (*devices)[fastest].batch_units += total_units - assigned;
+    if ((*devices)[fastest].batch_units < 1) {
+      (*devices)[fastest].batch_units = 1;
+    }
+  };
+  distribute(&by_speed, speeds, total_speed);
+  distribute(&even, std::vector<float>(even.size(), 1.0f), even.size());
+  addCandidate(makeRef<ShardingPlan>(total_units, by_speed));
+  addCandidate(makeRef<ShardingPlan>(total_units, even));
+}
+
+HspAnnotationRef SearchHspTuner::tune(GraphRef graph) {
+  auto&& best_plan = search();
+  assert(best_plan && "Expect at least one sharding plan evaluated");
+  return createAnnotator(best_plan)->annotate(graph);
+}
+
+ShardingPlanRef SearchHspTuner::search() {
+  start_time_ = std::chrono::steady_clock::now();
+  do {
+    auto&& state = nextState();
+    if (!state) {
+      break;
+    }
+    auto&& plan = downcastRef<ShardingPlan>(state);
+    updateScore(
+        makeRef<StepTimeScore, Score>(cost_model_->getStepTime(*plan)), state);
+  } while (!stopCriterionMet());
+  return best_plan_;
+}
+
+void SearchHspTuner::addCandidate(ShardingPlanRef plan) {
+  if (visited_.insert(plan->toString()).second) {
+    frontier_.push_back(plan);
+  }
+}
+
+void SearchHspTuner::expandBeam() {
+  beam_.insert(beam_.end(), round_.begin(), round_.end());
+  round_.clear();
+  std::stable_sort(beam_.begin(), beam_.end(),
+                   [](const ScoredPlan& lhs, const ScoredPlan& rhs) {
+                     return lhs.step_time < rhs.step_time;
+                   });
+  if (beam_.size() > static_cast<size_t>(tuner_config_.getBeamWidth())) {
+    beam_.resize(tuner_config_.getBeamWidth());
+  }
+  // The plans of the last round that entered the beam are expanded, plans of
+  // earlier rounds were already. Stop once none did.
+  for (auto&& scored_plan : beam_) {
+    if (scored_plan.expanded) {
+      continue;
+    }
+    scored_plan.expanded = true;
+    const auto& plan = *scored_plan.plan;
+    const auto& devices = plan.getDevices();
+    int64_t total_units = plan.getTotalBatchUnits();
+    // Move batch units from a device to another, by a single unit and by a
+    // larger step to leave plateaus quickly.
+    for (int64_t step : {int64_t(1), std::max<int64_t>(2, total_units / 8)}) {
+      for (size_t from = 0; from < devices.size(); from++) {
+        if (devices[from].batch_units - step <
+            static_cast<int64_t>(devices[from].num_stages)) {
+          continue;
+        }
+        for (size_t to = 0; to < devices.size(); to++) {
+          if (to == from) {
+            continue;
+          }
+          auto&& neighbor = makeRef<ShardingPlan>(plan);
+          neighbor->getDevices()[from].batch_units -= step;
+          neighbor->getDevices()[to].batch_units += step;
+          addCandidate(neighbor);
+        }
+      }
+    }
+    // Double or halve the stages of a device. Each stage needs at least one
+    // batch unit.
+    for (size_t i = 0; i < devices.size(); i++) {
+      size_t num_stages = devices[i].num_stages;
+      if (num_stages * 2 <= static_cast<size_t>(tuner_config_.getMaxStages()) &&
+          static_cast<int64_t>(num_stages * 2) <= devices[i].batch_units) {
+        auto&& neighbor = makeRef<ShardingPlan>(plan);
+        neighbor->getDevices()[i].num_stages = num_stages * 2;
+        addCandidate(neighbor);
+      }
+      if (num_stages > 1) {
+        auto&& neighbor = makeRef<ShardingPlan>(plan);
+        neighbor->getDevices()[i].num_stages = num_stages / 2;
+        addCandidate(neighbor);
+      }
+    }
+  }
+}
+
+TuningStateRef SearchHspTuner::nextState() {
+  if (frontier_.empty()) {
+    expandBeam();
+  }
+  if (frontier_.empty()) {
+    converged_ = true;
+    current_plan_ = nullptr;
+  } else {
+    current_plan_ = frontier_.front();
+    frontier_.pop_front();
+  }
+  return current_plan_;
+}
+
+void SearchHspTuner::updateScore(const ScoreRef& score,
+                                 TuningStateRef tuning_state) {
+  auto&& plan = downcastRef<ShardingPlan>(tuning_state ? tuning_state
+                                                       : current_plan_);
+  auto&& step_time_score = downcastRef<StepTimeScore>(score);
+  assert(plan && step_time_score &&
+         "Expect a sharding plan scored with its step time");
+  float step_time = step_time_score->getStepTime();
+  round_.push_back({step_time, plan, /*expanded=*/false});
+  num_evaluated_++;
+  if (step_time < best_step_time_) {
+    best_step_time_ = step_time;
+    best_plan_ = plan;
+  }
+}
+
+bool SearchHspTuner::stopCriterionMet() {
+  if (converged_) {
+    return true;
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start_time_);
+  return elapsed.count() >= tuner_config_.getTimeBudgetMs();
+}
+
 }  // namespace as
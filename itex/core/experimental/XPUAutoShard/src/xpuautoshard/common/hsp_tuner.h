@@ -14,8 +14,16 @@ limitations under the License.
 ==============================================================================*/
 
 #pragma once
+#include <chrono>
+#include <deque>
 #include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "xpuautoshard/common/config.h"
+#include "xpuautoshard/common/device_info.h"
 #include "xpuautoshard/common/hsp_annotator.h"
 #include "xpuautoshard/common/hsp_cost_evaluator.h"
 #include "xpuautoshard/common/ref_base.h"
@@ -98,4 +106,212 @@ class HspTuner {
 
 using HspTunerRef = Ref<HspTuner>;
 
+/**
+ * @brief A sharding plan: the share of the global batch and the number of
+ * stages given to each device.
+ *
+ */
+class ShardingPlan : public TuningState {
+ public:
+  struct DevicePlan {
+    DeviceId id;
+    std::string name;
+    // The device gets `batch_units / total_batch_units` of the global batch.
+    int64_t batch_units;
+    size_t num_stages;
+  };
+
+  ShardingPlan(int64_t total_batch_units, std::vector<DevicePlan> devices)
+      : total_batch_units_(total_batch_units), devices_(std::move(devices)) {}
+
+  int64_t getTotalBatchUnits() const { return total_batch_units_; }
+  const std::vector<DevicePlan>& getDevices() const { return devices_; }
+  std::vector<DevicePlan>& getDevices() { return devices_; }
+
+  float getBatchRatio(size_t i) const {
+    return static_cast<float>(devices_[i].batch_units) / total_batch_units_;
+  }
+
+  /**
+   * @brief Apply the plan to `device_info`: the score of each device is set
+   * to its batch ratio and the number of stages is set accordingly.
+   *
+   * @param device_info
+   * @return DeviceInfo
+   */
+  DeviceInfo applyTo(const DeviceInfo& device_info) const;
+
+  /**
+   * @brief Whether any device runs more than one stage.
+   *
+   */
+  bool isMultiStage() const;
+
+  std::string toString() const;
+
+ private:
+  int64_t total_batch_units_;
+  std::vector<DevicePlan> devices_;
+};
+
+using ShardingPlanRef = Ref<ShardingPlan>;
+
+/**
+ * @brief Estimate the step time of a sharding plan with the analytic cost
+ * model.
+ *
+ * The graph is characterized once at the global batch, and the work of a
+ * device is assumed to scale with its share of the batch. Devices run in
+ * parallel, so the step time is the one of the slowest device. The stages of a
+ * device run concurrently, which hides part of the shorter of the compute and
+ * memory time, at the cost of launching all the ops once per stage.
+ *
+ */
+class ShardingPlanCostModel {
+ public:
+  ShardingPlanCostModel(GraphRef graph, const DeviceInfo& device_info);
+
+  /**
+   * @brief A cost model with the given compute and memory time of the whole
+   * graph and stage overhead on each device, e.g. a synthetic one.
+   *
+   */
+  ShardingPlanCostModel(std::vector<float> compute_time,
+                        std::vector<float> memory_time,
+                        std::vector<float> stage_overhead)
+      : compute_time_(std::move(compute_time)),
+        memory_time_(std::move(memory_time)),
+        stage_overhead_(std::move(stage_overhead)) {}
+
+  virtual ~ShardingPlanCostModel() = default;
+
+  /**
+   * @brief Estimated step time of `plan` in seconds, or in the relative unit
+   * of the qualitative cost model when the graph shapes are unknown.
+   *
+   */
+  virtual float getStepTime(const ShardingPlan& plan) const;
+
+  /**
+   * @brief Estimated time of the whole graph on the i-th device.
+   *
+   */
+  float getDeviceTime(size_t i) const {
+    return compute_time_[i] + memory_time_[i];
+  }
+
+ private:
+  std::vector<float> compute_time_;
+  std::vector<float> memory_time_;
+  std::vector<float> stage_overhead_;
+};
+
+using ShardingPlanCostModelRef = Ref<ShardingPlanCostModel>;
+
+/**
+ * @brief Score of a sharding plan. Shorter step time is a higher score.
+ *
+ */
+class StepTimeScore : public Score {
+ public:
+  explicit StepTimeScore(float step_time) : step_time_(step_time) {}
+
+  float getStepTime() const { return step_time_; }
+
+  bool operator==(const Score& rhs) override {
+    return step_time_ == dynamic_cast<const StepTimeScore&>(rhs).step_time_;
+  }
+
+  bool operator<(const Score& rhs) override {
+    return step_time_ > dynamic_cast<const StepTimeScore&>(rhs).step_time_;
+  }
+
+ private:
+  float step_time_;
+};
+
+/**
+ * @brief A beam search over sharding plans. Starting from the plan splitting
+ * the batch by device speed with one stage, each round expands the best
+ * `beam_width` plans by moving batch units between two devices and by
+ * doubling or halving the stages of a device. Plans as good as the beam enter
+ * it too, so that the search crosses the plateaus of the step time, which is
+ * the one of the slowest device. The search stops when no plan of a round
+ * enters the beam or when the time budget is used up. Plans are scored with
+ * `ShardingPlanCostModel`, so that only the best plan is annotated on the
+ * graph.
+ *
+ * Framework specific tuners implement `createAnnotator` for a plan.
+ *
+ */
+class SearchHspTuner : public HspTuner {
+ public:
+  SearchHspTuner(GraphRef graph, const DeviceInfo& device_info,
+                 const TunerConfig& tuner_config);
+
+  /**
+   * @brief Search the plans of the devices in `device_info` scored with
+   * `cost_model`, which has the devices in the same order.
+   *
+   */
+  SearchHspTuner(ShardingPlanCostModelRef cost_model,
+                 const DeviceInfo& device_info,
+                 const TunerConfig& tuner_config);
+
+  HspAnnotationRef tune(GraphRef graph) override;
+
+  /**
+   * @brief Search the best plan until the search converges or the time budget
+   * is used up. At least one plan is evaluated.
+   *
+   * @return ShardingPlanRef The best plan.
+   */
+  ShardingPlanRef search();
+
+  HspCostEvaluatorRef getCostModel() override {
+    return makeRef<DummyHspCostEvaluator, HspCostEvaluator>();
+  }
+
+  /**
+   * @brief The next plan to evaluate, or nullptr if the search converged.
+   *
+   */
+  TuningStateRef nextState() override;
+
+  void updateScore(const ScoreRef& score,
+                   TuningStateRef tuning_state = nullptr) override;
+
+  bool stopCriterionMet() override;
+
+  ShardingPlanRef getBestPlan() const { return best_plan_; }
+  float getBestStepTime() const { return best_step_time_; }
+  size_t getNumEvaluatedPlans() const { return num_evaluated_; }
+
+ protected:
+  DeviceInfo device_info_;
+  TunerConfig tuner_config_;
+
+ private:
+  struct ScoredPlan {
+    float step_time;
+    ShardingPlanRef plan;
+    bool expanded;
+  };
+
+  void addCandidate(ShardingPlanRef plan);
+  void expandBeam();
+
+  ShardingPlanCostModelRef cost_model_;
+  std::chrono::steady_clock::time_point start_time_;
+  std::deque<ShardingPlanRef> frontier_;
+  std::vector<ScoredPlan> beam_;
+  std::vector<ScoredPlan> round_;
+  std::set<std::string> visited_;
+  ShardingPlanRef current_plan_;
+  ShardingPlanRef best_plan_;
+  float best_step_time_;
+  size_t num_evaluated_;
+  bool converged_;
+};
+
 }  // namespace as
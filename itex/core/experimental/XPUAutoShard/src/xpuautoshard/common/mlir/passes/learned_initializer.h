@@ -15,7 +15,9 @@ limitations under the License.
 
 #pragma once
 
+#include "xpuautoshard/common/config.h"
 #include "xpuautoshard/common/device_info.h"
+#include "xpuautoshard/common/mlir/passes/heuristics_initializer.h"
 #include "xpuautoshard/common/mlir/passes/hsp_initializer.h"
 #include "xpuautoshard/common/mlir/passes/mlir_hsp_annotator.h"
 #include "xpuautoshard/common/ref_base.h"
@@ -23,19 +25,25 @@ limitations under the License.
 namespace mlir {
 namespace hs {
 
+/**
+ * @brief Initializer of the LEARNED strategy. The score and the number of
+ * stages of the devices in `device_info` come from the plan found by
+ * `MLIRSearchHspTuner`, the batch is then split with the heuristics.
+ *
+ */
 class LearnedInitializer : public HspInitializer {
  public:
-  LearnedInitializer(const as::DeviceInfo& device_info, MLIRAnnotationRef annot)
-      : device_info_(device_info), annot_(annot) {}
+  LearnedInitializer(const as::DeviceInfo& device_info,
+                     const as::HeuristicsConfig& heuristics_config,
+                     MLIRAnnotationRef annot)
+      : heuristics_initializer_(device_info, heuristics_config, annot) {}
 
   bool initSome(Operation* root_op) override {
-    // TODO(itex)
-    return false;
+    return heuristics_initializer_.initSome(root_op);
   }
 
  private:
-  as::DeviceInfo device_info_;
-  MLIRAnnotationRef annot_;
+  HeuristicsInitializer heuristics_initializer_;
 };
 
 using LearnedInitializerRef = as::Ref<LearnedInitializer>;
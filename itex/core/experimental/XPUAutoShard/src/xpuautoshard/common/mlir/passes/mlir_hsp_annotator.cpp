@@ -131,8 +131,8 @@ HspAnnotationRef MLIRHspAnnotator::annotate(GraphRef graph) {
           device_info_, sharding_config_.getHeuristicsConfig(), mlir_annot);
       break;
     case StrategyKind::LEARNED:
-      initializer =
-          std::make_shared<LearnedInitializer>(device_info_, mlir_annot);
+      initializer = std::make_shared<LearnedInitializer>(
+          device_info_, sharding_config_.getHeuristicsConfig(), mlir_annot);
       break;
     default:
       assert(false && "unreachable");
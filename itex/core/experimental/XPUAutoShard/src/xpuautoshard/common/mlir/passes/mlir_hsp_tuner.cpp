@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "xpuautoshard/common/mlir/passes/mlir_hsp_tuner.h"
 
+#include "itex/core/utils/logging.h"
 #include "xpuautoshard/common/mlir/passes/mlir_hsp_annotator.h"
 
 namespace mlir {
@@ -22,7 +23,10 @@ namespace hs {
 
 using as::HspAnnotator;
 using as::HspAnnotatorRef;
+using as::HspAnnotationRef;
 using as::makeRef;
+using as::ShardingConfig;
+using as::ShardingPlan;
 using as::TuningStateRef;
 using ::mlir::hs::MLIRHspAnnotator;
 
@@ -31,5 +35,25 @@ HspAnnotatorRef MLIRHspTuner::createAnnotator(TuningStateRef tuning_state) {
                                                  sharding_config_);
 }
 
+HspAnnotationRef MLIRSearchHspTuner::tune(as::GraphRef graph) {
+  auto&& annot = as::SearchHspTuner::tune(graph);
+  ITEX_LOG(INFO) << "XPUAutoShard tuned sharding plan after evaluating "
+                 << getNumEvaluatedPlans()
+                 << " plans, estimated step time: " << getBestStepTime()
+                 << ", " << getBestPlan()->toString();
+  return annot;
+}
+
+HspAnnotatorRef MLIRSearchHspTuner::createAnnotator(
+    TuningStateRef tuning_state) {
+  auto&& plan = as::downcastRef<ShardingPlan>(
+      tuning_state ? tuning_state : TuningStateRef(getBestPlan()));
+  ShardingConfig sharding_config = sharding_config_;
+  sharding_config.getHeuristicsConfig().setMultiStageEnabled(
+      plan->isMultiStage());
+  return makeRef<MLIRHspAnnotator, HspAnnotator>(
+      graph_, plan->applyTo(device_info_), sharding_config);
+}
+
 }  // namespace hs
 }  // namespace mlir
@@ -50,5 +50,30 @@ class MLIRHspTuner : public as::HspTuner {
   as::ShardingConfig sharding_config_;
 };
 
+/**
+ * @brief Tuner of the LEARNED strategy: searches the batch split and the
+ * number of stages of each device with the analytic cost model, and annotates
+ * the graph with the best plan.
+ *
+ */
+class MLIRSearchHspTuner : public as::SearchHspTuner {
+ public:
+  MLIRSearchHspTuner(as::GraphRef graph, const as::DeviceInfo& device_info,
+                     const as::ShardingConfig& sharding_config)
+      : as::SearchHspTuner(graph, device_info,
+                           sharding_config.getTunerConfig()),
+        graph_(graph),
+        sharding_config_(sharding_config) {}
+
+  as::HspAnnotationRef tune(as::GraphRef graph) override;
+
+  as::HspAnnotatorRef createAnnotator(
+      as::TuningStateRef tuning_state = nullptr) override;
+
+ private:
+  as::GraphRef graph_;
+  as::ShardingConfig sharding_config_;
+};
+
 }  // namespace hs
 }  // namespace mlir
@@ -44,6 +44,10 @@ as::GraphRef mlirGraphToGraphHandle(Operation* root_op) {
 
 HspTunerRef createHspTunerMlir(GraphRef graph, const DeviceInfo& device_info,
                                const ShardingConfig& sharding_config) {
+  if (sharding_config.getStrategyKind() == as::StrategyKind::LEARNED) {
+    return makeRef<MLIRSearchHspTuner, HspTuner>(graph, device_info,
+                                                 sharding_config);
+  }
   return makeRef<MLIRHspTuner, HspTuner>(graph, device_info, sharding_config);
 }
 
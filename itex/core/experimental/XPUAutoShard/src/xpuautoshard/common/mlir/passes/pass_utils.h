@@ -75,6 +75,8 @@ static const OPSet kConstSingleSplitOP = {"tfg.Const", "tfg.VarHandleOp",
 
 static constexpr char kDeviceAttr[] = "_mlir_device";
 static constexpr char kMlirNameAttr[] = "_mlir_name";
+// NUMA node the CPU kernel of a pinned replica runs on.
+static constexpr char kNumaNodeAttr[] = "_numa_node";
 static constexpr char DEVICE_PREFIX[] =
     "/job:localhost/replica:0/task:0/device:";
 
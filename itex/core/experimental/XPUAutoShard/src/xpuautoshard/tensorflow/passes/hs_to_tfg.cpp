@@ -335,6 +335,16 @@ std::string HStoTFGConversion::getDeviceName(DeviceId id) {
   }
 }
 
+int HStoTFGConversion::getNumaNode(const std::string& device_name) {
+  const std::string mlir_device_name = getMlirDeviceName(device_name);
+  for (auto&& device : current_device_info_.getDevices()) {
+    if (getMlirDeviceName(device.getName()) == mlir_device_name) {
+      return device.getNumaNode();
+    }
+  }
+  return Device::NO_NUMA_NODE;
+}
+
 std::string HStoTFGConversion::getNextCollectiveKey() {
   return std::to_string(collective_id_++);
 }
@@ -415,6 +425,12 @@ Operation* HStoTFGConversion::buildTfgOp(
                             createShardedTfgOpNameFor(device_name, mlir_name)));
   op_state.addAttribute(kDeviceAttr,
                         builder->getStringAttr(getMlirDeviceName(device_name)));
+  // Kernels of a replica pinned to a NUMA node run on the threads of that node.
+  int numa_node = getNumaNode(device_name);
+  if (numa_node != Device::NO_NUMA_NODE) {
+    op_state.attributes.set(kNumaNodeAttr,
+                            builder->getI64IntegerAttr(numa_node));
+  }
   if (need_output_control_edge) {
     op_state.types.push_back(
         mlir::tfg::ControlType::get(builder->getContext()));
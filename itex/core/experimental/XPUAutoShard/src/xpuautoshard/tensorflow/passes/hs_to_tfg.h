@@ -69,6 +69,12 @@ struct HStoTFGConversion
 
   std::string getDeviceName(as::DeviceId id);
 
+  /**
+   * @brief Get the NUMA node the device named `device_name` is pinned to,
+   * or Device::NO_NUMA_NODE if it is not pinned.
+   */
+  int getNumaNode(const std::string& device_name);
+
   std::string createShardedTfgOpNameFor(const std::string& device_name,
                                         const std::string& op_name);
 
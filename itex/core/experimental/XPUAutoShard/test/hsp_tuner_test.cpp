@@ -0,0 +1,163 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "xpuautoshard/common/hsp_tuner.h"
+
+namespace as {
+namespace {
+
+#define EXPECT_TRUE(cond)                                                   \
+  do {                                                                      \
+    if (!(cond)) {                                                          \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": Expect " #cond "\n"; \
+      std::exit(1);                                                         \
+    }                                                                       \
+  } while (0)
+
+// Only the searched plan is checked, nothing is annotated.
+class TestSearchHspTuner : public SearchHspTuner {
+ public:
+  using SearchHspTuner::SearchHspTuner;
+
+  HspAnnotatorRef createAnnotator(
+      TuningStateRef tuning_state = nullptr) override {
+    return nullptr;
+  }
+};
+
+// A cost model taking `eval_time` to score a plan.
+class SlowCostModel : public ShardingPlanCostModel {
+ public:
+  SlowCostModel(size_t num_devices, std::chrono::milliseconds eval_time)
+      : ShardingPlanCostModel(std::vector<float>(num_devices, 1.0f),
+                              std::vector<float>(num_devices, 1.0f),
+                              std::vector<float>(num_devices, 0.01f)),
+        eval_time_(eval_time) {}
+
+  float getStepTime(const ShardingPlan& plan) const override {
+    std::this_thread::sleep_for(eval_time_);
+    return ShardingPlanCostModel::getStepTime(plan);
+  }
+
+ private:
+  std::chrono::milliseconds eval_time_;
+};
+
+DeviceInfo makeDeviceInfo(size_t num_devices) {
+  DeviceInfo device_info(/*add_cpu_host=*/false);
+  for (size_t i = 0; i < num_devices; i++) {
+    device_info.addDevice(Device(i + 1, "GPU:" + std::to_string(i)));
+  }
+  return device_info;
+}
+
+// Device 0 is bound by compute and memory and gains from concurrent stages,
+// device 1 only computes, at half the speed of device 0 overall. The split by
+// speed with one stage is far from the best plan.
+void testBeamSearchFindsBestPlan() {
+  auto&& cost_model = makeRef<ShardingPlanCostModel>(
+      std::vector<float>{1.0f, 2.0f}, std::vector<float>{1.0f, 0.0f},
+      std::vector<float>{0.01f, 0.01f});
+  TunerConfig tuner_config;
+  tuner_config.setTimeBudgetMs(60 * 1000);
+  TestSearchHspTuner tuner(cost_model, makeDeviceInfo(2), tuner_config);
+  auto&& best_plan = tuner.search();
+  EXPECT_TRUE(best_plan);
+
+  // Exhaustive search of the same space.
+  const int64_t total_units = tuner_config.getBatchUnits();
+  float best_step_time = std::numeric_limits<float>::max();
+  for (int64_t units = 1; units < total_units; units++) {
+    for (size_t stages_0 = 1; stages_0 <= 8; stages_0 *= 2) {
+      for (size_t stages_1 = 1; stages_1 <= 8; stages_1 *= 2) {
+        if (static_cast<int64_t>(stages_0) > units ||
+            static_cast<int64_t>(stages_1) > total_units - units) {
+          continue;
+        }
+        ShardingPlan plan(total_units, {{1, "GPU:0", units, stages_0},
+                                        {2, "GPU:1", total_units - units,
+                                         stages_1}});
+        best_step_time =
+            std::min(best_step_time, cost_model->getStepTime(plan));
+      }
+    }
+  }
+  EXPECT_TRUE(tuner.getBestStepTime() == best_step_time);
+  EXPECT_TRUE(cost_model->getStepTime(*best_plan) == best_step_time);
+  // The faster device with concurrent stages gets the larger share.
+  EXPECT_TRUE(best_plan->getDevices()[0].batch_units > total_units / 2);
+  EXPECT_TRUE(best_plan->getDevices()[0].num_stages > 1);
+}
+
+// Devices of the same speed are best split evenly with one stage, which is
+// the initial plan, so the search converges after the first round.
+void testSearchConvergesOnInitialPlan() {
+  auto&& cost_model = makeRef<ShardingPlanCostModel>(
+      std::vector<float>{1.0f, 1.0f}, std::vector<float>{0.0f, 0.0f},
+      std::vector<float>{0.01f, 0.01f});
+  TunerConfig tuner_config;
+  tuner_config.setTimeBudgetMs(60 * 1000);
+  TestSearchHspTuner tuner(cost_model, makeDeviceInfo(2), tuner_config);
+  auto&& best_plan = tuner.search();
+  EXPECT_TRUE(best_plan->getDevices()[0].batch_units ==
+              tuner_config.getBatchUnits() / 2);
+  EXPECT_TRUE(!best_plan->isMultiStage());
+}
+
+void testTimeBudgetRespected() {
+  const auto eval_time = std::chrono::milliseconds(2);
+  const int64_t budget_ms = 20;
+  TunerConfig tuner_config;
+  tuner_config.setTimeBudgetMs(budget_ms);
+  tuner_config.setBatchUnits(1024);
+  TestSearchHspTuner tuner(makeRef<SlowCostModel>(4, eval_time),
+                           makeDeviceInfo(4), tuner_config);
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(tuner.search());
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  // Stopped by the budget rather than by convergence, which takes far more
+  // plans, and within the evaluation of the plan running at the deadline.
+  EXPECT_TRUE(elapsed.count() >= budget_ms);
+  EXPECT_TRUE(static_cast<int64_t>(tuner.getNumEvaluatedPlans()) <=
+              budget_ms / eval_time.count() + 1);
+  EXPECT_TRUE(elapsed < std::chrono::milliseconds(budget_ms) + 10 * eval_time);
+
+  // A zero budget still evaluates one plan.
+  tuner_config.setTimeBudgetMs(0);
+  TestSearchHspTuner zero_budget_tuner(makeRef<SlowCostModel>(4, eval_time),
+                                       makeDeviceInfo(4), tuner_config);
+  EXPECT_TRUE(zero_budget_tuner.search());
+  EXPECT_TRUE(zero_budget_tuner.getNumEvaluatedPlans() == 1);
+}
+
+}  // namespace
+}  // namespace as
+
+int main() {
+  as::testBeamSearchFindsBestPlan();
+  as::testSearchConvergesOnInitialPlan();
+  as::testTimeBudgetRespected();
+  return 0;
+}
@@ -184,6 +184,7 @@ class AutoMixedPrecisionLists {
       "_ITEXFusedConv2DWithSum",
       "_ITEXFusedConv3D",
       "_ITEXFusedDepthwiseConv2dNative",
+      "_ITEXFusedMLP",
       "_ITEXFusedMatMul",
       "_ITEXFusedMatMulGrad",
       "_ITEXFusedMatMulWithSum",
@@ -197,6 +198,8 @@ class AutoMixedPrecisionLists {
       "ScaledDotProductAttention",
       "ScaledDotProductAttentionInference",
       "ScaledDotProductAttentionGrad",
+      "ScaledDotProductAttentionFlash",
+      "ScaledDotProductAttentionFlashGrad",
       "FusedDenseBiasAddGelu",
       "FusedDenseBiasAddGeluGrad",
   };
@@ -257,6 +260,7 @@ class AutoMixedPrecisionLists {
       "_FusedBatchNormEx",
       "_ITEXFusedBatchNormGradEx",
       "_ITEXFusedBinary",
+      "_ITEXFusedElementwise",
       "_ITEXFusedInstanceNorm",
       "_ITEXInstanceNorm",
       "_ITEXMish",
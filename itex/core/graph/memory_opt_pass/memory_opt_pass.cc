@@ -21,11 +21,13 @@ limitations under the License.
 #include <vector>
 
 #include "google/protobuf/text_format.h"
+#include "itex/core/graph/memory_opt_pass/memory_planner.h"
 #include "itex/core/graph/utils/graph_properties.h"
 #include "itex/core/graph/utils/layout_utils.h"
 #include "itex/core/graph/utils/op_types.h"
 #include "itex/core/graph/utils/utils.h"
 #include "itex/core/utils/attr_value_util.h"
+#include "itex/core/utils/env_var.h"
 #include "itex/core/utils/types.h"
 
 namespace itex {
@@ -393,6 +395,29 @@ Status RunMemoryOptPass(OptimizerContext* opt_ctx, const GrapplerItem& item,
 
   // Introduce more optimization if needed.
 
+  bool enable_memory_planner;
+  ITEX_CHECK_OK(ReadBoolFromEnvVar("ITEX_MEMORY_PLANNER", false,
+                                   &enable_memory_planner));
+  if (enable_memory_planner) {
+    std::vector<DeviceMemoryPlan> plans;
+    Status s = PlanMemory(item, &ctx, opt_ctx->device_name, &plans);
+    if (s.ok()) {
+      for (const auto& plan : plans) {
+        const auto& summary = plan.summary;
+        ITEX_LOG(INFO) << "MemoryPlanner: device " << summary.device
+                       << ", arena " << summary.arena_bytes
+                       << " bytes (live peak " << summary.live_peak_bytes
+                       << ") for " << summary.num_buffers
+                       << " buffers, persistent " << summary.persistent_bytes
+                       << " bytes, " << summary.num_unknown_tensors
+                       << " tensors of unknown size.";
+        opt_ctx->memory_plans.push_back(summary);
+      }
+    } else {
+      ITEX_LOG(WARNING) << "MemoryPlanner failed: " << s;
+    }
+  }
+
   *optimized_graph = std::move(mutable_graph_def);
   return Status::OK();
 }
@@ -0,0 +1,222 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/graph/memory_opt_pass/memory_planner.h"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "itex/core/graph/utils/graph_properties.h"
+#include "itex/core/graph/utils/op_types.h"
+#include "itex/core/utils/strcat.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+namespace graph {
+
+namespace {
+
+int64_t AlignedSize(int64_t bytes) {
+  return (bytes + kMemoryPlanAlignment - 1) / kMemoryPlanAlignment *
+         kMemoryPlanAlignment;
+}
+
+// Returns the input port whose buffer is forwarded to output 0 by the
+// in-place optimization, or -1.
+int GetForwardedInputPort(const MutableNodeView* node_view) {
+  const auto& attr = node_view->node()->attr();
+  auto is_set = [&attr](const char* name) {
+    auto it = attr.find(name);
+    return it != attr.end() && it->second.b();
+  };
+  if (!is_set("is_inplace") && !is_set("inplace_sum")) return -1;
+  std::vector<int> ports = GetCandidateForwardPort(node_view);
+  return ports.empty() ? -1 : ports[0];
+}
+
+// Assigns offsets greedily, largest buffers first, each one at the lowest
+// offset not overlapping any placed buffer alive at the same time. Returns
+// the arena size.
+int64_t AssignOffsets(std::vector<PlannedBuffer>* buffers) {
+  std::vector<int> order(buffers->size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [buffers](int a, int b) {
+    return (*buffers)[a].size > (*buffers)[b].size;
+  });
+
+  int64_t arena_bytes = 0;
+  std::vector<const PlannedBuffer*> placed;
+  std::vector<const PlannedBuffer*> overlapping;
+  for (int index : order) {
+    PlannedBuffer& buffer = (*buffers)[index];
+    overlapping.clear();
+    for (const PlannedBuffer* other : placed) {
+      if (other->first_use <= buffer.last_use &&
+          buffer.first_use <= other->last_use) {
+        overlapping.push_back(other);
+      }
+    }
+    std::sort(overlapping.begin(), overlapping.end(),
+              [](const PlannedBuffer* a, const PlannedBuffer* b) {
+                return a->offset < b->offset;
+              });
+    int64_t offset = 0;
+    for (const PlannedBuffer* other : overlapping) {
+      if (offset + buffer.size <= other->offset) break;
+      offset = std::max(offset, other->offset + other->size);
+    }
+    buffer.offset = offset;
+    arena_bytes = std::max(arena_bytes, offset + buffer.size);
+
+    // Keep `placed` sorted by offset for a stable overlap order.
+    auto pos = std::upper_bound(placed.begin(), placed.end(), &buffer,
+                                [](const PlannedBuffer* a,
+                                   const PlannedBuffer* b) {
+                                  return a->offset < b->offset;
+                                });
+    placed.insert(pos, &buffer);
+  }
+  return arena_bytes;
+}
+
+// Returns the largest total size of the buffers alive at the same step.
+int64_t GetLivePeakBytes(const std::vector<PlannedBuffer>& buffers) {
+  // Allocations at a step happen before the frees after it.
+  std::vector<std::pair<int, int64_t>> events;
+  events.reserve(buffers.size() * 2);
+  for (const auto& buffer : buffers) {
+    events.emplace_back(2 * buffer.first_use, buffer.size);
+    events.emplace_back(2 * buffer.last_use + 1, -buffer.size);
+  }
+  std::sort(events.begin(), events.end());
+  int64_t live_bytes = 0, peak_bytes = 0;
+  for (const auto& event : events) {
+    live_bytes += event.second;
+    peak_bytes = std::max(peak_bytes, live_bytes);
+  }
+  return peak_bytes;
+}
+
+}  // namespace
+
+Status PlanMemory(const GrapplerItem& item, MemoryOptContext* ctx,
+                  const char* default_device,
+                  std::vector<DeviceMemoryPlan>* plans) {
+  RewrittenGraphProperties properties(item, *ctx->graph_view.graph());
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      /*assume_valid_feeds=*/true, /*aggressive_shape_inference=*/false,
+      /*include_tensor_values=*/false));
+
+  const int num_nodes = ctx->graph_view.NumNodes();
+  std::map<string, DeviceMemoryPlan> device_plans;
+  // Index of the planned buffer of each output of each node, or -1 for the
+  // tensors left out of the plan.
+  std::vector<std::vector<int>> tensor_buffers(num_nodes);
+  std::vector<OpInfo_TensorProperties> props;
+
+  for (int node_index = 0; node_index < num_nodes; ++node_index) {
+    const auto* node_view = ctx->graph_view.GetNode(node_index);
+    const NodeDef* node_def = node_view->node();
+    const string device =
+        node_def->device().empty() ? default_device : node_def->device();
+    DeviceMemoryPlan& plan = device_plans[device];
+    plan.summary.device = device;
+
+    props.clear();
+    if (!properties.GetOutputProperties(node_def->name(), &props).ok()) {
+      props.clear();
+    }
+    const int num_fanout_ports = node_view->GetRegularFanouts().size();
+    const int num_outputs =
+        std::max(static_cast<int>(props.size()), num_fanout_ports);
+    tensor_buffers[node_index].assign(num_outputs, -1);
+
+    const bool is_persistent = IsAnyConst(*node_def) || IsVariable(*node_def);
+    const bool is_fetched = ctx->nodes_to_preserve.count(node_def->name()) > 0;
+    const int forwarded_port = GetForwardedInputPort(node_view);
+
+    for (int port = 0; port < num_outputs; ++port) {
+      const int64_t bytes = port < static_cast<int>(props.size())
+                                ? GetTensorBytes(props[port])
+                                : -1;
+      if (bytes < 0) {
+        ++plan.summary.num_unknown_tensors;
+        continue;
+      }
+      if (is_persistent) {
+        plan.summary.persistent_bytes += bytes;
+        continue;
+      }
+
+      int buffer_index = -1;
+      if (port == 0 && forwarded_port >= 0 &&
+          forwarded_port < node_view->NumRegularFanins()) {
+        const auto& fanin = node_view->GetRegularFanin(forwarded_port);
+        const auto& fanin_buffers = tensor_buffers[fanin.node_index()];
+        if (fanin.index() >= 0 &&
+            fanin.index() < static_cast<int>(fanin_buffers.size()) &&
+            IsOnSameDevice(node_view, fanin.node_view())) {
+          buffer_index = fanin_buffers[fanin.index()];
+        }
+      }
+      if (buffer_index >= 0) {
+        // The output reuses the forwarded input buffer.
+        auto& buffer = plan.buffers[buffer_index];
+        buffer.size = std::max(buffer.size, AlignedSize(bytes));
+      } else {
+        buffer_index = plan.buffers.size();
+        PlannedBuffer buffer;
+        buffer.tensor = strings::StrCat(node_def->name(), ":", port);
+        buffer.size = AlignedSize(bytes);
+        buffer.first_use = node_index;
+        buffer.last_use = node_index;
+        plan.buffers.push_back(std::move(buffer));
+      }
+      tensor_buffers[node_index][port] = buffer_index;
+
+      auto& buffer = plan.buffers[buffer_index];
+      if (is_fetched) buffer.last_use = num_nodes;
+      if (port < num_fanout_ports) {
+        for (const auto& fanout : node_view->GetRegularFanout(port)) {
+          buffer.last_use = std::max(buffer.last_use, fanout.node_index());
+        }
+      }
+    }
+  }
+
+  plans->clear();
+  for (auto& [device, plan] : device_plans) {
+    plan.summary.num_buffers = plan.buffers.size();
+    plan.summary.live_peak_bytes = GetLivePeakBytes(plan.buffers);
+    plan.summary.arena_bytes = AssignOffsets(&plan.buffers);
+    if (ITEX_VLOG_IS_ON(3)) {
+      for (const auto& buffer : plan.buffers) {
+        ITEX_VLOG(3) << "MemoryPlanner: " << buffer.tensor
+                     << " offset=" << buffer.offset << " size=" << buffer.size
+                     << " live=[" << buffer.first_use << ", "
+                     << buffer.last_use << "]";
+      }
+    }
+    plans->push_back(std::move(plan));
+  }
+  return Status::OK();
+}
+
+}  // namespace graph
+}  // namespace itex
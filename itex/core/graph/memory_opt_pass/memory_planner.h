@@ -0,0 +1,68 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_GRAPH_MEMORY_OPT_PASS_MEMORY_PLANNER_H_
+#define ITEX_CORE_GRAPH_MEMORY_OPT_PASS_MEMORY_PLANNER_H_
+
+#include <string>
+#include <vector>
+
+#include "itex/core/graph/memory_opt_pass/memory_opt_pass.h"
+#include "itex/core/graph/utils/grappler_item.h"
+#include "itex/core/graph/utils/utils.h"
+#include "itex/core/utils/status.h"
+
+namespace itex {
+namespace graph {
+
+// Intermediate tensors are placed at offsets aligned to this many bytes.
+constexpr int64_t kMemoryPlanAlignment = 64;
+
+// A block of the arena holding one tensor, or several tensors when a node
+// forwards its input buffer to its output (see StaticInplaceOpt).
+struct PlannedBuffer {
+  // Name of the tensor allocating the buffer, "node:port".
+  string tensor;
+  // Size in bytes, aligned to kMemoryPlanAlignment.
+  int64_t size = 0;
+  // Topological indices of the producer and of the last consumer.
+  int first_use = 0;
+  int last_use = 0;
+  int64_t offset = 0;
+};
+
+struct DeviceMemoryPlan {
+  MemoryPlanSummary summary;
+  std::vector<PlannedBuffer> buffers;
+};
+
+// Static memory planner: runs a liveness analysis over the topologically
+// sorted graph in `ctx`, using the shapes of RewrittenGraphProperties, and
+// assigns every intermediate tensor an offset in a single arena per device so
+// that tensors alive at the same time never overlap.
+//
+// Constants and variables are accounted as persistent memory. Tensors whose
+// size is not statically known (unknown dims, string/variant types, or nodes
+// without inferred shapes) are left out and counted. Fetched tensors stay
+// alive until the end of the step. Loops are not unrolled, so tensors of a
+// while loop body are planned as if the body ran once.
+Status PlanMemory(const GrapplerItem& item, MemoryOptContext* ctx,
+                  const char* default_device,
+                  std::vector<DeviceMemoryPlan>* plans);
+
+}  // namespace graph
+}  // namespace itex
+
+#endif  // ITEX_CORE_GRAPH_MEMORY_OPT_PASS_MEMORY_PLANNER_H_
@@ -0,0 +1,397 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/graph/memory_opt_pass/rematerialization.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "itex/core/graph/utils/graph_properties.h"
+#include "itex/core/graph/utils/graph_view.h"
+#include "itex/core/graph/utils/op_types.h"
+#include "itex/core/utils/env_var.h"
+#include "itex/core/utils/gtl/flatset.h"
+#include "itex/core/utils/strcat.h"
+#include "itex/core/utils/types.h"
+#include "xpuautoshard/common/analytic_cost_model.h"
+
+namespace itex {
+namespace graph {
+
+namespace {
+
+// Nominal CPU capability used to turn the analytic characteristics of the
+// recomputed nodes into a time estimate. Only the ratio between compute and
+// memory matters to rank the candidates.
+constexpr float kNominalFloatOPS = 2e12;
+constexpr float kNominalBfloat16OPS = 8e12;
+constexpr float kNominalFloat16OPS = 8e12;
+constexpr float kNominalInt8OPS = 16e12;
+constexpr float kNominalMemBandwidth = 2e11;
+
+bool IsBackwardNode(const NodeDef& node) {
+  const string& name = node.name();
+  return absl::StartsWith(name, "gradients") ||
+         absl::StartsWith(name, "gradient_tape/") ||
+         absl::StrContains(name, "/gradients/") ||
+         absl::StrContains(name, "/gradient_tape/");
+}
+
+bool IsPersistent(const NodeDef& node) {
+  return IsAnyConst(node) || IsVariable(node);
+}
+
+// Stateless ops which are cheap to recompute compared to the memory their
+// output occupies.
+bool IsCheapToRecompute(const NodeDef& node) {
+  static const auto* cheap_ops = new gtl::FlatSet<string>{
+      // Activations.
+      "Elu", "Gelu", "ITEXGelu", "LeakyRelu", "_ITEXLeakyRelu", "_ITEXMish",
+      "Relu", "Relu6", "Selu", "Sigmoid", "Softplus", "_ITEXSwish", "Tanh",
+      // Elementwise.
+      "Add", "AddV2", "BiasAdd", "Cast", "Exp", "Maximum", "Minimum", "Mul",
+      "Neg", "RealDiv", "Rsqrt", "Sqrt", "Square", "Sub",
+      // Normalizations.
+      "FusedBatchNormV3", "_FusedBatchNormEx", "_ITEXFusedBatchNormV3",
+      "_ITEXFusedBatchNormEx", "ITEXLayerNorm", "_ITEXMklLayerNorm",
+      "_ITEXInstanceNorm", "_ITEXFusedInstanceNorm"};
+  return cheap_ops->count(node.op()) != 0;
+}
+
+as::DataType ToAsDataType(DataType dtype) {
+  switch (BaseType(dtype)) {
+    case DT_DOUBLE:
+      return as::DataType::FLOAT64;
+    case DT_FLOAT:
+      return as::DataType::FLOAT32;
+    case DT_HALF:
+      return as::DataType::FLOAT16;
+    case DT_BFLOAT16:
+      return as::DataType::BFLOAT16;
+    default:
+      return DataTypeIsInteger(BaseType(dtype)) || dtype == DT_BOOL
+                 ? as::DataType::INTEGER
+                 : as::DataType::UNKNOWN;
+  }
+}
+
+// Adapters exposing a NodeDef and the statically inferred properties of its
+// tensors to the XPUAutoShard cost model.
+class TensorPropertiesValueDesc : public as::ValueDesc {
+ public:
+  explicit TensorPropertiesValueDesc(const OpInfo_TensorProperties& props)
+      : props_(props) {}
+
+  int64_t getRank() const override {
+    return props_.shape().unknown_rank() ? as::UNRANKED
+                                         : props_.shape().dim_size();
+  }
+  as::DataType getElementType() const override {
+    return ToAsDataType(props_.dtype());
+  }
+  bool isDynamicDim(int64_t dim) const override {
+    return props_.shape().dim(dim).size() < 0;
+  }
+  bool isConcreteDims() const override {
+    if (!isRanked()) return false;
+    for (const auto& dim : props_.shape().dim()) {
+      if (dim.size() < 0) return false;
+    }
+    return true;
+  }
+  int64_t getDimSize(int64_t dim) const override {
+    return props_.shape().dim(dim).size();
+  }
+  std::vector<int64_t> getConstVecInt64() const override { return {}; }
+
+ private:
+  OpInfo_TensorProperties props_;
+};
+
+class NodeDefOpDesc : public as::OpDesc {
+ public:
+  NodeDefOpDesc(const NodeDef& node,
+                const std::vector<OpInfo_TensorProperties>& input_props,
+                const std::vector<OpInfo_TensorProperties>& output_props)
+      : node_(node), name_(strings::StrCat("tfg.", node.op())) {
+    for (const auto& props : input_props) operands_.emplace_back(props);
+    for (const auto& props : output_props) results_.emplace_back(props);
+  }
+
+  const std::string& getName() const override { return name_; }
+  as::ValueDesc& getOperand(unsigned idx) override { return operands_[idx]; }
+  const as::ValueDesc& getOperand(unsigned idx) const override {
+    return operands_[idx];
+  }
+  size_t getNumOperands() const override { return operands_.size(); }
+  as::ValueDesc& getResult(unsigned idx) override { return results_[idx]; }
+  const as::ValueDesc& getResult(unsigned idx) const override {
+    return results_[idx];
+  }
+  size_t getNumResults() const override { return results_.size(); }
+
+  bool hasAttr(const std::string& attr_name) const override {
+    return node_.attr().count(attr_name) != 0;
+  }
+  bool getAttrBool(const std::string& attr_name) const override {
+    return hasAttr(attr_name) && node_.attr().at(attr_name).b();
+  }
+  int64_t getAttrInt64(const std::string& attr_name) const override {
+    return hasAttr(attr_name) ? node_.attr().at(attr_name).i() : 0;
+  }
+  std::string getAttrString(const std::string& attr_name) const override {
+    return hasAttr(attr_name) ? node_.attr().at(attr_name).s() : "";
+  }
+  std::vector<int64_t> getAttrVecInt64(
+      const std::string& attr_name) const override {
+    if (!hasAttr(attr_name)) return {};
+    const auto& list = node_.attr().at(attr_name).list().i();
+    return std::vector<int64_t>(list.begin(), list.end());
+  }
+
+ private:
+  const NodeDef& node_;
+  const std::string name_;
+  std::vector<TensorPropertiesValueDesc> operands_;
+  std::vector<TensorPropertiesValueDesc> results_;
+};
+
+struct RematCandidate {
+  int node_index;
+  // Backward node the recomputation waits for.
+  int trigger_index;
+  int64_t saved_bytes;
+  float time;
+};
+
+}  // namespace
+
+int64_t GetRematMemoryBudget() {
+  int64_t budget_mb;
+  Status status =
+      ReadInt64FromEnvVar("ITEX_REMAT_MEMORY_BUDGET_MB", 0, &budget_mb);
+  if (!status.ok()) {
+    ITEX_LOG(WARNING) << "Rematerialization is disabled: " << status.ToString();
+    return 0;
+  }
+  return budget_mb > 0 ? budget_mb * 1024 * 1024 : 0;
+}
+
+Status RunRematerialization(OptimizerContext* opt_ctx, const GrapplerItem& item,
+                            const GraphDef& graph_def,
+                            GraphDef* optimized_graph) {
+  *optimized_graph = graph_def;
+  const int64_t budget_bytes = GetRematMemoryBudget();
+  if (budget_bytes == 0) return Status::OK();
+
+  Status status;
+  GraphDef mutable_graph_def = graph_def;
+  utils::MutableGraphView graph_view(&mutable_graph_def, &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(graph_view.SortTopologically(/*ignore_cycles=*/false, {}));
+
+  // Built after sorting, which moves the nodes of the graph.
+  RewrittenGraphProperties properties(item, mutable_graph_def);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      /*assume_valid_feeds=*/true, /*aggressive_shape_inference=*/false,
+      /*include_tensor_values=*/false));
+  const std::unordered_set<string> nodes_to_preserve = item.NodesToPreserve();
+
+  const int num_nodes = graph_view.NumNodes();
+  std::vector<bool> is_backward(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    is_backward[i] = IsBackwardNode(*graph_view.GetNode(i)->node());
+  }
+  auto has_backward_consumer = [&](const utils::MutableNodeView* node_view,
+                                   int port) {
+    if (port >= static_cast<int>(node_view->GetRegularFanouts().size())) {
+      return false;
+    }
+    for (const auto& fanout : node_view->GetRegularFanout(port)) {
+      if (is_backward[fanout.node_index()]) return true;
+    }
+    return false;
+  };
+
+  as::AnalyticCostModel cost_model(as::DeviceComputeCapability(
+      kNominalFloatOPS, kNominalBfloat16OPS, kNominalFloat16OPS,
+      kNominalInt8OPS, kNominalMemBandwidth));
+  auto characterizer = cost_model.createComputeCharacterizer();
+
+  // Bytes of the forward tensors kept alive for the backward pass.
+  int64_t kept_bytes = 0;
+  std::vector<RematCandidate> candidates;
+  std::vector<OpInfo_TensorProperties> input_props, output_props;
+  for (int i = 0; i < num_nodes; ++i) {
+    const auto* node_view = graph_view.GetNode(i);
+    const NodeDef* node_def = node_view->node();
+    if (is_backward[i] || IsPersistent(*node_def)) continue;
+    if (!properties.GetOutputProperties(node_def->name(), &output_props).ok()) {
+      continue;
+    }
+
+    int64_t saved_bytes = 0;
+    bool known_size = true;
+    for (int port = 0; port < static_cast<int>(output_props.size()); ++port) {
+      if (!has_backward_consumer(node_view, port)) continue;
+      int64_t bytes = GetTensorBytes(output_props[port]);
+      if (bytes < 0) {
+        known_size = false;
+        continue;
+      }
+      saved_bytes += bytes;
+    }
+    kept_bytes += saved_bytes;
+
+    if (saved_bytes == 0 || !known_size || !IsCheapToRecompute(*node_def) ||
+        nodes_to_preserve.count(node_def->name()) != 0) {
+      continue;
+    }
+
+    // Recomputing must not keep any other forward tensor alive longer.
+    bool inputs_kept = true;
+    for (const auto& fanin : node_view->GetRegularFanins()) {
+      if (!IsPersistent(*fanin.node_view()->node()) &&
+          !has_backward_consumer(fanin.node_view(), fanin.index())) {
+        inputs_kept = false;
+        break;
+      }
+    }
+    if (!inputs_kept) continue;
+
+    // The copy waits for a backward input of the first backward consumer,
+    // so it runs right before that consumer instead of in the forward pass.
+    int first_consumer = num_nodes;
+    for (const auto& fanouts : node_view->GetRegularFanouts()) {
+      for (const auto& fanout : fanouts) {
+        if (is_backward[fanout.node_index()]) {
+          first_consumer = std::min(first_consumer, fanout.node_index());
+        }
+      }
+    }
+    int trigger_index = -1;
+    for (const auto& fanin :
+         graph_view.GetNode(first_consumer)->GetRegularFanins()) {
+      if (is_backward[fanin.node_index()]) {
+        trigger_index = fanin.node_index();
+        break;
+      }
+    }
+    if (trigger_index < 0) continue;
+
+    if (!properties.GetInputProperties(node_def->name(), &input_props).ok()) {
+      continue;
+    }
+    auto op_desc = as::makeRef<NodeDefOpDesc, as::OpDesc>(
+        *node_def, input_props, output_props);
+    auto cost = as::downcastRef<as::QuantitativeComputeCharacteristics>(
+        characterizer->characterize(op_desc));
+    // Unknown shapes give no quantitative estimate.
+    if (!cost) continue;
+    candidates.push_back(
+        {i, trigger_index, saved_bytes, cost_model.evaluateTime(cost)});
+  }
+
+  if (kept_bytes <= budget_bytes) {
+    ITEX_VLOG(1) << "Rematerialization: " << kept_bytes
+                 << " bytes of activations fit in the budget of "
+                 << budget_bytes << " bytes.";
+    return Status::OK();
+  }
+
+  // Most bytes saved per extra time first.
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const RematCandidate& a, const RematCandidate& b) {
+                     return a.saved_bytes * b.time > b.saved_bytes * a.time;
+                   });
+
+  // A selected node must keep reading its original inputs, so neither its
+  // inputs nor its consumers can be recomputed as well.
+  std::vector<bool> selected(num_nodes, false), pinned(num_nodes, false);
+  std::vector<const RematCandidate*> remat_nodes;
+  int64_t remaining_bytes = kept_bytes;
+  for (const auto& candidate : candidates) {
+    if (remaining_bytes <= budget_bytes) break;
+    const auto* node_view = graph_view.GetNode(candidate.node_index);
+    if (pinned[candidate.node_index]) continue;
+    bool has_selected_input = false;
+    for (const auto& fanin : node_view->GetRegularFanins()) {
+      has_selected_input |= selected[fanin.node_index()];
+    }
+    if (has_selected_input) continue;
+
+    selected[candidate.node_index] = true;
+    for (const auto& fanin : node_view->GetRegularFanins()) {
+      pinned[fanin.node_index()] = true;
+    }
+    remat_nodes.push_back(&candidate);
+    remaining_bytes -= candidate.saved_bytes;
+  }
+
+  // Clone the selected nodes and rewire their backward consumers.
+  utils::Mutation* mutation = graph_view.GetMutationBuilder();
+  std::vector<string> clone_names;
+  clone_names.reserve(remat_nodes.size());
+  float extra_time = 0;
+  for (const RematCandidate* candidate : remat_nodes) {
+    auto* node_view = graph_view.GetNode(candidate->node_index);
+    const NodeDef* node_def = node_view->node();
+    clone_names.push_back(strings::StrCat(node_def->name(), "/_remat"));
+    const string& clone_name = clone_names.back();
+    if (graph_view.HasNode(clone_name)) continue;
+
+    NodeDef clone = *node_def;
+    clone.set_name(clone_name);
+    clone.add_input(strings::StrCat(
+        "^", graph_view.GetNode(candidate->trigger_index)->GetName()));
+    mutation->AddNode(std::move(clone), &status);
+    TF_RETURN_IF_ERROR(status);
+
+    const auto& regular_fanouts = node_view->GetRegularFanouts();
+    for (int port = 0; port < static_cast<int>(regular_fanouts.size());
+         ++port) {
+      for (const auto& fanout : regular_fanouts[port]) {
+        if (!is_backward[fanout.node_index()]) continue;
+        mutation->AddOrUpdateRegularFanin(fanout.node_view(), fanout.index(),
+                                          {clone_name, port});
+      }
+    }
+    extra_time += candidate->time;
+    ITEX_VLOG(2) << "Rematerialization: recompute " << node_def->op() << " "
+                 << node_def->name() << " saving " << candidate->saved_bytes
+                 << " bytes.";
+  }
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  ITEX_LOG(INFO) << "Rematerialization: recompute " << remat_nodes.size()
+                 << " nodes on " << opt_ctx->device_name << ", activations "
+                 << kept_bytes << " -> " << remaining_bytes
+                 << " bytes (budget " << budget_bytes
+                 << "), estimated extra time " << extra_time * 1e6 << " us.";
+  if (remaining_bytes > budget_bytes) {
+    ITEX_LOG(WARNING) << "Rematerialization: not enough cheap nodes to fit "
+                      << "the activations in the memory budget.";
+  }
+
+  *optimized_graph = std::move(mutable_graph_def);
+  return Status::OK();
+}
+
+}  // namespace graph
+}  // namespace itex
@@ -0,0 +1,53 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_GRAPH_MEMORY_OPT_PASS_REMATERIALIZATION_H_
+#define ITEX_CORE_GRAPH_MEMORY_OPT_PASS_REMATERIALIZATION_H_
+
+#include "itex/core/graph/utils/grappler_item.h"
+#include "itex/core/graph/utils/utils.h"
+#include "itex/core/utils/status.h"
+#include "protos/graph.pb.h"
+
+namespace itex {
+namespace graph {
+
+// Activation rematerialization for training graphs.
+//
+// Forward tensors consumed by the backward pass (nodes under a "gradients" or
+// "gradient_tape" name scope) stay alive between the two passes. When their
+// total size exceeds `ITEX_REMAT_MEMORY_BUDGET_MB`, cheap forward nodes
+// (elementwise, activation and normalization ops, including the ones fused by
+// the remapper) are duplicated into the backward pass: the backward consumers
+// read the copy, which only runs once the backward pass reaches them, so the
+// forward output can be freed early. A node is only recomputed if all its
+// inputs are kept for the backward pass anyway, so recomputing never extends
+// the lifetime of another tensor. Nodes are picked by saved bytes per extra
+// time estimated with the XPUAutoShard analytic cost model, until the saved
+// activations fit in the budget.
+//
+// The pass is disabled when the budget is not set.
+Status RunRematerialization(OptimizerContext* opt_ctx, const GrapplerItem& item,
+                            const GraphDef& graph_def,
+                            GraphDef* optimized_graph);
+
+// Returns the memory budget in bytes set by `ITEX_REMAT_MEMORY_BUDGET_MB`, or
+// 0 if rematerialization is disabled.
+int64_t GetRematMemoryBudget();
+
+}  // namespace graph
+}  // namespace itex
+
+#endif  // ITEX_CORE_GRAPH_MEMORY_OPT_PASS_REMATERIALIZATION_H_
@@ -16,14 +16,20 @@ limitations under the License.
 #include "itex/core/graph/onednn_layout/onednn_layout.h"
 
 #include <cstring>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <unordered_map>
 #include <utility>
 
+#include "absl/strings/match.h"
 #include "google/protobuf/text_format.h"
 #include "itex/core/graph/utils/graph_properties.h"
 #include "itex/core/graph/utils/graph_view.h"
 #include "itex/core/graph/utils/op_types.h"
 #include "itex/core/graph/utils/utils.h"
 #include "itex/core/utils/attr_value_util.h"
+#include "itex/core/utils/env_var.h"
 #include "itex/core/utils/node_def_util.h"
 #include "itex/core/utils/onednn/onednn_post_op_util.h"
 #include "itex/core/utils/types.h"
@@ -774,26 +780,59 @@ Status MarkOneDnnGraphEndNode(OneDnnLayoutContext* ctx, const int node_index) {
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-//              Run function for the pass
+//              Rewrite nodes
 ///////////////////////////////////////////////////////////////////////////////
-Status RunOneDnnLayout(OptimizerContext* opt_ctx, const GrapplerItem& item,
-                       const GraphDef& graph_def, GraphDef* optimized_graph) {
-  Status status;
-  GraphDef multable_graph_def = graph_def;
-  OneDnnLayoutContext ctx(item, &multable_graph_def, &status);
+namespace {
+
+// Rewrites that are not optional: quantized ops and the rules rewriting
+// unconditionally, whose kernels may only exist in block layout.
+bool MustRewrite(const string& op_name, const RewriteInfo* ri) {
+  using RewriteRule = bool (*)(const utils::MutableNodeView&);
+  const RewriteRule* rule = ri->rewrite_rule.target<RewriteRule>();
+  return IsQuantizedOp(op_name) || (rule != nullptr && *rule == AlwaysRewrite);
+}
 
+// Ops whose oneDNN primitives pick a block layout for their activations, and
+// otherwise reorder them from and to plain layout.
+bool IsBlockedLayoutAnchor(const string& op_name) {
+  return absl::StrContains(op_name, "Conv") ||
+         absl::StrContains(op_name, "Pool") ||
+         absl::StrContains(op_name, "BatchNorm") ||
+         absl::StrContains(op_name, "InstanceNorm");
+}
+
+// Returns the size in bytes of output `port` of `node_name`, or -1 if it is not
+// statically known.
+int64_t GetOutputBytes(const RewrittenGraphProperties& properties,
+                       const string& node_name, int port) {
+  std::vector<OpInfo_TensorProperties> props;
+  if (!properties.GetOutputProperties(node_name, &props).ok() ||
+      port >= static_cast<int>(props.size())) {
+    return -1;
+  }
+  return GetTensorBytes(props[port]);
+}
+
+}  // namespace
+
+// Rewrites the nodes selected by the rewrite rules, except `skipped_nodes`.
+// If `rewritten_nodes` is not null, it maps the name of each rewritten node to
+// whether the rewrite is mandatory.
+void RewriteNodes(const OptimizerContext* opt_ctx, OneDnnLayoutContext* ctx,
+                  const std::unordered_set<string>& skipped_nodes,
+                  std::unordered_map<string, bool>* rewritten_nodes) {
   // Processing graph in reverse-topological sorted order allows to remap
   // longer chains of dependent ops in one pass.
   TF_ABORT_IF_ERROR(
-      ctx.graph_view.SortTopologically(/*ignore_cycles=*/false, {}));
+      ctx->graph_view.SortTopologically(/*ignore_cycles=*/false, {}));
 
   // Skip nodes that were invalidated
-  int num_nodes = multable_graph_def.node_size();
+  int num_nodes = ctx->graph_view.NumNodes();
 
   ITEX_VLOG(1) << "OneDnnLayoutPass: Start to rewrite nodes.";
 
   for (int node_index = 0; node_index < num_nodes; ++node_index) {
-    const auto* node_view = ctx.graph_view.GetNode(node_index);
+    const auto* node_view = ctx->graph_view.GetNode(node_index);
     const auto* node_def = node_view->node();
 
     // Check if node can run on current optimizer device.
@@ -808,7 +847,9 @@ Status RunOneDnnLayout(OptimizerContext* opt_ctx, const GrapplerItem& item,
     // Don't rewrite fetch node because layout will insert `OneDnnToTf` op
     // behind it and break the fetch node dependency.
     // TODO(itex): Rewrite fetch nodes if meeting performance regression.
-    if (ctx.nodes_to_preserve.count(node_def->name()) > 0) continue;
+    if (ctx->nodes_to_preserve.count(node_def->name()) > 0) continue;
+
+    if (skipped_nodes.count(node_def->name()) > 0) continue;
 
     const RewriteInfo* ri = nullptr;
     // We will first search if node is to be rewritten.
@@ -819,7 +860,10 @@ Status RunOneDnnLayout(OptimizerContext* opt_ctx, const GrapplerItem& item,
                    << " with OP " << op_name << " for rewrite using"
                    << " layout optimization.";
 
-      if (RewriteNode(&ctx, node_index, ri) == Status::OK()) {
+      if (RewriteNode(ctx, node_index, ri) == Status::OK()) {
+        if (rewritten_nodes != nullptr) {
+          (*rewritten_nodes)[node_name] = MustRewrite(op_name, ri);
+        }
         ITEX_VLOG(2) << "OneDnnLayoutPass: rewrote node " << node_name
                      << " with op " << op_name
                      << " for OneDNN layout optimization.";
@@ -829,6 +873,166 @@ Status RunOneDnnLayout(OptimizerContext* opt_ctx, const GrapplerItem& item,
       }
     }
   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//              Layout cost model
+///////////////////////////////////////////////////////////////////////////////
+// Selects the nodes to leave in plain layout.
+//
+// The rewrite rules are first run on a copy of the graph. The rewritten nodes
+// connected by data edges form layout regions, which are kept or left in plain
+// layout as a whole. In a region, a data edge between two block layout nodes
+// saves a reorder of the tensor for each of its endpoints that is an anchor
+// (see IsBlockedLayoutAnchor). A data edge from the region to a plain node
+// adds a `_OneDnnToTf` reorder of the tensor. A region is only kept if it
+// saves more bytes than it adds, or if it has a mandatory rewrite or a tensor
+// of unknown size.
+void PlanLayoutRegions(const OptimizerContext* opt_ctx,
+                       const GrapplerItem& item, const GraphDef& graph_def,
+                       OneDnnLayoutContext* ctx,
+                       const RewrittenGraphProperties& properties,
+                       std::unordered_set<string>* rejected_nodes,
+                       LayoutSummary* summary) {
+  Status status;
+  GraphDef trial_graph_def = graph_def;
+  OneDnnLayoutContext trial_ctx(item, &trial_graph_def, &status);
+  std::unordered_map<string, bool> rewritten_nodes;
+  RewriteNodes(opt_ctx, &trial_ctx, {}, &rewritten_nodes);
+
+  // Regions are found on the graph before rewrite, whose regular fanins are all
+  // data edges, by the names of the rewritten nodes.
+  const int num_nodes = ctx->graph_view.NumNodes();
+  std::vector<bool> rewritten(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    rewritten[i] =
+        rewritten_nodes.count(ctx->graph_view.GetNode(i)->GetName()) > 0;
+  }
+
+  // Union-find of the rewritten nodes.
+  std::vector<int> parent(num_nodes);
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find_root = [&parent](int i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+  for (int i = 0; i < num_nodes; ++i) {
+    if (!rewritten[i]) continue;
+    for (const auto& fanin : ctx->graph_view.GetNode(i)->GetRegularFanins()) {
+      if (rewritten[fanin.node_index()]) {
+        parent[find_root(fanin.node_index())] = find_root(i);
+      }
+    }
+  }
+
+  struct LayoutRegion {
+    std::vector<int> nodes;
+    int64_t saved_bytes = 0;
+    int64_t added_bytes = 0;
+    bool must_rewrite = false;
+    bool has_unknown_size = false;
+  };
+  std::map<int, LayoutRegion> regions;
+  for (int i = 0; i < num_nodes; ++i) {
+    const auto* node_view = ctx->graph_view.GetNode(i);
+    if (rewritten[i]) {
+      LayoutRegion& region = regions[find_root(i)];
+      region.nodes.push_back(i);
+      region.must_rewrite |= rewritten_nodes.at(node_view->GetName());
+    }
+
+    for (const auto& fanin : node_view->GetRegularFanins()) {
+      const int input_index = fanin.node_index();
+      if (!rewritten[input_index]) continue;
+      const auto* input_node_view = ctx->graph_view.GetNode(input_index);
+      LayoutRegion& region = regions[find_root(input_index)];
+      const int64_t bytes =
+          GetOutputBytes(properties, input_node_view->GetName(), fanin.index());
+      if (bytes < 0) {
+        region.has_unknown_size = true;
+      } else if (rewritten[i]) {
+        const int num_anchors =
+            IsBlockedLayoutAnchor(input_node_view->GetOp()) +
+            IsBlockedLayoutAnchor(node_view->GetOp());
+        region.saved_bytes += num_anchors * bytes;
+      } else {
+        region.added_bytes += bytes;
+      }
+    }
+  }
+
+  for (const auto& [root, region] : regions) {
+    ++summary->num_regions;
+    if (region.must_rewrite || region.has_unknown_size ||
+        region.saved_bytes > region.added_bytes) {
+      continue;
+    }
+    ++summary->num_rejected_regions;
+    summary->num_rejected_nodes += region.nodes.size();
+    for (int i : region.nodes) {
+      rejected_nodes->insert(ctx->graph_view.GetNode(i)->GetName());
+    }
+    ITEX_VLOG(2) << "OneDnnLayoutPass: leave the " << region.nodes.size()
+                 << " nodes of the region of "
+                 << ctx->graph_view.GetNode(root)->GetName()
+                 << " in plain layout, saving " << region.saved_bytes
+                 << " reorder bytes but adding " << region.added_bytes << ".";
+  }
+}
+
+// Counts the `_OneDnnToTf` conversions of the rewritten `graph_def`. They read
+// the data output of a rewritten node, which keeps its name and port.
+void CountReorders(const GraphDef& graph_def,
+                   const RewrittenGraphProperties& properties,
+                   LayoutSummary* summary) {
+  for (const NodeDef& node_def : graph_def.node()) {
+    if (node_def.op() != "_OneDnnToTf") continue;
+    ++summary->num_reorders;
+    TensorId input = ParseTensorName(node_def.input(0));
+    const int64_t bytes =
+        GetOutputBytes(properties, string(input.node()), input.index());
+    if (bytes < 0) {
+      ++summary->num_unknown_reorders;
+    } else {
+      summary->reorder_bytes += bytes;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//              Run function for the pass
+///////////////////////////////////////////////////////////////////////////////
+Status RunOneDnnLayout(OptimizerContext* opt_ctx, const GrapplerItem& item,
+                       const GraphDef& graph_def, GraphDef* optimized_graph) {
+  Status status;
+  GraphDef multable_graph_def = graph_def;
+  OneDnnLayoutContext ctx(item, &multable_graph_def, &status);
+
+  bool enable_cost_model;
+  ITEX_CHECK_OK(ReadBoolFromEnvVar("ITEX_LAYOUT_COST_MODEL", false,
+                                   &enable_cost_model));
+  std::unique_ptr<RewrittenGraphProperties> properties;
+  std::unordered_set<string> rejected_nodes;
+  LayoutSummary summary;
+  if (enable_cost_model) {
+    properties = std::make_unique<RewrittenGraphProperties>(item, graph_def);
+    Status s = properties->InferStatically(
+        /*assume_valid_feeds=*/true, /*aggressive_shape_inference=*/false,
+        /*include_tensor_values=*/false);
+    if (s.ok()) {
+      PlanLayoutRegions(opt_ctx, item, graph_def, &ctx, *properties,
+                        &rejected_nodes, &summary);
+    } else {
+      ITEX_LOG(WARNING) << "OneDnnLayoutPass: shape inference failed, the "
+                        << "layout cost model is disabled: " << s;
+      properties.reset();
+    }
+  }
+
+  RewriteNodes(opt_ctx, &ctx, rejected_nodes, /*rewritten_nodes=*/nullptr);
 
 #define RUN_LAYOUT_FUNC(ctx, func)                                      \
   do {                                                                  \
@@ -850,6 +1054,18 @@ Status RunOneDnnLayout(OptimizerContext* opt_ctx, const GrapplerItem& item,
 
 #undef RUN_LAYOUT_FUNC
 
+  if (properties != nullptr) {
+    CountReorders(*ctx.graph_view.graph(), *properties, &summary);
+    ITEX_VLOG(1) << "OneDnnLayoutPass: kept "
+                 << summary.num_regions - summary.num_rejected_regions << " of "
+                 << summary.num_regions << " layout regions ("
+                 << summary.num_rejected_nodes << " nodes left in plain "
+                 << "layout), inserted " << summary.num_reorders
+                 << " reorders of " << summary.reorder_bytes << " bytes, "
+                 << summary.num_unknown_reorders << " of unknown size.";
+    opt_ctx->layout_summaries.push_back(summary);
+  }
+
   *optimized_graph = std::move(multable_graph_def);
   return Status::OK();
 }
@@ -69,6 +69,11 @@ const RewriteInfo* CheckForNodeRewrite(const utils::MutableNodeView& node_view);
 Status RewriteNode(const char* device_name, OneDnnLayoutContext* ctx,
                    int node_index, const RewriteInfo* ri);
 
+// Rewrites the supported nodes to oneDNN block layout ops and inserts the
+// conversions to plain layout. With `ITEX_LAYOUT_COST_MODEL`, connected
+// rewritten nodes whose reorders are estimated to cost more than they save
+// are left in plain layout, and the inserted reorders are summarized in
+// `opt_ctx->layout_summaries`.
 Status RunOneDnnLayout(OptimizerContext* opt_ctx, const GrapplerItem& item,
                        const GraphDef& graph_def, GraphDef* optimized_graph);
 
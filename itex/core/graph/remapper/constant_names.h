@@ -89,6 +89,7 @@ constexpr char kConv3DBackpropFilterWithBias[] =
 constexpr char kConv3DBackpropInputWithSlice[] =
     "_ITEXConv3DBackpropInputV2WithSlice";
 constexpr char kDequantizeReshape[] = "_ITEXFusedDequantizeWithReshape";
+constexpr char kDynamicQuantizedMatMul[] = "_ITEXDynamicQuantizedMatMul";
 constexpr char kFusedAccMatMul[] = "_ITEXFusedAccMatMul";
 constexpr char kFusedAccMatMulGrad[] = "_ITEXFusedAccMatMulGrad";
 constexpr char kFusedAccMatMulWithSum[] = "_ITEXFusedAccMatMulWithSum";
@@ -96,11 +97,14 @@ constexpr char kFusedApplyAdam[] = "_ITEXFusedApplyAdam";
 constexpr char kFusedApplyAdamWithWeightDecay[] =
     "_ITEXFusedApplyAdamWithWeightDecay";
 constexpr char kFusedAddN[] = "_ITEXFusedAddN";
+constexpr char kFusedAddGroupNorm[] = "_ITEXFusedAddGroupNorm";
+constexpr char kFusedAddRMSNorm[] = "_ITEXFusedAddRMSNorm";
 constexpr char kFusedApplyMomentum[] = "_ITEXFusedApplyMomentum";
 constexpr char kFusedBatchMatMul[] = "_ITEXFusedBatchMatMulV2";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
 constexpr char kFusedBatchNormGradEx[] = "_ITEXFusedBatchNormGradEx";
 constexpr char kFusedBinary[] = "_ITEXFusedBinary";
+constexpr char kFusedElementwise[] = "_ITEXFusedElementwise";
 constexpr char kFusedConv2D[] = "_ITEXFusedConv2D";
 constexpr char kFusedConv2DWithSum[] = "_ITEXFusedConv2DWithSum";
 constexpr char kFusedConv3D[] = "_ITEXFusedConv3D";
@@ -109,6 +113,7 @@ constexpr char kFusedDepthwiseConv2dNative[] =
 constexpr char kFusedMatMul[] = "_ITEXFusedMatMul";
 constexpr char kFusedMatMulWithSum[] = "_ITEXFusedMatMulWithSum";
 constexpr char kFusedMatMulGrad[] = "_ITEXFusedMatMulGrad";
+constexpr char kFusedMLP[] = "_ITEXFusedMLP";
 constexpr char kFusedInstanceNorm[] = "_ITEXFusedInstanceNorm";
 constexpr char kFusedRandom[] = "_ITEXFusedRandom";
 constexpr char kFusedResourceApplyAdam[] = "_ITEXFusedResourceApplyAdam";
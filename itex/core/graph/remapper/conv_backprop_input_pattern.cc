@@ -26,6 +26,7 @@ namespace graph {
 class PadWithConvBackpropFilterFusion : public Fusion {
  public:
   PadWithConvBackpropFilterFusion() : Fusion() {
+    is_advanced_only_ = true;
     using utils::NodeStatus;
     using utils::OpTypePattern;
 
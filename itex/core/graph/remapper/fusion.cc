@@ -89,6 +89,23 @@ std::vector<Fusion*>& FusionMgr::GetFusions(const std::string& key) {
   return empty_vector;
 }
 
+bool FusionMgr::HasAdvancedOnlyFusion(const std::string& key) {
+  for (const auto* fusion : GetFusions(key)) {
+    if (fusion->IsAdvancedOnly()) return true;
+  }
+  return false;
+}
+
+int FusionMgr::MaxNumNodes() const {
+  int max_num_nodes = 0;
+  for (const auto& [key, fusions] : map_) {
+    for (const auto* fusion : fusions) {
+      max_num_nodes = std::max(max_num_nodes, fusion->NumNodes());
+    }
+  }
+  return max_num_nodes;
+}
+
 MatchedProperties FillProperties(utils::MutableGraphView* graph_view,
                                  utils::MutableNodeView* node_view,
                                  const Fusion::InternalPattern& pattern,
@@ -135,6 +152,7 @@ Status LaunchPatternMatcher(RemapperContext* ctx, int index,
     auto properties = fusion->Check(ctx, index);
     if (!properties.Empty()) {
       Status status = fusion->Update(ctx, properties);
+      if (status.ok()) ctx->fusion_match_counts[fusion->Name()]++;
 
       for (auto const& index : properties.invalidated) {
         invalidated->at(index) = true;
@@ -107,11 +107,16 @@ class Fusion {
 
   inline bool IsPartial() const { return is_partial_; }
 
+  inline bool IsAdvancedOnly() const { return is_advanced_only_; }
+
  protected:
   InternalPattern pattern_;
 
   // Set it as true only if need this fusion before oneDNN Graph.
   bool is_partial_ = false;
+
+  // Set it as true if this fusion only matches in non-BASIC remapper levels.
+  bool is_advanced_only_ = false;
 };
 
 class FusionMgr {
@@ -133,6 +138,13 @@ class FusionMgr {
   // Based on the node op, get all relevant fusions.
   std::vector<Fusion*>& GetFusions(const std::string& key);
 
+  // Whether any fusion may match at a node of op `key` only in non-BASIC
+  // remapper levels.
+  bool HasAdvancedOnlyFusion(const std::string& key);
+
+  // The nodes number of the largest registered pattern.
+  int MaxNumNodes() const;
+
  private:
   FusionMgr() {}
 
@@ -23,6 +23,7 @@ limitations under the License.
 #include "itex/core/graph/utils/symbolic_shapes.h"
 #include "itex/core/graph/utils/utils.h"
 #include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/strcat.h"
 
 namespace itex {
 namespace graph {
@@ -346,8 +347,174 @@ class MHAPatternWithMulAndAdd : public Fusion {
   }
 };
 
+// Rewrites the concat-based KV cache idiom of autoregressive decoding
+//   key = ConcatV2(past_key, new_key, axis=2)
+//   value = ConcatV2(past_value, new_value, axis=2)
+//   output = ScaledDotProductAttentionInference(query, key, value, mask)
+// into ScaledDotProductAttentionKVCacheInference, which appends the new step
+// into the cache and attends to it without separate concat kernels. The
+// ConcatV2 nodes become Identity of the updated caches, so consumers of the
+// present key/value are unchanged.
+class MHAPatternWithKVCacheConcat : public Fusion {
+ public:
+  MHAPatternWithKVCacheConcat() : Fusion() {
+    using utils::NodeStatus;
+    using utils::OpTypePattern;
+
+    OpTypePattern query = {kAny, "query", NodeStatus::kRemain};
+    OpTypePattern past_key = {kAny, "past_key", NodeStatus::kRemain};
+    OpTypePattern key = {kAny, "key", NodeStatus::kRemain};
+    OpTypePattern key_axis = {kConst, "key_axis", NodeStatus::kRemain};
+    OpTypePattern key_concat = {kConcatV2, "key_concat", NodeStatus::kReplace};
+    OpTypePattern past_value = {kAny, "past_value", NodeStatus::kRemain};
+    OpTypePattern value = {kAny, "value", NodeStatus::kRemain};
+    OpTypePattern value_axis = {kConst, "value_axis", NodeStatus::kRemain};
+    OpTypePattern value_concat = {kConcatV2, "value_concat",
+                                  NodeStatus::kReplace};
+    OpTypePattern mask = {kAny, "mask", NodeStatus::kRemain};
+    OpTypePattern output = {"ScaledDotProductAttentionInference", "output",
+                            NodeStatus::kReplace};
+
+    key_concat.AddInput(past_key).AddInput(key).AddInput(key_axis);
+    value_concat.AddInput(past_value).AddInput(value).AddInput(value_axis);
+    output.AddInput(query)
+        .AddInput(key_concat)
+        .AddInput(value_concat)
+        .AddInput(mask);
+
+    pattern_ = InternalPattern(std::move(output));
+  }
+
+  ~MHAPatternWithKVCacheConcat() {}
+
+  std::string Name() override { return "mha_pattern_with_kv_cache_concat"; }
+
+  MatchedProperties Check(RemapperContext* ctx,
+                          const int node_index) const override {
+    auto& graph_view = ctx->graph_view;
+
+    MatchedProperties ret = FillProperties(
+        &graph_view, graph_view.GetNode(node_index), pattern_, false);
+
+    bool is_ok = !ret.Empty() && CheckShapes(ctx, ret);
+
+    if (!is_ok) return ret.ToEmpty();
+
+    return ret;
+  }
+
+  bool CheckShapes(RemapperContext* ctx,
+                   const MatchedProperties& properties) const {
+    NodeDef* output =
+        ctx->graph_view.GetNode(properties.map.at("output"))->node();
+    // Only the CPU kernel supports the KV cache mode.
+    if (!NodeIsOnCpu(output)) return false;
+
+    const auto check_concat = [&](const string& concat, const string& axis) {
+      NodeDef* concat_node =
+          ctx->graph_view.GetNode(properties.map.at(concat))->node();
+      std::vector<OpInfo_TensorProperties> props;
+      TF_ABORT_IF_ERROR(ctx->graph_properties.GetInputProperties(
+          concat_node->name(), &props));
+      if (props.size() != 3) return false;
+      for (int i = 0; i < 2; ++i) {
+        if (props[i].shape().unknown_rank() ||
+            props[i].shape().dim_size() != 4) {
+          return false;
+        }
+      }
+
+      NodeDef* axis_node =
+          ctx->graph_view.GetNode(properties.map.at(axis))->node();
+      Tensor axis_t;
+      if (!axis_t.FromProto(axis_node->attr().at("value").tensor()) ||
+          axis_t.NumElements() != 1) {
+        return false;
+      }
+      int64_t axis_value = axis_t.dtype() == DT_INT64
+                               ? axis_t.flat<int64>()(0)
+                               : axis_t.flat<int32>()(0);
+      // Concat must be on the sequence axis of [B, H, S, D].
+      return axis_value == 2 || axis_value == -2;
+    };
+
+    return check_concat("key_concat", "key_axis") &&
+           check_concat("value_concat", "value_axis");
+  }
+
+  Status Update(RemapperContext* ctx /** in and out **/,
+                const MatchedProperties& properties) const override {
+    auto* output = ctx->graph_view.GetNode(properties.map.at("output"))->node();
+    auto* key_concat =
+        ctx->graph_view.GetNode(properties.map.at("key_concat"))->node();
+    auto* value_concat =
+        ctx->graph_view.GetNode(properties.map.at("value_concat"))->node();
+
+    Status status;
+    utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+
+    // A negative cache length means the whole past cache is valid, the kernel
+    // then grows the cache with the same result as ConcatV2. The past cache of
+    // this idiom never has spare rows, so it can't be updated in place, unlike
+    // the preallocated caches of scaled_dot_product_attention_kv_cache.
+    NodeDef cache_len_node;
+    string cache_len_name = output->name() + "/cache_len";
+    cache_len_node.set_name(cache_len_name);
+    cache_len_node.set_op(kConst);
+    cache_len_node.set_device(output->device());
+    auto* cache_len_attr = cache_len_node.mutable_attr();
+    SetAttrValue(DT_INT32, &(*cache_len_attr)["dtype"]);
+    Tensor cache_len_t(DT_INT32, TensorShape({}));
+    cache_len_t.scalar<int32>()() = -1;
+    cache_len_t.AsProtoTensorContent(
+        (*cache_len_attr)["value"].mutable_tensor());
+    mutation->AddNode(std::move(cache_len_node), &status);
+    TF_RETURN_IF_ERROR(status);
+
+    NodeDef fused_node;
+    fused_node.set_name(output->name());
+    fused_node.set_op("ScaledDotProductAttentionKVCacheInference");
+    fused_node.set_device(output->device());
+    fused_node.add_input(output->input(0));
+    fused_node.add_input(key_concat->input(1));
+    fused_node.add_input(value_concat->input(1));
+    fused_node.add_input(key_concat->input(0));
+    fused_node.add_input(value_concat->input(0));
+    fused_node.add_input(cache_len_name);
+    fused_node.add_input(output->input(3));
+
+    auto* attr = fused_node.mutable_attr();
+    auto& src_attr = output->attr();
+    (*attr)["T"] = src_attr.at("T");
+    (*attr)["use_mask"] = src_attr.at("use_mask");
+    (*attr)["use_causal"] = src_attr.at("use_causal");
+
+    const auto make_identity = [&](const NodeDef* concat, int port) {
+      NodeDef identity_op;
+      identity_op.set_op("Identity");
+      identity_op.set_name(concat->name());
+      identity_op.set_device(concat->device());
+      identity_op.add_input(strings::StrCat(output->name(), ":", port));
+      (*identity_op.mutable_attr())["T"] = src_attr.at("T");
+      return identity_op;
+    };
+    NodeDef key_identity = make_identity(key_concat, 1);
+    NodeDef value_identity = make_identity(value_concat, 2);
+
+    mutation->AddNode(std::move(fused_node), &status);
+    TF_RETURN_IF_ERROR(status);
+    mutation->AddNode(std::move(key_identity), &status);
+    TF_RETURN_IF_ERROR(status);
+    mutation->AddNode(std::move(value_identity), &status);
+    TF_RETURN_IF_ERROR(status);
+    TF_RETURN_IF_ERROR(mutation->Apply());
+    return Status::OK();
+  }
+};
+
 REGISTER_FUSION(MHAPatternWithMulAndAdd)
 REGISTER_FUSION(MHAFusionWithReshapeMatmul)
+REGISTER_FUSION(MHAPatternWithKVCacheConcat)
 
 }  // namespace graph
 }  // namespace itex
@@ -21,6 +21,7 @@ limitations under the License.
 #include <queue>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -35,6 +36,10 @@ limitations under the License.
 #include "itex/core/graph/utils/op_types.h"
 #include "itex/core/graph/utils/pattern_utils.h"
 #include "itex/core/graph/utils/symbolic_shapes.h"
+#include "itex/core/utils/attr_value_util.h"
+#include "itex/core/utils/env_var.h"
+#include "itex/core/utils/hash.h"
+#include "itex/core/utils/numa_thread_pool.h"
 #include "itex/core/utils/op_kernel.h"
 
 namespace itex {
@@ -472,6 +477,15 @@ struct FusedBinary {
   int num_ = kMissingIndex;
 };
 
+// Chain of elementwise ops, `nodes_` is ordered from the root (last op of the
+// chain) to the first op, `acc_ports_` is the input port of each node fed by
+// the previous op of the chain.
+struct FusedElementwise {
+  FusedElementwise() = default;
+  std::vector<int> nodes_;
+  std::vector<int> acc_ports_;
+};
+
 struct Dropout {
   Dropout() = default;
 
@@ -491,6 +505,41 @@ struct AddV2WithSoftmax {
   int softmaxIndex_ = kMissingIndex;
 };
 
+// Residual Add feeding ItexRmsNorm or ITEXGroupNorm.
+struct AddWithNorm {
+  AddWithNorm() = default;
+  AddWithNorm(int add, int norm) : add_(add), norm_(norm) {}
+
+  int add_ = kMissingIndex;
+  int norm_ = kMissingIndex;
+};
+
+// Feed-forward block of a transformer on CPU, see _ITEXFusedMLP:
+//   down(act(up(x))) or down(act(gate(x)) * up(x))
+// `up_`, `gate_` and `down_` are MatMul or _ITEXFusedMatMul nodes.
+// `activation_node_` is the activation op when it isn't fused into the
+// activated projection, and `mul_` the Mul of gated MLPs.
+struct FusedMLP {
+  FusedMLP() = default;
+
+  int up_ = kMissingIndex;
+  int gate_ = kMissingIndex;
+  int down_ = kMissingIndex;
+  int activation_node_ = kMissingIndex;
+  int mul_ = kMissingIndex;
+  string activation_;
+};
+
+// fp32 MatMul, MatMul + BiasAdd or BatchMatMulV2 with a constant 2D weight,
+// computed in INT8 by _ITEXDynamicQuantizedMatMul.
+struct DynamicQuantizedMatMul {
+  DynamicQuantizedMatMul() = default;
+
+  int contraction_ = kMissingIndex;
+  bool transpose_b_ = false;
+  bool has_bias_ = false;
+};
+
 struct GroupConv2DBlock {
   GroupConv2DBlock() = default;
   GroupConv2DBlock(int inputSplitIndex, std::vector<int> convIndexs,
@@ -2184,6 +2233,222 @@ bool FindAddV2WithSoftmax(const RemapperContext& ctx, int node_index,
   return true;
 }
 
+// Find Add + ItexRmsNorm/ITEXGroupNorm on CPU, where both inputs of the Add
+// have the same shape. The Add may have other consumers, e.g. the residual
+// stream of a transformer, they read the sum computed by the fused op.
+bool FindAddWithNorm(const RemapperContext& ctx, int node_index,
+                     AddWithNorm* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (node_def->op() != "ItexRmsNorm" && node_def->op() != "ITEXGroupNorm")
+    return false;
+  if (!NodeIsOnCpu(node_def) || HasControlFaninOrFanout(*node_view))
+    return false;
+
+  const auto* add_node_view = node_view->GetRegularFanin(0).node_view();
+  const auto* add_node_def = add_node_view->node();
+  if (!IsAdd(*add_node_def) || HasControlFaninOrFanout(*add_node_view) ||
+      add_node_def->device() != node_def->device())
+    return false;
+
+  std::vector<OpInfo_TensorProperties> props;
+  TF_ABORT_IF_ERROR(
+      ctx.graph_properties.GetInputProperties(add_node_def->name(), &props));
+  if (props.size() != 2 || props[0].shape().unknown_rank() ||
+      !ShapesSymbolicallyEqual(props[0].shape(), props[1].shape()))
+    return false;
+
+  *matched = AddWithNorm(add_node_view->node_index(), node_view->node_index());
+  return true;
+}
+
+// Returns true if `node_view` is a 2D matmul that _ITEXFusedMLP can compute,
+// i.e. a MatMul or an _ITEXFusedMatMul with BiasAdd and optionally one
+// activation. `activation` is set to the fused activation, or empty.
+bool IsMLPProjection(const RemapperContext& ctx,
+                     const utils::MutableNodeView& node_view,
+                     string* activation) {
+  const auto* node_def = node_view.node();
+  if (!NodeIsOnCpu(node_def) || HasControlFaninOrFanout(node_view) ||
+      IsInPreserveSet(ctx, node_def) ||
+      (!HasDataType(node_def, DT_FLOAT) && !HasDataType(node_def, DT_BFLOAT16)))
+    return false;
+
+  bool transpose_a = false, transpose_b = false;
+  TryGetNodeAttr(*node_def, "transpose_a", &transpose_a);
+  TryGetNodeAttr(*node_def, "transpose_b", &transpose_b);
+  if (transpose_a || transpose_b) return false;
+
+  activation->clear();
+  if (IsMatMul(*node_def)) return true;
+  if (node_def->op() != kFusedMatMul) return false;
+
+  std::vector<string> fused_ops;
+  if (!TryGetNodeAttr(*node_def, "fused_ops", &fused_ops) ||
+      fused_ops.empty() || fused_ops.size() > 2 || fused_ops[0] != "BiasAdd")
+    return false;
+  if (fused_ops.size() == 1) return true;
+  if (fused_ops[1] == "GeluExact" || fused_ops[1] == "GeluApproximate" ||
+      fused_ops[1] == "Relu") {
+    *activation = fused_ops[1];
+  } else if (fused_ops[1] == kSwish) {
+    *activation = "Silu";
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Returns the _ITEXFusedMLP activation computed by a standalone `node_def`,
+// or empty if it isn't supported.
+string GetMLPActivation(const NodeDef& node_def) {
+  if (IsGelu(node_def)) {
+    bool approximate = false;
+    TryGetNodeAttr(node_def, "approximate", &approximate);
+    return approximate ? "GeluApproximate" : "GeluExact";
+  }
+  if (IsRelu(node_def)) return "Relu";
+  if (node_def.op() == kSwish) {
+    float alpha = 1.0f;
+    TryGetNodeAttr(node_def, "alpha", &alpha);
+    if (alpha == 1.0f) return "Silu";
+  }
+  return "";
+}
+
+// Matches act(x @ w + b), where the activation is either fused into the
+// projection or a standalone op whose only input is the projection.
+bool FindMLPActivatedProjection(const RemapperContext& ctx,
+                                const utils::MutableNodeView& node_view,
+                                FusedMLP* matched) {
+  if (IsMLPProjection(ctx, node_view, &matched->activation_) &&
+      !matched->activation_.empty()) {
+    matched->gate_ = node_view.node_index();
+    matched->activation_node_ = kMissingIndex;
+    return true;
+  }
+
+  const auto* node_def = node_view.node();
+  string activation = GetMLPActivation(*node_def);
+  if (activation.empty() || node_view.NumRegularFanins() != 1 ||
+      HasControlFaninOrFanout(node_view) || IsInPreserveSet(ctx, node_def))
+    return false;
+  const auto* projection = node_view.GetRegularFanin(0).node_view();
+  string fused_activation;
+  if (!IsMLPProjection(ctx, *projection, &fused_activation) ||
+      !fused_activation.empty() || !HasAtMostOneFanoutAtPort0(*projection) ||
+      projection->NumRegularFanouts() != 1)
+    return false;
+  matched->gate_ = projection->node_index();
+  matched->activation_node_ = node_view.node_index();
+  matched->activation_ = activation;
+  return true;
+}
+
+// Find the feed-forward block of a transformer on CPU, rooted at the down
+// projection. The intermediate nodes must have no other consumers. The
+// activated projection is first recorded as `gate_`, and moved to `up_` for
+// MLPs without gate.
+bool FindFusedMLP(const RemapperContext& ctx, int node_index,
+                  FusedMLP* matched) {
+  const auto* down_view = ctx.graph_view.GetNode(node_index);
+  string activation;
+  if (!IsMLPProjection(ctx, *down_view, &activation) || !activation.empty())
+    return false;
+  const auto* down_def = down_view->node();
+
+  const auto* hidden_view = down_view->GetRegularFanin(0).node_view();
+  const auto* hidden_def = hidden_view->node();
+  if (!HasAtMostOneFanoutAtPort0(*hidden_view) ||
+      hidden_view->NumRegularFanouts() != 1 ||
+      hidden_def->device() != down_def->device())
+    return false;
+
+  FusedMLP pattern;
+  pattern.down_ = node_index;
+  if (IsMul(*hidden_def) && hidden_view->NumRegularFanins() == 2 &&
+      !HasControlFaninOrFanout(*hidden_view) &&
+      !IsInPreserveSet(ctx, hidden_def)) {
+    // Gated: act(x @ w_gate) * (x @ w_up), in any order.
+    for (int port = 0; port < 2; ++port) {
+      const auto* act_view = hidden_view->GetRegularFanin(port).node_view();
+      const auto* up_view = hidden_view->GetRegularFanin(1 - port).node_view();
+      if (!FindMLPActivatedProjection(ctx, *act_view, &pattern) ||
+          !IsMLPProjection(ctx, *up_view, &activation) || !activation.empty() ||
+          act_view->NumRegularFanouts() != 1 ||
+          up_view->NumRegularFanouts() != 1)
+        continue;
+      const auto* gate_def = ctx.graph_view.GetNode(pattern.gate_)->node();
+      const auto* up_def = up_view->node();
+      if (gate_def->input(0) != up_def->input(0)) continue;
+      pattern.up_ = up_view->node_index();
+      pattern.mul_ = hidden_view->node_index();
+      break;
+    }
+    if (pattern.up_ == kMissingIndex) return false;
+  } else {
+    if (!FindMLPActivatedProjection(ctx, *hidden_view, &pattern)) return false;
+    const auto* up_view = ctx.graph_view.GetNode(pattern.gate_);
+    if (up_view->NumRegularFanouts() != 1) return false;
+    pattern.up_ = pattern.gate_;
+    pattern.gate_ = kMissingIndex;
+  }
+
+  // All the nodes compute the same type on the same device.
+  for (int index : {pattern.up_, pattern.gate_, pattern.activation_node_,
+                    pattern.mul_}) {
+    if (index == kMissingIndex) continue;
+    const auto* node_def = ctx.graph_view.GetNode(index)->node();
+    if (!HaveSameDataType(node_def, down_def) ||
+        node_def->device() != down_def->device())
+      return false;
+  }
+
+  *matched = pattern;
+  return true;
+}
+
+// Find an fp32 contraction on CPU whose weight is a constant matrix, so it can
+// be quantized once while the activation is quantized on every run.
+bool FindDynamicQuantizedMatMul(const RemapperContext& ctx, int node_index,
+                                DynamicQuantizedMatMul* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (!NodeIsOnCpu(node_def) || !HasDataType(node_def, DT_FLOAT) ||
+      HasControlFaninOrFanout(*node_view) || IsInPreserveSet(ctx, node_def))
+    return false;
+
+  DynamicQuantizedMatMul pattern;
+  bool transpose_a = false;
+  if (IsMatMul(*node_def) || node_def->op() == kFusedMatMul) {
+    TryGetNodeAttr(*node_def, "transpose_a", &transpose_a);
+    TryGetNodeAttr(*node_def, "transpose_b", &pattern.transpose_b_);
+  } else if (node_def->op() == "BatchMatMulV2") {
+    TryGetNodeAttr(*node_def, "adj_x", &transpose_a);
+    TryGetNodeAttr(*node_def, "adj_y", &pattern.transpose_b_);
+  } else {
+    return false;
+  }
+  if (transpose_a) return false;
+
+  if (node_def->op() == kFusedMatMul) {
+    std::vector<string> fused_ops;
+    if (!TryGetNodeAttr(*node_def, "fused_ops", &fused_ops) ||
+        fused_ops.size() != 1 || fused_ops[0] != "BiasAdd")
+      return false;
+    pattern.has_bias_ = true;
+  }
+
+  const auto* weight_def = node_view->GetRegularFanin(1).node_view()->node();
+  if (!IsConstant(*weight_def) || !HasDataType(weight_def, DT_FLOAT, "dtype") ||
+      GetTensorShapeFromConstant(weight_def).dims() != 2)
+    return false;
+
+  pattern.contraction_ = node_index;
+  *matched = pattern;
+  return true;
+}
+
 bool FindQuantizedConv2DWithDequantize(const RemapperContext& ctx,
                                        int node_index,
                                        QuantizedConv2DWithDequantize* matched) {
@@ -3326,6 +3591,120 @@ bool FindFusedBinary(const RemapperContext& ctx, int node_index,
   return matched->num_ > 1;
 }
 
+// Returns true iff `node_def` can be evaluated by _ITEXFusedElementwise.
+// The fused op is on the auto mixed precision infer list, so ops of the deny
+// list (e.g. Exp, which overflows in fp16) must stay out of the chain.
+bool IsFusibleElementwise(const NodeDef& node_def) {
+  if (!HasDataType(&node_def, DT_FLOAT) &&
+      !HasDataType(&node_def, DT_BFLOAT16) && !HasDataType(&node_def, DT_HALF))
+    return false;
+
+  if (IsBiasAdd(node_def)) {
+    // The bias is broadcast along the last dimension only.
+    string data_format;
+    return !GetNodeAttr(node_def, kDataFormat, &data_format).ok() ||
+           data_format == "NHWC";
+  }
+  const string& op = node_def.op();
+  return IsGelu(node_def) || op == "Add" || op == "AddV2" || op == "Sub" ||
+         op == "Mul" || op == "RealDiv" || op == "Maximum" ||
+         op == "Minimum" || op == "Elu" || op == "LeakyRelu" || op == "Neg" ||
+         op == "Relu" || op == "Relu6" || op == "Rsqrt" || op == "Sigmoid" ||
+         op == "Sqrt" || op == "Square" || op == "Tanh";
+}
+
+// Find a chain of elementwise ops whose other operands are the full tensor, a
+// scalar or a vector broadcast along the last dimension.
+bool FindFusedElementwise(const RemapperContext& ctx, int node_index,
+                          FusedElementwise* matched) {
+  // Upper bound of ops fused into one node.
+  constexpr int kMaxChainLength = 16;
+
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+
+  if (!NodeIsOnCpu(node_def) || HasControlFanin(*node_view) ||
+      !IsFusibleElementwise(*node_def))
+    return false;
+
+  std::vector<OpInfo_TensorProperties> output_props;
+  TF_ABORT_IF_ERROR(ctx.graph_properties.GetOutputProperties(node_def->name(),
+                                                             &output_props));
+  if (output_props.empty() || output_props[0].shape().unknown_rank()) {
+    return false;
+  }
+  const TensorShapeProto& output_shape = output_props[0].shape();
+  const int64_t last_dim =
+      output_shape.dim_size() > 0
+          ? output_shape.dim(output_shape.dim_size() - 1).size()
+          : 1;
+
+  // Returns the port of the accumulator of a binary op, i.e. the input with
+  // the output shape, or -1 if the other input can't be broadcast by the
+  // kernel. Prefers the input produced by a fusible op.
+  const auto get_acc_port = [&](const utils::MutableNodeView& binary) -> int {
+    std::vector<OpInfo_TensorProperties> props;
+    TF_ABORT_IF_ERROR(ctx.graph_properties.GetInputProperties(
+        binary.node()->name(), &props));
+    if (props.size() != 2) return -1;
+
+    const auto is_full = [&](const TensorShapeProto& shape) {
+      return ShapesSymbolicallyEqual(shape, output_shape);
+    };
+    const auto is_broadcast = [&](const TensorShapeProto& shape) {
+      if (is_full(shape)) return true;
+      if (shape.unknown_rank()) return false;
+      if (Rank(shape) == 0) return true;
+      return Rank(shape) == 1 && last_dim > 0 &&
+             shape.dim(0).size() == last_dim;
+    };
+
+    int acc_port = -1;
+    for (int port = 0; port < 2; ++port) {
+      if (!is_full(props[port].shape()) ||
+          !is_broadcast(props[1 - port].shape()))
+        continue;
+      const auto* input_def = binary.GetRegularFanin(port).node_view()->node();
+      if (IsFusibleElementwise(*input_def)) return port;
+      if (acc_port == -1) acc_port = port;
+    }
+    return acc_port;
+  };
+
+  // Walk up the chain through single-consumer elementwise ops.
+  while (static_cast<int>(matched->nodes_.size()) < kMaxChainLength) {
+    const auto* current_def = node_view->node();
+    int acc_port = 0;
+    if (node_view->NumRegularFanins() == 2) {
+      acc_port = get_acc_port(*node_view);
+      if (acc_port < 0) break;
+    } else if (node_view->NumRegularFanins() != 1) {
+      break;
+    }
+    matched->nodes_.push_back(node_view->node_index());
+    matched->acc_ports_.push_back(acc_port);
+
+    const auto* input_node_view =
+        node_view->GetRegularFanin(acc_port).node_view();
+    const auto* input_node_def = input_node_view->node();
+    if (!IsFusibleElementwise(*input_node_def) ||
+        !HasDataType(input_node_def, GetDataTypeFromAttr(*current_def, "T")) ||
+        input_node_def->device() != current_def->device() ||
+        HasControlFaninOrFanout(*input_node_view) ||
+        !HasAtMostOneFanoutAtPort0(*input_node_view) ||
+        IsInPreserveSet(ctx, input_node_def))
+      break;
+    node_view = input_node_view;
+  }
+
+  if (matched->nodes_.size() < 2) {
+    matched->nodes_.clear();
+    matched->acc_ports_.clear();
+    return false;
+  }
+  return true;
+}
+
 // Find dropout pattern in TF2.11 and remaper to TF2.10 to reuse the optimzaiton
 // in TF2.10.
 bool FindDropout(const RemapperContext& ctx, int node_index, Dropout* matched) {
@@ -5702,6 +6081,149 @@ Status AddFusedAddV2WithSoftmaxNode(RemapperContext* ctx,
   return Status::OK();
 }
 
+Status AddFusedAddWithNormNode(RemapperContext* ctx,
+                               const AddWithNorm& matched,
+                               std::vector<bool>* invalidated_nodes,
+                               std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& add = graph->node(matched.add_);
+  const NodeDef& norm = graph->node(matched.norm_);
+
+  ITEX_VLOG(2) << "Fuse " << add.op() << " with " << norm.op() << ":"
+               << " add=" << add.name() << " norm=" << norm.name();
+
+  NodeDef fused_op;
+  fused_op.set_op(norm.op() == "ItexRmsNorm" ? kFusedAddRMSNorm
+                                             : kFusedAddGroupNorm);
+  fused_op.set_name(norm.name());
+  fused_op.set_device(norm.device());
+  fused_op.add_input(add.input(0));   // 0: x
+  fused_op.add_input(add.input(1));   // 1: residual
+  fused_op.add_input(norm.input(1));  // 2: scale
+  fused_op.add_input(norm.input(2));  // 3: offset
+  CopyAllAttrs(norm, &fused_op);
+
+  // Turn Add node into Identity of the sum computed by the fused op.
+  NodeDef identity_op;
+  identity_op.set_op("Identity");
+  identity_op.set_name(add.name());
+  identity_op.set_device(add.device());
+  identity_op.add_input(strings::StrCat(norm.name(), ":1"));
+  (*identity_op.mutable_attr())["T"] = add.attr().at("T");
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_ABORT_IF_ERROR(status);
+  mutation->AddNode(std::move(identity_op), &status);
+  TF_ABORT_IF_ERROR(status);
+  TF_ABORT_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.norm_] = true;
+  (*invalidated_nodes)[matched.add_] = true;
+
+  return Status::OK();
+}
+
+Status AddDynamicQuantizedMatMulNode(RemapperContext* ctx,
+                                     const DynamicQuantizedMatMul& matched,
+                                     std::vector<bool>* invalidated_nodes) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& contraction = graph->node(matched.contraction_);
+  ITEX_VLOG(2) << "Quantize " << contraction.op() << " dynamically: "
+               << contraction.name();
+
+  NodeDef fused_op;
+  fused_op.set_op(kDynamicQuantizedMatMul);
+  fused_op.set_name(contraction.name());
+  fused_op.set_device(contraction.device());
+  fused_op.add_input(contraction.input(0));  // 0: a
+  fused_op.add_input(contraction.input(1));  // 1: b
+  if (matched.has_bias_) fused_op.add_input(contraction.input(2));  // bias
+
+  auto* attr = fused_op.mutable_attr();
+  (*attr)["T"] = contraction.attr().at("T");
+  SetAttrValue(matched.has_bias_ ? 1 : 0, &(*attr)["num_args"]);
+  SetAttrValue(matched.transpose_b_, &(*attr)["transpose_b"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_ABORT_IF_ERROR(status);
+  TF_ABORT_IF_ERROR(mutation->Apply());
+  (*invalidated_nodes)[matched.contraction_] = true;
+
+  return Status::OK();
+}
+
+Status AddFusedMLPNode(RemapperContext* ctx, const FusedMLP& matched,
+                       std::vector<bool>* invalidated_nodes,
+                       std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& up = graph->node(matched.up_);
+  const NodeDef& down = graph->node(matched.down_);
+  const bool is_gated = matched.gate_ != kMissingIndex;
+  // Only _ITEXFusedMatMul nodes have a bias.
+  const auto has_bias = [](const NodeDef& node) {
+    return node.op() == kFusedMatMul;
+  };
+
+  ITEX_VLOG(2) << "Fuse MLP with " << matched.activation_
+               << ": up=" << up.name() << " down=" << down.name()
+               << " gated=" << is_gated;
+
+  NodeDef fused_op;
+  fused_op.set_op(kFusedMLP);
+  fused_op.set_name(down.name());
+  fused_op.set_device(down.device());
+  fused_op.add_input(up.input(0));    // 0: x
+  fused_op.add_input(up.input(1));    // 1: w_up
+  fused_op.add_input(down.input(1));  // 2: w_down
+  int num_args = 0;
+  bool has_gate_bias = false;
+  if (is_gated) {
+    const NodeDef& gate = graph->node(matched.gate_);
+    fused_op.add_input(gate.input(1));  // w_gate
+    ++num_args;
+    has_gate_bias = has_bias(gate);
+    if (has_gate_bias) {
+      fused_op.add_input(gate.input(2));  // b_gate
+      ++num_args;
+    }
+  }
+  if (has_bias(up)) {
+    fused_op.add_input(up.input(2));  // b_up
+    ++num_args;
+  }
+  if (has_bias(down)) {
+    fused_op.add_input(down.input(2));  // b_down
+    ++num_args;
+  }
+
+  auto* attr = fused_op.mutable_attr();
+  (*attr)["T"] = down.attr().at("T");
+  SetAttrValue(num_args, &(*attr)["num_args"]);
+  SetAttrValue(matched.activation_, &(*attr)["activation"]);
+  SetAttrValue(is_gated, &(*attr)["is_gated"]);
+  SetAttrValue(has_gate_bias, &(*attr)["has_gate_bias"]);
+  SetAttrValue(has_bias(up), &(*attr)["has_up_bias"]);
+  SetAttrValue(has_bias(down), &(*attr)["has_down_bias"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_ABORT_IF_ERROR(status);
+  TF_ABORT_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.down_] = true;
+  for (int index :
+       {matched.up_, matched.gate_, matched.activation_node_, matched.mul_}) {
+    if (index != kMissingIndex) (*nodes_to_delete)[index] = true;
+  }
+
+  return Status::OK();
+}
+
 Status AddConvBackpropInputWithSliceNode(
     RemapperContext* ctx, const ConvBackpropInputWithSlice& matched,
     std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
@@ -6616,6 +7138,68 @@ Status AddFusedBinaryNode(RemapperContext* ctx, const FusedBinary& matched,
   return Status::OK();
 }
 
+// Add elementwise chain fusion.
+Status AddFusedElementwiseNode(RemapperContext* ctx,
+                               const FusedElementwise& matched,
+                               std::vector<bool>* invalidated_nodes,
+                               std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& root_def = graph->node(matched.nodes_.front());
+
+  ITEX_VLOG(2) << "Fuse " << matched.nodes_.size() << " elementwise ops into "
+               << root_def.name();
+
+  NodeDef new_node_def;
+  new_node_def.set_op(kFusedElementwise);
+  new_node_def.set_name(root_def.name());
+  new_node_def.set_device(root_def.device());
+
+  // The kernel evaluates the chain from its first op, which is the last
+  // matched node.
+  const NodeDef& first_def = graph->node(matched.nodes_.back());
+  new_node_def.add_input(first_def.input(matched.acc_ports_.back()));
+
+  std::vector<string> fused_ops;
+  std::vector<int> acc_first;
+  std::vector<float> alphas;
+  for (int i = static_cast<int>(matched.nodes_.size()) - 1; i >= 0; --i) {
+    const NodeDef& node_def = graph->node(matched.nodes_[i]);
+    const int acc_port = matched.acc_ports_[i];
+    float alpha = 0.0f;
+    if (IsGelu(node_def)) {
+      fused_ops.push_back(node_def.attr().at("approximate").b()
+                              ? "GeluApproximate"
+                              : "GeluExact");
+    } else {
+      if (IsLeakyRelu(node_def)) alpha = node_def.attr().at("alpha").f();
+      fused_ops.push_back(node_def.op());
+    }
+    if (ctx->graph_view.GetNode(matched.nodes_[i])->NumRegularFanins() == 2) {
+      new_node_def.add_input(node_def.input(1 - acc_port));
+    }
+    acc_first.push_back(acc_port == 0);
+    alphas.push_back(alpha);
+  }
+
+  AddNodeAttr("T", root_def.attr().at("T"), &new_node_def);
+  AddNodeAttr("num_args", new_node_def.input_size(), &new_node_def);
+  AddNodeAttr("fused_ops", fused_ops, &new_node_def);
+  AddNodeAttr("acc_first", acc_first, &new_node_def);
+  AddNodeAttr("alphas", alphas, &new_node_def);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(new_node_def), &status);
+  TF_ABORT_IF_ERROR(status);
+  TF_ABORT_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.nodes_.front()] = true;
+  for (size_t i = 1; i < matched.nodes_.size(); ++i) {
+    (*nodes_to_delete)[matched.nodes_[i]] = true;
+  }
+  return Status::OK();
+}
+
 // Remap TF2.11 dropout select to TF2.10 cast+mul.
 Status AddDropout(RemapperContext* ctx, const Dropout& matched,
                   std::vector<bool>* invalidated_nodes,
@@ -6866,6 +7450,218 @@ Status AddDilatedContractionNode(RemapperContext* ctx,
   return Status::OK();
 }
 
+// Op types the hand-written Find* matchers in RunRemapper start from, i.e. the
+// type they require for node `i`. Nodes of other types (without a registered
+// Fusion keyed by their type either) can't match anything and are skipped.
+// Keep it in sync when adding a matcher to RunRemapper.
+bool IsHandWrittenFusionRoot(const string& op) {
+  static const auto* root_ops = new gtl::FlatSet<string>{
+      // FindAddV2, FindContractionWithBiasAddAndAdd, FindFusedAddN.
+      "AddN",
+      // FindContractionWithBias, FindContractionWithBiasAddAndAdd,
+      // FindContractionWithBiasAndActivationAdd, FindFusedAddN,
+      // FindFusedBinary.
+      "Add", "AddV2",
+      // FindGelu, FindContractionWithMul, FindFusedBinary.
+      "Mul", "MulNoNan", "Sub",
+      // FindContractionWithBias.
+      "BiasAdd", "BiasAddV1",
+      // FindContractionWithBiasAddGrad, FindConvContractionWithBiasAddGrad,
+      // FindContractionWithReshapeAndBiasAddGrad.
+      "BiasAddGrad",
+      // FindDropout.
+      "Select", "SelectV2",
+      // FindMulWithMaximum.
+      "Maximum",
+      // FindMatmulReshapeBiasadd, FindKerasDenseLayerFwd,
+      // FindDequantizeWithReshape.
+      "Reshape",
+      // FindDilatedContraction.
+      "BatchToSpaceND",
+      // FindSum.
+      "Sum",
+      // FindResNeXtGroupConv2DBlock.
+      "ConcatV2",
+      // FindConv2DWithBatchNorm.
+      "FusedBatchNorm", "FusedBatchNormV2", "FusedBatchNormV3",
+      "_ITEXFusedBatchNorm", "_ITEXFusedBatchNormV2", "_ITEXFusedBatchNormV3",
+      // FindFusedBatchNormGradEx.
+      "FusedBatchNormGrad", "FusedBatchNormGradV2", "FusedBatchNormGradV3",
+      // FindPadWithTransposeConv.
+      "Transpose",
+      // FindPadWithContraction, FindPadWithContractionFwdBwd.
+      "Conv2D", "Conv3D", "DepthwiseConv2dNative", kFusedConv2D, kFusedConv3D,
+      // FindConvBackpropInputWithSlice, FindConv2DBackpropInputWithSliceLLGA.
+      "Slice",
+      // FindPadConvFwdBwd.
+      "Conv2DBackpropFilter",
+      // FindFusedTrainingOp.
+      "ApplyMomentum", "ResourceApplyMomentum", "ApplyAdam",
+      "ResourceApplyAdam", "ITEXApplyAdamWithWeightDecay",
+      "ITEXResourceApplyAdamWithWeightDecay",
+      // FindDequantizeWithShape.
+      "Shape",
+      // FindQuantizeV2WithQuantizedConv2D.
+      "QuantizedConv2DWithBiasAndReluAndRequantize",
+      // FindQuantizedConv2DWithDequantize.
+      "Dequantize",
+      // FindAddV2WithSoftmax.
+      "Softmax",
+      // FindBf16ContractionWithCastFp32, FindBf16ContractionGradWithCastFp32,
+      // FindComparisonWithCast, FindConstWithCast, FindQuantizedConv2DWithCast,
+      // FindRandomWithComparisonAndCast.
+      "Cast",
+      // FindStridedSliceGrad.
+      "StridedSliceGrad",
+      // FindFusedElementwise.
+      "Exp", "Gelu", kGelu, "Minimum", "Neg", "RealDiv", "Rsqrt", "Sigmoid",
+      "Sqrt", "Square",
+      // FindAddWithNorm.
+      "ITEXGroupNorm", "ItexRmsNorm",
+      // FindFusedMLP, FindDynamicQuantizedMatMul.
+      "MatMul", kFusedMatMul,
+      // FindDynamicQuantizedMatMul.
+      "BatchMatMulV2"};
+
+  // FindContractionWithBiasAndActivation, FindFusedBatchNormEx,
+  // FindContractionWithBiasAndAddActivation,
+  // FindConv2DWithBatchNormAndActivation,
+  // FindConv2DWithBatchNormAndAddV2AndActivation.
+  return root_ops->count(op) != 0 || PostOpUtil::IsSupportedActivation(op);
+}
+
+// Subset of the above only enabled in non-BASIC levels (FindFusedBinary,
+// FindFusedElementwise, FindAddWithNorm, FindFusedMLP,
+// FindDynamicQuantizedMatMul).
+bool IsAdvancedOnlyHandWrittenFusionRoot(const string& op) {
+  static const auto* root_ops = new gtl::FlatSet<string>{
+      // FindAddWithNorm.
+      "ITEXGroupNorm", "ItexRmsNorm",
+      // FindFusedMLP, FindDynamicQuantizedMatMul.
+      "MatMul", kFusedMatMul,
+      // FindDynamicQuantizedMatMul.
+      "BatchMatMulV2",
+      // FindFusedBinary, FindFusedElementwise.
+      "Add", "AddV2", "Mul", "Sub",
+      // FindFusedElementwise.
+      "BiasAdd", "Elu", "Exp", "Gelu", kGelu, "LeakyRelu", "Maximum",
+      "Minimum", "Neg", "RealDiv", "Relu", "Relu6", "Rsqrt", "Sigmoid", "Sqrt",
+      "Square", "Tanh"};
+  return root_ops->count(op) != 0;
+}
+
+// The largest hand-written Find* pattern (including the fanout checks some
+// matchers do) spans fewer hops than this.
+constexpr int kHandWrittenPatternRadius = 8;
+
+// Nodes further than this many hops away from any rewritten node can't match
+// differently in the next remapper run. A registered pattern of N nodes spans
+// at most N - 1 hops, plus one for the fanout checks of its Update, e.g.
+// MHAFusionWithReshapeMatmul spans more hops than any Find* pattern.
+int RemapperWorklistRadius() {
+  static const int radius = std::max(kHandWrittenPatternRadius,
+                                     FusionMgr::GetInstance().MaxNumNodes());
+  return radius;
+}
+
+using NodeDefMap =
+    std::unordered_map<StringPiece, const NodeDef*, StringPieceHasher>;
+
+bool HaveSameAttrs(const NodeDef& a, const NodeDef& b) {
+  if (a.attr_size() != b.attr_size()) return false;
+  for (const auto& [name, value] : a.attr()) {
+    auto it = b.attr().find(name);
+    if (it == b.attr().end() || !FastAreAttrValuesEqual(value, it->second))
+      return false;
+  }
+  return true;
+}
+
+// Collects the nodes within RemapperWorklistRadius() hops of the nodes changed
+// by a remapper run in the rewritten graph of `ctx`. Changed nodes are
+// `changed_nodes` and the nodes whose op, inputs or attrs differ from
+// `input_nodes`.
+void UpdateRemapperWorklist(const NodeDefMap& input_nodes,
+                            const RemapperContext& ctx,
+                            const std::unordered_set<string>& changed_nodes,
+                            RemapperWorklist* worklist) {
+  const auto& graph_view = ctx.graph_view;
+  std::vector<int> frontier;
+  std::vector<bool> visited(graph_view.NumNodes(), false);
+  for (int i = 0; i < graph_view.NumNodes(); ++i) {
+    const NodeDef* node = graph_view.GetNode(i)->node();
+    bool changed = changed_nodes.count(node->name()) != 0;
+    if (!changed) {
+      auto it = input_nodes.find(node->name());
+      changed = it == input_nodes.end() || it->second->op() != node->op() ||
+                it->second->input_size() != node->input_size() ||
+                !std::equal(node->input().begin(), node->input().end(),
+                            it->second->input().begin()) ||
+                !HaveSameAttrs(*it->second, *node);
+    }
+    if (changed) {
+      visited[i] = true;
+      frontier.push_back(i);
+    }
+  }
+
+  const int radius = RemapperWorklistRadius();
+  for (int hop = 0; hop < radius && !frontier.empty(); ++hop) {
+    std::vector<int> next;
+    auto visit = [&](int index) {
+      if (!visited[index]) {
+        visited[index] = true;
+        next.push_back(index);
+      }
+    };
+    for (int index : frontier) {
+      const auto* node_view = graph_view.GetNode(index);
+      for (const auto& fanin : node_view->GetRegularFanins()) {
+        visit(fanin.node_index());
+      }
+      for (const auto& fanin : node_view->GetControllingFanins()) {
+        visit(fanin.node_index());
+      }
+      for (const auto& fanouts : node_view->GetRegularFanouts()) {
+        for (const auto& fanout : fanouts) visit(fanout.node_index());
+      }
+      for (const auto& fanout : node_view->GetControlledFanouts()) {
+        visit(fanout.node_index());
+      }
+    }
+    frontier.swap(next);
+  }
+
+  worklist->valid = true;
+  worklist->nodes.clear();
+  for (int i = 0; i < graph_view.NumNodes(); ++i) {
+    if (visited[i]) worklist->nodes.insert(graph_view.GetNode(i)->GetName());
+  }
+  ITEX_VLOG(2) << "Remapper worklist: " << worklist->nodes.size() << " of "
+               << graph_view.NumNodes() << " nodes to revisit.";
+}
+
+// Fused nodes are created without the attrs of the nodes they replace, but
+// take the name of the root of the pattern. Keep the NUMA node AutoShard set
+// on the nodes of a pinned CPU replica, so the fused kernel runs on the same
+// node as the rest of the replica.
+void KeepNumaNodeAttr(const GraphDef& graph_def, GraphDef* optimized_graph) {
+  std::unordered_map<string, int64> numa_nodes;
+  for (const auto& node : graph_def.node()) {
+    auto it = node.attr().find(kNumaNodeAttr);
+    if (it != node.attr().end()) numa_nodes[node.name()] = it->second.i();
+  }
+  if (numa_nodes.empty()) return;
+
+  for (auto& node : *optimized_graph->mutable_node()) {
+    if (node.attr().count(kNumaNodeAttr)) continue;
+    auto it = numa_nodes.find(node.name());
+    if (it != numa_nodes.end()) {
+      (*node.mutable_attr())[kNumaNodeAttr].set_i(it->second);
+    }
+  }
+}
+
 }  // namespace
 
 // `is_full` is true by default. It will be set as false if this pass runs
@@ -6876,7 +7672,8 @@ Status AddDilatedContractionNode(RemapperContext* ctx,
 // any variant will be checked under BASIC(0) level only.
 Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
                    const GraphDef& graph_def, GraphDef* optimized_graph,
-                   bool is_full, RemapperLevel level) {
+                   bool is_full, RemapperLevel level,
+                   RemapperWorklist* worklist) {
   // `level` must be `BASIC` if in partial remapper.
   ITEX_CHECK(is_full || level == RemapperLevel::BASIC);
 
@@ -6914,6 +7711,41 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
   // Infer statically first and only once.
   ctx.GetGraphProperties();
 
+  // Op type index of the fusions: whether a node of the given type may be the
+  // root of any fusion, and of a fusion newly enabled at this level. Computed
+  // once per op type.
+  struct FusionRootInfo {
+    bool is_root;
+    bool is_advanced_only;
+  };
+  std::unordered_map<string, FusionRootInfo> fusion_root_index;
+  auto get_fusion_root_info = [&](const string& op) {
+    auto it = fusion_root_index.find(op);
+    if (it != fusion_root_index.end()) return it->second;
+    auto& fusion_mgr = FusionMgr::GetInstance();
+    FusionRootInfo info;
+    info.is_root =
+        !fusion_mgr.GetFusions(op).empty() || IsHandWrittenFusionRoot(op);
+    info.is_advanced_only = level != RemapperLevel::BASIC &&
+                            (fusion_mgr.HasAdvancedOnlyFusion(op) ||
+                             IsAdvancedOnlyHandWrittenFusionRoot(op));
+    fusion_root_index.emplace(op, info);
+    return info;
+  };
+
+  bool use_worklist = false;
+  if (worklist != nullptr) {
+    bool worklist_enabled;
+    ITEX_CHECK_OK(
+        ReadBoolFromEnvVar("ITEX_REMAPPER_WORKLIST", true, &worklist_enabled));
+    if (!worklist_enabled) worklist = nullptr;
+  }
+  if (worklist != nullptr) use_worklist = worklist->valid;
+
+  bool dynamic_quantization;
+  ITEX_CHECK_OK(ReadBoolFromEnvVar("ITEX_DYNAMIC_QUANTIZATION", false,
+                                   &dynamic_quantization));
+
   bool is_visited = false;
   string last_op;
   for (int i = num_nodes - 1; i >= 0;) {
@@ -6970,14 +7802,25 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       continue;
     }
 
+    // Skip nodes no fusion starts from, and, when revisiting the worklist of
+    // the previous run, nodes whose neighborhood has not changed.
+    FusionRootInfo root_info = get_fusion_root_info(node_def->op());
+    if (!root_info.is_root) continue;
+    if (use_worklist && !root_info.is_advanced_only &&
+        worklist->nodes.count(node_def->name()) == 0) {
+      continue;
+    }
+
     // Put the fusions that always need to be enabled here no matter `is_full`
-    // is true or false.
+    // is true or false. Hand-written fusions are counted in the graph
+    // optimization report under the name of their Find* matcher.
     {
       // Use AddV2 for AddN when N=2
       int AddN_index;
       if (FindAddV2(ctx, i, &AddN_index)) {
         TF_ABORT_IF_ERROR(ReplaceAddN(&ctx, AddN_index, &invalidated_nodes,
                                       &nodes_to_delete));
+        ctx.fusion_match_counts["AddNToAddV2"]++;
         continue;
       }
 
@@ -6986,6 +7829,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       if (FindDropout(ctx, i, &dropout)) {
         TF_ABORT_IF_ERROR(
             AddDropout(&ctx, dropout, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["Dropout"]++;
         continue;
       }
 
@@ -6999,6 +7843,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(AddGelu(&ctx, &matched_nodes_map,
                                   &remove_node_indices, &invalidated_nodes,
                                   &nodes_to_delete, is_gelu_approximate));
+        ctx.fusion_match_counts["Gelu"]++;
         continue;
       }
 
@@ -7008,6 +7853,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
           FindMulWithMaximum(ctx, i, &mul_with_maximum)) {
         TF_ABORT_IF_ERROR(AddMulWithMaximumNode(
             &ctx, mul_with_maximum, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["MulWithMaximum"]++;
         continue;
       }
 
@@ -7016,6 +7862,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(AddMatmulReshapeBiasadd(&ctx, matmul_reshape_biasadd,
                                                   &invalidated_nodes,
                                                   &nodes_to_delete));
+        ctx.fusion_match_counts["MatmulReshapeBiasadd"]++;
         continue;
       }
 
@@ -7023,6 +7870,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       if (FindDilatedContraction(ctx, i, &dilated_contraction)) {
         TF_ABORT_IF_ERROR(AddDilatedContractionNode(
             &ctx, dilated_contraction, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["DilatedContraction"]++;
         continue;
       }
 
@@ -7031,6 +7879,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       if (FindSum(ctx, i, &sum)) {
         TF_ABORT_IF_ERROR(
             AddSum(&ctx, sum, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["Sum"]++;
         continue;
       }
 
@@ -7043,6 +7892,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(AddContractionWithReshapeAndBiasAddGrad(
             &ctx, contraction_reshape_bias_grad, &invalidated_nodes,
             &nodes_to_delete));
+        ctx.fusion_match_counts["ContractionWithReshapeAndBiasAddGrad"]++;
         continue;
       }
 
@@ -7063,6 +7913,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
                                        &invalidated_nodes, &nodes_to_delete));
         }
 
+        ctx.fusion_match_counts["KerasDenseLayerFwd"]++;
         continue;
       }
     }
@@ -7079,6 +7930,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(
             AddFusedContractionNode(&ctx, contract_with_bias_and_activation_add,
                                     &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["ContractionWithBiasAndActivationAdd"]++;
         continue;
       }
 
@@ -7086,6 +7938,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       if (FindResNeXtGroupConv2DBlock(ctx, i, &group_conv)) {
         TF_ABORT_IF_ERROR(AddGroupConv2DNode(
             &ctx, group_conv, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["ResNeXtGroupConv2DBlock"]++;
         continue;
       }
 
@@ -7096,6 +7949,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(
             AddFusedContractionNode(&ctx, contract_with_bias_and_add_activation,
                                     &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["ContractionWithBiasAndAddActivation"]++;
         continue;
       }
 
@@ -7106,6 +7960,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(
             AddFusedContractionNode(&ctx, contract_with_bias_and_add,
                                     &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["ContractionWithBiasAddAndAdd"]++;
         continue;
       }
 
@@ -7115,6 +7970,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       if (FindContractionWithBias(ctx, i, &contract_with_bias)) {
         TF_ABORT_IF_ERROR(AddFusedContractionNode(
             &ctx, contract_with_bias, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["ContractionWithBias"]++;
         continue;
       }
 
@@ -7124,6 +7980,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(
             AddFusedContractionGradNode(&ctx, contract_with_bias_grad,
                                         &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["ContractionWithBiasAddGrad"]++;
         continue;
       }
 
@@ -7135,6 +7992,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(
             AddFusedContractionGradNode(&ctx, conv_contract_with_bias_grad,
                                         &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["ConvContractionWithBiasAddGrad"]++;
         continue;
       }
       // Remap {Conv2D,Conv3D,MatMul}+BiasAdd+Activation into
@@ -7145,6 +8003,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(
             AddFusedContractionNode(&ctx, contract_with_bias_and_activation,
                                     &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["ContractionWithBiasAndActivation"]++;
         continue;
       }
       // NOTE: We can only fuse BatchNorm into Conv2D nodes. In theory we can do
@@ -7159,6 +8018,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_RETURN_IF_ERROR(AddFusedConv2DNode(
             &ctx, contract_with_batch_norm_and_addv2_and_activation,
             &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["Conv2DWithBatchNormAndAddV2AndActivation"]++;
         continue;
       }
 
@@ -7170,6 +8030,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_RETURN_IF_ERROR(
             AddFusedConv2DNode(&ctx, contract_with_batch_norm_and_activation,
                                &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["Conv2DWithBatchNormAndActivation"]++;
         continue;
       }
 
@@ -7179,6 +8040,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_RETURN_IF_ERROR(AddFusedConv2DNode(&ctx, contract_with_batch_norm,
                                               &invalidated_nodes,
                                               &nodes_to_delete));
+        ctx.fusion_match_counts["Conv2DWithBatchNorm"]++;
         continue;
       }
       // Remap FusedBatchNorm+<SideInput>+<Activation> into the
@@ -7187,6 +8049,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       if (FindFusedBatchNormEx(ctx, i, &fused_batch_norm_ex)) {
         TF_ABORT_IF_ERROR(AddFusedBatchNormExNode(
             &ctx, fused_batch_norm_ex, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["FusedBatchNormEx"]++;
         continue;
       }
 
@@ -7195,6 +8058,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(
             AddFusedBatchNormGradExNode(&ctx, fused_batch_norm_grad_ex,
                                         &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["FusedBatchNormGradEx"]++;
         continue;
       }
 
@@ -7203,6 +8067,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(AddPadWithTransposeConv(&ctx, pad_with_transpose_conv,
                                                   &invalidated_nodes,
                                                   &nodes_to_delete));
+        ctx.fusion_match_counts["PadWithTransposeConv"]++;
         continue;
       }
 
@@ -7211,6 +8076,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(
             AddPadWithContractionFwdBwd(&ctx, pad_with_contract_fwd_bwd,
                                         &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["PadWithContractionFwdBwd"]++;
         continue;
       }
 
@@ -7219,6 +8085,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       if (FindPadWithContraction(ctx, i, &pad_with_contract)) {
         TF_ABORT_IF_ERROR(AddPadWithContraction(
             &ctx, pad_with_contract, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["PadWithContraction"]++;
         continue;
       }
 
@@ -7226,6 +8093,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       if (FindConvBackpropInputWithSlice(ctx, i, &conv_with_slice)) {
         TF_ABORT_IF_ERROR(AddConvBackpropInputWithSliceNode(
             &ctx, conv_with_slice, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["ConvBackpropInputWithSlice"]++;
         continue;
       }
 
@@ -7235,6 +8103,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
           FindFusedTrainingOp(ctx, i, &fused_training_op)) {
         TF_ABORT_IF_ERROR(AddFusedTrainingNode(
             &ctx, fused_training_op, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["FusedTrainingOp"]++;
         continue;
       }
 
@@ -7243,6 +8112,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       if (FindContractionWithMul(ctx, i, &contract_with_mul)) {
         TF_ABORT_IF_ERROR(AddFusedContractionNode(
             &ctx, contract_with_mul, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["ContractionWithMul"]++;
         continue;
       }
 
@@ -7252,6 +8122,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
           FindDequantizeWithShape(ctx, i, &dequantize_with_shape)) {
         TF_ABORT_IF_ERROR(AddFusedDequantizeWithShape(
             &ctx, dequantize_with_shape, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["DequantizeWithShape"]++;
         continue;
       }
 
@@ -7262,6 +8133,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(AddFusedDequantizeWithReshape(
             &ctx, dequantize_with_reshape, &invalidated_nodes,
             &nodes_to_delete));
+        ctx.fusion_match_counts["DequantizeWithReshape"]++;
         continue;
       }
 
@@ -7273,6 +8145,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(AddQuantizeV2WithQuantizedConv2DNode(
             &ctx, quantizev2_with_quantizedconv, &invalidated_nodes,
             &nodes_to_delete));
+        ctx.fusion_match_counts["QuantizeV2WithQuantizedConv2D"]++;
         continue;
       }
 
@@ -7282,6 +8155,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(AddQuantizedConv2DWithDequantizeNode(
             &ctx, conv2d_with_dequantize, &invalidated_nodes,
             &nodes_to_delete));
+        ctx.fusion_match_counts["QuantizedConv2DWithDequantize"]++;
         continue;
       }
 
@@ -7290,6 +8164,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
           (FindQuantizedConv2DWithCast(ctx, i, &conv2d_with_cast))) {
         TF_ABORT_IF_ERROR(AddQuantizedConv2DWithCastNode(
             &ctx, conv2d_with_cast, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["QuantizedConv2DWithCast"]++;
         continue;
       }
 
@@ -7298,6 +8173,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       if (level == RemapperLevel::BASIC && FindFusedAddN(ctx, i, &fused_addn)) {
         TF_ABORT_IF_ERROR(AddFusedAddN(&ctx, fused_addn, &invalidated_nodes,
                                        &nodes_to_delete));
+        ctx.fusion_match_counts["FusedAddN"]++;
         continue;
       }
 
@@ -7307,6 +8183,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(
             AddFusedAddV2WithSoftmaxNode(&ctx, fused_addv2_with_softmax,
                                          &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["AddV2WithSoftmax"]++;
         continue;
       }
 
@@ -7315,6 +8192,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       if (FindBf16ContractionWithCastFp32(ctx, i, &contraction_with_cast)) {
         TF_ABORT_IF_ERROR(AddBf16ContractionWithCastFp32Node(
             &ctx, contraction_with_cast, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["Bf16ContractionWithCastFp32"]++;
         continue;
       }
 
@@ -7326,6 +8204,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(AddRandomWithComparisonAndCastNode(
             &ctx, random_with_compare_and_cast, &invalidated_nodes,
             &nodes_to_delete));
+        ctx.fusion_match_counts["RandomWithComparisonAndCast"]++;
         continue;
       }
 
@@ -7336,6 +8215,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
         TF_ABORT_IF_ERROR(AddFusedContractionGradWithCastNode(
             &ctx, contraction_grad_with_cast, &invalidated_nodes,
             &nodes_to_delete));
+        ctx.fusion_match_counts["Bf16ContractionGradWithCastFp32"]++;
         continue;
       }
 
@@ -7345,6 +8225,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
           FindComparisonWithCast(ctx, i, &comparison_with_cast)) {
         TF_ABORT_IF_ERROR(AddComparisonWithCastNode(
             &ctx, comparison_with_cast, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["ComparisonWithCast"]++;
         continue;
       }
 
@@ -7355,6 +8236,56 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
           FindConstWithCast(ctx, i, &const_with_cast)) {
         TF_ABORT_IF_ERROR(AddConstWithCastNode(
             &ctx, const_with_cast, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["ConstWithCast"]++;
+        continue;
+      }
+
+      // Remap the feed-forward block of transformers into _ITEXFusedMLP on
+      // CPU. Disable it in 1st remapper since the projections are fused with
+      // their bias and activation first.
+      FusedMLP fused_mlp;
+      if (level != RemapperLevel::BASIC &&
+          FindFusedMLP(ctx, i, &fused_mlp)) {
+        TF_ABORT_IF_ERROR(AddFusedMLPNode(&ctx, fused_mlp, &invalidated_nodes,
+                                          &nodes_to_delete));
+        ctx.fusion_match_counts["FusedMLP"]++;
+        continue;
+      }
+
+      // Remap fp32 contractions with constant weights into INT8 ones that
+      // quantize the activation at runtime, opt-in with
+      // ITEX_DYNAMIC_QUANTIZATION. Disable it in 1st remapper so the bias is
+      // fused first, and after FindFusedMLP which keeps its block in fp32.
+      DynamicQuantizedMatMul dynamic_quantized_matmul;
+      if (dynamic_quantization && level != RemapperLevel::BASIC &&
+          FindDynamicQuantizedMatMul(ctx, i, &dynamic_quantized_matmul)) {
+        TF_ABORT_IF_ERROR(AddDynamicQuantizedMatMulNode(
+            &ctx, dynamic_quantized_matmul, &invalidated_nodes));
+        ctx.fusion_match_counts["DynamicQuantizedMatMul"]++;
+        continue;
+      }
+
+      // Remap Add+ItexRmsNorm/ITEXGroupNorm into the fused residual-add norm
+      // on CPU. Disable it in 1st remapper since the Add may be fused into
+      // a contraction first.
+      AddWithNorm add_with_norm;
+      if (level != RemapperLevel::BASIC &&
+          FindAddWithNorm(ctx, i, &add_with_norm)) {
+        TF_ABORT_IF_ERROR(AddFusedAddWithNormNode(
+            &ctx, add_with_norm, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["AddWithNorm"]++;
+        continue;
+      }
+
+      // Remap elementwise chains into the _ITEXFusedElementwise op on CPU.
+      // Disable it in 1st remapper since it may break other high priority
+      // fusions.
+      FusedElementwise fused_elementwise;
+      if (level != RemapperLevel::BASIC &&
+          FindFusedElementwise(ctx, i, &fused_elementwise)) {
+        TF_ABORT_IF_ERROR(AddFusedElementwiseNode(
+            &ctx, fused_elementwise, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["FusedElementwise"]++;
         continue;
       }
 
@@ -7366,6 +8297,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
           FindFusedBinary(ctx, i, &seq_binary)) {
         TF_ABORT_IF_ERROR(AddFusedBinaryNode(
             &ctx, seq_binary, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["FusedBinary"]++;
       }
 
       // Remap StridedSliceGrad to Pad when the stride of it is 1.
@@ -7373,6 +8305,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       if (FindStridedSliceGrad(ctx, i, &strided_slice_grad)) {
         TF_ABORT_IF_ERROR(AddStridedSliceGrad(
             &ctx, strided_slice_grad, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["StridedSliceGrad"]++;
         continue;
       }
     } else {
@@ -7390,6 +8323,7 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       if (FindConv2DBackpropInputWithSliceLLGA(ctx, i, &conv_with_slice)) {
         TF_ABORT_IF_ERROR(AddConv2DBackpropInputWithSliceNodeLLGA(
             &ctx, conv_with_slice, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["Conv2DBackpropInputWithSliceLLGA"]++;
         continue;
       }
 
@@ -7397,11 +8331,32 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
       if (FindPadConvFwdBwd(ctx, i, &pad_conv_fwd_bwd)) {
         TF_ABORT_IF_ERROR(AddPadConvFwdBwd(
             &ctx, pad_conv_fwd_bwd, &invalidated_nodes, &nodes_to_delete));
+        ctx.fusion_match_counts["PadConvFwdBwd"]++;
         continue;
       }
     }
   }
 
+  // Nodes rewritten in place keep their op and inputs, and fanins of removed
+  // nodes lose fanouts, so record both before removing nodes.
+  NodeDefMap input_nodes;
+  std::unordered_set<string> changed_nodes;
+  if (worklist != nullptr) {
+    for (const auto& node : graph_def.node()) {
+      input_nodes.emplace(node.name(), &node);
+    }
+    for (int i = 0; i < num_nodes; ++i) {
+      const string& name = ctx.graph_view.GetNode(i)->GetName();
+      if (invalidated_nodes[i]) changed_nodes.insert(name);
+      if (!nodes_to_delete[i]) continue;
+      auto it = input_nodes.find(name);
+      if (it == input_nodes.end()) continue;
+      for (const string& input : it->second->input()) {
+        changed_nodes.insert(NodeName(input));
+      }
+    }
+  }
+
   // Remove invalidated nodes.
   utils::Mutation* mutation = ctx.graph_view.GetMutationBuilder();
   for (int i = 0; i < num_nodes; ++i) {
@@ -7411,6 +8366,16 @@ Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
   }
   TF_ABORT_IF_ERROR(mutation->Apply());
 
+  if (worklist != nullptr) {
+    UpdateRemapperWorklist(input_nodes, ctx, changed_nodes, worklist);
+  }
+
+  for (const auto& [name, count] : ctx.fusion_match_counts) {
+    opt_ctx->fusion_match_counts[name] += count;
+  }
+
+  KeepNumaNodeAttr(graph_def, &multable_graph_def);
+
   *optimized_graph = std::move(multable_graph_def);
   return Status::OK();
 }
@@ -55,6 +55,8 @@ struct RemapperContext {
   GraphProperties graph_properties;
   bool inferred_graph_properties;
   RemapperLevel remap_level;
+  // Number of matches of each registered fusion in this run.
+  std::map<std::string, int> fusion_match_counts;
 
   GraphProperties& GetGraphProperties() {
     if (!inferred_graph_properties) {
@@ -133,16 +135,28 @@ void SetFusedOpAttributes(NodeDef* fused,
 // Helper function to remove all regular Fanin from given node.
 void RemoveAllRegularFanin(RemapperContext* ctx, int node_idx);
 
+// Nodes rewritten by a remapper run and their neighborhood. Consecutive
+// remapper runs sharing a worklist only revisit these nodes, plus the nodes
+// which may match a fusion enabled only at the new level, since the others
+// already failed to match with the same neighborhood.
+struct RemapperWorklist {
+  bool valid = false;
+  std::unordered_set<string> nodes;
+};
+
 // `is_full` is true by default. It will be set as false if this pass runs
 // before oneDNN Graph, that means only a few necessary fusions
 // (InstanceNorm/LayerNorm) will be enabled to keep the original graph as
 // complete as possible for oneDNN graph.
 // `level` is to indicate current remapper fusion level. Simple fusions without
 // any variant will be checked under BASIC(0) level only.
+// `worklist` is optional. If valid, only its nodes are revisited, and it is
+// updated with the nodes rewritten by this run for the next one.
 Status RunRemapper(OptimizerContext* opt_ctx, const GrapplerItem& item,
                    const GraphDef& graph_def, GraphDef* optimized_graph,
                    bool is_full = true,
-                   RemapperLevel level = RemapperLevel::BASIC);
+                   RemapperLevel level = RemapperLevel::BASIC,
+                   RemapperWorklist* worklist = nullptr);
 
 }  // namespace graph
 }  // namespace itex
@@ -38,6 +38,7 @@ limitations under the License.
 #include "itex/core/ir/tf_op_registry.h"
 #include "itex/core/utils/env_var.h"
 #include "itex/core/utils/errors.h"
+#include "itex/core/utils/numa.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Threading.h"
@@ -209,10 +210,19 @@ Status RunAutoShard(itex::graph::OptimizerContext* opt_ctx,
     itex::int64 itex_gpu_bs = -1;
     itex::int64 itex_cpu_steps = 1;
     itex::int64 itex_gpu_steps = 1;
+    bool itex_cpu_numa = false;
 
     auto configs = itex::itex_get_config().graph_options().sharding_config();
-    if (configs.auto_mode())
-      ITEX_LOG(WARNING) << "auto_mode is not supported in sharding_config";
+    // In auto mode, the batch size and the stage number of each device are
+    // searched with the cost model instead of being configured.
+    bool auto_mode = configs.auto_mode();
+    if (!auto_mode) {
+      ITEX_CHECK_OK(itex::ReadBoolFromEnvVar("ITEX_SHARDING_AUTO_MODE", false,
+                                             &auto_mode));
+    }
+    itex::int64 tune_budget_ms = 200;
+    ITEX_CHECK_OK(itex::ReadInt64FromEnvVar("ITEX_SHARDING_TUNE_BUDGET_MS", 200,
+                                            &tune_budget_ms));
 
     if (configs.devices().size() == 0) {
       ITEX_CHECK_OK(itex::ReadInt64FromEnvVar("ITEX_SHARDING_CPU_DEVICE_NUM", 0,
@@ -227,6 +237,8 @@ Status RunAutoShard(itex::graph::OptimizerContext* opt_ctx,
                                               &itex_cpu_steps));
       ITEX_CHECK_OK(itex::ReadInt64FromEnvVar("ITEX_SHARDING_GPU_STAGE_NUM", 1,
                                               &itex_gpu_steps));
+      ITEX_CHECK_OK(itex::ReadBoolFromEnvVar("ITEX_SHARDING_CPU_NUMA", false,
+                                             &itex_cpu_numa));
     }
 
     for (auto cfg : configs.devices()) {
@@ -238,17 +250,26 @@ Status RunAutoShard(itex::graph::OptimizerContext* opt_ctx,
         itex_num_cpus = cfg.device_num();
         itex_cpu_bs = cfg.batch_size();
         itex_cpu_steps = cfg.stage_num();
+        itex_cpu_numa = cfg.numa_aware();
       } else {
         ITEX_LOG(WARNING) << "Only CPU and GPU is supported in ShardingConfig";
       }
     }
 
+    // In NUMA-aware mode, each CPU replica is pinned to one NUMA node, one
+    // replica per node unless the device number is configured.
+    const int num_numa_nodes = itex::port::NUMANumNodes();
+    if (itex_cpu_numa && itex_num_cpus == 0) itex_num_cpus = num_numa_nodes;
+
+    ITEX_VLOG(1) << "AutoShard pass, auto_mode: " << auto_mode;
     ITEX_VLOG(1) << "AutoShard pass, itex_num_cpus: " << itex_num_cpus;
     ITEX_VLOG(1) << "AutoShard pass, itex_num_gpus: " << itex_num_gpus;
     ITEX_VLOG(1) << "AutoShard pass, itex_cpu_bs: " << itex_cpu_bs;
     ITEX_VLOG(1) << "AutoShard pass, itex_gpu_bs: " << itex_gpu_bs;
     ITEX_VLOG(1) << "AutoShard pass, itex_cpu_steps: " << itex_cpu_steps;
     ITEX_VLOG(1) << "AutoShard pass, itex_gpu_steps: " << itex_gpu_steps;
+    ITEX_VLOG(1) << "AutoShard pass, itex_cpu_numa: " << itex_cpu_numa
+                 << ", NUMA nodes: " << num_numa_nodes;
 
     float gpu_score = itex_gpu_bs * itex_gpu_steps;
     float cpu_score = itex_cpu_bs * itex_cpu_steps;
@@ -256,20 +277,23 @@ Status RunAutoShard(itex::graph::OptimizerContext* opt_ctx,
     as::DeviceInfo device_info(/*add_cpu_host=*/false);
     for (int i = 0; i < itex_num_gpus; i++) {
       as::Device gpu(i + 1, "XPU:" + std::to_string(i), gpu_score);
-      gpu.setNumStages(itex_gpu_steps);
+      if (!auto_mode) gpu.setNumStages(itex_gpu_steps);
       device_info.addDevice(gpu);
     }
     for (int i = 0; i < itex_num_cpus; i++) {
       as::Device cpu(i + itex_num_gpus + 1, "CPU:" + std::to_string(i),
                      cpu_score);
-      cpu.setNumStages(itex_cpu_steps);
+      if (!auto_mode) cpu.setNumStages(itex_cpu_steps);
+      if (itex_cpu_numa) cpu.setNumaNode(i % num_numa_nodes);
       device_info.addDevice(cpu);
     }
 
     bool model_prune = false;
     ITEX_CHECK_OK(itex::ReadBoolFromEnvVar("MODEL_PRUNE", false, &model_prune));
     as::ShardingConfig config;
-    config.setStrategyKind(as::StrategyKind::HEURISTIC);
+    config.setStrategyKind(auto_mode ? as::StrategyKind::LEARNED
+                                     : as::StrategyKind::HEURISTIC);
+    config.getTunerConfig().setTimeBudgetMs(tune_budget_ms);
     config.setUseMultiStageJoin(true);
     config.getHeuristicsConfig().setMultiStageEnabled((itex_gpu_steps != 1) ||
                                                       (itex_cpu_steps != 1));
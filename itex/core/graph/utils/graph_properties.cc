@@ -15,8 +15,14 @@ limitations under the License.
 
 #include "itex/core/graph/utils/graph_properties.h"
 
+#include <algorithm>
+#include <utility>
+
+#include "itex/core/graph/utils/op_types.h"
 #include "itex/core/utils/errors.h"
+#include "itex/core/utils/tensor_id.h"
 #include "itex/core/utils/tf_buffer.h"
+#include "itex/core/utils/types.h"
 #include "protos/op_performance_data.pb.h"
 
 namespace itex {
@@ -92,5 +98,89 @@ Status GraphProperties::GetOutputProperties(
                        TF_GetOutputPropertiesList);
 }
 
+RewrittenGraphProperties::RewrittenGraphProperties(const GrapplerItem& item,
+                                                   const GraphDef& graph)
+    : properties_(item) {
+  nodes_.reserve(graph.node_size());
+  for (const NodeDef& node : graph.node()) nodes_.emplace(node.name(), &node);
+  Status status = type_map_.Init(graph);
+  if (!status.ok()) {
+    ITEX_VLOG(1) << "Output types of the rewritten graph are unknown: "
+                 << status;
+    type_map_.Clear();
+  }
+}
+
+Status RewrittenGraphProperties::GetOutputProperties(
+    const string& node_name,
+    std::vector<OpInfo_TensorProperties>* output_props) const {
+  Status status = properties_.GetOutputProperties(node_name, output_props);
+  auto it = nodes_.find(node_name);
+  if (it == nodes_.end()) return status;
+  const NodeDef& node = *it->second;
+
+  if ((!status.ok() || output_props->empty()) &&
+      (IsCast(node) || IsIdentity(node)) && node.input_size() > 0) {
+    const TensorId tensor = ParseTensorName(node.input(0));
+    std::vector<OpInfo_TensorProperties> fanin_props;
+    TF_RETURN_IF_ERROR(
+        GetOutputProperties(string(tensor.node()), &fanin_props));
+    if (tensor.index() < 0 ||
+        tensor.index() >= static_cast<int>(fanin_props.size())) {
+      return errors::NotFound("No properties for input ", node.input(0),
+                              " of ", node_name, ".");
+    }
+    output_props->assign(1, std::move(fanin_props[tensor.index()]));
+    status = Status::OK();
+  }
+  TF_RETURN_IF_ERROR(status);
+
+  if (!type_map_.is_initialized()) return Status::OK();
+  const int num_outputs =
+      std::min(static_cast<int>(output_props->size()),
+               type_map_.GetOutputSize(node));
+  for (int port = 0; port < num_outputs; ++port) {
+    const DataType dtype =
+        GetDataType(node, type_map_.GetOutputTypeAttr(node, port));
+    if (dtype != DT_INVALID) (*output_props)[port].set_dtype(dtype);
+  }
+  return Status::OK();
+}
+
+Status RewrittenGraphProperties::GetInputProperties(
+    const string& node_name,
+    std::vector<OpInfo_TensorProperties>* input_props) const {
+  auto it = nodes_.find(node_name);
+  if (it == nodes_.end()) {
+    return errors::NotFound("Node ", node_name, " is not in the graph.");
+  }
+  input_props->clear();
+  std::vector<OpInfo_TensorProperties> fanin_props;
+  for (const string& input : it->second->input()) {
+    const TensorId tensor = ParseTensorName(input);
+    if (IsTensorIdControl(tensor)) break;
+    TF_RETURN_IF_ERROR(
+        GetOutputProperties(string(tensor.node()), &fanin_props));
+    if (tensor.index() >= static_cast<int>(fanin_props.size())) {
+      return errors::NotFound("No properties for input ", input, " of ",
+                              node_name, ".");
+    }
+    input_props->push_back(std::move(fanin_props[tensor.index()]));
+  }
+  return Status::OK();
+}
+
+int64_t GetTensorBytes(const OpInfo_TensorProperties& props) {
+  if (props.shape().unknown_rank()) return -1;
+  const int dtype_size = DataTypeSize(BaseType(props.dtype()));
+  if (dtype_size <= 0) return -1;
+  int64_t num_elements = 1;
+  for (const auto& dim : props.shape().dim()) {
+    if (dim.size() < 0) return -1;
+    num_elements *= dim.size();
+  }
+  return num_elements * dtype_size;
+}
+
 }  // namespace graph
 }  // namespace itex
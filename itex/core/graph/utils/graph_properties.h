@@ -19,10 +19,13 @@ limitations under the License.
 #define ITEX_CORE_GRAPH_UTILS_GRAPH_PROPERTIES_H_
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "itex/core/graph/utils/grappler_item.h"
+#include "itex/core/graph/utils/node_type_attr_map.h"
 #include "itex/core/utils/status.h"
+#include "protos/graph.pb.h"
 #include "protos/op_performance_data.pb.h"
 
 namespace itex {
@@ -77,6 +80,44 @@ class GraphProperties {
   TF_GraphProperties* graph_prop_;
 };
 
+// Shapes of `graph`, a rewrite of the graph of `item` by earlier passes.
+// Shapes can only be inferred on the graph given to the optimizer, so the
+// output shapes of a node are those of the original node with the same name:
+// fused and rewritten nodes keep the name of the node producing their output.
+// New casts and identities, e.g. from auto mixed precision, have the shape of
+// their input, and the output types are read from the attrs of the rewritten
+// nodes. The input properties are the output properties of the fanins in
+// `graph`, since a fused node doesn't read the inputs of the original node
+// with its name. `graph` must outlive this object.
+class RewrittenGraphProperties {
+ public:
+  RewrittenGraphProperties(const GrapplerItem& item, const GraphDef& graph);
+
+  Status InferStatically(bool assume_valid_feeds,
+                         bool aggressive_shape_inference,
+                         bool include_tensor_values) {
+    return properties_.InferStatically(assume_valid_feeds,
+                                       aggressive_shape_inference,
+                                       include_tensor_values);
+  }
+
+  Status GetInputProperties(
+      const string& node_name,
+      std::vector<OpInfo_TensorProperties>* input_props) const;
+
+  Status GetOutputProperties(
+      const string& node_name,
+      std::vector<OpInfo_TensorProperties>* output_props) const;
+
+ private:
+  GraphProperties properties_;
+  std::unordered_map<string, const NodeDef*> nodes_;
+  NodeTypeAttrMap type_map_;
+};
+
+// Returns the size in bytes of a tensor, or -1 if it is not statically known.
+int64_t GetTensorBytes(const OpInfo_TensorProperties& props);
+
 }  // namespace graph
 }  // namespace itex
 
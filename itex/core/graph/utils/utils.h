@@ -21,6 +21,7 @@ limitations under the License.
 #include <algorithm>
 #include <functional>
 #include <iterator>
+#include <map>
 #include <set>
 #include <string>
 #include <utility>
@@ -44,6 +45,38 @@ limitations under the License.
 namespace itex {
 namespace graph {
 
+// Predicted memory usage of one device, filled by the memory planner (see
+// memory_opt_pass/memory_planner.h).
+struct MemoryPlanSummary {
+  std::string device;
+  // Size of the arena holding all the planned intermediate tensors.
+  int64_t arena_bytes = 0;
+  // Largest total size of the tensors alive at the same time, a lower bound
+  // of `arena_bytes`.
+  int64_t live_peak_bytes = 0;
+  // Constants and variables, alive for the whole execution.
+  int64_t persistent_bytes = 0;
+  int64_t num_buffers = 0;
+  // Tensors left out of the plan because their size is not statically known.
+  int64_t num_unknown_tensors = 0;
+};
+
+// Layout regions and reorders of one run of the oneDNN layout pass, filled
+// when `ITEX_LAYOUT_COST_MODEL` is enabled (see onednn_layout/onednn_layout.h).
+struct LayoutSummary {
+  // Connected groups of nodes rewritten to oneDNN block layout ops.
+  int64_t num_regions = 0;
+  // Regions left in plain layout because their reorders cost more than the
+  // reorders they save.
+  int64_t num_rejected_regions = 0;
+  int64_t num_rejected_nodes = 0;
+  // `_OneDnnToTf` conversions in the rewritten graph and their total size.
+  int64_t num_reorders = 0;
+  int64_t reorder_bytes = 0;
+  // Conversions whose size is not statically known, not included above.
+  int64_t num_unknown_reorders = 0;
+};
+
 struct OptimizerContext {
   explicit OptimizerContext(const char* device_name)
       : device_name(device_name),
@@ -53,6 +86,13 @@ struct OptimizerContext {
   bool is_compute_intensive;
   bool enable_complete_opt;
   bool is_quantization_graph;
+  // Number of matches of each registered remapper fusion, accumulated over
+  // all remapper runs of this optimization.
+  std::map<std::string, int> fusion_match_counts;
+  // Filled by the memory planner when `ITEX_MEMORY_PLANNER` is enabled.
+  std::vector<MemoryPlanSummary> memory_plans;
+  // Filled by the oneDNN layout pass when `ITEX_LAYOUT_COST_MODEL` is enabled.
+  std::vector<LayoutSummary> layout_summaries;
 };
 
 // Check whether current graph contains compute-intensive ops or not.
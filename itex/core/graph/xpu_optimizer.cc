@@ -12,11 +12,22 @@ limitations under the License.
 
 #include "itex/core/graph/xpu_optimizer.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
 #include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "absl/strings/match.h"
 #include "itex/core/graph/auto_mixed_precision/auto_mixed_precision.h"
+#include "itex/core/graph/config_util.h"
 #include "itex/core/graph/generic_layout_optimizer/generic_layout_optimizer.h"
 #include "itex/core/graph/memory_opt_pass/memory_opt_pass.h"
+#include "itex/core/graph/memory_opt_pass/rematerialization.h"
 #include "itex/core/graph/native_layout/native_layout.h"
 #ifdef ITEX_ONEDNN_GRAPH
 #include "itex/core/graph/onednn_graph/onednn_graph.h"
@@ -25,10 +36,23 @@ limitations under the License.
 #include "itex/core/graph/optimizer_config.h"
 #include "itex/core/graph/remapper/remapper.h"
 #include "itex/core/graph/utils/utils.h"
+#include "itex/core/utils/env_time.h"
+#include "itex/core/utils/env_var.h"
 #include "itex/core/utils/errors.h"
+#include "itex/core/utils/fingerprint.h"
+#include "itex/core/utils/human_readable_json.h"
+#include "itex/core/utils/mutex.h"
 #include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/path.h"
+#include "itex/core/utils/proto_serialization.h"
+#include "itex/core/utils/protobuf/graph_optimization_report.pb.h"
+#include "itex/core/utils/str_util.h"
+#include "itex/core/utils/strcat.h"
+#include "itex/core/version.h"
 #include "tensorflow/c/experimental/grappler/grappler.h"
 
+extern char** environ;
+
 #ifndef INTEL_CPU_ONLY
 #include "itex/core/graph/tfg_optimizer_hook/tfg_optimizer_hook.h"
 #endif  // INTEL_CPU_ONLY
@@ -58,6 +82,223 @@ void Optimizer_Destroy(void* optimizer) {
   if (optimizer) delete reinterpret_cast<Optimizer*>(optimizer);
 }
 
+namespace {
+
+// Opt-in directory to cache optimized graphs across process restarts.
+constexpr char kGraphCacheDirEnv[] = "ITEX_OPTIMIZED_GRAPH_CACHE_DIR";
+
+const string& GetGraphCacheDir() {
+  static const string* dir = [] {
+    string* dir = new string;
+    ITEX_CHECK_OK(ReadStringFromEnvVar(kGraphCacheDirEnv, "", dir));
+    return dir;
+  }();
+  return *dir;
+}
+
+// Returns the cache file name of `graph_def`. The fingerprint covers
+// everything the optimization pipeline depends on: the input graph, the
+// device, the ITEX build, the optimizer config (ConfigProto and flags), the
+// nodes to preserve and the ITEX_* environment variables tuning the passes.
+string GetGraphCacheFileName(const GraphDef& graph_def,
+                             const string& device_name,
+                             const GrapplerItem& item,
+                             const OptimizerConfigFlags& config) {
+  string serialized;
+  SerializeToStringDeterministic(graph_def, &serialized);
+  uint64 fingerprint = Fingerprint64(serialized);
+
+  serialized.clear();
+  SerializeToStringDeterministic(itex_get_config(), &serialized);
+  fingerprint = FingerprintCat64(fingerprint, Fingerprint64(serialized));
+
+  std::unordered_set<string> preserve_set = item.NodesToPreserve();
+  std::vector<string> nodes_to_preserve(preserve_set.begin(),
+                                        preserve_set.end());
+  std::sort(nodes_to_preserve.begin(), nodes_to_preserve.end());
+
+  std::vector<string> env_vars;
+  for (char** env = environ; env != nullptr && *env != nullptr; ++env) {
+    StringPiece var(*env);
+    if (absl::StartsWith(var, "ITEX_") &&
+        !absl::StartsWith(var, strings::StrCat(kGraphCacheDirEnv, "="))) {
+      env_vars.emplace_back(var);
+    }
+  }
+  std::sort(env_vars.begin(), env_vars.end());
+
+  string options = strings::StrCat(
+      device_name, ";", ITEX_VERSION_MAJOR, ".", ITEX_VERSION_MINOR, ".",
+      ITEX_VERSION_PATCH, "-", ITEX_VERSION_HASH, ";", isxehpc_value, ";",
+      config.enable_sharding, config.enable_onednn_graph,
+      config.enable_onednn_graph_all_type,
+      config.enable_onednn_graph_compiler_backend,
+      config.enable_onednn_graph_dnnl_backend,
+      config.enable_tf_constant_folding, config.enable_optimize_aggressive,
+      config.enable_remapper, config.enable_auto_mixed_precision,
+      config.enable_layout_opt, config.enable_test_mode, ",",
+      config.remapper_run_pass, ";", str_util::Join(nodes_to_preserve, ","),
+      ";", str_util::Join(env_vars, ";"));
+  fingerprint = FingerprintCat64(fingerprint, Fingerprint64(options));
+
+  return strings::StrCat(strings::Hex(fingerprint, strings::kZeroPad16), ".pb");
+}
+
+// Leaves `graph_def` untouched if the cached graph is missing or can't be
+// parsed, e.g. a truncated file.
+bool LoadCachedGraph(const string& path, GraphDef* graph_def) {
+  std::ifstream file(path, std::ios::in | std::ios::binary);
+  if (!file.is_open()) return false;
+  string data((std::istreambuf_iterator<char>(file)),
+              std::istreambuf_iterator<char>());
+  GraphDef cached_graph_def;
+  if (file.bad() || !cached_graph_def.ParseFromString(data)) {
+    ITEX_LOG(WARNING) << "Ignoring corrupted optimized graph cache " << path;
+    return false;
+  }
+  *graph_def = std::move(cached_graph_def);
+  return true;
+}
+
+void StoreCachedGraph(const string& path, const GraphDef& graph_def) {
+  // oneDNN Graph kernels look up partitions registered in this process while
+  // rewriting the graph, so those graphs can't be reused by another process.
+  for (const auto& node : graph_def.node()) {
+    if (node.op().find("OneDnnGraph") != std::string::npos) {
+      ITEX_VLOG(2) << "Optimized graph with oneDNN Graph partitions is not "
+                      "cached.";
+      return;
+    }
+  }
+
+  string data;
+  if (!SerializeToStringDeterministic(graph_def, &data)) return;
+  // Write to a unique temporary file and rename it, so that concurrent
+  // processes sharing the directory never read a partial graph.
+  string tmp_path = strings::StrCat(path, ".", EnvTime::NowNanos(), ".tmp");
+  {
+    std::ofstream file(tmp_path, std::ios::out | std::ios::binary);
+    if (!file.is_open() || !file.write(data.data(), data.size())) {
+      ITEX_LOG(WARNING) << "Failed to write optimized graph cache " << tmp_path;
+      return;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    ITEX_LOG(WARNING) << "Failed to write optimized graph cache " << path;
+  }
+}
+
+// Collects wall time, node counts and remapper fusion matches of each pass into
+// a GraphOptimizationReport. Enabled by `ITEX_VERBOSE` (the report is logged)
+// or by `ITEX_GRAPH_OPTIMIZATION_REPORT`, the path of a file the reports are
+// appended to, one JSON object per line.
+class PassReporter {
+ public:
+  PassReporter(const string& device, const OptimizerContext* opt_ctx,
+               const GraphDef& graph_def)
+      : opt_ctx_(opt_ctx) {
+    enabled_ = IsVerboseEnabled() || !GetReportPath().empty();
+    if (!enabled_) return;
+    start_micros_ = EnvTime::NowMicros();
+    report_.set_device(device);
+    report_.set_num_nodes_before(graph_def.node_size());
+  }
+
+  // Called right before running a pass on `graph_def`.
+  void StartPass(const GraphDef& graph_def) {
+    if (!enabled_) return;
+    pass_num_nodes_before_ = graph_def.node_size();
+    pass_fusion_counts_before_ = opt_ctx_->fusion_match_counts;
+    pass_start_micros_ = EnvTime::NowMicros();
+  }
+
+  // Called right after the pass `name` produced `graph_def`.
+  void EndPass(const string& name, const GraphDef& graph_def) {
+    if (!enabled_) return;
+    auto* pass = report_.add_passes();
+    pass->set_name(name);
+    pass->set_wall_time_us(EnvTime::NowMicros() - pass_start_micros_);
+    pass->set_num_nodes_before(pass_num_nodes_before_);
+    pass->set_num_nodes_after(graph_def.node_size());
+    for (const auto& [fusion, count] : opt_ctx_->fusion_match_counts) {
+      auto it = pass_fusion_counts_before_.find(fusion);
+      int matched = it == pass_fusion_counts_before_.end()
+                        ? count
+                        : count - it->second;
+      if (matched > 0) (*pass->mutable_fusion_match_counts())[fusion] = matched;
+    }
+  }
+
+  // Emits the report of the whole optimization producing `graph_def`.
+  void Finish(const GraphDef& graph_def) {
+    if (!enabled_) return;
+    report_.set_num_nodes_after(graph_def.node_size());
+    report_.set_wall_time_us(EnvTime::NowMicros() - start_micros_);
+    for (const auto& summary : opt_ctx_->memory_plans) {
+      auto* plan = report_.add_memory_plans();
+      plan->set_device(summary.device);
+      plan->set_arena_bytes(summary.arena_bytes);
+      plan->set_live_peak_bytes(summary.live_peak_bytes);
+      plan->set_persistent_bytes(summary.persistent_bytes);
+      plan->set_num_buffers(summary.num_buffers);
+      plan->set_num_unknown_tensors(summary.num_unknown_tensors);
+    }
+    for (const auto& summary : opt_ctx_->layout_summaries) {
+      auto* layout = report_.add_layouts();
+      layout->set_num_regions(summary.num_regions);
+      layout->set_num_rejected_regions(summary.num_rejected_regions);
+      layout->set_num_rejected_nodes(summary.num_rejected_nodes);
+      layout->set_num_reorders(summary.num_reorders);
+      layout->set_reorder_bytes(summary.reorder_bytes);
+      layout->set_num_unknown_reorders(summary.num_unknown_reorders);
+    }
+
+    string json;
+    Status s = ProtoToHumanReadableJson(report_, &json,
+                                        /*ignore_accuracy_loss=*/true);
+    if (!s.ok()) {
+      ITEX_LOG(WARNING) << "Failed to serialize graph optimization report: "
+                        << s;
+      return;
+    }
+    if (IsVerboseEnabled()) {
+      ITEX_VLOG(0) << "Graph optimization report: " << json;
+    }
+    if (!GetReportPath().empty()) {
+      static mutex mu(LINKER_INITIALIZED);
+      mutex_lock lock(&mu);
+      std::ofstream file(GetReportPath(), std::ios::out | std::ios::app);
+      if (!file.is_open()) {
+        ITEX_LOG(WARNING) << "Failed to open " << GetReportPath();
+        return;
+      }
+      file << json << "\n";
+    }
+  }
+
+ private:
+  static const string& GetReportPath() {
+    static const string* path = [] {
+      string* path = new string;
+      ITEX_CHECK_OK(
+          ReadStringFromEnvVar("ITEX_GRAPH_OPTIMIZATION_REPORT", "", path));
+      return path;
+    }();
+    return *path;
+  }
+
+  const OptimizerContext* opt_ctx_;
+  bool enabled_;
+  GraphOptimizationReport report_;
+  uint64 start_micros_ = 0;
+  uint64 pass_start_micros_ = 0;
+  int pass_num_nodes_before_ = 0;
+  std::map<std::string, int> pass_fusion_counts_before_;
+};
+
+}  // namespace
+
 void Optimizer_Optimize(void* optimizer, const TF_Buffer* graph_buf,
                         const TF_GrapplerItem* tf_item,
                         TF_Buffer* optimized_graph_buf, TF_Status* tf_status) {
@@ -86,6 +327,22 @@ void Optimizer_Optimize(void* optimizer, const TF_Buffer* graph_buf,
   GraphDef optimized_graph_def = graph_def;
   auto config = GetOptimizerConfigFlags();
 
+  string graph_cache_path;
+  if (!GetGraphCacheDir().empty()) {
+    graph_cache_path = io::JoinPath(
+        GetGraphCacheDir(),
+        GetGraphCacheFileName(graph_def, dev_name, item, config));
+    if (LoadCachedGraph(graph_cache_path, &optimized_graph_def)) {
+      ITEX_VLOG(1) << "Load optimized graph from " << graph_cache_path;
+      SET_STATUS_IF_ERROR(tf_status, MessageToBuffer(optimized_graph_def,
+                                                     optimized_graph_buf));
+      TF_StatusFromStatus(status, tf_status);
+      return;
+    }
+  }
+
+  PassReporter reporter(dev_name, &opt_ctx, graph_def);
+
   opt_ctx.is_compute_intensive = HaveComputeIntensiveNode(graph_def);
   opt_ctx.is_quantization_graph = HaveQuantizeDequantizeNode(graph_def);
 #ifndef INTEL_CPU_ONLY
@@ -125,9 +382,11 @@ void Optimizer_Optimize(void* optimizer, const TF_Buffer* graph_buf,
       if (ITEX_VLOG_IS_ON(4)) {
         DumpGraphDefToFile("itex_optimizer_before_sharding", graph_def, "./");
       }
+      reporter.StartPass(graph_def);
       SET_STATUS_IF_ERROR(tf_status,
                           mlir::tfg::RunAutoShard(&opt_ctx, item, graph_def,
                                                   &optimized_graph_def));
+      reporter.EndPass("auto_shard", optimized_graph_def);
       if (ITEX_VLOG_IS_ON(4)) {
         DumpGraphDefToFile("itex_optimizer_after_sharding", optimized_graph_def,
                            "./");
@@ -146,78 +405,115 @@ void Optimizer_Optimize(void* optimizer, const TF_Buffer* graph_buf,
 
   optimized_graph_def.Swap(&graph_def);
   GenericLayoutOptimizer generic_layout_opt;
+  reporter.StartPass(graph_def);
   SET_STATUS_IF_ERROR(tf_status,
                       generic_layout_opt.Optimize(&opt_ctx, item, graph_def,
                                                   &optimized_graph_def));
+  reporter.EndPass("generic_layout", optimized_graph_def);
 
   if (config.enable_remapper && opt_ctx.enable_complete_opt) {
     if (onednn_graph_optimize) {
       // We don't want full scope remapper here if oneDNN graph is enabled.
       optimized_graph_def.Swap(&graph_def);
+      reporter.StartPass(graph_def);
       SET_STATUS_IF_ERROR(tf_status, RunRemapper(&opt_ctx, item, graph_def,
                                                  &optimized_graph_def, false));
+      reporter.EndPass("partial_remapper", optimized_graph_def);
     } else {
       // Run remapper twice for full scope fusions if oneDNN graph is disabled.
+      // Later runs only revisit the nodes affected by the previous one.
+      RemapperWorklist remapper_worklist;
       for (int i = 0; i < config.remapper_run_pass; ++i) {
         optimized_graph_def.Swap(&graph_def);
-        SET_STATUS_IF_ERROR(tf_status, RunRemapper(&opt_ctx, item, graph_def,
-                                                   &optimized_graph_def, true,
-                                                   RemapperLevel(i)));
+        reporter.StartPass(graph_def);
+        SET_STATUS_IF_ERROR(
+            tf_status,
+            RunRemapper(&opt_ctx, item, graph_def, &optimized_graph_def, true,
+                        RemapperLevel(i), &remapper_worklist));
+        reporter.EndPass("remapper", optimized_graph_def);
       }
     }
   }
 
   if (config.enable_auto_mixed_precision && opt_ctx.enable_complete_opt) {
     optimized_graph_def.Swap(&graph_def);
+    reporter.StartPass(graph_def);
     SET_STATUS_IF_ERROR(
         tf_status,
         RunAutoMixedPrecision(&opt_ctx, item, graph_def, &optimized_graph_def));
+    reporter.EndPass("auto_mixed_precision", optimized_graph_def);
     // Because after running auto_mixed_precision, it will insert Cast op
     // before Const op. So run remapper Const + Cast fusion will remove
     // these overhead.
     // We don't want ITEX remapper pass change graph before LLGA pass
     if (config.enable_remapper && !onednn_graph_optimize) {
       optimized_graph_def.Swap(&graph_def);
+      reporter.StartPass(graph_def);
       SET_STATUS_IF_ERROR(tf_status, RunRemapper(&opt_ctx, item, graph_def,
                                                  &optimized_graph_def));
+      reporter.EndPass("remapper", optimized_graph_def);
     }
   }
 
 #ifdef ITEX_ONEDNN_GRAPH
   if (onednn_graph_optimize && opt_ctx.enable_complete_opt) {
     optimized_graph_def.Swap(&graph_def);
+    reporter.StartPass(graph_def);
     SET_STATUS_IF_ERROR(tf_status,
                         RunOneDnnGraph(item, graph_def, &optimized_graph_def));
+    reporter.EndPass("onednn_graph", optimized_graph_def);
 
     // Run the full scope remapper here since only got partial remapper before
     // if oneDNN graph is enabled.
     if (config.enable_remapper) {
+      RemapperWorklist remapper_worklist;
       for (int i = 0; i < config.remapper_run_pass; ++i) {
         optimized_graph_def.Swap(&graph_def);
-        SET_STATUS_IF_ERROR(tf_status, RunRemapper(&opt_ctx, item, graph_def,
-                                                   &optimized_graph_def, true,
-                                                   RemapperLevel(i)));
+        reporter.StartPass(graph_def);
+        SET_STATUS_IF_ERROR(
+            tf_status,
+            RunRemapper(&opt_ctx, item, graph_def, &optimized_graph_def, true,
+                        RemapperLevel(i), &remapper_worklist));
+        reporter.EndPass("remapper", optimized_graph_def);
       }
     }
   }
 #endif  // ITEX_ONEDNN_GRAPH
 
+  // Recompute cheap forward nodes in the backward pass if the activations of
+  // a training graph exceed the memory budget. Run before the layout passes
+  // so the recomputed nodes are rewritten like the others.
+  if (opt_ctx.enable_complete_opt && GetRematMemoryBudget() > 0) {
+    optimized_graph_def.Swap(&graph_def);
+    reporter.StartPass(graph_def);
+    SET_STATUS_IF_ERROR(tf_status,
+                        RunRematerialization(&opt_ctx, item, graph_def,
+                                             &optimized_graph_def));
+    reporter.EndPass("rematerialization", optimized_graph_def);
+  }
+
   if (config.enable_layout_opt && opt_ctx.enable_complete_opt) {
     optimized_graph_def.Swap(&graph_def);
+    reporter.StartPass(graph_def);
     SET_STATUS_IF_ERROR(tf_status, RunOneDnnLayout(&opt_ctx, item, graph_def,
                                                    &optimized_graph_def));
+    reporter.EndPass("onednn_layout", optimized_graph_def);
   }
 
   // Put post Native Format rewrite pass for better co-working with oneDNN
   // layout.
   optimized_graph_def.Swap(&graph_def);
+  reporter.StartPass(graph_def);
   SET_STATUS_IF_ERROR(tf_status, RunNativeLayout(&opt_ctx, item, graph_def,
                                                  &optimized_graph_def));
+  reporter.EndPass("native_layout", optimized_graph_def);
 
   // Memory Optimization
   optimized_graph_def.Swap(&graph_def);
+  reporter.StartPass(graph_def);
   SET_STATUS_IF_ERROR(tf_status, RunMemoryOptPass(&opt_ctx, item, graph_def,
                                                   &optimized_graph_def));
+  reporter.EndPass("memory_opt", optimized_graph_def);
 
   if (IsVerboseEnabled()) {
     end = std::chrono::steady_clock::now();
@@ -225,11 +521,16 @@ void Optimizer_Optimize(void* optimizer, const TF_Buffer* graph_buf,
     ITEX_VLOG(0) << "Time for graph optimize costs " << duration.count()
                  << " sec\n";
   }
+  reporter.Finish(optimized_graph_def);
 
   if (ITEX_VLOG_IS_ON(4)) {
     DumpGraphDefToFile("itex_optimizer", optimized_graph_def, "./");
   }
 
+  if (!graph_cache_path.empty()) {
+    StoreCachedGraph(graph_cache_path, optimized_graph_def);
+  }
+
   // Serialize output GraphDef into optimized_graph_buf.
   SET_STATUS_IF_ERROR(
       tf_status, MessageToBuffer(optimized_graph_def, optimized_graph_buf));
@@ -317,6 +317,7 @@ class BatchMatMulOp : public OpKernel {
 
     // Skip primitive execution if the calculation is meaningless.
     if (!is_input_zero_) {
+      ReportPrimitiveImplementation(matmul_primitive_);
       matmul_primitive_.execute(onednn_stream_, fwd_primitive_args_);
     }
 
@@ -28,6 +28,7 @@ limitations under the License.
 #include "itex/core/utils/errors.h"
 #include "itex/core/utils/onednn/onednn_layout_util.h"
 #include "itex/core/utils/onednn/onednn_post_op_util.h"
+#include "itex/core/utils/onednn/onednn_primitive_cache.h"
 #include "itex/core/utils/onednn/onednn_util.h"
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/op_requires.h"
@@ -718,8 +719,15 @@ class ConvOpBase : public OpKernel {
   void InitOrSetMemory(OpKernelContext* context) {
     if (!(enable_cache_ && is_init_ && context->is_input_same(0, input_dims_) &&
           context->is_input_same(1, filter_dims_) && !is_format_reordered_)) {
-      Init(context);
-      return;
+      // Shape changed, try the objects created for a previously seen shape
+      // before falling back to a full initialization.
+      if (!(enable_cache_ && RestoreFromPrimitiveCache(context))) {
+        Init(context);
+        if (enable_cache_ && is_init_ && context->status().ok()) {
+          SaveToPrimitiveCache();
+        }
+        return;
+      }
     }
 
     if (is_input_zero_) {
@@ -798,6 +806,7 @@ class ConvOpBase : public OpKernel {
     }
 
     if (!is_format_reordered_) {
+      ReportPrimitiveImplementation(fwd_primitive_);
       fwd_primitive_.execute(onednn_stream_, fwd_primitives_args_);
     }
     scratchpad_tensor_.reset();
@@ -806,6 +815,8 @@ class ConvOpBase : public OpKernel {
   void Init(OpKernelContext* context) {
     try {
       fwd_primitives_args_.clear();
+      is_init_ = false;
+      is_input_zero_ = false;
 
       const Tensor& src_tensor = context->input(kSrcIndex_);
       const Tensor& filter_tensor = context->input(kFilterIndex_);
@@ -1132,6 +1143,101 @@ class ConvOpBase : public OpKernel {
     return;
   }
 
+  // Keep the shape dependent oneDNN objects created by Init(), including the
+  // reordered filter, so they can be reused when this shape comes back.
+  void SaveToPrimitiveCache() {
+    // Only the objects usable by the fast path in InitOrSetMemory are kept.
+    if (!primitive_cache_.IsEnabled() || is_format_reordered_ ||
+        is_filter_zero_) {
+      return;
+    }
+    PrimitiveCacheEntry entry;
+    entry.input_dims = input_dims_;
+    entry.filter_dims = filter_dims_;
+    entry.dst_tensor_shape = dst_tensor_shape_;
+    entry.dst_dims_onednn = dst_dims_onednn_;
+    entry.dst_md = dst_md_;
+    entry.add_dst_md = add_dst_md_;
+    entry.is_input_zero = is_input_zero_;
+    entry.is_filter_reordered = is_filter_reordered_;
+    entry.scratchpad_size = scratchpad_size_;
+    entry.fwd_pd = fwd_pd_;
+    entry.fwd_primitive = fwd_primitive_;
+    entry.weight_reorder = weight_reorder_;
+    entry.fwd_primitives_args = fwd_primitives_args_;
+    entry.weight_reorder_args = weight_reorder_args_;
+    entry.src_mem = src_mem_;
+    entry.src_mem_opt = src_mem_opt_;
+    entry.dst_mem = dst_mem_;
+    entry.dst_mem_opt = dst_mem_opt_;
+    entry.filter_mem = filter_mem_;
+    entry.filter_mem_input = filter_mem_input_;
+    entry.scratchpad_mem = scratchpad_mem_;
+    entry.bias_mem = bias_mem_;
+    // Tensor copy constructor requires an initialized tensor, so assign it.
+    entry.tmp_weight = std::make_shared<Tensor>();
+    *entry.tmp_weight = tmp_weight_;
+    primitive_cache_.Insert(
+        PrimitiveCache::MakeKey({&input_dims_, &filter_dims_}),
+        std::move(entry));
+  }
+
+  // Restore the objects created for the current input shapes, return false if
+  // this shape has not been seen or was evicted.
+  bool RestoreFromPrimitiveCache(OpKernelContext* context) {
+    if (!primitive_cache_.IsEnabled()) return false;
+    std::vector<int64> input_dims, filter_dims;
+    const TensorShape& src_shape = context->input(kSrcIndex_).shape();
+    for (int i = 0; i < src_shape.dims(); ++i) {
+      input_dims.push_back(src_shape.dim_size(i));
+    }
+    const TensorShape& filter_shape = context->input(kFilterIndex_).shape();
+    for (int i = 0; i < filter_shape.dims(); ++i) {
+      filter_dims.push_back(filter_shape.dim_size(i));
+    }
+
+    PrimitiveCacheEntry* entry = primitive_cache_.Find(
+        PrimitiveCache::MakeKey({&input_dims, &filter_dims}));
+    if (entry == nullptr) return false;
+
+    input_dims_ = entry->input_dims;
+    filter_dims_ = entry->filter_dims;
+    dst_tensor_shape_ = entry->dst_tensor_shape;
+    dst_dims_onednn_ = entry->dst_dims_onednn;
+    dst_md_ = entry->dst_md;
+    add_dst_md_ = entry->add_dst_md;
+    is_input_zero_ = entry->is_input_zero;
+    is_filter_reordered_ = entry->is_filter_reordered;
+    is_format_reordered_ = false;
+    scratchpad_size_ = entry->scratchpad_size;
+    fwd_pd_ = entry->fwd_pd;
+    fwd_primitive_ = entry->fwd_primitive;
+    weight_reorder_ = entry->weight_reorder;
+    fwd_primitives_args_ = entry->fwd_primitives_args;
+    weight_reorder_args_ = entry->weight_reorder_args;
+    src_mem_ = entry->src_mem;
+    src_mem_opt_ = entry->src_mem_opt;
+    dst_mem_ = entry->dst_mem;
+    dst_mem_opt_ = entry->dst_mem_opt;
+    filter_mem_ = entry->filter_mem;
+    filter_mem_input_ = entry->filter_mem_input;
+    scratchpad_mem_ = entry->scratchpad_mem;
+    bias_mem_ = entry->bias_mem;
+    tmp_weight_ = *entry->tmp_weight;
+
+    if (post_op_util_.HasBN()) {
+      // BN memory objects are owned by `post_op_util_` and re-created by every
+      // Init(), point the restored arguments to the current ones.
+      for (int i = 0; i < 4; ++i) {
+        fwd_primitives_args_.erase(DNNL_ARG_ATTR_MULTIPLE_POST_OP(i) |
+                                   DNNL_ARG_SRC_1);
+      }
+      post_op_util_.AddBNPrimArgs(&fwd_primitives_args_);
+    }
+    is_init_ = true;
+    return true;
+  }
+
  private:
   TensorFormat data_format_;
   std::vector<int32_t> strides_;
@@ -1147,6 +1253,26 @@ class ConvOpBase : public OpKernel {
   mutex mu_compute_;
   HostDataCache<Device, float> output_scale_cache_;
 
+  // oneDNN objects created by Init() for one pair of input shapes.
+  struct PrimitiveCacheEntry {
+    std::vector<int64> input_dims, filter_dims;
+    TensorShape dst_tensor_shape;
+    dnnl::memory::dims dst_dims_onednn;
+    memory::desc dst_md, add_dst_md;
+    bool is_input_zero = false;
+    bool is_filter_reordered = false;
+    int64_t scratchpad_size = 0;
+    ConvFwdPd fwd_pd;
+    primitive fwd_primitive;
+    dnnl::reorder weight_reorder;
+    std::unordered_map<int, memory> fwd_primitives_args, weight_reorder_args;
+    dnnl::memory src_mem, src_mem_opt, dst_mem, dst_mem_opt, filter_mem,
+        filter_mem_input, scratchpad_mem, bias_mem;
+    std::shared_ptr<Tensor> tmp_weight;
+  };
+  using PrimitiveCache = OneDnnPrimitiveCache<PrimitiveCacheEntry>;
+  PrimitiveCache primitive_cache_;
+
  protected:
   std::vector<int64_t> explicit_paddings_;
   bool is_conv2d_;
@@ -15,8 +15,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-#ifndef ITEX_CORE_KERNELS_GPU_DENSE_UPDATE_FUNCTOR_H_
-#define ITEX_CORE_KERNELS_GPU_DENSE_UPDATE_FUNCTOR_H_
+#ifndef ITEX_CORE_KERNELS_COMMON_DENSE_UPDATE_FUNCTOR_H_
+#define ITEX_CORE_KERNELS_COMMON_DENSE_UPDATE_FUNCTOR_H_
 
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/op_requires.h"
@@ -117,4 +117,4 @@ TF_CALL_complex128(DEFINE_GPU_KERNELS);
 
 }  // end namespace itex
 
-#endif  // ITEX_CORE_KERNELS_GPU_DENSE_UPDATE_FUNCTOR_H_
+#endif  // ITEX_CORE_KERNELS_COMMON_DENSE_UPDATE_FUNCTOR_H_
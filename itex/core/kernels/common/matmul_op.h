@@ -28,6 +28,7 @@ limitations under the License.
 #include "itex/core/utils/bcast.h"
 #include "itex/core/utils/errors.h"
 #include "itex/core/utils/onednn/onednn_post_op_util.h"
+#include "itex/core/utils/onednn/onednn_primitive_cache.h"
 #include "itex/core/utils/onednn/onednn_util.h"
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/op_requires.h"
@@ -283,8 +284,15 @@ class MatMulOp : public OpKernel {
   void InitOrSetMemory(OpKernelContext* context) {
     if (!(enable_cache_ && is_init_ && context->is_input_same(0, input_dims_) &&
           context->is_input_same(1, weights_dims_))) {
-      Init(context);
-      return;
+      // Shape changed, try the objects created for a previously seen shape
+      // before falling back to a full initialization.
+      if (!(enable_cache_ && RestoreFromPrimitiveCache(context))) {
+        Init(context);
+        if (enable_cache_ && is_init_ && context->status().ok()) {
+          SaveToPrimitiveCache();
+        }
+        return;
+      }
     }
 
     if (is_input_zero_) {
@@ -352,6 +360,8 @@ class MatMulOp : public OpKernel {
     const Tensor& src_tensor = context->input(0);
     const Tensor& weights_tensor = context->input(1);
     fwd_primitive_args_.clear();
+    is_init_ = false;
+    is_input_zero_ = false;
     auto input_shape = src_tensor.shape();
     input_dims_.clear();
     for (int i = 0; i < input_shape.dims(); ++i) {
@@ -564,16 +574,29 @@ class MatMulOp : public OpKernel {
                                           weight_cached_data);
         } else {
           // Reorder if cache is failed since pd has already used any format.
-          int64_t reorder_size = weights_md_prefer.get_size() / sizeof(T);
-          OP_REQUIRES_OK(context,
-                         context->allocate_temp(DataTypeToEnum<T>::v(),
-                                                TensorShape({reorder_size}),
-                                                &tmp_weight_));
+          // The shapes kept in the primitive cache share one buffer per
+          // layout, a const weight is only reordered once into it.
+          bool is_reordered = false;
+          if (enable_cache_ && primitive_cache_.IsEnabled()) {
+            is_reordered = FindReorderedWeight(weights_md_prefer, &tmp_weight_);
+          }
+          if (!is_reordered) {
+            int64_t reorder_size = weights_md_prefer.get_size() / sizeof(T);
+            OP_REQUIRES_OK(context,
+                           context->allocate_temp(DataTypeToEnum<T>::v(),
+                                                  TensorShape({reorder_size}),
+                                                  &tmp_weight_));
+            if (enable_cache_ && primitive_cache_.IsEnabled()) {
+              reordered_weights_.emplace_back(weights_md_prefer, tmp_weight_);
+            }
+          }
           void* data_handle = GetTensorBuffer<T>(&tmp_weight_);
           weights_mem_ =
               CreateDnnlMemory(weights_md_prefer, dnnl_engine_, data_handle);
-          ReorderMemory(*context, &weights_mem_input_, &weights_mem_,
-                        dnnl_engine_);
+          if (!is_reordered || !is_filter_const_) {
+            ReorderMemory(*context, &weights_mem_input_, &weights_mem_,
+                          dnnl_engine_);
+          }
         }
       } else {
         weights_mem_ = weights_mem_input_;
@@ -631,10 +654,97 @@ class MatMulOp : public OpKernel {
       return;
     }
 
+    ReportPrimitiveImplementation(matmul_primitive_);
     matmul_primitive_.execute(dnnl_stream_, fwd_primitive_args_);
     scratchpad_tensor_.reset();
   }
 
+  // Keep the shape dependent oneDNN objects created by Init(), including the
+  // reordered weight, so they can be reused when this shape comes back.
+  void SaveToPrimitiveCache() {
+    if (!primitive_cache_.IsEnabled()) return;
+    PrimitiveCacheEntry entry;
+    entry.input_dims = input_dims_;
+    entry.weights_dims = weights_dims_;
+    entry.dst_shape = dst_shape_;
+    entry.is_input_zero = is_input_zero_;
+    entry.is_weight_reorder = is_weight_reorder_;
+    entry.scratchpad_size = scratchpad_size_;
+#ifdef INTEL_CPU_ONLY
+    entry.single_thread = single_thread_;
+#endif
+    entry.matmul_primitive = matmul_primitive_;
+    entry.fwd_primitive_args = fwd_primitive_args_;
+    entry.src_mem = src_mem_;
+    entry.weights_mem = weights_mem_;
+    entry.weights_mem_input = weights_mem_input_;
+    entry.dst_mem = dst_mem_;
+    entry.bias_mem = bias_mem_;
+    entry.fuse_add_src_mem = fuse_add_src_mem_;
+    entry.fuse_add_dst_mem = fuse_add_dst_mem_;
+    entry.scratchpad_mem = scratchpad_mem_;
+    // Tensor copy constructor requires an initialized tensor, so assign it.
+    entry.tmp_weight = std::make_shared<Tensor>();
+    *entry.tmp_weight = tmp_weight_;
+    primitive_cache_.Insert(
+        PrimitiveCache::MakeKey({&input_dims_, &weights_dims_}),
+        std::move(entry));
+  }
+
+  // Looks up the buffer of the weight reordered to `md` for another shape.
+  bool FindReorderedWeight(const dnnl::memory::desc& md, Tensor* weight) {
+    for (const auto& reordered : reordered_weights_) {
+      if (reordered.first == md) {
+        *weight = reordered.second;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Restore the objects created for the current input shapes, return false if
+  // this shape has not been seen or was evicted.
+  bool RestoreFromPrimitiveCache(OpKernelContext* context) {
+    if (!primitive_cache_.IsEnabled()) return false;
+    std::vector<int64> input_dims, weights_dims;
+    const TensorShape& input_shape = context->input(kSrcIndex_).shape();
+    for (int i = 0; i < input_shape.dims(); ++i) {
+      input_dims.push_back(input_shape.dim_size(i));
+    }
+    const TensorShape& weights_shape = context->input(kWeightIndex_).shape();
+    for (int i = 0; i < weights_shape.dims(); ++i) {
+      weights_dims.push_back(weights_shape.dim_size(i));
+    }
+
+    PrimitiveCacheEntry* entry =
+        primitive_cache_.Find(PrimitiveCache::MakeKey({&input_dims,
+                                                       &weights_dims}));
+    if (entry == nullptr) return false;
+
+    input_dims_ = entry->input_dims;
+    weights_dims_ = entry->weights_dims;
+    dst_shape_ = entry->dst_shape;
+    is_input_zero_ = entry->is_input_zero;
+    is_weight_reorder_ = entry->is_weight_reorder;
+    scratchpad_size_ = entry->scratchpad_size;
+#ifdef INTEL_CPU_ONLY
+    single_thread_ = entry->single_thread;
+#endif
+    matmul_primitive_ = entry->matmul_primitive;
+    fwd_primitive_args_ = entry->fwd_primitive_args;
+    src_mem_ = entry->src_mem;
+    weights_mem_ = entry->weights_mem;
+    weights_mem_input_ = entry->weights_mem_input;
+    dst_mem_ = entry->dst_mem;
+    bias_mem_ = entry->bias_mem;
+    fuse_add_src_mem_ = entry->fuse_add_src_mem;
+    fuse_add_dst_mem_ = entry->fuse_add_dst_mem;
+    scratchpad_mem_ = entry->scratchpad_mem;
+    tmp_weight_ = *entry->tmp_weight;
+    is_init_ = true;
+    return true;
+  }
+
  protected:
   bool adj_x_ = false;
   bool adj_y_ = false;
@@ -674,6 +784,28 @@ class MatMulOp : public OpKernel {
   dnnl::stream dnnl_stream_;
   dnnl::engine dnnl_engine_;
   HostDataCache<Device, float> output_scale_cache_;
+
+  // oneDNN objects created by Init() for one pair of input shapes.
+  struct PrimitiveCacheEntry {
+    std::vector<int64> input_dims, weights_dims;
+    TensorShape dst_shape;
+    bool is_input_zero = false;
+    bool is_weight_reorder = false;
+    int64_t scratchpad_size = 0;
+#ifdef INTEL_CPU_ONLY
+    int single_thread = -1;
+#endif
+    dnnl::matmul matmul_primitive;
+    std::unordered_map<int, memory> fwd_primitive_args;
+    memory src_mem, weights_mem, weights_mem_input, dst_mem, bias_mem,
+        fuse_add_src_mem, fuse_add_dst_mem, scratchpad_mem;
+    std::shared_ptr<Tensor> tmp_weight;
+  };
+  using PrimitiveCache = OneDnnPrimitiveCache<PrimitiveCacheEntry>;
+  PrimitiveCache primitive_cache_;
+  // Weights reordered to a layout other than the one of the weight cache,
+  // shared by the cache entries of all the shapes using that layout.
+  std::vector<std::pair<dnnl::memory::desc, Tensor>> reordered_weights_;
 };
 
 template <typename Device, typename T, typename Tout, typename Tpost,
@@ -1013,6 +1145,7 @@ class MatMulFunctor {
       return;
     }
 
+    ReportPrimitiveImplementation(matmul_primitive_);
     matmul_primitive_.execute(dnnl_stream_, fwd_primitive_args_);
 
     scratchpad_tensor_.reset();
@@ -15,12 +15,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-#ifndef ITEX_CORE_KERNELS_GPU_TRAINING_OP_HELPERS_H_
-#define ITEX_CORE_KERNELS_GPU_TRAINING_OP_HELPERS_H_
+#ifndef ITEX_CORE_KERNELS_COMMON_TRAINING_OP_HELPERS_H_
+#define ITEX_CORE_KERNELS_COMMON_TRAINING_OP_HELPERS_H_
 
 #include <vector>
 
-#include "itex/core/kernels/gpu/dense_update_functor.h"
+#include "itex/core/kernels/common/dense_update_functor.h"
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/plugin_tensor.h"
 #include "itex/core/utils/status.h"
@@ -268,4 +268,4 @@ Status AssignUpdateVariable(OpKernelContext* ctx, int input_index,
 
 }  // namespace itex
 
-#endif  // ITEX_CORE_KERNELS_GPU_TRAINING_OP_HELPERS_H_
+#endif  // ITEX_CORE_KERNELS_COMMON_TRAINING_OP_HELPERS_H_
@@ -0,0 +1,500 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Microbenchmark of the oneDNN primitives behind the CPU kernels (matmul,
+// convolution, layer norm, softmax) and of the CPU FmhaFunctor, swept over
+// shapes and data types.
+//
+// Every primitive is reported with three timings:
+//   create_us:        first creation of the primitive, including JIT.
+//   cached_create_us: creation of the same primitive again, which is what a
+//                     kernel pays on every Compute() when it hits the oneDNN
+//                     primitive cache.
+//   exec_us:          mean time of one execution after warmup.
+// GFLOP/s and GB/s are derived from exec_us, bytes count every input and
+// output once. Results are printed, and written as JSON with --output so
+// runs of different releases can be compared.
+//
+// Shapes are comma separated lists of 'x' separated dims, e.g.
+//   onednn_cpu_benchmark --matmul=128x4096x4096,1x4096x4096 \
+//       --dtypes=float,bfloat16 --output=result.json
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dnnl.hpp"  // NOLINT(build/include_subdir)
+#include "itex/core/kernels/cpu/mha_op.h"
+#include "itex/core/utils/command_line_flags.h"
+#include "itex/core/utils/env_time.h"
+#include "itex/core/utils/logging.h"
+#include "itex/core/utils/numbers.h"
+#include "itex/core/utils/onednn/onednn_util.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/str_util.h"
+#include "itex/core/utils/strcat.h"
+#include "itex/core/utils/stringprintf.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+namespace benchmark {
+
+using dnnl::memory;
+
+struct BenchmarkOptions {
+  int32 warmup = 10;
+  int32 iterations = 100;
+};
+
+struct BenchmarkResult {
+  string op;
+  string dtype;
+  string shape;
+  double create_us = 0;
+  double cached_create_us = 0;
+  double exec_us = 0;
+  double flops = 0;
+  double bytes = 0;
+};
+
+double ElapsedMicros(uint64 start_ns) {
+  return (EnvTime::NowNanos() - start_ns) / 1e3;
+}
+
+// Mean time of `fn` in microseconds after `options.warmup` runs.
+double TimeExecution(const BenchmarkOptions& options,
+                     const std::function<void()>& fn) {
+  for (int i = 0; i < options.warmup; ++i) fn();
+  uint64 start = EnvTime::NowNanos();
+  for (int i = 0; i < options.iterations; ++i) fn();
+  return ElapsedMicros(start) / std::max(options.iterations, 1);
+}
+
+// Times the first and the cached creation of a primitive, `create` must
+// build the primitive descriptor and the primitive.
+template <typename Primitive>
+Primitive TimeCreation(const std::function<Primitive()>& create,
+                       BenchmarkResult* result) {
+  uint64 start = EnvTime::NowNanos();
+  Primitive primitive = create();
+  result->create_us = ElapsedMicros(start);
+  start = EnvTime::NowNanos();
+  create();
+  result->cached_create_us = ElapsedMicros(start);
+  return primitive;
+}
+
+// Returns a oneDNN memory of `md` filled with uniform values in [-1, 1).
+// Buffers stay alive in `buffers` until the benchmark finishes.
+template <typename T>
+memory RandomMemory(const memory::desc& md, const dnnl::engine& engine,
+                    std::vector<std::vector<T>>* buffers) {
+  static std::mt19937 generator(2023);
+  std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+  std::vector<T> buffer(md.get_size() / sizeof(T));
+  for (auto& value : buffer) value = static_cast<T>(distribution(generator));
+  buffers->push_back(std::move(buffer));
+  return CreateDnnlMemory(md, engine, buffers->back().data());
+}
+
+template <typename T>
+memory::desc PlainDesc(const memory::dims& dims) {
+  return CreatePlainMemDescWithFormatTag<T>(dims);
+}
+
+string DimsToString(const std::vector<int64>& dims) {
+  return str_util::Join(dims, "x");
+}
+
+// Runs `primitive` with `args` and fills the timings of `result`. A user
+// scratchpad is allocated like the kernels do.
+void TimePrimitive(const BenchmarkOptions& options, const dnnl::engine& engine,
+                   dnnl::stream* stream, const dnnl::primitive& primitive,
+                   const memory::desc& scratchpad_md,
+                   std::unordered_map<int, memory> args,
+                   BenchmarkResult* result) {
+  std::vector<uint8> scratchpad(scratchpad_md.get_size());
+  args.insert({DNNL_ARG_SCRATCHPAD,
+               CreateDnnlMemory(scratchpad_md, engine, scratchpad.data())});
+  result->exec_us = TimeExecution(options, [&]() {
+    primitive.execute(*stream, args);
+    stream->wait();
+  });
+}
+
+// [m, k] x [k, n]. Weights use the blocked layout picked by oneDNN and are
+// reordered once outside the timed region, like the weight cache does.
+template <typename T>
+BenchmarkResult BenchmarkMatMul(const BenchmarkOptions& options,
+                                const dnnl::engine& engine,
+                                dnnl::stream* stream,
+                                const std::vector<int64>& dims) {
+  const int64 m = dims[0], n = dims[1], k = dims[2];
+  BenchmarkResult result;
+  result.op = "matmul";
+  result.shape = DimsToString(dims);
+
+  auto src_md = PlainDesc<T>({m, k});
+  auto weights_md =
+      memory::desc({k, n}, OneDnnType<T>(), memory::format_tag::any);
+  auto dst_md = PlainDesc<T>({m, n});
+  dnnl::primitive_attr attr;
+  attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+  dnnl::matmul::primitive_desc pd;
+  auto primitive = TimeCreation<dnnl::matmul>(
+      [&]() {
+        pd = dnnl::matmul::primitive_desc(engine, src_md, weights_md, dst_md,
+                                          attr);
+        return dnnl::matmul(pd);
+      },
+      &result);
+
+  std::vector<std::vector<T>> buffers;
+  memory plain_weights =
+      RandomMemory<T>(PlainDesc<T>({k, n}), engine, &buffers);
+  memory weights = plain_weights;
+  if (pd.weights_desc() != plain_weights.get_desc()) {
+    weights = CreateDnnlMemory(pd.weights_desc(), engine);
+    dnnl::reorder(plain_weights, weights)
+        .execute(*stream, plain_weights, weights);
+    stream->wait();
+  }
+  TimePrimitive(options, engine, stream, primitive, pd.scratchpad_desc(),
+                {{DNNL_ARG_SRC, RandomMemory<T>(src_md, engine, &buffers)},
+                 {DNNL_ARG_WEIGHTS, weights},
+                 {DNNL_ARG_DST, RandomMemory<T>(dst_md, engine, &buffers)}},
+                &result);
+  result.flops = 2.0 * m * n * k;
+  result.bytes = (m * k + k * n + m * n) * sizeof(T);
+  return result;
+}
+
+// NHWC input [n, h, w, c], filter [r, s, c, oc], stride and same padding.
+template <typename T>
+BenchmarkResult BenchmarkConv(const BenchmarkOptions& options,
+                              const dnnl::engine& engine, dnnl::stream* stream,
+                              const std::vector<int64>& dims) {
+  const int64 n = dims[0], h = dims[1], w = dims[2], c = dims[3];
+  const int64 oc = dims[4], r = dims[5], s = dims[6], stride = dims[7];
+  const int64 oh = (h + stride - 1) / stride, ow = (w + stride - 1) / stride;
+  const int64 pad_h = std::max<int64>((oh - 1) * stride + r - h, 0);
+  const int64 pad_w = std::max<int64>((ow - 1) * stride + s - w, 0);
+  BenchmarkResult result;
+  result.op = "conv2d";
+  result.shape = DimsToString(dims);
+
+  auto src_md = memory::desc({n, c, h, w}, OneDnnType<T>(),
+                             memory::format_tag::nhwc);
+  auto filter_md = memory::desc({oc, c, r, s}, OneDnnType<T>(),
+                                memory::format_tag::any);
+  auto dst_md = memory::desc({n, oc, oh, ow}, OneDnnType<T>(),
+                             memory::format_tag::nhwc);
+  dnnl::primitive_attr attr;
+  attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+  dnnl::convolution_forward::primitive_desc pd;
+  auto primitive = TimeCreation<dnnl::convolution_forward>(
+      [&]() {
+        pd = dnnl::convolution_forward::primitive_desc(
+            engine, dnnl::prop_kind::forward_inference,
+            dnnl::algorithm::convolution_direct, src_md, filter_md, dst_md,
+            {stride, stride}, {0, 0}, {pad_h / 2, pad_w / 2},
+            {pad_h - pad_h / 2, pad_w - pad_w / 2}, attr);
+        return dnnl::convolution_forward(pd);
+      },
+      &result);
+
+  std::vector<std::vector<T>> buffers;
+  TimePrimitive(
+      options, engine, stream, primitive, pd.scratchpad_desc(),
+      {{DNNL_ARG_SRC, RandomMemory<T>(src_md, engine, &buffers)},
+       {DNNL_ARG_WEIGHTS,
+        RandomMemory<T>(pd.weights_desc(), engine, &buffers)},
+       {DNNL_ARG_DST, RandomMemory<T>(dst_md, engine, &buffers)}},
+      &result);
+  result.flops = 2.0 * n * oh * ow * oc * c * r * s;
+  result.bytes =
+      (n * h * w * c + r * s * c * oc + n * oh * ow * oc) * sizeof(T);
+  return result;
+}
+
+// Layer norm over the last dim of [rows, cols] with fp32 scale and shift.
+template <typename T>
+BenchmarkResult BenchmarkLayerNorm(const BenchmarkOptions& options,
+                                   const dnnl::engine& engine,
+                                   dnnl::stream* stream,
+                                   const std::vector<int64>& dims) {
+  const int64 rows = dims[0], cols = dims[1];
+  BenchmarkResult result;
+  result.op = "layer_norm";
+  result.shape = DimsToString(dims);
+
+  auto src_md = PlainDesc<T>({rows, cols});
+  auto scale_md = PlainDesc<float>({cols});
+  dnnl::primitive_attr attr;
+  attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+  dnnl::layer_normalization_forward::primitive_desc pd;
+  auto primitive = TimeCreation<dnnl::layer_normalization_forward>(
+      [&]() {
+        pd = dnnl::layer_normalization_forward::primitive_desc(
+            engine, dnnl::prop_kind::forward_inference, src_md, src_md, 1e-5f,
+            dnnl::normalization_flags::use_scale |
+                dnnl::normalization_flags::use_shift,
+            attr);
+        return dnnl::layer_normalization_forward(pd);
+      },
+      &result);
+
+  std::vector<std::vector<T>> buffers;
+  std::vector<std::vector<float>> float_buffers;
+  TimePrimitive(
+      options, engine, stream, primitive, pd.scratchpad_desc(),
+      {{DNNL_ARG_SRC, RandomMemory<T>(src_md, engine, &buffers)},
+       {DNNL_ARG_DST, RandomMemory<T>(src_md, engine, &buffers)},
+       {DNNL_ARG_SCALE, RandomMemory<float>(scale_md, engine, &float_buffers)},
+       {DNNL_ARG_SHIFT,
+        RandomMemory<float>(scale_md, engine, &float_buffers)}},
+      &result);
+  result.flops = 8.0 * rows * cols;
+  result.bytes = 2.0 * rows * cols * sizeof(T) + 2.0 * cols * sizeof(float);
+  return result;
+}
+
+// Softmax over the last dim of [rows, cols].
+template <typename T>
+BenchmarkResult BenchmarkSoftmax(const BenchmarkOptions& options,
+                                 const dnnl::engine& engine,
+                                 dnnl::stream* stream,
+                                 const std::vector<int64>& dims) {
+  const int64 rows = dims[0], cols = dims[1];
+  BenchmarkResult result;
+  result.op = "softmax";
+  result.shape = DimsToString(dims);
+
+  auto src_md = PlainDesc<T>({rows, cols});
+  dnnl::primitive_attr attr;
+  attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+  dnnl::softmax_forward::primitive_desc pd;
+  auto primitive = TimeCreation<dnnl::softmax_forward>(
+      [&]() {
+        pd = dnnl::softmax_forward::primitive_desc(
+            engine, dnnl::prop_kind::forward_inference,
+            dnnl::algorithm::softmax_accurate, src_md, src_md, 1, attr);
+        return dnnl::softmax_forward(pd);
+      },
+      &result);
+
+  std::vector<std::vector<T>> buffers;
+  TimePrimitive(options, engine, stream, primitive, pd.scratchpad_desc(),
+                {{DNNL_ARG_SRC, RandomMemory<T>(src_md, engine, &buffers)},
+                 {DNNL_ARG_DST, RandomMemory<T>(src_md, engine, &buffers)}},
+                &result);
+  result.flops = 5.0 * rows * cols;
+  result.bytes = 2.0 * rows * cols * sizeof(T);
+  return result;
+}
+
+template <typename T>
+void FillRandom(Tensor* tensor) {
+  static std::mt19937 generator(2023);
+  std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+  auto flat = tensor->flat<T>();
+  for (int64 i = 0; i < flat.size(); ++i) {
+    flat(i) = static_cast<T>(distribution(generator));
+  }
+}
+
+// FmhaFunctor with query [batch, heads, q_len, head_size] and key/value
+// [batch, heads, kv_len, head_size], without mask and dropout. It has no
+// primitive to create, so only exec_us is reported.
+template <typename T>
+BenchmarkResult BenchmarkFmha(const BenchmarkOptions& options,
+                              const std::vector<int64>& dims) {
+  const int64 batch = dims[0], heads = dims[1], q_len = dims[2];
+  const int64 kv_len = dims[3], head_size = dims[4];
+  BenchmarkResult result;
+  result.op = "fmha";
+  result.shape = DimsToString(dims);
+
+  Tensor query(DataTypeToEnum<T>::v(), {batch, heads, q_len, head_size});
+  Tensor key(DataTypeToEnum<T>::v(), {batch, heads, kv_len, head_size});
+  Tensor value(DataTypeToEnum<T>::v(), {batch, heads, kv_len, head_size});
+  Tensor output(DataTypeToEnum<T>::v(), {batch, q_len, heads, head_size});
+  FillRandom<T>(&query);
+  FillRandom<T>(&key);
+  FillRandom<T>(&value);
+  Tensor unused_mask(DataTypeToEnum<T>::v(), {0});
+
+  // Same split sizes as the MHA kernel.
+  result.exec_us = TimeExecution(options, [&]() {
+#define CALL_FMHA_FUNC(qSplitSize, kvSplitSize)                                \
+  FmhaFunctor<T, qSplitSize, kvSplitSize>()(                                   \
+      query, key, value, batch, q_len, heads, heads, head_size, kv_len, false, \
+      false, false, unused_mask, unused_mask, 0.f, &output)
+    if (q_len >= 768) {
+      CALL_FMHA_FUNC(256, 512);
+    } else if (q_len >= 192) {
+      CALL_FMHA_FUNC(64, 512);
+    } else {
+      CALL_FMHA_FUNC(32, 512);
+    }
+#undef CALL_FMHA_FUNC
+  });
+  result.flops = 4.0 * batch * heads * q_len * kv_len * head_size;
+  result.bytes =
+      (2.0 * q_len + 2.0 * kv_len) * batch * heads * head_size * sizeof(T);
+  return result;
+}
+
+// Parses "AxBxC,DxExF" into dims, every entry must have `rank` dims.
+bool ParseShapes(const string& flag_name, const string& text, int rank,
+                 std::vector<std::vector<int64>>* shapes) {
+  for (const string& shape :
+       str_util::Split(text, ',', str_util::SkipEmpty())) {
+    std::vector<int64> dims;
+    for (const string& dim : str_util::Split(shape, 'x')) {
+      int64 value;
+      if (!strings::safe_strto64(dim, &value) || value <= 0) {
+        ITEX_LOG(ERROR) << "Invalid dim '" << dim << "' in --" << flag_name;
+        return false;
+      }
+      dims.push_back(value);
+    }
+    if (static_cast<int>(dims.size()) != rank) {
+      ITEX_LOG(ERROR) << "--" << flag_name << " expects " << rank
+                      << " dims per shape, got '" << shape << "'";
+      return false;
+    }
+    shapes->push_back(std::move(dims));
+  }
+  return true;
+}
+
+string ToJson(const std::vector<BenchmarkResult>& results) {
+  string json = "{\n  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const BenchmarkResult& r = results[i];
+    strings::Appendf(
+        &json,
+        "%s\n    {\"op\": \"%s\", \"dtype\": \"%s\", \"shape\": \"%s\", "
+        "\"create_us\": %.3f, \"cached_create_us\": %.3f, "
+        "\"exec_us\": %.3f, \"gflops\": %.3f, \"gbytes_per_sec\": %.3f}",
+        i == 0 ? "" : ",", r.op.c_str(), r.dtype.c_str(), r.shape.c_str(),
+        r.create_us, r.cached_create_us, r.exec_us,
+        r.flops / r.exec_us / 1e3, r.bytes / r.exec_us / 1e3);
+  }
+  json += "\n  ]\n}\n";
+  return json;
+}
+
+int Main(int argc, char** argv) {
+  BenchmarkOptions options;
+  string matmul = "128x1024x1024,1024x1024x1024,1x4096x4096";
+  string conv = "32x56x56x64x64x3x3x1,32x28x28x128x128x3x3x1";
+  string layer_norm = "4096x1024,512x4096";
+  string softmax = "16384x512,4096x4096";
+  string fmha = "1x16x512x512x64,1x32x1x2048x128";
+  string dtypes = "float,bfloat16";
+  string output;
+  std::vector<Flag> flag_list = {
+      Flag("matmul", &matmul, "MxNxK shapes of matmul"),
+      Flag("conv", &conv,
+           "NxHxWxCxOCxRxSxSTRIDE shapes of NHWC conv2d with same padding"),
+      Flag("layer_norm", &layer_norm, "ROWSxCOLS shapes of layer norm"),
+      Flag("softmax", &softmax, "ROWSxCOLS shapes of softmax"),
+      Flag("fmha", &fmha,
+           "BATCHxHEADSxQ_LENxKV_LENxHEAD_SIZE shapes of the CPU FMHA"),
+      Flag("dtypes", &dtypes, "comma separated float and/or bfloat16"),
+      Flag("warmup", &options.warmup, "untimed executions per benchmark"),
+      Flag("iterations", &options.iterations,
+           "timed executions per benchmark"),
+      Flag("output", &output, "JSON file to write the results to"),
+  };
+  const string usage = Flags::Usage(argv[0], flag_list);
+  if (!Flags::Parse(&argc, argv, flag_list) || argc != 1) {
+    ITEX_LOG(ERROR) << usage;
+    return 1;
+  }
+
+  std::vector<std::vector<int64>> matmul_shapes, conv_shapes,
+      layer_norm_shapes, softmax_shapes, fmha_shapes;
+  if (!ParseShapes("matmul", matmul, 3, &matmul_shapes) ||
+      !ParseShapes("conv", conv, 8, &conv_shapes) ||
+      !ParseShapes("layer_norm", layer_norm, 2, &layer_norm_shapes) ||
+      !ParseShapes("softmax", softmax, 2, &softmax_shapes) ||
+      !ParseShapes("fmha", fmha, 5, &fmha_shapes)) {
+    ITEX_LOG(ERROR) << usage;
+    return 1;
+  }
+
+  dnnl::engine engine(dnnl::engine::kind::cpu, 0);
+  dnnl::stream stream(engine);
+  std::vector<BenchmarkResult> results;
+
+  const auto run_all = [&](auto type_tag, const string& dtype) {
+    using T = decltype(type_tag);
+    const size_t first = results.size();
+    for (const auto& dims : matmul_shapes)
+      results.push_back(BenchmarkMatMul<T>(options, engine, &stream, dims));
+    for (const auto& dims : conv_shapes)
+      results.push_back(BenchmarkConv<T>(options, engine, &stream, dims));
+    for (const auto& dims : layer_norm_shapes)
+      results.push_back(BenchmarkLayerNorm<T>(options, engine, &stream, dims));
+    for (const auto& dims : softmax_shapes)
+      results.push_back(BenchmarkSoftmax<T>(options, engine, &stream, dims));
+    for (const auto& dims : fmha_shapes)
+      results.push_back(BenchmarkFmha<T>(options, dims));
+    for (size_t i = first; i < results.size(); ++i) results[i].dtype = dtype;
+  };
+
+  for (const string& dtype : str_util::Split(dtypes, ',')) {
+    if (dtype == "float") {
+      run_all(float(), dtype);
+    } else if (dtype == "bfloat16") {
+      run_all(Eigen::bfloat16(), dtype);
+    } else {
+      ITEX_LOG(ERROR) << "Unsupported dtype " << dtype;
+      return 1;
+    }
+  }
+
+  for (const BenchmarkResult& r : results) {
+    printf("%-10s %-8s %-24s create %10.1f us  cached %8.1f us  "
+           "exec %10.1f us  %8.1f GFLOP/s  %7.1f GB/s\n",
+           r.op.c_str(), r.dtype.c_str(), r.shape.c_str(), r.create_us,
+           r.cached_create_us, r.exec_us, r.flops / r.exec_us / 1e3,
+           r.bytes / r.exec_us / 1e3);
+  }
+
+  if (!output.empty()) {
+    FILE* file = fopen(output.c_str(), "w");
+    if (file == nullptr) {
+      ITEX_LOG(ERROR) << "Failed to open " << output;
+      return 1;
+    }
+    const string json = ToJson(results);
+    fwrite(json.data(), 1, json.size(), file);
+    fclose(file);
+  }
+  return 0;
+}
+
+}  // namespace benchmark
+}  // namespace itex
+
+int main(int argc, char** argv) { return itex::benchmark::Main(argc, argv); }
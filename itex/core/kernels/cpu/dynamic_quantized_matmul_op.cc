@@ -0,0 +1,395 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "itex/core/utils/errors.h"
+#include "itex/core/utils/mutex.h"
+#include "itex/core/utils/onednn/onednn_primitive_cache.h"
+#include "itex/core/utils/onednn/onednn_util.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/parallel.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+
+using CPUDevice = Eigen::ThreadPoolDevice;
+using dnnl::memory;
+
+namespace functor {
+
+// Symmetric INT8 quantization of `size` values with `scale`.
+template <typename T>
+inline void QuantizeRow(const T* in, int64 size, float scale, int8* out) {
+  const float inv_scale = 1.0f / scale;
+  for (int64 i = 0; i < size; ++i) {
+    float value = std::nearbyint(static_cast<float>(in[i]) * inv_scale);
+    out[i] = static_cast<int8>(std::min(std::max(value, -127.0f), 127.0f));
+  }
+}
+
+// Scale mapping the largest magnitude of `size` values to 127.
+template <typename T>
+inline float SymmetricScale(const T* in, int64 size) {
+  float max_abs = 0.0f;
+  for (int64 i = 0; i < size; ++i) {
+    max_abs = std::max(max_abs, std::abs(static_cast<float>(in[i])));
+  }
+  return max_abs > 0.0f ? max_abs / 127.0f : 1.0f;
+}
+
+}  // namespace functor
+
+// MatMul of a float/bfloat16 activation with a constant weight in INT8,
+// without calibration: the scales of `a` are computed from its values on
+// every call, the weight is quantized per output channel on the first call
+// and cached. The oneDNN INT8 matmul applies the weight scales and writes
+// fp32, the row scales of `a` and the bias are applied when casting to T.
+template <typename T>
+class DynamicQuantizedMatMulOp : public OpKernel {
+ public:
+  explicit DynamicQuantizedMatMulOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_b", &transpose_b_));
+    int num_args;
+    OP_REQUIRES_OK(context, context->GetAttr("num_args", &num_args));
+    OP_REQUIRES(context, num_args <= 1,
+                errors::InvalidArgument(
+                    "DynamicQuantizedMatMul only supports a bias in args, got ",
+                    num_args, " args"));
+    has_bias_ = num_args == 1;
+    string granularity;
+    OP_REQUIRES_OK(context, context->GetAttr("granularity", &granularity));
+    per_tensor_ = granularity == "per_tensor";
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& a = context->input(0);
+    const Tensor& b = context->input(1);
+
+    OP_REQUIRES(context, a.dims() >= 2 && b.dims() == 2,
+                errors::InvalidArgument(
+                    "DynamicQuantizedMatMul expects a of rank >= 2 and 2D b, "
+                    "got ",
+                    a.shape().DebugString(), " and ", b.shape().DebugString()));
+    const int64 k = a.dim_size(a.dims() - 1);
+    const int64 m = k == 0 ? 0 : a.NumElements() / k;
+    const int64 n = b.dim_size(transpose_b_ ? 0 : 1);
+    OP_REQUIRES(context, b.dim_size(transpose_b_ ? 1 : 0) == k,
+                errors::InvalidArgument(
+                    "DynamicQuantizedMatMul inner dims mismatch: ",
+                    a.shape().DebugString(), " vs ", b.shape().DebugString(),
+                    transpose_b_ ? " (transposed)" : ""));
+    const T* bias_data = nullptr;
+    if (has_bias_) {
+      const Tensor& bias = context->input(2);
+      OP_REQUIRES(context, bias.dims() == 1 && bias.dim_size(0) == n,
+                  errors::InvalidArgument(
+                      "DynamicQuantizedMatMul bias must be [", n, "], got ",
+                      bias.shape().DebugString()));
+      bias_data = bias.flat<T>().data();
+    }
+
+    TensorShape output_shape = a.shape();
+    output_shape.set_dim(a.dims() - 1, n);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+    T* output_data = output->flat<T>().data();
+
+    if (k == 0) {
+      for (int64 r = 0; r < m; ++r) {
+        for (int64 j = 0; j < n; ++j) {
+          output_data[r * n + j] = bias_data ? bias_data[j] : T(0);
+        }
+      }
+      return;
+    }
+
+    int8* weight_quantized = nullptr;
+    float* weight_scales = nullptr;
+    OP_REQUIRES_OK(context, QuantizeWeight(context, b, k, n, &weight_quantized,
+                                           &weight_scales));
+
+    // Quantize `a` row by row.
+    Tensor a_quantized, a_scales;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_INT8, TensorShape({m, k}), &a_quantized));
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_FLOAT, TensorShape({m}), &a_scales));
+    const T* a_data = a.flat<T>().data();
+    int8* a_quantized_data = a_quantized.flat<int8>().data();
+    float* a_scales_data = a_scales.flat<float>().data();
+    const Eigen::TensorOpCost row_cost(k * sizeof(T), k, 4 * k);
+    ParallelFor(m, row_cost, [&](int64 begin, int64 end) {
+      for (int64 r = begin; r < end; ++r) {
+        a_scales_data[r] = functor::SymmetricScale(a_data + r * k, k);
+      }
+    });
+    if (per_tensor_) {
+      const float scale = *std::max_element(a_scales_data, a_scales_data + m);
+      std::fill(a_scales_data, a_scales_data + m, scale);
+    }
+    ParallelFor(m, row_cost, [&](int64 begin, int64 end) {
+      for (int64 r = begin; r < end; ++r) {
+        functor::QuantizeRow(a_data + r * k, k, a_scales_data[r],
+                             a_quantized_data + r * k);
+      }
+    });
+
+    Tensor product;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_FLOAT, TensorShape({m, n}), &product));
+    float* product_data = product.flat<float>().data();
+
+    try {
+      auto onednn_engine = CreateDnnlEngine<CPUDevice>(*context);
+      auto onednn_stream = CreateDnnlStream(*context, onednn_engine);
+
+      auto src_md = memory::desc({m, k}, memory::data_type::s8,
+                                 memory::format_tag::ab);
+      auto dst_md = memory::desc({m, n}, memory::data_type::f32,
+                                 memory::format_tag::ab);
+      PrimitiveCacheEntry primitive;
+      OP_REQUIRES_OK(context, GetPrimitive(context, m, k, n, weight_quantized,
+                                           onednn_engine, &primitive));
+      const auto& matmul_pd = primitive.matmul_pd;
+
+      void* weight_data = weight_quantized;
+      memory::desc expected_md = matmul_pd.weights_desc();
+      if (primitive.weight_cache != nullptr) {
+        weight_data = primitive.weight_cache->GetCache(context, expected_md);
+        OP_REQUIRES(context, weight_data != nullptr,
+                    errors::Internal("DynamicQuantizedMatMul weight cache "
+                                     "has an unexpected layout"));
+      }
+
+      Tensor scratchpad;
+      OP_REQUIRES_OK(
+          context,
+          context->allocate_temp(
+              DT_UINT8,
+              TensorShape({static_cast<int64>(
+                  matmul_pd.scratchpad_desc().get_size())}),
+              &scratchpad));
+
+      std::unordered_map<int, memory> args = {
+          {DNNL_ARG_SRC,
+           CreateDnnlMemory(src_md, onednn_engine, a_quantized_data)},
+          {DNNL_ARG_WEIGHTS,
+           CreateDnnlMemory(expected_md, onednn_engine, weight_data)},
+          {DNNL_ARG_DST,
+           CreateDnnlMemory(dst_md, onednn_engine, product_data)},
+          {DNNL_ARG_SCRATCHPAD,
+           CreateDnnlMemory(matmul_pd.scratchpad_desc(), onednn_engine,
+                            GetTensorBuffer<uint8>(&scratchpad))},
+          {DNNL_ARG_ATTR_SCALES | DNNL_ARG_WEIGHTS,
+           CreateDnnlMemory(
+               memory::desc({n}, memory::data_type::f32,
+                            memory::format_tag::x),
+               onednn_engine, weight_scales)}};
+      ReportPrimitiveImplementation(primitive.matmul_primitive);
+      primitive.matmul_primitive.execute(onednn_stream, args);
+    } catch (dnnl::error& e) {
+      string error_msg = "Status: " + std::to_string(e.status) +
+                         ", message: " + string(e.message) + ", in file " +
+                         string(__FILE__) + ":" + std::to_string(__LINE__);
+      OP_REQUIRES_OK(
+          context,
+          errors::Aborted("Operation received an exception:", error_msg));
+    }
+
+    // Dequantize with the row scales and add the bias.
+    ParallelFor(
+        m, Eigen::TensorOpCost(n * sizeof(float), n * sizeof(T), 2 * n),
+        [&](int64 begin, int64 end) {
+          for (int64 r = begin; r < end; ++r) {
+            const float scale = a_scales_data[r];
+            const float* in = product_data + r * n;
+            T* out = output_data + r * n;
+            for (int64 j = 0; j < n; ++j) {
+              float value = in[j] * scale;
+              if (bias_data != nullptr) {
+                value += static_cast<float>(bias_data[j]);
+              }
+              out[j] = static_cast<T>(value);
+            }
+          }
+        });
+  }
+
+ private:
+  // oneDNN objects created for one [m, k] x [k, n] matmul.
+  struct PrimitiveCacheEntry {
+    dnnl::matmul::primitive_desc matmul_pd;
+    dnnl::matmul matmul_primitive;
+    // Cache of the weight in the layout expected by the primitive, nullptr
+    // if it is the plain layout.
+    WeightCacheManager<qint8>* weight_cache = nullptr;
+  };
+  using PrimitiveCache = OneDnnPrimitiveCache<PrimitiveCacheEntry>;
+
+  // Returns the primitive for these dims, created on the first call with
+  // them, and reorders the weight once per layout the primitives expect.
+  Status GetPrimitive(OpKernelContext* context, int64 m, int64 k, int64 n,
+                      int8* weight_quantized,
+                      const dnnl::engine& onednn_engine,
+                      PrimitiveCacheEntry* primitive)
+      TF_LOCKS_EXCLUDED(mu_compute_) {
+    mutex_lock lock(&mu_compute_);
+    const std::vector<int64> dims = {m, k, n};
+    const PrimitiveCache::Key key = PrimitiveCache::MakeKey({&dims});
+    PrimitiveCacheEntry* cached = primitive_cache_.Find(key);
+    if (cached != nullptr) {
+      *primitive = *cached;
+      return Status::OK();
+    }
+
+    auto src_md =
+        memory::desc({m, k}, memory::data_type::s8, memory::format_tag::ab);
+    auto weight_md =
+        memory::desc({k, n}, memory::data_type::s8, memory::format_tag::ab);
+    auto weight_md_prefer =
+        memory::desc({k, n}, memory::data_type::s8, memory::format_tag::any);
+    auto dst_md =
+        memory::desc({m, n}, memory::data_type::f32, memory::format_tag::ab);
+    dnnl::primitive_attr attr;
+    attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+    // Per output channel weight scales.
+    attr.set_scales_mask(DNNL_ARG_WEIGHTS, 1 << 1);
+    primitive->matmul_pd = dnnl::matmul::primitive_desc(
+        onednn_engine, src_md, weight_md_prefer, dst_md, attr);
+    primitive->matmul_primitive = dnnl::matmul(primitive->matmul_pd);
+
+    // The preferred layout may change with the number of rows, keep one
+    // reordered weight per layout.
+    const memory::desc expected_md = primitive->matmul_pd.weights_desc();
+    primitive->weight_cache = nullptr;
+    if (expected_md != weight_md) {
+      for (auto& weight_cache : weight_caches_) {
+        if (weight_cache.first == expected_md) {
+          primitive->weight_cache = weight_cache.second.get();
+          break;
+        }
+      }
+      if (primitive->weight_cache == nullptr) {
+        auto weight_cache = std::make_unique<WeightCacheManager<qint8>>();
+        weight_cache->SetCache(context, weight_md, expected_md,
+                               weight_quantized, onednn_engine);
+        TF_RETURN_IF_ERROR(context->status());
+        primitive->weight_cache = weight_cache.get();
+        weight_caches_.emplace_back(expected_md, std::move(weight_cache));
+      }
+    }
+    primitive_cache_.Insert(key, *primitive);
+    return Status::OK();
+  }
+
+  // Quantizes the constant weight once into a plain [k, n] INT8 buffer with
+  // one scale per output channel, and returns the cached buffers.
+  Status QuantizeWeight(OpKernelContext* context, const Tensor& b, int64 k,
+                        int64 n, int8** weight_quantized,
+                        float** weight_scales) TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock lock(&mu_);
+    if (weight_quantized_.IsInitialized()) {
+      *weight_quantized =
+          weight_quantized_.AccessTensor(context)->flat<int8>().data();
+      *weight_scales =
+          weight_scales_.AccessTensor(context)->flat<float>().data();
+      return Status::OK();
+    }
+
+    // Transpose to [n, k] so every output channel is contiguous.
+    Tensor b_transposed;
+    const T* channels = b.flat<T>().data();
+    if (!transpose_b_) {
+      TF_RETURN_IF_ERROR(context->allocate_temp(
+          DataTypeToEnum<T>::v(), TensorShape({n, k}), &b_transposed));
+      T* data = b_transposed.flat<T>().data();
+      for (int64 i = 0; i < k; ++i) {
+        for (int64 j = 0; j < n; ++j) data[j * k + i] = channels[i * n + j];
+      }
+      channels = data;
+    }
+
+    Tensor* scales = nullptr;
+    Tensor* quantized = nullptr;
+    Tensor quantized_transposed;
+    TF_RETURN_IF_ERROR(context->allocate_persistent(
+        DT_FLOAT, TensorShape({n}), &weight_scales_, &scales));
+    TF_RETURN_IF_ERROR(context->allocate_temp(DT_INT8, TensorShape({n, k}),
+                                              &quantized_transposed));
+    float* scales_data = scales->flat<float>().data();
+    int8* quantized_transposed_data = quantized_transposed.flat<int8>().data();
+    ParallelFor(n, Eigen::TensorOpCost(k * sizeof(T), k, 8 * k),
+                [&](int64 begin, int64 end) {
+                  for (int64 j = begin; j < end; ++j) {
+                    scales_data[j] =
+                        functor::SymmetricScale(channels + j * k, k);
+                    functor::QuantizeRow(channels + j * k, k, scales_data[j],
+                                         quantized_transposed_data + j * k);
+                  }
+                });
+
+    TF_RETURN_IF_ERROR(context->allocate_persistent(
+        DT_INT8, TensorShape({k, n}), &weight_quantized_, &quantized));
+    int8* quantized_data = quantized->flat<int8>().data();
+    for (int64 j = 0; j < n; ++j) {
+      for (int64 i = 0; i < k; ++i) {
+        quantized_data[i * n + j] = quantized_transposed_data[j * k + i];
+      }
+    }
+    *weight_quantized = quantized_data;
+    *weight_scales = scales_data;
+    return Status::OK();
+  }
+
+  bool transpose_b_;
+  bool has_bias_;
+  bool per_tensor_;
+
+  mutex mu_;
+  PersistentTensor weight_quantized_ TF_GUARDED_BY(mu_);
+  PersistentTensor weight_scales_ TF_GUARDED_BY(mu_);
+
+  mutex mu_compute_;
+  PrimitiveCache primitive_cache_ TF_GUARDED_BY(mu_compute_);
+  std::vector<std::pair<memory::desc,
+                        std::unique_ptr<WeightCacheManager<qint8>>>>
+      weight_caches_ TF_GUARDED_BY(mu_compute_);
+};
+
+#define REGISTER_DYNAMIC_QUANTIZED_MATMUL(T)                    \
+  REGISTER_KERNEL_BUILDER(Name("_ITEXDynamicQuantizedMatMul")   \
+                              .Device(DEVICE_CPU)               \
+                              .TypeConstraint<T>("T"),          \
+                          DynamicQuantizedMatMulOp<T>);
+
+TF_CALL_float(REGISTER_DYNAMIC_QUANTIZED_MATMUL);
+TF_CALL_bfloat16(REGISTER_DYNAMIC_QUANTIZED_MATMUL);
+#undef REGISTER_DYNAMIC_QUANTIZED_MATMUL
+
+}  // namespace itex
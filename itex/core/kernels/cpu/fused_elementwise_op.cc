@@ -0,0 +1,211 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/kernels/cpu/fused_elementwise_op.h"
+
+#include <string>
+#include <vector>
+
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+
+using CPUDevice = Eigen::ThreadPoolDevice;
+
+namespace {
+
+using functor::ElementwiseBlock;
+using functor::SpecializedElementwiseChain;
+
+using RunChainFn = void (*)(ElementwiseBlock*, const ElementwiseBlock*,
+                            const ElementwiseStep*);
+
+// Common chains evaluated as one expression, e.g. bias + activation or
+// scale + shift (+ activation).
+RunChainFn GetSpecializedChain(const std::vector<ElementwiseStep>& steps) {
+  using Op = ElementwiseOp;
+#define SPECIALIZED_CHAIN(...)                                          \
+  if (SpecializedElementwiseChain<__VA_ARGS__>::Matches(steps)) {       \
+    return &SpecializedElementwiseChain<__VA_ARGS__>::Run;              \
+  }
+  SPECIALIZED_CHAIN(Op::kAdd, Op::kRelu)
+  SPECIALIZED_CHAIN(Op::kAdd, Op::kGeluErf)
+  SPECIALIZED_CHAIN(Op::kAdd, Op::kGeluTanh)
+  SPECIALIZED_CHAIN(Op::kAdd, Op::kSigmoid)
+  SPECIALIZED_CHAIN(Op::kAdd, Op::kTanh)
+  SPECIALIZED_CHAIN(Op::kMul, Op::kAdd)
+  SPECIALIZED_CHAIN(Op::kMul, Op::kAdd, Op::kRelu)
+  SPECIALIZED_CHAIN(Op::kAdd, Op::kMul)
+  SPECIALIZED_CHAIN(Op::kAdd, Op::kAdd)
+  SPECIALIZED_CHAIN(Op::kAdd, Op::kMaximum, Op::kMinimum)
+  SPECIALIZED_CHAIN(Op::kMaximum, Op::kMinimum)
+#undef SPECIALIZED_CHAIN
+  return nullptr;
+}
+
+}  // namespace
+
+template <typename T>
+class FusedElementwiseOp : public OpKernel {
+ public:
+  explicit FusedElementwiseOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    std::vector<string> fused_ops;
+    std::vector<int> acc_first;
+    std::vector<float> alphas;
+    OP_REQUIRES_OK(context, context->GetAttr("fused_ops", &fused_ops));
+    OP_REQUIRES_OK(context, context->GetAttr("acc_first", &acc_first));
+    OP_REQUIRES_OK(context, context->GetAttr("alphas", &alphas));
+    OP_REQUIRES(context,
+                fused_ops.size() == acc_first.size() &&
+                    fused_ops.size() == alphas.size(),
+                errors::InvalidArgument(
+                    "fused_ops, acc_first and alphas must have same size. ",
+                    fused_ops.size(), " vs ", acc_first.size(), " vs ",
+                    alphas.size()));
+    OP_REQUIRES(context, !fused_ops.empty(),
+                errors::InvalidArgument("fused_ops must not be empty."));
+
+    for (size_t i = 0; i < fused_ops.size(); ++i) {
+      ElementwiseStep step;
+      OP_REQUIRES(context,
+                  ParseElementwiseOp(fused_ops[i], acc_first[i] != 0, &step.op),
+                  errors::Unimplemented("Unsupported op in FusedElementwise: ",
+                                        fused_ops[i]));
+      step.alpha = alphas[i];
+      if (IsBinaryElementwiseOp(step.op)) ++num_binary_ops_;
+      steps_.push_back(step);
+    }
+    OP_REQUIRES(context, context->num_inputs() == num_binary_ops_ + 1,
+                errors::InvalidArgument("FusedElementwise expects ",
+                                        num_binary_ops_ + 1, " inputs, got ",
+                                        context->num_inputs()));
+    specialized_chain_ = GetSpecializedChain(steps_);
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    const TensorShape& output_shape = input.shape();
+    const int64 num_elements = output_shape.num_elements();
+    const int64 last_dim =
+        output_shape.dims() > 0 ? output_shape.dim_size(output_shape.dims() - 1)
+                                : 1;
+
+    // Flat data and size of the operand of each binary op.
+    std::vector<const T*> args_data = {input.flat<T>().data()};
+    std::vector<int64> args_size = {num_elements};
+    for (int i = 1; i < context->num_inputs(); ++i) {
+      const Tensor& arg = context->input(i);
+      const int64 size = arg.NumElements();
+      OP_REQUIRES(context,
+                  arg.shape() == output_shape || size == 1 ||
+                      (size == last_dim && arg.dims() >= 1 &&
+                       arg.dim_size(arg.dims() - 1) == last_dim &&
+                       arg.dims() <= output_shape.dims()),
+                  errors::InvalidArgument(
+                      "FusedElementwise argument ", i, " with shape ",
+                      arg.shape().DebugString(), " can't be broadcast to ",
+                      output_shape.DebugString()));
+      args_data.push_back(arg.flat<T>().data());
+      args_size.push_back(size);
+    }
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, output_shape, &output));
+    if (num_elements == 0) return;
+    T* output_data = output->flat<T>().data();
+
+    const int64 num_blocks =
+        (num_elements + kElementwiseBlockSize - 1) / kElementwiseBlockSize;
+    const int64 bytes_per_block =
+        kElementwiseBlockSize * sizeof(T) * (num_binary_ops_ + 2);
+    const int64 cycles_per_block = kElementwiseBlockSize * 5 * steps_.size();
+    const CPUDevice& device = context->eigen_device<CPUDevice>();
+    device.parallelFor(
+        num_blocks,
+        Eigen::TensorOpCost(bytes_per_block, kElementwiseBlockSize * sizeof(T),
+                            cycles_per_block),
+        [&](Eigen::Index first, Eigen::Index last) {
+          // Accumulator followed by the operand of each step.
+          std::vector<float> scratch(kElementwiseBlockSize *
+                                     (steps_.size() + 1));
+          std::vector<ElementwiseBlock> operands;
+          operands.reserve(steps_.size());
+          for (Eigen::Index block = first; block < last; ++block) {
+            const int64 begin = block * kElementwiseBlockSize;
+            const int64 n = std::min(kElementwiseBlockSize,
+                                     num_elements - begin);
+            EvaluateBlock(args_data, args_size, begin, n, scratch.data(),
+                          &operands, output_data + begin);
+          }
+        });
+  }
+
+ private:
+  void EvaluateBlock(const std::vector<const T*>& args_data,
+                     const std::vector<int64>& args_size, int64 begin,
+                     int64 n, float* scratch,
+                     std::vector<ElementwiseBlock>* operands, T* out) const {
+    float* acc_data = scratch;
+    functor::LoadElementwiseArg(args_data[0], args_size[0], begin, n,
+                                acc_data);
+    ElementwiseBlock acc(acc_data, n);
+
+    // The maps are rebuilt for every block since the last one may be shorter,
+    // in the capacity the caller reserved once per shard.
+    operands->clear();
+    int arg = 1;
+    for (size_t i = 0; i < steps_.size(); ++i) {
+      float* operand_data = scratch + (i + 1) * kElementwiseBlockSize;
+      if (IsBinaryElementwiseOp(steps_[i].op)) {
+        functor::LoadElementwiseArg(args_data[arg], args_size[arg], begin, n,
+                                    operand_data);
+        ++arg;
+      }
+      operands->emplace_back(operand_data, n);
+    }
+
+    if (specialized_chain_ != nullptr) {
+      specialized_chain_(&acc, operands->data(), steps_.data());
+    } else {
+      for (size_t i = 0; i < steps_.size(); ++i) {
+        functor::ApplyElementwiseStep(steps_[i], &acc, (*operands)[i]);
+      }
+    }
+
+    for (int64 i = 0; i < n; ++i) out[i] = static_cast<T>(acc_data[i]);
+  }
+
+  std::vector<ElementwiseStep> steps_;
+  int num_binary_ops_ = 0;
+  RunChainFn specialized_chain_ = nullptr;
+};
+
+#define REGISTER_FUSED_ELEMENTWISE_KERNELS(type)                  \
+  REGISTER_KERNEL_BUILDER(Name("_ITEXFusedElementwise")           \
+                              .Device(DEVICE_CPU)                 \
+                              .TypeConstraint<type>("T"),         \
+                          FusedElementwiseOp<type>)
+
+TF_CALL_CPU_NUMBER_TYPES(REGISTER_FUSED_ELEMENTWISE_KERNELS);
+#undef REGISTER_FUSED_ELEMENTWISE_KERNELS
+
+}  // namespace itex
@@ -0,0 +1,280 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_KERNELS_CPU_FUSED_ELEMENTWISE_OP_H_
+#define ITEX_CORE_KERNELS_CPU_FUSED_ELEMENTWISE_OP_H_
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "itex/core/utils/types.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace itex {
+
+// `_ITEXFusedElementwise` evaluates a chain of elementwise ops
+//   acc = args[0]; acc = op_0(acc, ...); acc = op_1(acc, ...); ...
+// in a single pass over memory. Binary ops take the next argument as their
+// other operand, which is either the full tensor, a scalar or a vector
+// broadcast along the last dimension (bias, scale). The chain is evaluated in
+// fp32 on blocks small enough to stay in L1, so intermediate results are never
+// written to memory.
+
+// Elements per block evaluated by one step of the chain.
+constexpr int64 kElementwiseBlockSize = 1024;
+
+enum class ElementwiseOp {
+  // Binary ops, `Rev` variants take the accumulator as their second operand.
+  kAdd,
+  kSub,
+  kSubRev,
+  kMul,
+  kDiv,
+  kDivRev,
+  kMaximum,
+  kMinimum,
+  // Unary ops.
+  kElu,
+  kExp,
+  kGeluErf,
+  kGeluTanh,
+  kLeakyRelu,
+  kNeg,
+  kRelu,
+  kRelu6,
+  kRsqrt,
+  kSigmoid,
+  kSqrt,
+  kSquare,
+  kTanh,
+};
+
+inline bool IsBinaryElementwiseOp(ElementwiseOp op) {
+  return op <= ElementwiseOp::kMinimum;
+}
+
+struct ElementwiseStep {
+  ElementwiseOp op;
+  // LeakyRelu slope.
+  float alpha = 0.0f;
+};
+
+// Parses a `fused_ops` entry of `_ITEXFusedElementwise`. `acc_first` is false
+// when the accumulator is the second operand of a binary op.
+inline bool ParseElementwiseOp(const std::string& name, bool acc_first,
+                               ElementwiseOp* op) {
+  if (name == "Add" || name == "AddV2" || name == "BiasAdd") {
+    *op = ElementwiseOp::kAdd;
+  } else if (name == "Sub") {
+    *op = acc_first ? ElementwiseOp::kSub : ElementwiseOp::kSubRev;
+  } else if (name == "Mul") {
+    *op = ElementwiseOp::kMul;
+  } else if (name == "RealDiv") {
+    *op = acc_first ? ElementwiseOp::kDiv : ElementwiseOp::kDivRev;
+  } else if (name == "Maximum") {
+    *op = ElementwiseOp::kMaximum;
+  } else if (name == "Minimum") {
+    *op = ElementwiseOp::kMinimum;
+  } else if (name == "Elu") {
+    *op = ElementwiseOp::kElu;
+  } else if (name == "Exp") {
+    *op = ElementwiseOp::kExp;
+  } else if (name == "GeluExact") {
+    *op = ElementwiseOp::kGeluErf;
+  } else if (name == "GeluApproximate") {
+    *op = ElementwiseOp::kGeluTanh;
+  } else if (name == "LeakyRelu") {
+    *op = ElementwiseOp::kLeakyRelu;
+  } else if (name == "Neg") {
+    *op = ElementwiseOp::kNeg;
+  } else if (name == "Relu") {
+    *op = ElementwiseOp::kRelu;
+  } else if (name == "Relu6") {
+    *op = ElementwiseOp::kRelu6;
+  } else if (name == "Rsqrt") {
+    *op = ElementwiseOp::kRsqrt;
+  } else if (name == "Sigmoid") {
+    *op = ElementwiseOp::kSigmoid;
+  } else if (name == "Sqrt") {
+    *op = ElementwiseOp::kSqrt;
+  } else if (name == "Square") {
+    *op = ElementwiseOp::kSquare;
+  } else if (name == "Tanh") {
+    *op = ElementwiseOp::kTanh;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+namespace functor {
+
+// Each step builds the Eigen expression of one op on the accumulator `x` and,
+// for binary ops, the operand `y`, so that a chain of steps composes into a
+// single vectorized expression.
+template <ElementwiseOp Op>
+struct ElementwiseStepExpr;
+
+constexpr float kElementwiseRsqrt2 = 0.70710678118654752440f;
+constexpr float kElementwiseSqrt2OverPi = 0.79788456080286535588f;
+
+#define DEFINE_ELEMENTWISE_STEP_EXPR(op, expr)                                \
+  template <>                                                                 \
+  struct ElementwiseStepExpr<ElementwiseOp::op> {                             \
+    template <typename X, typename Y>                                         \
+    static auto Build(const X& x, const Y& y, float alpha) {                  \
+      return expr;                                                            \
+    }                                                                         \
+  };
+
+DEFINE_ELEMENTWISE_STEP_EXPR(kAdd, x + y)
+DEFINE_ELEMENTWISE_STEP_EXPR(kSub, x - y)
+DEFINE_ELEMENTWISE_STEP_EXPR(kSubRev, y - x)
+DEFINE_ELEMENTWISE_STEP_EXPR(kMul, x * y)
+DEFINE_ELEMENTWISE_STEP_EXPR(kDiv, x / y)
+DEFINE_ELEMENTWISE_STEP_EXPR(kDivRev, y / x)
+DEFINE_ELEMENTWISE_STEP_EXPR(kMaximum, x.cwiseMax(y))
+DEFINE_ELEMENTWISE_STEP_EXPR(kMinimum, x.cwiseMin(y))
+DEFINE_ELEMENTWISE_STEP_EXPR(kElu,
+                             (x > x.constant(0.0f))
+                                 .select(x, x.exp() - x.constant(1.0f)))
+DEFINE_ELEMENTWISE_STEP_EXPR(kExp, x.exp())
+// 0.5 * x * (1 + erf(x / sqrt(2)))
+DEFINE_ELEMENTWISE_STEP_EXPR(
+    kGeluErf, x * ((x * x.constant(kElementwiseRsqrt2)).erf() + 1.0f) * 0.5f)
+// 0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+DEFINE_ELEMENTWISE_STEP_EXPR(
+    kGeluTanh,
+    x * (((x + x.cube() * 0.044715f) * x.constant(kElementwiseSqrt2OverPi))
+             .tanh() +
+         1.0f) *
+        0.5f)
+DEFINE_ELEMENTWISE_STEP_EXPR(kLeakyRelu,
+                             (x > x.constant(0.0f))
+                                 .select(x, x * x.constant(alpha)))
+DEFINE_ELEMENTWISE_STEP_EXPR(kNeg, -x)
+DEFINE_ELEMENTWISE_STEP_EXPR(kRelu, x.cwiseMax(0.0f))
+DEFINE_ELEMENTWISE_STEP_EXPR(kRelu6, x.cwiseMax(0.0f).cwiseMin(6.0f))
+DEFINE_ELEMENTWISE_STEP_EXPR(kRsqrt, x.rsqrt())
+DEFINE_ELEMENTWISE_STEP_EXPR(kSigmoid, x.sigmoid())
+DEFINE_ELEMENTWISE_STEP_EXPR(kSqrt, x.sqrt())
+DEFINE_ELEMENTWISE_STEP_EXPR(kSquare, x.square())
+DEFINE_ELEMENTWISE_STEP_EXPR(kTanh, x.tanh())
+
+#undef DEFINE_ELEMENTWISE_STEP_EXPR
+
+using ElementwiseBlock =
+    Eigen::TensorMap<Eigen::Tensor<float, 1, Eigen::RowMajor>>;
+
+// Runtime-dispatched step for chains without a specialization: one
+// vectorized pass over the block per op.
+template <ElementwiseOp Op>
+inline void ApplyElementwiseStep(ElementwiseBlock* acc,
+                                 const ElementwiseBlock& operand,
+                                 float alpha) {
+  *acc = ElementwiseStepExpr<Op>::Build(*acc, operand, alpha);
+}
+
+inline void ApplyElementwiseStep(const ElementwiseStep& step,
+                                 ElementwiseBlock* acc,
+                                 const ElementwiseBlock& operand) {
+#define APPLY_STEP_CASE(op)                                           \
+  case ElementwiseOp::op:                                             \
+    ApplyElementwiseStep<ElementwiseOp::op>(acc, operand, step.alpha); \
+    break;
+
+  switch (step.op) {
+    APPLY_STEP_CASE(kAdd)
+    APPLY_STEP_CASE(kSub)
+    APPLY_STEP_CASE(kSubRev)
+    APPLY_STEP_CASE(kMul)
+    APPLY_STEP_CASE(kDiv)
+    APPLY_STEP_CASE(kDivRev)
+    APPLY_STEP_CASE(kMaximum)
+    APPLY_STEP_CASE(kMinimum)
+    APPLY_STEP_CASE(kElu)
+    APPLY_STEP_CASE(kExp)
+    APPLY_STEP_CASE(kGeluErf)
+    APPLY_STEP_CASE(kGeluTanh)
+    APPLY_STEP_CASE(kLeakyRelu)
+    APPLY_STEP_CASE(kNeg)
+    APPLY_STEP_CASE(kRelu)
+    APPLY_STEP_CASE(kRelu6)
+    APPLY_STEP_CASE(kRsqrt)
+    APPLY_STEP_CASE(kSigmoid)
+    APPLY_STEP_CASE(kSqrt)
+    APPLY_STEP_CASE(kSquare)
+    APPLY_STEP_CASE(kTanh)
+  }
+#undef APPLY_STEP_CASE
+}
+
+// Chains known at compile time are composed into a single expression, so
+// each element goes through all the ops in registers.
+template <int I, ElementwiseOp Op, ElementwiseOp... Rest, typename X>
+inline auto BuildElementwiseChain(const X& x, const ElementwiseBlock* operands,
+                                  const ElementwiseStep* steps) {
+  auto y = ElementwiseStepExpr<Op>::Build(x, operands[I], steps[I].alpha);
+  if constexpr (sizeof...(Rest) == 0) {
+    return y;
+  } else {
+    return BuildElementwiseChain<I + 1, Rest...>(y, operands, steps);
+  }
+}
+
+template <ElementwiseOp... Ops>
+struct SpecializedElementwiseChain {
+  static bool Matches(const std::vector<ElementwiseStep>& steps) {
+    static constexpr ElementwiseOp kOps[] = {Ops...};
+    if (steps.size() != sizeof...(Ops)) return false;
+    for (size_t i = 0; i < steps.size(); ++i) {
+      if (steps[i].op != kOps[i]) return false;
+    }
+    return true;
+  }
+
+  // `operands[i]` is the operand of step `i`, unused for unary steps.
+  static void Run(ElementwiseBlock* acc, const ElementwiseBlock* operands,
+                  const ElementwiseStep* steps) {
+    *acc = BuildElementwiseChain<0, Ops...>(*acc, operands, steps);
+  }
+};
+
+// Loads `n` elements starting at flat index `begin` of an argument broadcast
+// to the output, converted to fp32.
+template <typename T>
+inline void LoadElementwiseArg(const T* data, int64 size, int64 begin,
+                               int64 n, float* dst) {
+  if (size == 1) {
+    std::fill(dst, dst + n, static_cast<float>(data[0]));
+    return;
+  }
+  int64 pos = begin % size;
+  int64 i = 0;
+  while (i < n) {
+    const int64 len = std::min(n - i, size - pos);
+    for (int64 j = 0; j < len; ++j) {
+      dst[i + j] = static_cast<float>(data[pos + j]);
+    }
+    i += len;
+    pos = 0;
+  }
+}
+
+}  // namespace functor
+}  // namespace itex
+
+#endif  // ITEX_CORE_KERNELS_CPU_FUSED_ELEMENTWISE_OP_H_
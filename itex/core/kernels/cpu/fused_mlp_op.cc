@@ -0,0 +1,320 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "itex/core/kernels/cpu/cpu_blas.h"
+#include "itex/core/kernels/cpu/fused_elementwise_op.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/parallel.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace itex {
+
+// Rows of x computed together. Decoding batches usually fit in one block.
+constexpr int64 kMLPRowBlockSize = 32;
+// Columns of the hidden dimension computed at a time, so the intermediate of
+// a row block, [kMLPRowBlockSize, kMLPHiddenBlockSize] fp32 (twice for gated
+// MLPs), stays in L2 between the two matmuls.
+constexpr int64 kMLPHiddenBlockSize = 256;
+
+enum class MLPActivation { kGeluExact, kGeluApproximate, kRelu, kSilu };
+
+namespace functor {
+
+using MLPBlock = Eigen::TensorMap<Eigen::Tensor<float, 1, Eigen::RowMajor>>;
+
+template <typename T>
+using ConstMLPVec =
+    Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>>;
+
+// act(row + bias) on one row of the hidden block, bias may be null.
+template <typename T>
+inline void ApplyMLPActivation(MLPActivation activation, const T* bias,
+                               MLPBlock* row) {
+  if (bias != nullptr) {
+    *row += ConstMLPVec<T>(bias, row->size()).template cast<float>();
+  }
+  switch (activation) {
+    case MLPActivation::kGeluExact:
+      *row = ElementwiseStepExpr<ElementwiseOp::kGeluErf>::Build(*row, *row,
+                                                                 0.0f);
+      break;
+    case MLPActivation::kGeluApproximate:
+      *row = ElementwiseStepExpr<ElementwiseOp::kGeluTanh>::Build(*row, *row,
+                                                                  0.0f);
+      break;
+    case MLPActivation::kRelu:
+      *row = row->cwiseMax(0.0f);
+      break;
+    case MLPActivation::kSilu:
+      *row = *row * row->sigmoid();
+      break;
+  }
+}
+
+}  // namespace functor
+
+// CPU kernel of `_ITEXFusedMLP`, see its definition in nn_ops.cc. The hidden
+// dimension is processed in blocks: each block of the intermediate is
+// computed by the first matmul(s), activated in place and immediately
+// multiplied by the matching rows of w_down, so the [m, hidden] intermediate
+// is never written to memory.
+//
+// Work is split by row blocks and, when there are fewer row blocks than
+// threads (small-batch decoding), also by ranges of hidden blocks. Every
+// hidden range accumulates a fp32 partial output that is reduced with b_down
+// at the end.
+template <typename T>
+class FusedMLPOp : public OpKernel {
+ public:
+  explicit FusedMLPOp(OpKernelConstruction* context) : OpKernel(context) {
+    string activation;
+    OP_REQUIRES_OK(context, context->GetAttr("activation", &activation));
+    OP_REQUIRES_OK(context, context->GetAttr("is_gated", &is_gated_));
+    OP_REQUIRES_OK(context, context->GetAttr("has_gate_bias", &has_gate_bias_));
+    OP_REQUIRES_OK(context, context->GetAttr("has_up_bias", &has_up_bias_));
+    OP_REQUIRES_OK(context, context->GetAttr("has_down_bias", &has_down_bias_));
+    if (activation == "GeluExact") {
+      activation_ = MLPActivation::kGeluExact;
+    } else if (activation == "GeluApproximate") {
+      activation_ = MLPActivation::kGeluApproximate;
+    } else if (activation == "Relu") {
+      activation_ = MLPActivation::kRelu;
+    } else if (activation == "Silu") {
+      activation_ = MLPActivation::kSilu;
+    } else {
+      OP_REQUIRES(context, false,
+                  errors::Unimplemented("Unsupported activation in FusedMLP: ",
+                                        activation));
+    }
+    OP_REQUIRES(context, is_gated_ || !has_gate_bias_,
+                errors::InvalidArgument(
+                    "FusedMLP has_gate_bias requires is_gated."));
+    const int num_args =
+        is_gated_ + has_gate_bias_ + has_up_bias_ + has_down_bias_;
+    OP_REQUIRES(context, context->num_inputs() == num_args + 3,
+                errors::InvalidArgument("FusedMLP expects ", num_args + 3,
+                                        " inputs, got ",
+                                        context->num_inputs()));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    const Tensor& w_up = context->input(1);
+    const Tensor& w_down = context->input(2);
+    int arg = 3;
+    const Tensor* w_gate = is_gated_ ? &context->input(arg++) : nullptr;
+    const Tensor* b_gate = has_gate_bias_ ? &context->input(arg++) : nullptr;
+    const Tensor* b_up = has_up_bias_ ? &context->input(arg++) : nullptr;
+    const Tensor* b_down = has_down_bias_ ? &context->input(arg++) : nullptr;
+
+    OP_REQUIRES(context,
+                x.dims() == 2 && w_up.dims() == 2 && w_down.dims() == 2,
+                errors::InvalidArgument(
+                    "FusedMLP expects 2D x, w_up and w_down, got ",
+                    x.shape().DebugString(), ", ", w_up.shape().DebugString(),
+                    " and ", w_down.shape().DebugString()));
+    const int64 m = x.dim_size(0);
+    const int64 k = x.dim_size(1);
+    const int64 hidden = w_up.dim_size(1);
+    const int64 n = w_down.dim_size(1);
+    OP_REQUIRES(context,
+                w_up.dim_size(0) == k && w_down.dim_size(0) == hidden,
+                errors::InvalidArgument(
+                    "FusedMLP shapes mismatch: x ", x.shape().DebugString(),
+                    ", w_up ", w_up.shape().DebugString(), ", w_down ",
+                    w_down.shape().DebugString()));
+    if (is_gated_) {
+      OP_REQUIRES(context, w_gate->shape() == w_up.shape(),
+                  errors::InvalidArgument(
+                      "FusedMLP w_gate must have the shape of w_up, got ",
+                      w_gate->shape().DebugString()));
+    }
+    const auto check_bias = [&](const Tensor* bias, int64 size,
+                                const char* name) {
+      OP_REQUIRES(context,
+                  bias == nullptr ||
+                      (bias->dims() == 1 && bias->dim_size(0) == size),
+                  errors::InvalidArgument("FusedMLP ", name, " must be [",
+                                          size, "], got ",
+                                          bias->shape().DebugString()));
+    };
+    check_bias(b_gate, hidden, "b_gate");
+    check_bias(b_up, hidden, "b_up");
+    check_bias(b_down, n, "b_down");
+    if (!context->status().ok()) return;
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, TensorShape({m, n}),
+                                                     &output));
+    if (output->NumElements() == 0) return;
+
+    const int64 row_blocks = (m + kMLPRowBlockSize - 1) / kMLPRowBlockSize;
+    const int64 hidden_block = std::min(kMLPHiddenBlockSize, hidden);
+    const int64 hidden_blocks =
+        hidden == 0 ? 0 : (hidden + hidden_block - 1) / hidden_block;
+    const int64 num_threads = GetNumThreads();
+    const int64 hidden_splits = std::max<int64>(
+        1, std::min(hidden_blocks, num_threads / row_blocks));
+
+    // fp32 partial outputs of every hidden range.
+    Tensor partial;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(
+                       DT_FLOAT, TensorShape({hidden_splits, m, n}), &partial));
+    float* partial_data = partial.flat<float>().data();
+
+    T* x_data = const_cast<T*>(x.flat<T>().data());
+    T* w_up_data = const_cast<T*>(w_up.flat<T>().data());
+    T* w_down_data = const_cast<T*>(w_down.flat<T>().data());
+    T* w_gate_data =
+        is_gated_ ? const_cast<T*>(w_gate->flat<T>().data()) : nullptr;
+    const T* b_gate_data = b_gate ? b_gate->flat<T>().data() : nullptr;
+    const T* b_up_data = b_up ? b_up->flat<T>().data() : nullptr;
+    // The activated branch is the gate projection of gated MLPs.
+    T* w_act_data = is_gated_ ? w_gate_data : w_up_data;
+    const T* b_act_data = is_gated_ ? b_gate_data : b_up_data;
+    constexpr bool is_reduced_type = !std::is_same<T, float>::value;
+
+    // Cost of one task: a row block against a range of hidden blocks.
+    const int64 task_rows = std::min(kMLPRowBlockSize, m);
+    const int64 task_hidden = hidden / hidden_splits;
+    const int64 weight_cols = (is_gated_ ? 2 * k : k) + n;
+    const Eigen::TensorOpCost cost(weight_cols * task_hidden * sizeof(T),
+                                   task_rows * n * sizeof(float),
+                                   2.0 * task_rows * task_hidden * weight_cols);
+    ParallelFor(
+        row_blocks * hidden_splits, cost, [&](int64 begin, int64 end) {
+          const int64 block_size = kMLPRowBlockSize * hidden_block;
+          // Activated branch, linear branch of gated MLPs, and the
+          // intermediate converted back to T as input of the second matmul.
+          std::vector<float> act(block_size);
+          std::vector<float> linear(is_gated_ ? block_size : 0);
+          std::vector<T> reduced(is_reduced_type ? block_size : 0);
+
+          for (int64 task = begin; task < end; ++task) {
+            const int64 row_block = task / hidden_splits;
+            const int64 split = task % hidden_splits;
+            const int64 row = row_block * kMLPRowBlockSize;
+            const int64 rows = std::min(kMLPRowBlockSize, m - row);
+            const int64 first_block = hidden_blocks * split / hidden_splits;
+            const int64 last_block =
+                hidden_blocks * (split + 1) / hidden_splits;
+            float* out = partial_data + split * m * n + row * n;
+
+            for (int64 blk = first_block; blk < last_block; ++blk) {
+              const int64 h = blk * hidden_block;
+              const int64 cols = std::min(hidden_block, hidden - h);
+              cpublas::gemm('N', 'N', rows, cols, k, 1.0f, x_data + row * k, k,
+                            w_act_data + h, hidden, 0.0f, act.data(), cols);
+              if (is_gated_) {
+                cpublas::gemm('N', 'N', rows, cols, k, 1.0f, x_data + row * k,
+                              k, w_up_data + h, hidden, 0.0f, linear.data(),
+                              cols);
+              }
+              for (int64 r = 0; r < rows; ++r) {
+                functor::MLPBlock act_row(act.data() + r * cols, cols);
+                functor::ApplyMLPActivation<T>(
+                    activation_, b_act_data ? b_act_data + h : nullptr,
+                    &act_row);
+                if (is_gated_) {
+                  functor::MLPBlock linear_row(linear.data() + r * cols, cols);
+                  if (b_up_data != nullptr) {
+                    act_row =
+                        act_row *
+                        (linear_row +
+                         functor::ConstMLPVec<T>(b_up_data + h, cols)
+                             .template cast<float>());
+                  } else {
+                    act_row = act_row * linear_row;
+                  }
+                }
+              }
+              if (is_reduced_type) {
+                typename TTypes<T>::Flat reduced_block(reduced.data(),
+                                                       rows * cols);
+                reduced_block = functor::MLPBlock(act.data(), rows * cols)
+                                    .template cast<T>();
+              }
+              cpublas::gemm('N', 'N', rows, n, cols, 1.0f,
+                            HiddenData(act.data(), reduced.data()), cols,
+                            w_down_data + h * n, n,
+                            blk == first_block ? 0.0f : 1.0f, out, n);
+            }
+            if (first_block == last_block) {
+              std::fill(out, out + rows * n, 0.0f);
+            }
+          }
+        });
+
+    // Sums the partial outputs and adds b_down.
+    T* output_data = output->flat<T>().data();
+    const T* b_down_data = b_down ? b_down->flat<T>().data() : nullptr;
+    ParallelFor(m,
+                Eigen::TensorOpCost((hidden_splits + 1) * n * sizeof(float),
+                                    n * sizeof(T), hidden_splits * n),
+                [&](int64 begin, int64 end) {
+                  for (int64 r = begin; r < end; ++r) {
+                    functor::MLPBlock sum(partial_data + r * n, n);
+                    for (int64 s = 1; s < hidden_splits; ++s) {
+                      sum += functor::MLPBlock(partial_data + (s * m + r) * n,
+                                               n);
+                    }
+                    if (b_down_data != nullptr) {
+                      sum += functor::ConstMLPVec<T>(b_down_data, n)
+                                 .template cast<float>();
+                    }
+                    typename TTypes<T>::Flat out_row(output_data + r * n, n);
+                    out_row = sum.template cast<T>();
+                  }
+                });
+  }
+
+ private:
+  // Input of the second matmul, the fp32 intermediate or its T copy.
+  static T* HiddenData(float* act, T* reduced) {
+    if constexpr (std::is_same<T, float>::value) {
+      return act;
+    } else {
+      return reduced;
+    }
+  }
+
+  MLPActivation activation_;
+  bool is_gated_;
+  bool has_gate_bias_;
+  bool has_up_bias_;
+  bool has_down_bias_;
+};
+
+#define REGISTER_FUSED_MLP_KERNELS(type)                                    \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("_ITEXFusedMLP").Device(DEVICE_CPU).TypeConstraint<type>("T"), \
+      FusedMLPOp<type>)
+
+TF_CALL_float(REGISTER_FUSED_MLP_KERNELS);
+TF_CALL_bfloat16(REGISTER_FUSED_MLP_KERNELS);
+#undef REGISTER_FUSED_MLP_KERNELS
+
+}  // namespace itex
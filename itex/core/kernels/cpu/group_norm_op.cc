@@ -0,0 +1,270 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "itex/core/kernels/cpu/norm_op_utils.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+
+using CPUDevice = Eigen::ThreadPoolDevice;
+
+// Elements of the input read by one task, sized to stay in L2.
+constexpr int64 kGroupNormBlockSize = 16384;
+
+// GroupNorm of a channels-last input [N, spatial..., C], the C channels are
+// split into `num_groups` groups of contiguous channels and each (n, group)
+// is normalized over its spatial elements and channels.
+//
+// The input is split into blocks of whole pixels of one sample. A first pass
+// runs a Welford update of the per-channel mean and sum of squared deviations
+// (M2) of each block, which is vectorized over the contiguous channels, and
+// reduces them to per-group partial statistics. These are merged across blocks
+// with Chan's parallel formula, which unlike E[x^2] - mean^2 doesn't cancel
+// when the mean is large relative to the spread. The statistics of each group
+// are then folded with scale and offset into one multiplier and one addend
+// per (n, channel), so the second pass is a single multiply-add per element.
+// With `kFuseAdd`, the input is `x + residual`, which is written by the first
+// pass and returned as the second output.
+template <typename T, bool kFuseAdd>
+class GroupNormOp : public OpKernel {
+ public:
+  explicit GroupNormOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_groups", &num_groups_));
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+    OP_REQUIRES_OK(context, context->GetAttr("use_scale", &use_scale_));
+    OP_REQUIRES_OK(context, context->GetAttr("use_center", &use_center_));
+    OP_REQUIRES(context, num_groups_ > 0,
+                errors::InvalidArgument("num_groups must be positive, got ",
+                                        num_groups_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const int param_index = kFuseAdd ? 2 : 1;
+    const Tensor& input = context->input(0);
+    const Tensor& gamma = context->input(param_index);
+    const Tensor& beta = context->input(param_index + 1);
+
+    OP_REQUIRES(context, input.dims() >= 2,
+                errors::InvalidArgument("input must be at least 2-dimensional",
+                                        input.shape().DebugString()));
+    const int64 batch = input.dim_size(0);
+    const int64 channels = input.dim_size(input.dims() - 1);
+    OP_REQUIRES(context, channels % num_groups_ == 0,
+                errors::InvalidArgument("Number of channels ", channels,
+                                        " must be a multiple of num_groups ",
+                                        num_groups_));
+    OP_REQUIRES(context,
+                !use_scale_ ||
+                    (gamma.dims() == 1 && gamma.dim_size(0) == channels),
+                errors::InvalidArgument("gamma must have ", channels,
+                                        " elements, got ",
+                                        gamma.shape().DebugString()));
+    OP_REQUIRES(context,
+                !use_center_ ||
+                    (beta.dims() == 1 && beta.dim_size(0) == channels),
+                errors::InvalidArgument("beta must have ", channels,
+                                        " elements, got ",
+                                        beta.shape().DebugString()));
+
+    const T* residual_data = nullptr;
+    T* sum_data = nullptr;
+    if (kFuseAdd) {
+      const Tensor& residual = context->input(1);
+      OP_REQUIRES(context, residual.shape() == input.shape(),
+                  errors::InvalidArgument(
+                      "residual must have the shape of input, got ",
+                      residual.shape().DebugString(), " vs ",
+                      input.shape().DebugString()));
+      residual_data = residual.flat<T>().data();
+      Tensor* sum = nullptr;
+      OP_REQUIRES_OK(context,
+                     context->allocate_output(1, input.shape(), &sum));
+      sum_data = sum->flat<T>().data();
+    }
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, input.shape(), &output));
+    if (input.NumElements() == 0) return;
+
+    const int64 groups = num_groups_;
+    const int64 group_size = channels / groups;
+    const int64 pixels = input.NumElements() / (batch * channels);
+    const int64 block_pixels =
+        std::max<int64>(1, kGroupNormBlockSize / channels);
+    const int64 blocks_per_sample = (pixels + block_pixels - 1) / block_pixels;
+    const int64 num_blocks = batch * blocks_per_sample;
+
+    const T* input_data = input.flat<T>().data();
+    T* output_data = output->flat<T>().data();
+    const CPUDevice& device = context->eigen_device<CPUDevice>();
+
+    // Pass 1: mean and M2 of each group in each block.
+    std::vector<double> partial_stats(num_blocks * groups * 2, 0.0);
+    const int64 bytes_per_block =
+        block_pixels * channels * sizeof(T) * (kFuseAdd ? 3 : 1);
+    device.parallelFor(
+        num_blocks,
+        Eigen::TensorOpCost(bytes_per_block, 0,
+                            block_pixels * channels * 5),
+        [&](Eigen::Index first, Eigen::Index last) {
+          std::vector<float> buffer(channels);
+          std::vector<float> channel_delta(channels);
+          std::vector<float> channel_mean(channels);
+          std::vector<float> channel_m2(channels);
+          functor::NormRow<float> row(buffer.data(), channels);
+          functor::NormRow<float> delta(channel_delta.data(), channels);
+          functor::NormRow<float> mean(channel_mean.data(), channels);
+          functor::NormRow<float> m2(channel_m2.data(), channels);
+          for (Eigen::Index block = first; block < last; ++block) {
+            const int64 begin = PixelOffset(block, blocks_per_sample,
+                                            block_pixels, pixels);
+            const int64 end = std::min(begin + block_pixels,
+                                       (begin / pixels + 1) * pixels);
+            mean.setZero();
+            m2.setZero();
+            for (int64 p = begin; p < end; ++p) {
+              const int64 offset = p * channels;
+              functor::LoadNormInput<T, kFuseAdd>(
+                  input_data + offset,
+                  kFuseAdd ? residual_data + offset : nullptr,
+                  kFuseAdd ? sum_data + offset : nullptr, channels,
+                  buffer.data());
+              delta = row - mean;
+              mean += delta * (1.0f / static_cast<float>(p - begin + 1));
+              m2 += delta * (row - mean);
+            }
+            // All the channels of a group have the same count, so the group
+            // mean is the average of the channel means.
+            const double block_count = static_cast<double>(end - begin);
+            double* block_stats = &partial_stats[block * groups * 2];
+            for (int64 g = 0; g < groups; ++g) {
+              double group_mean = 0.0;
+              for (int64 c = g * group_size; c < (g + 1) * group_size; ++c) {
+                group_mean += channel_mean[c];
+              }
+              group_mean /= group_size;
+              double group_m2 = 0.0;
+              for (int64 c = g * group_size; c < (g + 1) * group_size; ++c) {
+                const double d = channel_mean[c] - group_mean;
+                group_m2 += channel_m2[c] + block_count * d * d;
+              }
+              block_stats[g * 2] = group_mean;
+              block_stats[g * 2 + 1] = group_m2;
+            }
+          }
+        });
+
+    // Folds the statistics with scale and offset: y = x * mul + add.
+    std::vector<float> mul(batch * channels);
+    std::vector<float> add(batch * channels);
+    const T* gamma_data = use_scale_ ? gamma.flat<T>().data() : nullptr;
+    const T* beta_data = use_center_ ? beta.flat<T>().data() : nullptr;
+    for (int64 n = 0; n < batch; ++n) {
+      for (int64 g = 0; g < groups; ++g) {
+        double count = 0.0;
+        double mean = 0.0;
+        double m2 = 0.0;
+        for (int64 b = 0; b < blocks_per_sample; ++b) {
+          const double* block_stats =
+              &partial_stats[((n * blocks_per_sample + b) * groups + g) * 2];
+          const double block_count = static_cast<double>(
+              std::min(block_pixels, pixels - b * block_pixels) * group_size);
+          const double total = count + block_count;
+          const double d = block_stats[0] - mean;
+          mean += d * block_count / total;
+          m2 += block_stats[1] + d * d * count * block_count / total;
+          count = total;
+        }
+        const double variance = std::max(m2 / count, 0.0);
+        const double rstd = 1.0 / std::sqrt(variance + epsilon_);
+        for (int64 c = g * group_size; c < (g + 1) * group_size; ++c) {
+          const double scale =
+              use_scale_ ? rstd * static_cast<float>(gamma_data[c]) : rstd;
+          const double shift =
+              use_center_ ? static_cast<float>(beta_data[c]) : 0.0;
+          mul[n * channels + c] = static_cast<float>(scale);
+          add[n * channels + c] = static_cast<float>(shift - mean * scale);
+        }
+      }
+    }
+
+    // Pass 2: normalize, the input is read again from the sum if fused.
+    const T* normalize_data = kFuseAdd ? sum_data : input_data;
+    device.parallelFor(
+        num_blocks,
+        Eigen::TensorOpCost(bytes_per_block,
+                            block_pixels * channels * sizeof(T),
+                            block_pixels * channels * 2),
+        [&](Eigen::Index first, Eigen::Index last) {
+          for (Eigen::Index block = first; block < last; ++block) {
+            const int64 begin = PixelOffset(block, blocks_per_sample,
+                                            block_pixels, pixels);
+            const int64 end = std::min(begin + block_pixels,
+                                       (begin / pixels + 1) * pixels);
+            const int64 n = begin / pixels;
+            functor::NormConstRow<float> sample_mul(&mul[n * channels],
+                                                    channels);
+            functor::NormConstRow<float> sample_add(&add[n * channels],
+                                                    channels);
+            for (int64 p = begin; p < end; ++p) {
+              const int64 offset = p * channels;
+              functor::NormRow<T>(output_data + offset, channels) =
+                  (functor::NormConstRow<T>(normalize_data + offset, channels)
+                           .template cast<float>() *
+                       sample_mul +
+                   sample_add)
+                      .template cast<T>();
+            }
+          }
+        });
+  }
+
+ private:
+  // Index of the first pixel of `block`, blocks don't cross samples.
+  static int64 PixelOffset(int64 block, int64 blocks_per_sample,
+                           int64 block_pixels, int64 pixels) {
+    const int64 n = block / blocks_per_sample;
+    return n * pixels + (block % blocks_per_sample) * block_pixels;
+  }
+
+  int num_groups_;
+  float epsilon_;
+  bool use_scale_;
+  bool use_center_;
+};
+
+#define REGISTER_CPU_KERNEL(T)                                            \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("ITEXGroupNorm").Device(DEVICE_CPU).TypeConstraint<T>("T"),    \
+      GroupNormOp<T, false>);                                             \
+  REGISTER_KERNEL_BUILDER(Name("_ITEXFusedAddGroupNorm")                  \
+                              .Device(DEVICE_CPU)                         \
+                              .TypeConstraint<T>("T"),                    \
+                          GroupNormOp<T, true>);
+
+TF_CALL_CPU_NUMBER_TYPES(REGISTER_CPU_KERNEL);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace itex
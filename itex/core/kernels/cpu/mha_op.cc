@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "itex/core/kernels/cpu/mha_op.h"
 
+#include <algorithm>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -30,6 +31,24 @@ limitations under the License.
 
 namespace itex {
 
+// Returns the number of key/value heads of `key`, checking it against the
+// `num_kv_heads` attr (0 means not set) and that it evenly divides the query
+// heads.
+static Status GetNumKVHeads(int64_t num_heads, const Tensor& key,
+                            int num_kv_heads_attr, int64_t* num_kv_heads) {
+  *num_kv_heads = key.dim_size(1);
+  if (num_kv_heads_attr > 0 && num_kv_heads_attr != *num_kv_heads) {
+    return errors::InvalidArgument("num_kv_heads is ", num_kv_heads_attr,
+                                   " but key has ", *num_kv_heads, " heads");
+  }
+  if (*num_kv_heads <= 0 || num_heads % *num_kv_heads != 0) {
+    return errors::InvalidArgument("Number of query heads ", num_heads,
+                                   " must be a multiple of key/value heads ",
+                                   *num_kv_heads);
+  }
+  return Status::OK();
+}
+
 template <typename T>
 class MHAOp : public OpKernel {
  public:
@@ -40,6 +59,8 @@ class MHAOp : public OpKernel {
       OP_REQUIRES_OK(context, context->GetAttr("dropout_prob", &dropout_prob));
     } else {
       OP_REQUIRES_OK(context, context->GetAttr("use_causal", &use_causal));
+      OP_REQUIRES_OK(context,
+                     context->GetAttr("num_kv_heads", &num_kv_heads_attr));
     }
     OP_REQUIRES_OK(context, context->GetAttr("use_mask", &use_mask));
   }
@@ -58,6 +79,14 @@ class MHAOp : public OpKernel {
     int64_t q_seq_len = query.dim_size(2);
     int64_t head_size = query.dim_size(3);
     int64_t k_seq_len = key.dim_size(2);
+    int64_t num_kv_heads = 0;
+    OP_REQUIRES_OK(context, GetNumKVHeads(num_heads, key, num_kv_heads_attr,
+                                          &num_kv_heads));
+    OP_REQUIRES(context, key.shape() == value.shape(),
+                errors::InvalidArgument("key and value must have the same "
+                                        "shape, got ",
+                                        key.shape().DebugString(), " vs ",
+                                        value.shape().DebugString()));
 
     Tensor* output = nullptr;
     OP_REQUIRES_OK(
@@ -65,11 +94,11 @@ class MHAOp : public OpKernel {
         context->allocate_output(
             0, {batch_size, q_seq_len, num_heads, head_size}, &output));
 
-#define CALL_FMHA_FUNC(T, qSplitSize, kvSplitSize)                            \
-  FmhaFunctor<T, qSplitSize, kvSplitSize>()(                                  \
-      query, key, value, batch_size, q_seq_len, num_heads, head_size,         \
-      k_seq_len, use_mask, use_causal, use_dropout, atten_mask, dropout_mask, \
-      dropout_prob, output)
+#define CALL_FMHA_FUNC(T, qSplitSize, kvSplitSize)                             \
+  FmhaFunctor<T, qSplitSize, kvSplitSize>()(                                   \
+      query, key, value, batch_size, q_seq_len, num_heads, num_kv_heads,       \
+      head_size, k_seq_len, use_mask, use_causal, use_dropout,                 \
+      atten_mask, dropout_mask, dropout_prob, output)
 
     if (q_seq_len >= 768) {
       CALL_FMHA_FUNC(T, 256, 512);
@@ -86,6 +115,423 @@ class MHAOp : public OpKernel {
   bool use_causal = false;
   bool use_dropout = false;
   bool is_inference = false;
+  int num_kv_heads_attr = 0;
+};
+
+// Attention for autoregressive decoding with a preallocated KV cache.
+// `key`/`value` of the current step are written into the cache at row
+// `cache_len` and `query` attends to the first `cache_len + new_len` rows of
+// the cache. When the cache is not shared the buffer is updated in place, so a
+// decoding step costs O(new_len) copies instead of re-concatenating the whole
+// history. A negative `cache_len` means the whole cache is valid, the cache is
+// then grown like ConcatV2 on the sequence axis, which is what the remapper
+// emits for concat-based cache graphs.
+template <typename T>
+class MHAKVCacheOp : public OpKernel {
+ public:
+  explicit MHAKVCacheOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("use_mask", &use_mask));
+    OP_REQUIRES_OK(context, context->GetAttr("use_causal", &use_causal));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("num_kv_heads", &num_kv_heads_attr));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& query = context->input(0);
+    const Tensor& key = context->input(1);
+    const Tensor& value = context->input(2);
+    const Tensor& key_cache = context->input(3);
+    const Tensor& value_cache = context->input(4);
+    const Tensor& cache_len_tensor = context->input(5);
+    Tensor atten_mask;
+    if (use_mask) atten_mask = context->input(6);
+
+    OP_REQUIRES(context,
+                query.dims() == 4 && key.dims() == 4 && value.dims() == 4 &&
+                    key_cache.dims() == 4 && value_cache.dims() == 4,
+                errors::InvalidArgument(
+                    "query, key, value and caches must be 4-D, got ",
+                    query.shape().DebugString(), ", ",
+                    key.shape().DebugString(), ", ",
+                    key_cache.shape().DebugString()));
+    OP_REQUIRES(context, key.shape() == value.shape(),
+                errors::InvalidArgument("key and value must have the same "
+                                        "shape, got ",
+                                        key.shape().DebugString(), " vs ",
+                                        value.shape().DebugString()));
+    OP_REQUIRES(context, key_cache.shape() == value_cache.shape(),
+                errors::InvalidArgument("key_cache and value_cache must have "
+                                        "the same shape, got ",
+                                        key_cache.shape().DebugString(), " vs ",
+                                        value_cache.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(cache_len_tensor.shape()),
+                errors::InvalidArgument(
+                    "cache_len must be a scalar, got ",
+                    cache_len_tensor.shape().DebugString()));
+
+    int64_t batch_size = query.dim_size(0);
+    int64_t num_heads = query.dim_size(1);
+    int64_t q_seq_len = query.dim_size(2);
+    int64_t head_size = query.dim_size(3);
+    int64_t new_len = key.dim_size(2);
+    int64_t capacity = key_cache.dim_size(2);
+    int64_t num_kv_heads = 0;
+    OP_REQUIRES_OK(context, GetNumKVHeads(num_heads, key, num_kv_heads_attr,
+                                          &num_kv_heads));
+    OP_REQUIRES(context, key_cache.dim_size(1) == num_kv_heads,
+                errors::InvalidArgument(
+                    "key_cache must have ", num_kv_heads, " heads, got ",
+                    key_cache.shape().DebugString()));
+    for (int d : {0, 3}) {
+      OP_REQUIRES(context,
+                  key.dim_size(d) == query.dim_size(d) &&
+                      key_cache.dim_size(d) == query.dim_size(d),
+                  errors::InvalidArgument(
+                      "Mismatched dimension ", d, " between query ",
+                      query.shape().DebugString(), ", key ",
+                      key.shape().DebugString(), " and key_cache ",
+                      key_cache.shape().DebugString()));
+    }
+
+    int64_t cache_len = cache_len_tensor.scalar<int32>()();
+    if (cache_len < 0) cache_len = capacity;
+    OP_REQUIRES(context, cache_len <= capacity,
+                errors::InvalidArgument("cache_len ", cache_len,
+                                        " exceeds the cache capacity ",
+                                        capacity));
+    int64_t k_seq_len = cache_len + new_len;
+    // Grow the cache if the new step doesn't fit.
+    int64_t out_capacity = std::max(capacity, k_seq_len);
+
+    Tensor* key_cache_out = nullptr;
+    Tensor* value_cache_out = nullptr;
+    UpdateCache(context, 3, 1, key_cache, key, cache_len, out_capacity,
+                &key_cache_out);
+    if (!context->status().ok()) return;
+    UpdateCache(context, 4, 2, value_cache, value, cache_len, out_capacity,
+                &value_cache_out);
+    if (!context->status().ok()) return;
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(
+        context,
+        context->allocate_output(
+            0, {batch_size, q_seq_len, num_heads, head_size}, &output));
+    if (output->NumElements() == 0) return;
+
+    Tensor dropout_mask;
+#define CALL_FMHA_KV_CACHE_FUNC(T, qSplitSize, kvSplitSize)                    \
+  FmhaFunctor<T, qSplitSize, kvSplitSize>()(                                   \
+      query, *key_cache_out, *value_cache_out, batch_size, q_seq_len,          \
+      num_heads, num_kv_heads, head_size, k_seq_len, use_mask, use_causal,     \
+      false, atten_mask, dropout_mask, 0.f, output, out_capacity)
+
+    if (q_seq_len >= 768) {
+      CALL_FMHA_KV_CACHE_FUNC(T, 256, 512);
+    } else if (q_seq_len >= 192) {
+      CALL_FMHA_KV_CACHE_FUNC(T, 64, 512);
+    } else {
+      CALL_FMHA_KV_CACHE_FUNC(T, 32, 512);
+    }
+#undef CALL_FMHA_KV_CACHE_FUNC
+  }
+
+ private:
+  // Writes the first `cache_len` rows of `cache` followed by `update` into
+  // output `output_index` of shape [B, H, capacity, D]. The cache buffer is
+  // forwarded when nobody else holds it, then only `update` is copied.
+  void UpdateCache(OpKernelContext* context, int input_index,
+                   int output_index, const Tensor& cache, const Tensor& update,
+                   int64_t cache_len, int64_t capacity, Tensor** output) {
+    int64_t batch_size = cache.dim_size(0);
+    int64_t num_heads = cache.dim_size(1);
+    int64_t head_size = cache.dim_size(3);
+    int64_t new_len = update.dim_size(2);
+    TensorShape shape({batch_size, num_heads, capacity, head_size});
+
+    int forwarded_input = -1;
+    if (capacity == cache.dim_size(2)) {
+      OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                  {input_index}, output_index, shape, output,
+                                  &forwarded_input));
+    } else {
+      OP_REQUIRES_OK(context,
+                     context->allocate_output(output_index, shape, output));
+    }
+    if ((*output)->NumElements() == 0) return;
+    bool copy_cache = forwarded_input != input_index && cache_len > 0;
+
+    const T* cache_data = const_cast<Tensor&>(cache).flat<T>().data();
+    const T* update_data = const_cast<Tensor&>(update).flat<T>().data();
+    T* out_data = (*output)->flat<T>().data();
+    int64_t cache_stride_h = cache.dim_size(2) * head_size;
+    int64_t update_stride_h = new_len * head_size;
+    int64_t out_stride_h = capacity * head_size;
+
+    double bytes =
+        ((copy_cache ? cache_len : 0) + new_len) * head_size * sizeof(T);
+    Eigen::TensorOpCost cost(bytes, bytes, 0);
+    ParallelFor(batch_size * num_heads, cost, [&](int64_t begin, int64_t end) {
+      for (int64_t bh = begin; bh < end; ++bh) {
+        T* out_head = out_data + bh * out_stride_h;
+        if (copy_cache) {
+          std::copy_n(cache_data + bh * cache_stride_h, cache_len * head_size,
+                      out_head);
+        }
+        std::copy_n(update_data + bh * update_stride_h, new_len * head_size,
+                    out_head + cache_len * head_size);
+      }
+    });
+  }
+
+  bool use_mask = false;
+  bool use_causal = false;
+  int num_kv_heads_attr = 0;
+};
+
+// Inference over a packed batch of variable-length sequences, see
+// FmhaVarLenFunctor. Replaces padding + atten_mask for ragged batches.
+template <typename T>
+class MHAVarLenOp : public OpKernel {
+ public:
+  explicit MHAVarLenOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("use_causal", &use_causal));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("num_kv_heads", &num_kv_heads_attr));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& query = context->input(0);
+    const Tensor& key = context->input(1);
+    const Tensor& value = context->input(2);
+    const Tensor& cu_seqlens_q = context->input(3);
+    const Tensor& cu_seqlens_k = context->input(4);
+
+    OP_REQUIRES(context,
+                query.dims() == 3 && key.dims() == 3 && value.dims() == 3,
+                errors::InvalidArgument(
+                    "Packed query, key and value must be 3-D, got ",
+                    query.shape().DebugString(), ", ",
+                    key.shape().DebugString(), ", ",
+                    value.shape().DebugString()));
+    OP_REQUIRES(context, key.shape() == value.shape(),
+                errors::InvalidArgument("key and value must have the same "
+                                        "shape, got ",
+                                        key.shape().DebugString(), " vs ",
+                                        value.shape().DebugString()));
+    OP_REQUIRES(context, key.dim_size(2) == query.dim_size(2),
+                errors::InvalidArgument("query and key must have the same "
+                                        "head size, got ",
+                                        query.shape().DebugString(), " vs ",
+                                        key.shape().DebugString()));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(cu_seqlens_q.shape()) &&
+                    cu_seqlens_q.shape() == cu_seqlens_k.shape() &&
+                    cu_seqlens_q.NumElements() >= 1,
+                errors::InvalidArgument(
+                    "cu_seqlens_q and cu_seqlens_k must be vectors of size "
+                    "batch_size + 1, got ",
+                    cu_seqlens_q.shape().DebugString(), " and ",
+                    cu_seqlens_k.shape().DebugString()));
+
+    int64_t total_q = query.dim_size(0);
+    int64_t num_heads = query.dim_size(1);
+    int64_t head_size = query.dim_size(2);
+    int64_t total_k = key.dim_size(0);
+    int64_t num_kv_heads = 0;
+    // Packed key is [total_k, H_kv, D], heads are dim 1 as in the dense case.
+    OP_REQUIRES_OK(context, GetNumKVHeads(num_heads, key, num_kv_heads_attr,
+                                          &num_kv_heads));
+
+    int64_t batch_size = cu_seqlens_q.NumElements() - 1;
+    const int32* cu_q = cu_seqlens_q.flat<int32>().data();
+    const int32* cu_k = cu_seqlens_k.flat<int32>().data();
+    int64_t max_q_seq_len = 0;
+    int64_t max_k_seq_len = 0;
+    OP_REQUIRES(context, cu_q[0] == 0 && cu_k[0] == 0,
+                errors::InvalidArgument("cu_seqlens must start with 0"));
+    for (int64_t b = 0; b < batch_size; ++b) {
+      OP_REQUIRES(context, cu_q[b + 1] >= cu_q[b] && cu_k[b + 1] >= cu_k[b],
+                  errors::InvalidArgument("cu_seqlens must be non-decreasing"));
+      max_q_seq_len = std::max<int64_t>(max_q_seq_len, cu_q[b + 1] - cu_q[b]);
+      max_k_seq_len = std::max<int64_t>(max_k_seq_len, cu_k[b + 1] - cu_k[b]);
+    }
+    OP_REQUIRES(context,
+                cu_q[batch_size] == total_q && cu_k[batch_size] == total_k,
+                errors::InvalidArgument(
+                    "cu_seqlens must end with the number of packed tokens, "
+                    "got ",
+                    cu_q[batch_size], " vs ", total_q, " and ",
+                    cu_k[batch_size], " vs ", total_k));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, query.shape(), &output));
+    if (max_q_seq_len == 0 || head_size == 0) return;
+
+#define CALL_FMHA_VARLEN_FUNC(T, qSplitSize, kvSplitSize)                      \
+  FmhaVarLenFunctor<T, qSplitSize, kvSplitSize>()(                             \
+      query, key, value, cu_q, cu_k, batch_size, max_q_seq_len, max_k_seq_len, \
+      num_heads, num_kv_heads, head_size, use_causal, output)
+
+    // Tile by the longest sequence like the dense kernel, short sequences
+    // simply have fewer tiles.
+    if (max_q_seq_len >= 768) {
+      CALL_FMHA_VARLEN_FUNC(T, 256, 512);
+    } else if (max_q_seq_len >= 192) {
+      CALL_FMHA_VARLEN_FUNC(T, 64, 512);
+    } else {
+      CALL_FMHA_VARLEN_FUNC(T, 32, 512);
+    }
+#undef CALL_FMHA_VARLEN_FUNC
+  }
+
+ private:
+  bool use_causal = false;
+  int num_kv_heads_attr = 0;
+};
+
+// Training forward. Same as the inference kernel, but also saves the softmax
+// log-sum-exp so that MHAFlashGradOp can recompute the attention blockwise
+// instead of keeping the [B, H, Sq, Sk] probabilities alive.
+template <typename T>
+class MHAFlashOp : public OpKernel {
+ public:
+  explicit MHAFlashOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("use_mask", &use_mask));
+    OP_REQUIRES_OK(context, context->GetAttr("use_causal", &use_causal));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("num_kv_heads", &num_kv_heads_attr));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& query = context->input(0);
+    const Tensor& key = context->input(1);
+    const Tensor& value = context->input(2);
+    Tensor atten_mask;
+    if (use_mask) atten_mask = context->input(3);
+
+    int64_t batch_size = query.dim_size(0);
+    int64_t num_heads = query.dim_size(1);
+    int64_t q_seq_len = query.dim_size(2);
+    int64_t head_size = query.dim_size(3);
+    int64_t k_seq_len = key.dim_size(2);
+    int64_t num_kv_heads = 0;
+    OP_REQUIRES_OK(context, GetNumKVHeads(num_heads, key, num_kv_heads_attr,
+                                          &num_kv_heads));
+    OP_REQUIRES(context, key.shape() == value.shape(),
+                errors::InvalidArgument("key and value must have the same "
+                                        "shape, got ",
+                                        key.shape().DebugString(), " vs ",
+                                        value.shape().DebugString()));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(
+        context,
+        context->allocate_output(
+            0, {batch_size, q_seq_len, num_heads, head_size}, &output));
+    Tensor* softmax_lse = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       1, {batch_size, num_heads, q_seq_len}, &softmax_lse));
+    if (output->NumElements() == 0) return;
+
+    Tensor dropout_mask;
+#define CALL_FMHA_FLASH_FUNC(T, qSplitSize, kvSplitSize)                       \
+  FmhaFunctor<T, qSplitSize, kvSplitSize>()(                                   \
+      query, key, value, batch_size, q_seq_len, num_heads, num_kv_heads,       \
+      head_size, k_seq_len, use_mask, use_causal, false, atten_mask,           \
+      dropout_mask, 0.f, output, 0, softmax_lse)
+
+    if (q_seq_len >= 768) {
+      CALL_FMHA_FLASH_FUNC(T, 256, 512);
+    } else if (q_seq_len >= 192) {
+      CALL_FMHA_FLASH_FUNC(T, 64, 512);
+    } else {
+      CALL_FMHA_FLASH_FUNC(T, 32, 512);
+    }
+#undef CALL_FMHA_FLASH_FUNC
+  }
+
+ private:
+  bool use_mask = false;
+  bool use_causal = false;
+  int num_kv_heads_attr = 0;
+};
+
+template <typename T>
+class MHAFlashGradOp : public OpKernel {
+ public:
+  explicit MHAFlashGradOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("use_mask", &use_mask));
+    OP_REQUIRES_OK(context, context->GetAttr("use_causal", &use_causal));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("num_kv_heads", &num_kv_heads_attr));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& query = context->input(0);
+    const Tensor& key = context->input(1);
+    const Tensor& value = context->input(2);
+    Tensor atten_mask;
+    if (use_mask) atten_mask = context->input(3);
+    const Tensor& output = context->input(4);
+    const Tensor& softmax_lse = context->input(5);
+    const Tensor& output_backprop = context->input(6);
+
+    int64_t batch_size = query.dim_size(0);
+    int64_t num_heads = query.dim_size(1);
+    int64_t q_seq_len = query.dim_size(2);
+    int64_t head_size = query.dim_size(3);
+    int64_t k_seq_len = key.dim_size(2);
+    int64_t num_kv_heads = 0;
+    OP_REQUIRES_OK(context, GetNumKVHeads(num_heads, key, num_kv_heads_attr,
+                                          &num_kv_heads));
+    OP_REQUIRES(context, output_backprop.shape() == output.shape(),
+                errors::InvalidArgument("output_backprop must have the same "
+                                        "shape as output, got ",
+                                        output_backprop.shape().DebugString(),
+                                        " vs ", output.shape().DebugString()));
+    OP_REQUIRES(
+        context,
+        softmax_lse.shape() ==
+            TensorShape({batch_size, num_heads, q_seq_len}),
+        errors::InvalidArgument("softmax_lse must be [batch, heads, q_len], "
+                                "got ",
+                                softmax_lse.shape().DebugString()));
+
+    Tensor* query_backprop = nullptr;
+    Tensor* key_backprop = nullptr;
+    Tensor* value_backprop = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, query.shape(),
+                                                     &query_backprop));
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(1, key.shape(), &key_backprop));
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(2, value.shape(), &value_backprop));
+    if (query.NumElements() == 0 || key.NumElements() == 0) return;
+
+    // Must use the same tiling as the forward.
+#define CALL_FMHA_BWD_FUNC(T, qSplitSize, kvSplitSize)                         \
+  FmhaBackwardFunctor<T, qSplitSize, kvSplitSize>()(                           \
+      query, key, value, output, softmax_lse, output_backprop, batch_size,     \
+      q_seq_len, num_heads, num_kv_heads, head_size, k_seq_len, use_mask,      \
+      use_causal, atten_mask, query_backprop, key_backprop, value_backprop)
+
+    if (q_seq_len >= 768) {
+      CALL_FMHA_BWD_FUNC(T, 256, 512);
+    } else if (q_seq_len >= 192) {
+      CALL_FMHA_BWD_FUNC(T, 64, 512);
+    } else {
+      CALL_FMHA_BWD_FUNC(T, 32, 512);
+    }
+#undef CALL_FMHA_BWD_FUNC
+  }
+
+ private:
+  bool use_mask = false;
+  bool use_causal = false;
+  int num_kv_heads_attr = 0;
 };
 
 #define REGISTER_MHA_INF_CPU(type)                                   \
@@ -98,4 +544,38 @@ REGISTER_MHA_INF_CPU(Eigen::bfloat16);
 REGISTER_MHA_INF_CPU(float);
 #undef REGISTER_MHA_INF_GPU
 
+#define REGISTER_MHA_KV_CACHE_CPU(type)                                     \
+  REGISTER_KERNEL_BUILDER(Name("ScaledDotProductAttentionKVCacheInference") \
+                              .Device(DEVICE_CPU)                           \
+                              .TypeConstraint<type>("T"),                   \
+                          MHAKVCacheOp<type>);
+
+REGISTER_MHA_KV_CACHE_CPU(Eigen::bfloat16);
+REGISTER_MHA_KV_CACHE_CPU(float);
+#undef REGISTER_MHA_KV_CACHE_CPU
+
+#define REGISTER_MHA_FLASH_CPU(type)                                 \
+  REGISTER_KERNEL_BUILDER(Name("ScaledDotProductAttentionFlash")     \
+                              .Device(DEVICE_CPU)                    \
+                              .TypeConstraint<type>("T"),            \
+                          MHAFlashOp<type>);                         \
+  REGISTER_KERNEL_BUILDER(Name("ScaledDotProductAttentionFlashGrad") \
+                              .Device(DEVICE_CPU)                    \
+                              .TypeConstraint<type>("T"),            \
+                          MHAFlashGradOp<type>);
+
+REGISTER_MHA_FLASH_CPU(Eigen::bfloat16);
+REGISTER_MHA_FLASH_CPU(float);
+#undef REGISTER_MHA_FLASH_CPU
+
+#define REGISTER_MHA_VARLEN_CPU(type)                                     \
+  REGISTER_KERNEL_BUILDER(Name("ScaledDotProductAttentionVarLenInference") \
+                              .Device(DEVICE_CPU)                          \
+                              .TypeConstraint<type>("T"),                  \
+                          MHAVarLenOp<type>);
+
+REGISTER_MHA_VARLEN_CPU(Eigen::bfloat16);
+REGISTER_MHA_VARLEN_CPU(float);
+#undef REGISTER_MHA_VARLEN_CPU
+
 }  // namespace itex
@@ -61,27 +61,207 @@ static inline scalar_t* conditional_data_ptr(float* ptr, scalar_t* ptr2) {
   return ptr2;
 }
 
-template <typename T, int64_t qSplitSize, int64_t kvSplitSize>
-class FmhaFunctor {
- public:
+// Applies the causal mask and the additive `atten_mask` to the
+// [q_block_size, kv_block_size] block of scores of head (i, j) starting at
+// query row `m` and key column `n`.
+template <typename T>
+inline void ApplyAttentionMask(float* qk_data, int64_t q_block_size,
+                               int64_t kv_block_size, int64_t i, int64_t j,
+                               int64_t m, int64_t n, int64_t k_seq_len,
+                               int64_t causal_q_start, bool use_causal,
+                               bool use_mask, const Tensor& atten_mask) {
+  using Tvec = typename TTypes<T>::Flat;
+  using Fvec = typename TTypes<float>::Flat;
+
+  // Apply causal mask, fill unused with -inf.
+  // Suppose there is a lower_triangle_mask whose lower triangle is all 1, cut
+  // a portion of it like lower_triangle_mask[:, :, key_length - query_length :
+  // key_length, :key_length], this portion is then applied to the qk result as
+  // causal mask.
+  if (use_causal && n + kv_block_size > causal_q_start + 1) {
+    int64_t row_end =
+        std::min(n + kv_block_size - causal_q_start - 1, q_block_size);
+    for (int row = 0; row < row_end; ++row) {
+      // First masked column of this row, relative to the block.
+      int64_t first_col = std::max<int64_t>(causal_q_start + 1 + row - n, 0);
+      float* row_ptr = qk_data + row * kv_block_size;
+      Fvec causal_mask_vec(row_ptr + first_col, kv_block_size - first_col);
+      causal_mask_vec.setConstant(-std::numeric_limits<float>::infinity());
+    }
+  }
+
+  if (use_mask) {
+    T* atten_mask_data = const_cast<Tensor&>(atten_mask).flat<T>().data();
+    int64_t mask_batch_size = atten_mask.dim_size(0);
+    int64_t mask_num_heads = atten_mask.dim_size(1);
+    int64_t mask_q_size = atten_mask.dim_size(2);
+    for (int row = 0; row < q_block_size; ++row) {
+      int b_index = mask_batch_size > 1 ? i : 0;
+      int h_index = mask_num_heads > 1 ? j : 0;
+      int q_index = mask_q_size > 1 ? (m + row) : 0;
+      T* mask_start_data = atten_mask_data +
+                           b_index * mask_num_heads * mask_q_size * k_seq_len +
+                           h_index * mask_q_size * k_seq_len +
+                           q_index * k_seq_len + n;
+      Fvec qk_vec(qk_data + row * kv_block_size, kv_block_size);
+      Tvec mask_vec(mask_start_data, kv_block_size);
+      qk_vec += mask_vec.template cast<float>();
+    }
+  }
+}
+
+// Per thread float buffers of the blocked forward.
+template <typename T>
+struct FmhaBlockBuffers {
+  float* qk;
+  float* qk_max;
+  float* qk_sum;
+  float* dst;
+  // P_ij converted back to T for (P_ij @ V), null if T is float.
+  T* qk_reduced;
+};
+
+// Computes the attention of one query tile with the online softmax:
+// `q_block_size` rows of `q` (row stride `q_stride_m`) attend to the first
+// `num_keys` rows of `k`/`v` (row stride `kv_stride_n`) in blocks of
+// `kv_split_size` keys. `apply_mask(qk, kv_block_size, n)` adds the masks of
+// the key block starting at `n` to the float scores. The result is written to
+// `out` (row stride `o_stride_m`) and, if `lse` is not null, the log-sum-exp
+// of every row to `lse`.
+template <typename T, typename MaskFn>
+inline void FmhaBlockForward(T* q, int64_t q_stride_m, T* k, T* v,
+                             int64_t kv_stride_n, T* out, int64_t o_stride_m,
+                             float* lse, int64_t q_block_size, int64_t num_keys,
+                             int64_t kv_split_size, int64_t head_size,
+                             float scaling_factor,
+                             const FmhaBlockBuffers<T>& buffers,
+                             const MaskFn& apply_mask) {
   using Tvec = typename TTypes<T>::Flat;
   using Fvec = typename TTypes<float>::Flat;
+  constexpr bool is_reduced_type = is_reduced_floating_point_v<T>;
+
+  float* qk_data = buffers.qk;
+  float* qk_max_data = buffers.qk_max;
+  float* qk_sum_data = buffers.qk_sum;
+  float* dst_data = buffers.dst;
+  T* qk_reduced_data = buffers.qk_reduced;
+
+  // Initialize max and sum
+  Fvec qk_max_vec(qk_max_data, q_block_size);
+  Fvec qk_sum_vec(qk_sum_data, q_block_size);
+  qk_max_vec.setConstant(-std::numeric_limits<float>::infinity());
+  qk_sum_vec.setConstant(0.f);
+  if (num_keys <= 0) {
+    Fvec dst_vec(dst_data, q_block_size * head_size);
+    dst_vec.setZero();
+  }
 
+  for (int64_t n = 0; n < num_keys; n += kv_split_size) {
+    int64_t kv_block_size = std::min(kv_split_size, num_keys - n);
+    // Calculate scale * q @ k.T
+    // And the output is float type.
+    cpublas::gemm('N', 'T', q_block_size, kv_block_size, head_size,
+                  scaling_factor, q, q_stride_m, k + n * kv_stride_n,
+                  kv_stride_n, 0.f, qk_data, kv_block_size);
+
+    apply_mask(qk_data, kv_block_size, n);
+
+    // Below is applying the softmax.
+    float tmp_max = 0.f, tmp_sum = 0.f, sum_old = 0.f, exp_tmp = 0.f;
+
+    for (int row = 0; row < q_block_size; ++row) {
+      sum_old = qk_sum_data[row];
+
+      Fvec qk_max_vec(qk_data + row * kv_block_size, kv_block_size);
+      Eigen::Tensor<float, 0, Eigen::RowMajor> max_t = qk_max_vec.maximum();
+      tmp_max = max_t(0);
+
+      tmp_max = qk_max_data[row] > tmp_max ? qk_max_data[row] : tmp_max;
+
+      Fvec pij_vec(qk_data + row * kv_block_size, kv_block_size);
+      if (tmp_max == -std::numeric_limits<float>::infinity()) {
+        // No key is visible to this row yet, keep its output 0 instead of
+        // computing exp(-inf + inf).
+        pij_vec.setZero();
+        if (is_reduced_type) {
+          Tvec reduced_vec(qk_reduced_data + row * kv_block_size,
+                           kv_block_size);
+          reduced_vec.setZero();
+        }
+        continue;
+      }
+      // P_ij = exp(S_ij - m_inew)
+      pij_vec = (pij_vec - tmp_max).exp();
+      Eigen::Tensor<float, 0, Eigen::RowMajor> sum_t = pij_vec.sum();
+      tmp_sum = sum_t(0);
+
+      // exp_tmp = exp(m_i - m_inew)
+      exp_tmp = std::exp(qk_max_data[row] - tmp_max);
+      // l_inew = exp_tmp * l_i + l_icur
+      qk_sum_data[row] = tmp_sum + exp_tmp * qk_sum_data[row];
+      qk_max_data[row] = tmp_max;
+
+      pij_vec = pij_vec / qk_sum_data[row];
+      if (is_reduced_type) {
+        Tvec reduced_vec(qk_reduced_data + row * kv_block_size, kv_block_size);
+        reduced_vec = pij_vec.cast<T>();
+      }
+      // dst <- dst * sum_old / sum_new * exp_tmp
+      if (n > 0) {
+        Fvec origin_out_vec(dst_data + row * head_size, head_size);
+        Fvec update_out_vec(dst_data + row * head_size, head_size);
+        float sum_cor = sum_old / qk_sum_data[row];
+        update_out_vec = origin_out_vec * sum_cor * exp_tmp;
+      }
+    }
+    // Calculate Softmax(q @ k.T) @ v
+    cpublas::gemm('N', 'N', q_block_size, head_size, kv_block_size, 1.0f,
+                  conditional_data_ptr(qk_data, qk_reduced_data), kv_block_size,
+                  v + n * kv_stride_n, kv_stride_n, n == 0 ? 0.0f : 1.0f,
+                  dst_data, head_size);
+  }
+  for (int64_t row = 0; row < q_block_size; ++row) {
+    Tvec out_vec(out + row * o_stride_m, head_size);
+    Fvec dst_vec(dst_data + row * head_size, head_size);
+    out_vec = dst_vec.cast<T>();
+  }
+  if (lse != nullptr) {
+    for (int64_t row = 0; row < q_block_size; ++row) {
+      // Fully masked rows get +inf, so that their recomputed probabilities are
+      // 0 instead of NaN.
+      lse[row] = qk_max_data[row] == -std::numeric_limits<float>::infinity()
+                     ? std::numeric_limits<float>::infinity()
+                     : qk_max_data[row] + std::log(qk_sum_data[row]);
+    }
+  }
+}
+
+template <typename T, int64_t qSplitSize, int64_t kvSplitSize>
+class FmhaFunctor {
+ public:
   void operator()(const Tensor& query, const Tensor& key, const Tensor& value,
                   int64_t batch_size, int64_t q_seq_len, int64_t num_heads,
-                  int64_t head_size, int64_t k_seq_len, bool use_mask,
-                  bool use_causal, bool use_dropout, const Tensor& atten_mask,
-                  const Tensor& dropout_mask, float dropout_prob,
-                  Tensor* output) {
+                  int64_t num_kv_heads, int64_t head_size, int64_t k_seq_len,
+                  bool use_mask, bool use_causal, bool use_dropout,
+                  const Tensor& atten_mask, const Tensor& dropout_mask,
+                  float dropout_prob, Tensor* output, int64_t kv_capacity = 0,
+                  Tensor* softmax_lse = nullptr) {
+    // `kv_capacity` is the number of rows allocated per head in key/value. It
+    // is larger than k_seq_len when attending to a partially filled KV cache,
+    // 0 means key/value are dense.
+    // `softmax_lse` optionally receives the float [B, H, Sq] log-sum-exp of
+    // the scores, which the backward uses to recompute the probabilities.
+    if (kv_capacity < k_seq_len) kv_capacity = k_seq_len;
+    // Grouped-query attention: every `num_groups` consecutive query heads
+    // share one key/value head. num_kv_heads == num_heads is the MHA case and
+    // num_kv_heads == 1 is multi-query attention.
+    int64_t num_groups = num_heads / num_kv_heads;
     int64_t q_stride_b = num_heads * q_seq_len * head_size;
     int64_t q_stride_h = q_seq_len * head_size;
     int64_t q_stride_m = head_size;
-    int64_t k_stride_b = num_heads * k_seq_len * head_size;
-    int64_t k_stride_h = k_seq_len * head_size;
+    int64_t k_stride_b = num_kv_heads * kv_capacity * head_size;
+    int64_t k_stride_h = kv_capacity * head_size;
     int64_t k_stride_n = head_size;
-    int64_t v_stride_b = num_heads * k_seq_len * head_size;
-    int64_t v_stride_h = k_seq_len * head_size;
-    int64_t v_stride_n = head_size;
     int64_t o_stride_b = num_heads * q_seq_len * head_size;
     int64_t o_stride_h = head_size;
     int64_t o_stride_m = num_heads * head_size;
@@ -115,6 +295,8 @@ class FmhaFunctor {
     T* out_data = const_cast<Tensor&>(*output).flat<T>().data();
 
     float* buf_data = buf.flat<float>().data();
+    float* lse_data =
+        softmax_lse != nullptr ? softmax_lse->flat<float>().data() : nullptr;
     T* buf_reduced_data =
         is_reduced_type ? buf_reduced.flat<T>().data() : nullptr;
 
@@ -134,143 +316,443 @@ class FmhaFunctor {
     ParallelFor(
         batch_size * num_heads * q_slice, cost,
         [&](int64_t begin, int64_t end) {
-          int64_t i = 0, j = 0, k = 0;
-          DataIndexInit(begin, &i, batch_size, &j, num_heads, &k, q_slice);
+          // The query heads of a group are the innermost index, so that a
+          // thread walks the same key/value blocks for the whole group while
+          // they are still hot in cache.
+          int64_t i = 0, j_kv = 0, k = 0, g = 0;
+          DataIndexInit(begin, &i, batch_size, &j_kv, num_kv_heads, &k, q_slice,
+                        &g, num_groups);
 
           int thread_idx = GetThreadNum();
           float* buf_ptr = buf_data + thread_idx * size_per_thread;
-          float* qk_data = buf_ptr;
-          float* qk_max_data = qk_data + q_split_size * kv_split_size;
-          float* qk_sum_data = qk_max_data + q_split_size;
-          float* dst_data = qk_sum_data + q_split_size;
-          T* qk_reduced_data =
+          FmhaBlockBuffers<T> buffers;
+          buffers.qk = buf_ptr;
+          buffers.qk_max = buffers.qk + q_split_size * kv_split_size;
+          buffers.qk_sum = buffers.qk_max + q_split_size;
+          buffers.dst = buffers.qk_sum + q_split_size;
+          buffers.qk_reduced =
               is_reduced_type
                   ? buf_reduced_data + thread_idx * q_split_size * kv_split_size
                   : nullptr;
 
           for (int x = begin; x < end; ++x) {
+            int64_t j = j_kv * num_groups + g;
             int64_t m = k * q_split_size;
             int64_t q_block_size = std::min(q_split_size, q_seq_len - m);
-            // Initialize max and sum
-            Fvec qk_max_vec(qk_max_data, q_block_size);
-            Fvec qk_sum_vec(qk_sum_data, q_block_size);
-            qk_max_vec.setConstant(-std::numeric_limits<float>::infinity());
-            qk_sum_vec.setConstant(0.f);
 
+            // Query rows before the first key (q_seq_len > k_seq_len) attend
+            // to nothing, so a whole tile can have no keys.
             int64_t causal_q_start = k_seq_len - q_seq_len + m;
             int64_t num_keys =
-                use_causal ? std::min(causal_q_start + q_block_size, k_seq_len)
+                use_causal ? std::max<int64_t>(
+                                 std::min(causal_q_start + q_block_size,
+                                          k_seq_len),
+                                 0)
                            : k_seq_len;
 
-            for (int64_t n = 0; n < num_keys; n += kv_split_size) {
-              int64_t kv_block_size = std::min(kv_split_size, num_keys - n);
-              // Calculate scale * q @ k.T
-              // And the output is float type.
-              cpublas::gemm(
-                  'N', 'T', q_block_size, kv_block_size, head_size,
-                  scaling_factor,
-                  q_data + i * q_stride_b + j * q_stride_h + m * q_stride_m,
-                  q_stride_m,
-                  k_data + i * k_stride_b + j * k_stride_h + n * k_stride_n,
-                  k_stride_n, 0.f, qk_data, kv_block_size);
-
-              // Apply causal mask, fill unused with -inf.
-              // Suppose there is a lower_triangle_mask whose lower triangle is
-              // all 1, cut a portion of it like lower_triangle_mask[:, :,
-              // key_length - query_length : key_length, :key_length], this
-              // portion is then applied to the qk result as causal mask.
-              if (use_causal && n + kv_block_size > causal_q_start + 1) {
-                int64_t row_end = std::min(
-                    n + kv_block_size - causal_q_start - 1, q_block_size);
-                for (int row = 0; row < row_end; ++row) {
-                  int64_t last_col = causal_q_start + 1 + row;
-                  float* row_ptr = qk_data + row * kv_block_size;
-                  Fvec causal_mask_vec(row_ptr + last_col,
-                                       n + kv_block_size - last_col);
-                  causal_mask_vec.setConstant(
-                      -std::numeric_limits<float>::infinity());
-                }
-              }
+            FmhaBlockForward<T>(
+                q_data + i * q_stride_b + j * q_stride_h + m * q_stride_m,
+                q_stride_m, k_data + i * k_stride_b + j_kv * k_stride_h,
+                v_data + i * k_stride_b + j_kv * k_stride_h, k_stride_n,
+                out_data + i * o_stride_b + j * o_stride_h + m * o_stride_m,
+                o_stride_m,
+                lse_data != nullptr
+                    ? lse_data + (i * num_heads + j) * q_seq_len + m
+                    : nullptr,
+                q_block_size, num_keys, kv_split_size, head_size,
+                scaling_factor, buffers,
+                [&](float* qk_data, int64_t kv_block_size, int64_t n) {
+                  ApplyAttentionMask<T>(qk_data, q_block_size, kv_block_size,
+                                        i, j, m, n, k_seq_len, causal_q_start,
+                                        use_causal, use_mask, atten_mask);
+                });
+            // Move to the next query
+            DataIndexStep(&i, batch_size, &j_kv, num_kv_heads, &k, q_slice, &g,
+                          num_groups);
+          }
+        });
+  }
+};
 
-              if (use_mask) {
-                T* atten_mask_data =
-                    const_cast<Tensor&>(atten_mask).flat<T>().data();
-                int64_t mask_batch_size = atten_mask.dim_size(0);
-                int64_t mask_num_heads = atten_mask.dim_size(1);
-                int64_t mask_q_size = atten_mask.dim_size(2);
-                for (int row = 0; row < q_block_size; ++row) {
-                  int b_index = mask_batch_size > 1 ? i : 0;
-                  int h_index = mask_num_heads > 1 ? j : 0;
-                  int q_index = mask_q_size > 1 ? (m + row) : 0;
-                  T* mask_start_data =
-                      atten_mask_data +
-                      b_index * mask_num_heads * mask_q_size * k_seq_len +
-                      h_index * mask_q_size * k_seq_len + q_index * k_seq_len +
-                      n;
-                  Fvec qk_vec(qk_data + row * kv_block_size, kv_block_size);
-                  Tvec mask_vec(mask_start_data, kv_block_size);
-                  qk_vec += mask_vec.template cast<float>();
-                }
-              }
+// Attention over a packed batch of variable-length sequences. query is
+// [total_q, H, D] and key/value are [total_k, H_kv, D], where sequence `b`
+// owns rows [cu_seqlens[b], cu_seqlens[b + 1]). Work items are only the real
+// (query tile, head) pairs of every sequence, so the cost scales with the
+// number of tokens instead of batch_size * max_seq_len. Causal masking is
+// aligned to the bottom right like in the dense kernel.
+template <typename T, int64_t qSplitSize, int64_t kvSplitSize>
+class FmhaVarLenFunctor {
+ public:
+  void operator()(const Tensor& query, const Tensor& key, const Tensor& value,
+                  const int32* cu_seqlens_q, const int32* cu_seqlens_k,
+                  int64_t batch_size, int64_t max_q_seq_len,
+                  int64_t max_k_seq_len, int64_t num_heads,
+                  int64_t num_kv_heads, int64_t head_size, bool use_causal,
+                  Tensor* output) {
+    int64_t num_groups = num_heads / num_kv_heads;
+    int64_t q_stride_m = num_heads * head_size;
+    int64_t q_stride_h = head_size;
+    int64_t k_stride_n = num_kv_heads * head_size;
+    int64_t k_stride_h = head_size;
+
+    float scaling_factor = 1.0 / std::sqrt(static_cast<double>(head_size));
+
+    int64_t q_split_size =
+        qSplitSize > max_q_seq_len ? max_q_seq_len : qSplitSize;
+    int64_t kv_split_size =
+        kvSplitSize > max_k_seq_len ? max_k_seq_len : kvSplitSize;
+    int64_t num_thread = GetNumThreads();
+
+    // Prefix sum of query tiles per sequence, a work item is a (tile, head)
+    // pair.
+    std::vector<int64_t> tile_offsets(batch_size + 1, 0);
+    for (int64_t b = 0; b < batch_size; ++b) {
+      int64_t q_len = cu_seqlens_q[b + 1] - cu_seqlens_q[b];
+      tile_offsets[b + 1] =
+          tile_offsets[b] + (q_len + q_split_size - 1) / q_split_size;
+    }
+    int64_t num_tiles = tile_offsets[batch_size];
+    if (num_tiles == 0) return;
+
+    int64_t size_per_thread =
+        /* qk     */ q_split_size * kv_split_size +
+        /* qk_max */ q_split_size +
+        /* qk_sum */ q_split_size +
+        /* dst    */ q_split_size * head_size;
+
+    constexpr bool is_reduced_type = is_reduced_floating_point_v<T>;
+    Tensor buf(DT_FLOAT, {num_thread, size_per_thread});
+    Tensor buf_reduced(
+        DataTypeToEnum<T>::v(),
+        {num_thread, q_split_size, is_reduced_type ? kv_split_size : 0});
+
+    T* q_data = const_cast<Tensor&>(query).flat<T>().data();
+    T* k_data = const_cast<Tensor&>(key).flat<T>().data();
+    T* v_data = const_cast<Tensor&>(value).flat<T>().data();
+    T* out_data = output->flat<T>().data();
+    float* buf_data = buf.flat<float>().data();
+    T* buf_reduced_data =
+        is_reduced_type ? buf_reduced.flat<T>().data() : nullptr;
+
+    // Cost of an average tile.
+    double avg_k_seq_len =
+        static_cast<double>(cu_seqlens_k[batch_size]) / batch_size;
+    double load_cost =
+        (2 * q_split_size * head_size + 2 * avg_k_seq_len * head_size) *
+        sizeof(T);
+    double store_cost = q_split_size * head_size * sizeof(T);
+    double compute_cost =
+        (4 * avg_k_seq_len * head_size + 20 * avg_k_seq_len) * q_split_size /
+        Eigen::internal::packet_traits<T>::size;
+    Eigen::TensorOpCost cost(load_cost, store_cost, compute_cost);
+    // Padding is removed by packing, only the causal mask applies.
+    Tensor no_mask;
 
-              // Below is applying the softmax.
-              float tmp_max = 0.f, tmp_sum = 0.f, sum_old = 0.f, exp_tmp = 0.f;
-
-              for (int row = 0; row < q_block_size; ++row) {
-                sum_old = qk_sum_data[row];
-
-                Fvec qk_max_vec(qk_data + row * kv_block_size, kv_block_size);
-                Eigen::Tensor<float, 0, Eigen::RowMajor> max_t =
-                    qk_max_vec.maximum();
-                tmp_max = max_t(0);
-
-                tmp_max =
-                    qk_max_data[row] > tmp_max ? qk_max_data[row] : tmp_max;
-
-                Fvec pij_vec(qk_data + row * kv_block_size, kv_block_size);
-                // P_ij = exp(S_ij - m_inew)
-                pij_vec = (pij_vec - tmp_max).exp();
-                Eigen::Tensor<float, 0, Eigen::RowMajor> sum_t = pij_vec.sum();
-                tmp_sum = sum_t(0);
-
-                // exp_tmp = exp(m_i - m_inew)
-                exp_tmp = std::exp(qk_max_data[row] - tmp_max);
-                // l_inew = exp_tmp * l_i + l_icur
-                qk_sum_data[row] = tmp_sum + exp_tmp * qk_sum_data[row];
-                qk_max_data[row] = tmp_max;
-
-                pij_vec = pij_vec / qk_sum_data[row];
-                if (is_reduced_type) {
-                  Tvec reduced_vec(qk_reduced_data + row * kv_block_size,
-                                   kv_block_size);
-                  reduced_vec = pij_vec.cast<T>();
+    ParallelFor(
+        num_tiles * num_heads, cost, [&](int64_t begin, int64_t end) {
+          int64_t t = 0, j_kv = 0, g = 0;
+          DataIndexInit(begin, &t, num_tiles, &j_kv, num_kv_heads, &g,
+                        num_groups);
+
+          int thread_idx = GetThreadNum();
+          float* buf_ptr = buf_data + thread_idx * size_per_thread;
+          FmhaBlockBuffers<T> buffers;
+          buffers.qk = buf_ptr;
+          buffers.qk_max = buffers.qk + q_split_size * kv_split_size;
+          buffers.qk_sum = buffers.qk_max + q_split_size;
+          buffers.dst = buffers.qk_sum + q_split_size;
+          buffers.qk_reduced =
+              is_reduced_type
+                  ? buf_reduced_data + thread_idx * q_split_size * kv_split_size
+                  : nullptr;
+
+          for (int64_t x = begin; x < end; ++x) {
+            // Sequence owning tile `t`.
+            int64_t b = std::upper_bound(tile_offsets.begin(),
+                                         tile_offsets.end(), t) -
+                        tile_offsets.begin() - 1;
+            int64_t j = j_kv * num_groups + g;
+            int64_t q_start = cu_seqlens_q[b];
+            int64_t q_seq_len = cu_seqlens_q[b + 1] - q_start;
+            int64_t k_start = cu_seqlens_k[b];
+            int64_t k_seq_len = cu_seqlens_k[b + 1] - k_start;
+            int64_t m = (t - tile_offsets[b]) * q_split_size;
+            int64_t q_block_size = std::min(q_split_size, q_seq_len - m);
+
+            int64_t causal_q_start = k_seq_len - q_seq_len + m;
+            int64_t num_keys =
+                use_causal ? std::max<int64_t>(
+                                 std::min(causal_q_start + q_block_size,
+                                          k_seq_len),
+                                 0)
+                           : k_seq_len;
+
+            FmhaBlockForward<T>(
+                q_data + (q_start + m) * q_stride_m + j * q_stride_h,
+                q_stride_m, k_data + k_start * k_stride_n + j_kv * k_stride_h,
+                v_data + k_start * k_stride_n + j_kv * k_stride_h, k_stride_n,
+                out_data + (q_start + m) * q_stride_m + j * q_stride_h,
+                q_stride_m, nullptr, q_block_size, num_keys, kv_split_size,
+                head_size, scaling_factor, buffers,
+                [&](float* qk_data, int64_t kv_block_size, int64_t n) {
+                  ApplyAttentionMask<T>(qk_data, q_block_size, kv_block_size,
+                                        0, j, m, n, k_seq_len, causal_q_start,
+                                        use_causal, false, no_mask);
+                });
+            DataIndexStep(&t, num_tiles, &j_kv, num_kv_heads, &g, num_groups);
+          }
+        });
+  }
+};
+
+// Memory-efficient backward of FmhaFunctor. The attention probabilities are
+// recomputed block by block from the log-sum-exp saved by the forward with the
+// same tiling, so the [B, H, Sq, Sk] score tensor is never materialized:
+//   P = exp(scale * Q @ K.T + mask - lse), dV = P.T @ dO, dP = dO @ V.T,
+//   dS = P * (dP - rowsum(dO * O)), dQ = scale * dS @ K, dK = scale * dS.T @ Q
+// The (query head, query block) pairs of each (batch, kv head) are split into
+// enough chunks to occupy all threads, which matters for MQA/GQA with a small
+// batch. Each chunk writes dQ of its blocks and accumulates dK/dV in its own
+// float buffer, the buffers of the chunks are summed at the end.
+template <typename T, int64_t qSplitSize, int64_t kvSplitSize>
+class FmhaBackwardFunctor {
+ public:
+  using Tvec = typename TTypes<T>::Flat;
+  using Fvec = typename TTypes<float>::Flat;
+
+  void operator()(const Tensor& query, const Tensor& key, const Tensor& value,
+                  const Tensor& output, const Tensor& softmax_lse,
+                  const Tensor& output_backprop, int64_t batch_size,
+                  int64_t q_seq_len, int64_t num_heads, int64_t num_kv_heads,
+                  int64_t head_size, int64_t k_seq_len, bool use_mask,
+                  bool use_causal, const Tensor& atten_mask,
+                  Tensor* query_backprop, Tensor* key_backprop,
+                  Tensor* value_backprop) {
+    int64_t num_groups = num_heads / num_kv_heads;
+    // query and its gradient are [B, H, Sq, D].
+    int64_t q_stride_b = num_heads * q_seq_len * head_size;
+    int64_t q_stride_h = q_seq_len * head_size;
+    int64_t q_stride_m = head_size;
+    // key, value and their gradients are [B, H_kv, Sk, D].
+    int64_t k_stride_b = num_kv_heads * k_seq_len * head_size;
+    int64_t k_stride_h = k_seq_len * head_size;
+    int64_t k_stride_n = head_size;
+    // output and its gradient are [B, Sq, H, D].
+    int64_t o_stride_b = num_heads * q_seq_len * head_size;
+    int64_t o_stride_h = head_size;
+    int64_t o_stride_m = num_heads * head_size;
+
+    float scaling_factor = 1.0 / std::sqrt(static_cast<double>(head_size));
+
+    int64_t q_split_size = qSplitSize > q_seq_len ? q_seq_len : qSplitSize;
+    int64_t kv_split_size = kvSplitSize > k_seq_len ? k_seq_len : kvSplitSize;
+    int64_t num_thread = GetNumThreads();
+
+    // Chunks of the (query head, query block) pairs of a kv head.
+    int64_t num_q_blocks = (q_seq_len + q_split_size - 1) / q_split_size;
+    int64_t num_pairs = num_groups * num_q_blocks;
+    int64_t num_kv_items = batch_size * num_kv_heads;
+    int64_t num_chunks = std::max<int64_t>(
+        1, std::min(num_pairs, (num_thread + num_kv_items - 1) / num_kv_items));
+
+    int64_t size_per_thread =
+        /* attn      */ q_split_size * kv_split_size +
+        /* grad_attn */ q_split_size * kv_split_size +
+        /* delta     */ q_split_size +
+        /* grad_q    */ q_split_size * head_size;
+
+    constexpr bool is_reduced_type = is_reduced_floating_point_v<T>;
+    Tensor buf(DT_FLOAT, {num_thread, size_per_thread});
+    // Reduced type copies of attn and grad_attn, used as gemm inputs.
+    Tensor buf_reduced(
+        DataTypeToEnum<T>::v(),
+        {num_thread, 2, q_split_size, is_reduced_type ? kv_split_size : 0});
+    // dK and dV accumulated by each chunk.
+    int64_t kv_size = k_seq_len * head_size;
+    Tensor grad_kv_acc(DT_FLOAT, {num_kv_items, num_chunks, 2, kv_size});
+
+    T* q_data = const_cast<Tensor&>(query).flat<T>().data();
+    T* k_data = const_cast<Tensor&>(key).flat<T>().data();
+    T* v_data = const_cast<Tensor&>(value).flat<T>().data();
+    T* out_data = const_cast<Tensor&>(output).flat<T>().data();
+    T* grad_out_data = const_cast<Tensor&>(output_backprop).flat<T>().data();
+    float* lse_data = const_cast<Tensor&>(softmax_lse).flat<float>().data();
+    T* grad_q_data = query_backprop->flat<T>().data();
+    T* grad_k_data = key_backprop->flat<T>().data();
+    T* grad_v_data = value_backprop->flat<T>().data();
+
+    float* buf_data = buf.flat<float>().data();
+    T* buf_reduced_data =
+        is_reduced_type ? buf_reduced.flat<T>().data() : nullptr;
+    float* grad_kv_acc_data = grad_kv_acc.flat<float>().data();
+
+    // Five gemms of [q, kv, head_size] per block, for the query blocks of a
+    // chunk.
+    double pairs_per_chunk = static_cast<double>(num_pairs) / num_chunks;
+    double load_cost = (pairs_per_chunk * q_split_size * (3 * head_size + 1) +
+                        2 * k_seq_len * head_size) *
+                       sizeof(T);
+    double store_cost = load_cost;
+    double compute_cost = 10.0 * pairs_per_chunk * q_split_size * k_seq_len *
+                          head_size / Eigen::internal::packet_traits<T>::size;
+    Eigen::TensorOpCost cost(load_cost, store_cost, compute_cost);
+
+    ParallelFor(
+        num_kv_items * num_chunks, cost, [&](int64_t begin, int64_t end) {
+          int64_t i = 0, j_kv = 0, c = 0;
+          DataIndexInit(begin, &i, batch_size, &j_kv, num_kv_heads, &c,
+                        num_chunks);
+
+          int thread_idx = GetThreadNum();
+          float* buf_ptr = buf_data + thread_idx * size_per_thread;
+          float* attn_data = buf_ptr;
+          float* grad_attn_data = attn_data + q_split_size * kv_split_size;
+          float* delta_data = grad_attn_data + q_split_size * kv_split_size;
+          float* grad_q_acc = delta_data + q_split_size;
+          int64_t attn_size = q_split_size * kv_split_size;
+          T* attn_reduced_data =
+              is_reduced_type ? buf_reduced_data + thread_idx * 2 * attn_size
+                              : nullptr;
+          T* grad_attn_reduced_data =
+              is_reduced_type ? attn_reduced_data + attn_size : nullptr;
+
+          for (int64_t x = begin; x < end; ++x) {
+            float* grad_k_acc = grad_kv_acc_data + x * 2 * kv_size;
+            float* grad_v_acc = grad_k_acc + kv_size;
+            Fvec grad_kv_vec(grad_k_acc, 2 * kv_size);
+            grad_kv_vec.setZero();
+            T* k_cur = k_data + i * k_stride_b + j_kv * k_stride_h;
+            T* v_cur = v_data + i * k_stride_b + j_kv * k_stride_h;
+
+            int64_t pair_begin = c * num_pairs / num_chunks;
+            int64_t pair_end = (c + 1) * num_pairs / num_chunks;
+            for (int64_t pair = pair_begin; pair < pair_end; ++pair) {
+              int64_t j = j_kv * num_groups + pair / num_q_blocks;
+              int64_t m = (pair % num_q_blocks) * q_split_size;
+              int64_t q_block_size = std::min(q_split_size, q_seq_len - m);
+              T* q_cur =
+                  q_data + i * q_stride_b + j * q_stride_h + m * q_stride_m;
+              T* out_cur =
+                  out_data + i * o_stride_b + j * o_stride_h + m * o_stride_m;
+              T* grad_out_cur = grad_out_data + i * o_stride_b +
+                                j * o_stride_h + m * o_stride_m;
+              float* lse_cur = lse_data + (i * num_heads + j) * q_seq_len + m;
+
+              // delta = rowsum(dO * O)
+              for (int64_t row = 0; row < q_block_size; ++row) {
+                Tvec out_vec(out_cur + row * o_stride_m, head_size);
+                Tvec grad_out_vec(grad_out_cur + row * o_stride_m, head_size);
+                Eigen::Tensor<float, 0, Eigen::RowMajor> sum_t =
+                    (out_vec.template cast<float>() *
+                     grad_out_vec.template cast<float>())
+                        .sum();
+                delta_data[row] = sum_t(0);
+              }
+              Fvec grad_q_vec(grad_q_acc, q_block_size * head_size);
+              grad_q_vec.setZero();
+
+              int64_t causal_q_start = k_seq_len - q_seq_len + m;
+              int64_t num_keys =
+                  use_causal
+                      ? std::max<int64_t>(
+                            std::min(causal_q_start + q_block_size, k_seq_len),
+                            0)
+                      : k_seq_len;
+
+              for (int64_t n = 0; n < num_keys; n += kv_split_size) {
+                int64_t kv_block_size = std::min(kv_split_size, num_keys - n);
+                T* k_block = k_cur + n * k_stride_n;
+                T* v_block = v_cur + n * k_stride_n;
+
+                // Recompute the scores scale * q @ k.T.
+                cpublas::gemm('N', 'T', q_block_size, kv_block_size, head_size,
+                              scaling_factor, q_cur, q_stride_m, k_block,
+                              k_stride_n, 0.f, attn_data, kv_block_size);
+                ApplyAttentionMask<T>(attn_data, q_block_size, kv_block_size,
+                                      i, j, m, n, k_seq_len, causal_q_start,
+                                      use_causal, use_mask, atten_mask);
+
+                // P = exp(S - lse)
+                for (int64_t row = 0; row < q_block_size; ++row) {
+                  Fvec attn_vec(attn_data + row * kv_block_size,
+                                kv_block_size);
+                  attn_vec = (attn_vec - lse_cur[row]).exp();
+                  if (is_reduced_type) {
+                    Tvec reduced_vec(attn_reduced_data + row * kv_block_size,
+                                     kv_block_size);
+                    reduced_vec = attn_vec.cast<T>();
+                  }
                 }
-                // dst <- dst * sum_old / sum_new * exp_tmp
-                if (n > 0) {
-                  Fvec origin_out_vec(dst_data + row * head_size, head_size);
-                  Fvec update_out_vec(dst_data + row * head_size, head_size);
-                  float sum_cor = sum_old / qk_sum_data[row];
-                  update_out_vec = origin_out_vec * sum_cor * exp_tmp;
+
+                // dV += P.T @ dO
+                cpublas::gemm(
+                    'T', 'N', kv_block_size, head_size, q_block_size, 1.f,
+                    conditional_data_ptr(attn_data, attn_reduced_data),
+                    kv_block_size, grad_out_cur, o_stride_m, 1.f,
+                    grad_v_acc + n * head_size, head_size);
+
+                // dP = dO @ V.T
+                cpublas::gemm('N', 'T', q_block_size, kv_block_size, head_size,
+                              1.f, grad_out_cur, o_stride_m, v_block,
+                              k_stride_n, 0.f, grad_attn_data, kv_block_size);
+
+                // dS = P * (dP - delta)
+                for (int64_t row = 0; row < q_block_size; ++row) {
+                  Fvec attn_vec(attn_data + row * kv_block_size,
+                                kv_block_size);
+                  Fvec grad_attn_vec(grad_attn_data + row * kv_block_size,
+                                     kv_block_size);
+                  grad_attn_vec = attn_vec * (grad_attn_vec - delta_data[row]);
+                  if (is_reduced_type) {
+                    Tvec reduced_vec(
+                        grad_attn_reduced_data + row * kv_block_size,
+                        kv_block_size);
+                    reduced_vec = grad_attn_vec.cast<T>();
+                  }
                 }
+                T* grad_attn_ptr = conditional_data_ptr(
+                    grad_attn_data, grad_attn_reduced_data);
+
+                // dQ += scale * dS @ K
+                cpublas::gemm('N', 'N', q_block_size, head_size, kv_block_size,
+                              scaling_factor, grad_attn_ptr, kv_block_size,
+                              k_block, k_stride_n, 1.f, grad_q_acc, head_size);
+
+                // dK += scale * dS.T @ Q
+                cpublas::gemm('T', 'N', kv_block_size, head_size, q_block_size,
+                              scaling_factor, grad_attn_ptr, kv_block_size,
+                              q_cur, q_stride_m, 1.f,
+                              grad_k_acc + n * head_size, head_size);
               }
-              // Calculate Softmax(q @ k.T) @ v
-              cpublas::gemm(
-                  'N', 'N', q_block_size, head_size, kv_block_size, 1.0f,
-                  conditional_data_ptr(qk_data, qk_reduced_data), kv_block_size,
-                  v_data + i * v_stride_b + j * v_stride_h + n * v_stride_n,
-                  v_stride_n, n == 0 ? 0.0f : 1.0f, dst_data, head_size);
-            }
-            T* out_cur_data =
-                out_data + i * o_stride_b + j * o_stride_h + m * o_stride_m;
-            for (int64_t i = 0; i < q_block_size; ++i) {
-              Tvec out_vec(out_cur_data + i * o_stride_m, head_size);
-              Fvec dst_vec(dst_data + i * head_size, head_size);
-              out_vec = dst_vec.cast<T>();
+
+              Tvec grad_q_out(grad_q_data + i * q_stride_b + j * q_stride_h +
+                                  m * q_stride_m,
+                              q_block_size * head_size);
+              grad_q_out = grad_q_vec.cast<T>();
             }
-            // Move to the next query
-            DataIndexStep(&i, batch_size, &j, num_heads, &k, q_slice);
+            // Move to the next chunk
+            DataIndexStep(&i, batch_size, &j_kv, num_kv_heads, &c, num_chunks);
           }
         });
+
+    // Sum dK and dV of the chunks of each kv head.
+    Eigen::TensorOpCost reduce_cost(num_chunks * 2 * kv_size * sizeof(float),
+                                    2 * kv_size * sizeof(T),
+                                    num_chunks * 2 * kv_size);
+    ParallelFor(num_kv_items, reduce_cost, [&](int64_t begin, int64_t end) {
+      for (int64_t x = begin; x < end; ++x) {
+        float* acc = grad_kv_acc_data + x * num_chunks * 2 * kv_size;
+        Fvec sum_vec(acc, 2 * kv_size);
+        for (int64_t c = 1; c < num_chunks; ++c) {
+          sum_vec += Fvec(acc + c * 2 * kv_size, 2 * kv_size);
+        }
+        // x enumerates (batch, kv head), the layout of dK and dV.
+        Tvec grad_k_out(grad_k_data + x * kv_size, kv_size);
+        Tvec grad_v_out(grad_v_data + x * kv_size, kv_size);
+        grad_k_out = Fvec(acc, kv_size).cast<T>();
+        grad_v_out = Fvec(acc + kv_size, kv_size).cast<T>();
+      }
+    });
   }
 };
 }  // namespace itex
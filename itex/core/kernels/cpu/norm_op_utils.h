@@ -0,0 +1,51 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_KERNELS_CPU_NORM_OP_UTILS_H_
+#define ITEX_CORE_KERNELS_CPU_NORM_OP_UTILS_H_
+
+#include "itex/core/utils/types.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace itex {
+namespace functor {
+
+template <typename T>
+using NormConstRow =
+    Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>>;
+template <typename T>
+using NormRow = Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>>;
+
+// Loads `n` elements of the input of a normalization into `dst` in fp32. With
+// a residual, the input is `x + residual`, which is also stored to `sum` in T.
+// The sum is rounded to T before being normalized, as the unfused Add would.
+template <typename T, bool kFuseAdd>
+inline void LoadNormInput(const T* x, const T* residual, T* sum, int64 n,
+                          float* dst) {
+  NormRow<float> out(dst, n);
+  NormConstRow<T> in(x, n);
+  if (kFuseAdd) {
+    NormRow<T> sum_row(sum, n);
+    sum_row = in + NormConstRow<T>(residual, n);
+    out = sum_row.template cast<float>();
+  } else {
+    out = in.template cast<float>();
+  }
+}
+
+}  // namespace functor
+}  // namespace itex
+
+#endif  // ITEX_CORE_KERNELS_CPU_NORM_OP_UTILS_H_
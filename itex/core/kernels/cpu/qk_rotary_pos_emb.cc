@@ -0,0 +1,204 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <vector>
+
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace itex {
+
+using CPUDevice = Eigen::ThreadPoolDevice;
+
+namespace functor {
+
+using RotaryRow = Eigen::TensorMap<Eigen::Tensor<float, 1, Eigen::RowMajor>>;
+using ConstRotaryRow =
+    Eigen::TensorMap<Eigen::Tensor<const float, 1, Eigen::RowMajor>>;
+
+// Rotates the first `rotary_dim` elements of one head, `out` may alias `in`:
+//   out[2i]     = x[2i]     * cos[2i]     - x[2i + 1] * sin[2i]
+//   out[2i + 1] = x[2i + 1] * cos[2i + 1] + x[2i]     * sin[2i + 1]
+// `x` and `rotated` are fp32 scratch rows of `rotary_dim` elements.
+template <typename T>
+inline void ApplyRotaryEmbedding(const T* in, T* out, int rotary_dim,
+                                 const ConstRotaryRow& sin,
+                                 const ConstRotaryRow& cos, float* x,
+                                 float* rotated) {
+  for (int i = 0; i < rotary_dim; i += 2) {
+    x[i] = static_cast<float>(in[i]);
+    x[i + 1] = static_cast<float>(in[i + 1]);
+    rotated[i] = -x[i + 1];
+    rotated[i + 1] = x[i];
+  }
+  RotaryRow x_row(x, rotary_dim);
+  x_row = x_row * cos + RotaryRow(rotated, rotary_dim) * sin;
+  for (int i = 0; i < rotary_dim; ++i) out[i] = static_cast<T>(x[i]);
+}
+
+}  // namespace functor
+
+// Applies RoPE to query and key of shape [batch, length, num_heads * head_dim]
+// or [batch, length, num_heads, head_dim]. sin and cos are
+// [batch or 1, length, 1, rotary_dim]. The outputs reuse the input buffers when
+// they can be forwarded, so only the rotary part of each head is written.
+//
+// Work is split by position: sin and cos of a position are converted to fp32
+// once and reused for all heads of query and key.
+template <typename T>
+class QKRotaryPositionalEmbeddingOp : public OpKernel {
+ public:
+  explicit QKRotaryPositionalEmbeddingOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("rotary_dim", &rotary_dim_));
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("num_attention_heads", &num_attention_heads_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("head_dim", &head_dim_));
+    OP_REQUIRES(ctx,
+                rotary_dim_ > 0 && rotary_dim_ % 2 == 0 &&
+                    rotary_dim_ <= head_dim_,
+                errors::InvalidArgument(
+                    "rotary_dim must be a positive even number not larger "
+                    "than head_dim, got ",
+                    rotary_dim_, " and ", head_dim_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& q = ctx->input(0);
+    const Tensor& k = ctx->input(1);
+    const Tensor& sin = ctx->input(2);
+    const Tensor& cos = ctx->input(3);
+
+    OP_REQUIRES(ctx, q.dims() >= 3 && q.shape() == k.shape(),
+                errors::InvalidArgument(
+                    "query and key must have the same shape of rank >= 3, got ",
+                    q.shape().DebugString(), " and ", k.shape().DebugString()));
+    const int64 batch = q.dim_size(0);
+    const int64 length = q.dim_size(1);
+    const TensorShape output_shape(
+        {batch, length, num_attention_heads_, head_dim_});
+    OP_REQUIRES(ctx, q.NumElements() == output_shape.num_elements(),
+                errors::InvalidArgument(
+                    "query of shape ", q.shape().DebugString(),
+                    " doesn't match num_attention_heads ", num_attention_heads_,
+                    " and head_dim ", head_dim_));
+    OP_REQUIRES(ctx, sin.shape() == cos.shape(),
+                errors::InvalidArgument(
+                    "sin and cos must have the same shape, got ",
+                    sin.shape().DebugString(), " and ",
+                    cos.shape().DebugString()));
+    const int64 sin_batch = sin.dims() > 0 ? sin.dim_size(0) : 0;
+    OP_REQUIRES(ctx,
+                (sin_batch == 1 || sin_batch == batch) &&
+                    sin.NumElements() == sin_batch * length * rotary_dim_,
+                errors::InvalidArgument(
+                    "sin and cos must be [", batch, " or 1, ", length,
+                    ", 1, ", rotary_dim_, "], got ",
+                    sin.shape().DebugString()));
+
+    Tensor* output_q = nullptr;
+    Tensor* output_k = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                            {0}, 0, output_shape, &output_q));
+    OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                            {1}, 1, output_shape, &output_k));
+    if (q.NumElements() == 0) return;
+
+    const T* q_data = q.flat<T>().data();
+    const T* k_data = k.flat<T>().data();
+    const T* sin_data = sin.flat<T>().data();
+    const T* cos_data = cos.flat<T>().data();
+    T* output_q_data = output_q->flat<T>().data();
+    T* output_k_data = output_k->flat<T>().data();
+    // The pass-through part of each head is only copied if not forwarded.
+    const bool copy_q = output_q_data != q_data;
+    const bool copy_k = output_k_data != k_data;
+
+    const int rotary_dim = rotary_dim_;
+    const int64 heads = num_attention_heads_;
+    const int64 head_dim = head_dim_;
+    const int64 row_size = heads * head_dim;
+    const int64 bytes_per_position = 2 * row_size * sizeof(T);
+
+    const CPUDevice& device = ctx->eigen_device<CPUDevice>();
+    device.parallelFor(
+        batch * length,
+        Eigen::TensorOpCost(bytes_per_position, bytes_per_position,
+                            2 * heads * rotary_dim * 4),
+        [&](Eigen::Index first, Eigen::Index last) {
+          // sin, cos, then x and rotated of the current head.
+          std::vector<float> scratch(4 * rotary_dim);
+          float* sin_buf = scratch.data();
+          float* cos_buf = sin_buf + rotary_dim;
+          float* x_buf = cos_buf + rotary_dim;
+          float* rotated_buf = x_buf + rotary_dim;
+          functor::ConstRotaryRow sin_row(sin_buf, rotary_dim);
+          functor::ConstRotaryRow cos_row(cos_buf, rotary_dim);
+
+          for (Eigen::Index pos = first; pos < last; ++pos) {
+            const int64 sin_pos = sin_batch == 1 ? pos % length : pos;
+            const int64 sin_offset = sin_pos * rotary_dim;
+            for (int i = 0; i < rotary_dim; ++i) {
+              sin_buf[i] = static_cast<float>(sin_data[sin_offset + i]);
+              cos_buf[i] = static_cast<float>(cos_data[sin_offset + i]);
+            }
+
+            for (int64 h = 0; h < heads; ++h) {
+              const int64 offset = pos * row_size + h * head_dim;
+              functor::ApplyRotaryEmbedding(q_data + offset,
+                                            output_q_data + offset, rotary_dim,
+                                            sin_row, cos_row, x_buf,
+                                            rotated_buf);
+              functor::ApplyRotaryEmbedding(k_data + offset,
+                                            output_k_data + offset, rotary_dim,
+                                            sin_row, cos_row, x_buf,
+                                            rotated_buf);
+              if (copy_q) {
+                std::copy(q_data + offset + rotary_dim,
+                          q_data + offset + head_dim,
+                          output_q_data + offset + rotary_dim);
+              }
+              if (copy_k) {
+                std::copy(k_data + offset + rotary_dim,
+                          k_data + offset + head_dim,
+                          output_k_data + offset + rotary_dim);
+              }
+            }
+          }
+        });
+  }
+
+ private:
+  int rotary_dim_;
+  int num_attention_heads_;
+  int head_dim_;
+};
+
+#define REGISTER_QK_ROTARY_EMBEDDING(type)                    \
+  REGISTER_KERNEL_BUILDER(Name("QKRotaryPositionalEmbedding") \
+                              .Device(DEVICE_CPU)             \
+                              .TypeConstraint<type>("T"),     \
+                          QKRotaryPositionalEmbeddingOp<type>)
+
+TF_CALL_CPU_NUMBER_TYPES(REGISTER_QK_ROTARY_EMBEDDING);
+#undef REGISTER_QK_ROTARY_EMBEDDING
+
+}  // namespace itex
@@ -0,0 +1,152 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <vector>
+
+#include "itex/core/kernels/cpu/norm_op_utils.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+
+using CPUDevice = Eigen::ThreadPoolDevice;
+
+// RMSNorm over the last dimension of `x`:
+//   y = x / sqrt(mean(x^2) + epsilon) * scale + offset
+// Each row is converted to fp32 once into a buffer small enough to stay in
+// cache, reduced and then normalized from that buffer, so the input is read
+// from memory once. With `kFuseAdd`, the input is `x + residual` and the sum
+// is also returned as the second output.
+template <typename T, typename U, bool kFuseAdd>
+class RMSNormOp : public OpKernel {
+ public:
+  explicit RMSNormOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+    OP_REQUIRES_OK(context, context->GetAttr("use_scale", &use_scale_));
+    OP_REQUIRES_OK(context, context->GetAttr("use_center", &use_center_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const int param_index = kFuseAdd ? 2 : 1;
+    const Tensor& input = context->input(0);
+    const Tensor& gamma = context->input(param_index);
+    const Tensor& beta = context->input(param_index + 1);
+
+    OP_REQUIRES(context, input.dims() >= 1,
+                errors::InvalidArgument("input must be at least 1-dimensional",
+                                        input.shape().DebugString()));
+    const int64 cols = input.dim_size(input.dims() - 1);
+    OP_REQUIRES(context,
+                !use_scale_ || (gamma.dims() == 1 && gamma.dim_size(0) == cols),
+                errors::InvalidArgument(
+                    "gamma's size", gamma.shape().DebugString(),
+                    " must be equal to input's last-dimensional size, but got",
+                    input.shape().DebugString()));
+    OP_REQUIRES(context,
+                !use_center_ || (beta.dims() == 1 && beta.dim_size(0) == cols),
+                errors::InvalidArgument(
+                    "beta's size", beta.shape().DebugString(),
+                    " must be equal to input's last-dimensional size, but got",
+                    input.shape().DebugString()));
+
+    const T* residual_data = nullptr;
+    T* sum_data = nullptr;
+    if (kFuseAdd) {
+      const Tensor& residual = context->input(1);
+      OP_REQUIRES(context, residual.shape() == input.shape(),
+                  errors::InvalidArgument(
+                      "residual must have the shape of input, got ",
+                      residual.shape().DebugString(), " vs ",
+                      input.shape().DebugString()));
+      residual_data = residual.flat<T>().data();
+      Tensor* sum = nullptr;
+      OP_REQUIRES_OK(context,
+                     context->allocate_output(1, input.shape(), &sum));
+      sum_data = sum->flat<T>().data();
+    }
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, input.shape(), &output));
+    if (input.NumElements() == 0) return;
+
+    const int64 rows = input.NumElements() / cols;
+    const T* input_data = input.flat<T>().data();
+    const U* gamma_data = use_scale_ ? gamma.flat<U>().data() : nullptr;
+    const U* beta_data = use_center_ ? beta.flat<U>().data() : nullptr;
+    T* output_data = output->flat<T>().data();
+
+    const int64 bytes_per_row = cols * sizeof(T) * (kFuseAdd ? 4 : 2);
+    const CPUDevice& device = context->eigen_device<CPUDevice>();
+    device.parallelFor(
+        rows, Eigen::TensorOpCost(bytes_per_row, 0, cols * 6),
+        [&](Eigen::Index first, Eigen::Index last) {
+          std::vector<float> buffer(cols);
+          functor::NormRow<float> row(buffer.data(), cols);
+          for (Eigen::Index i = first; i < last; ++i) {
+            const int64 offset = i * cols;
+            functor::LoadNormInput<T, kFuseAdd>(
+                input_data + offset,
+                kFuseAdd ? residual_data + offset : nullptr,
+                kFuseAdd ? sum_data + offset : nullptr, cols, buffer.data());
+
+            Eigen::Tensor<float, 0, Eigen::RowMajor> sum_square =
+                row.square().sum();
+            const float rms = 1.0f / std::sqrt(sum_square() / cols + epsilon_);
+
+            auto normalized = row * rms;
+            functor::NormConstRow<U> scale(gamma_data, cols);
+            functor::NormConstRow<U> shift(beta_data, cols);
+            functor::NormRow<T> out(output_data + offset, cols);
+            if (use_scale_ && use_center_) {
+              out = (normalized * scale + shift).template cast<T>();
+            } else if (use_scale_) {
+              out = (normalized * scale).template cast<T>();
+            } else if (use_center_) {
+              out = (normalized + shift).template cast<T>();
+            } else {
+              out = normalized.template cast<T>();
+            }
+          }
+        });
+  }
+
+ private:
+  float epsilon_;
+  bool use_scale_;
+  bool use_center_;
+};
+
+#define REGISTER_CPU_KERNEL(T)                                            \
+  REGISTER_KERNEL_BUILDER(Name("ItexRmsNorm")                             \
+                              .Device(DEVICE_CPU)                         \
+                              .TypeConstraint<T>("T")                     \
+                              .TypeConstraint<float>("U"),                \
+                          RMSNormOp<T, float, false>);                    \
+  REGISTER_KERNEL_BUILDER(Name("_ITEXFusedAddRMSNorm")                    \
+                              .Device(DEVICE_CPU)                         \
+                              .TypeConstraint<T>("T")                     \
+                              .TypeConstraint<float>("U"),                \
+                          RMSNormOp<T, float, true>);
+
+TF_CALL_CPU_NUMBER_TYPES(REGISTER_CPU_KERNEL);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace itex
@@ -0,0 +1,409 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "itex/core/kernels/common/training_op_helpers.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace itex {
+
+using CPUDevice = Eigen::ThreadPoolDevice;
+
+// Elements updated by one task. Variables are split into chunks of this size,
+// so small variables are batched into one task and large ones are split
+// across threads.
+constexpr int64 kMultiTensorChunkSize = 4096;
+
+namespace functor {
+
+template <typename T>
+using AdamFlat = Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>>;
+template <typename T>
+using AdamConstFlat =
+    Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>>;
+
+// Slots of one variable updated by the optimizer.
+template <typename T>
+struct AdamSlots {
+  T* var;
+  T* m;
+  T* v;
+  T* vhat;
+  const T* grad;
+  float* update;  // LAMB only, the update before the trust ratio.
+  int64 size;
+  bool use_weight_decay;
+  bool use_lamb;
+};
+
+struct AdamHyperParams {
+  float beta1_power;
+  float beta2_power;
+  float lr;
+  float beta1;
+  float beta2;
+  float epsilon;
+  float weight_decay;
+};
+
+// Updates m and v of elements [begin, begin + n) of `slots`, returns the
+// denominator source, i.e. vhat with AMSGrad and v otherwise.
+template <typename T>
+inline const T* UpdateAdamMoments(const AdamSlots<T>& slots, int64 begin,
+                                  int64 n, const AdamHyperParams& params,
+                                  bool use_amsgrad) {
+  auto grad = AdamConstFlat<T>(slots.grad + begin, n).template cast<float>();
+  AdamFlat<T> m(slots.m + begin, n);
+  AdamFlat<T> v(slots.v + begin, n);
+  m = (m.template cast<float>() +
+       (grad - m.template cast<float>()) * (1.0f - params.beta1))
+          .template cast<T>();
+  v = (v.template cast<float>() +
+       (grad.square() - v.template cast<float>()) * (1.0f - params.beta2))
+          .template cast<T>();
+  if (!use_amsgrad) return slots.v + begin;
+  AdamFlat<T> vhat(slots.vhat + begin, n);
+  vhat = vhat.template cast<float>()
+             .cwiseMax(v.template cast<float>())
+             .template cast<T>();
+  return slots.vhat + begin;
+}
+
+// AdamW, same as ITEXResourceApplyAdamWithWeightDecay:
+//   var = (1 - wd * lr) * var - alpha * m / (sqrt(v) + epsilon)
+template <typename T>
+inline void ApplyAdamWeightDecayChunk(const AdamSlots<T>& slots, int64 begin,
+                                      int64 n, const AdamHyperParams& params,
+                                      bool use_amsgrad) {
+  const T* denom = UpdateAdamMoments(slots, begin, n, params, use_amsgrad);
+  const float alpha = params.lr * std::sqrt(1.0f - params.beta2_power) /
+                      (1.0f - params.beta1_power);
+  const float wd_sub =
+      slots.use_weight_decay ? 1.0f - params.weight_decay * params.lr : 1.0f;
+  AdamFlat<T> var(slots.var + begin, n);
+  var = (var.template cast<float>() * wd_sub -
+         AdamConstFlat<T>(slots.m + begin, n).template cast<float>() * alpha /
+             (AdamConstFlat<T>(denom, n).template cast<float>().sqrt() +
+              params.epsilon))
+            .template cast<T>();
+}
+
+// First stage of LAMB, same as ITEXResourceApplyLAMB: computes the update
+//   m_hat / (sqrt(v_hat) + epsilon) + wd * var
+// and returns the squared norms of var and update of the chunk.
+template <typename T>
+inline void ComputeLAMBUpdateChunk(const AdamSlots<T>& slots, int64 begin,
+                                   int64 n, const AdamHyperParams& params,
+                                   bool use_amsgrad, float* var_norm,
+                                   float* update_norm) {
+  auto grad = AdamConstFlat<T>(slots.grad + begin, n).template cast<float>();
+  AdamFlat<T> m(slots.m + begin, n);
+  AdamFlat<T> v(slots.v + begin, n);
+  m = (m.template cast<float>() +
+       (grad - m.template cast<float>()) * (1.0f - params.beta1))
+          .template cast<T>();
+  v = (v.template cast<float>() +
+       (grad.square() - v.template cast<float>()) * (1.0f - params.beta2))
+          .template cast<T>();
+  // AMSGrad keeps the max of the bias corrected v.
+  auto v_hat =
+      v.template cast<float>() * (1.0f / (1.0f - params.beta2_power));
+  AdamFlat<float> update(slots.update + begin, n);
+  if (use_amsgrad) {
+    AdamFlat<T> vhat(slots.vhat + begin, n);
+    vhat = vhat.template cast<float>().cwiseMax(v_hat).template cast<T>();
+    update = vhat.template cast<float>();
+  } else {
+    update = v_hat;
+  }
+  const float wd = slots.use_weight_decay ? params.weight_decay : 0.0f;
+  auto var = AdamConstFlat<T>(slots.var + begin, n).template cast<float>();
+  update = m.template cast<float>() *
+               (1.0f / (1.0f - params.beta1_power)) /
+               (update.sqrt() + params.epsilon) +
+           var * wd;
+
+  Eigen::Tensor<float, 0, Eigen::RowMajor> sum;
+  sum = var.square().sum();
+  *var_norm = sum();
+  sum = update.square().sum();
+  *update_norm = sum();
+}
+
+}  // namespace functor
+
+// CPU kernels of AdamW and LAMB. The single variable ops take one variable,
+// the multi-tensor ops take N variables sharing the hyperparameters and
+// update them all in one parallel loop over chunks of all the variables, so
+// the optimizer doesn't run one op per variable. Elements are computed in
+// fp32 with vectorized Eigen expressions.
+template <typename T, bool kLamb, bool kMultiTensor>
+class CpuApplyAdamOp : public OpKernel {
+ public:
+  explicit CpuApplyAdamOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_amsgrad", &use_amsgrad_));
+    if (kMultiTensor) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &num_vars_));
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("use_weight_decay", &use_weight_decay_));
+      if (kLamb) OP_REQUIRES_OK(ctx, ctx->GetAttr("use_lamb", &use_lamb_));
+    } else if (kLamb) {
+      bool use_lamb;
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("use_lamb", &use_lamb));
+      use_lamb_ = {use_lamb};
+    }
+    OP_REQUIRES(ctx,
+                use_weight_decay_.empty() ||
+                    static_cast<int>(use_weight_decay_.size()) == num_vars_,
+                errors::InvalidArgument("use_weight_decay must have ",
+                                        num_vars_, " elements, got ",
+                                        use_weight_decay_.size()));
+    OP_REQUIRES(ctx,
+                use_lamb_.empty() ||
+                    static_cast<int>(use_lamb_.size()) == num_vars_,
+                errors::InvalidArgument("use_lamb must have ", num_vars_,
+                                        " elements, got ", use_lamb_.size()));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const bool sparse = false;
+    std::vector<int> var_inputs;
+    for (int i = 0; i < num_vars_; ++i) {
+      var_inputs.push_back(VarInput(i));
+      var_inputs.push_back(MInput(i));
+      var_inputs.push_back(VInput(i));
+      if (use_amsgrad_) var_inputs.push_back(VhatInput(i));
+    }
+    auto locks = MaybeLockVariableInputMutexesInOrder<CPUDevice, T>(
+        ctx, use_exclusive_lock_, sparse, var_inputs);
+
+    functor::AdamHyperParams params;
+    const int first_param = kMultiTensor ? 5 * num_vars_ : 3;
+    float* param_values[] = {&params.beta1_power, &params.beta2_power,
+                             &params.lr,          &params.beta1,
+                             &params.beta2,       &params.epsilon,
+                             &params.weight_decay};
+    for (int i = 0; i < 7; ++i) {
+      const Tensor& param = ctx->input(first_param + i);
+      OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(param.shape()),
+                  errors::InvalidArgument("Hyperparameter ", i,
+                                          " is not a scalar: ",
+                                          param.shape().DebugString()));
+      *param_values[i] = static_cast<float>(param.scalar<T>()());
+    }
+
+    // Tensors are kept alive until the update is done.
+    std::vector<Tensor> tensors(4 * num_vars_);
+    std::vector<functor::AdamSlots<T>> slots(num_vars_);
+    int64 total_size = 0;
+    for (int i = 0; i < num_vars_; ++i) {
+      Tensor& var = tensors[4 * i];
+      Tensor& m = tensors[4 * i + 1];
+      Tensor& v = tensors[4 * i + 2];
+      Tensor& vhat = tensors[4 * i + 3];
+      OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                              ctx, VarInput(i), use_exclusive_lock_, sparse,
+                              &var));
+      OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                              ctx, MInput(i), use_exclusive_lock_, sparse, &m));
+      OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                              ctx, VInput(i), use_exclusive_lock_, sparse, &v));
+      OP_REQUIRES(ctx,
+                  var.IsInitialized() && m.IsInitialized() &&
+                      v.IsInitialized(),
+                  errors::FailedPrecondition(
+                      "Attempting to use uninitialized variables"));
+      if (use_amsgrad_) {
+        OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                                ctx, VhatInput(i), use_exclusive_lock_, sparse,
+                                &vhat));
+        OP_REQUIRES(ctx, var.shape().IsSameSize(vhat.shape()),
+                    errors::InvalidArgument(
+                        "var and vhat do not have the same shape",
+                        var.shape().DebugString(), " ",
+                        vhat.shape().DebugString()));
+      }
+      const Tensor& grad = ctx->input(GradInput(i));
+      OP_REQUIRES(ctx,
+                  var.shape().IsSameSize(m.shape()) &&
+                      var.shape().IsSameSize(v.shape()),
+                  errors::InvalidArgument(
+                      "var, m and v do not have the same shape",
+                      var.shape().DebugString(), " ", m.shape().DebugString(),
+                      " ", v.shape().DebugString()));
+      OP_REQUIRES(
+          ctx, var.shape().IsSameSize(grad.shape()),
+          errors::InvalidArgument("var and grad do not have the same shape",
+                                  var.shape().DebugString(), " ",
+                                  grad.shape().DebugString()));
+
+      functor::AdamSlots<T>& slot = slots[i];
+      slot.var = var.flat<T>().data();
+      slot.m = m.flat<T>().data();
+      slot.v = v.flat<T>().data();
+      slot.vhat = use_amsgrad_ ? vhat.flat<T>().data() : nullptr;
+      slot.grad = grad.flat<T>().data();
+      slot.update = nullptr;
+      slot.size = var.NumElements();
+      slot.use_weight_decay =
+          use_weight_decay_.empty() ? true : use_weight_decay_[i];
+      slot.use_lamb = use_lamb_.empty() ? kLamb : use_lamb_[i];
+      total_size += slot.size;
+    }
+
+    // Chunks of all the variables: variable index and first element.
+    std::vector<std::pair<int, int64>> chunks;
+    for (int i = 0; i < num_vars_; ++i) {
+      for (int64 begin = 0; begin < slots[i].size;
+           begin += kMultiTensorChunkSize) {
+        chunks.emplace_back(i, begin);
+      }
+    }
+    if (chunks.empty()) return;
+    const int64 num_chunks = chunks.size();
+    const int64 chunk_bytes = kMultiTensorChunkSize * sizeof(T);
+    const CPUDevice& device = ctx->eigen_device<CPUDevice>();
+
+    if (!kLamb) {
+      device.parallelFor(
+          num_chunks,
+          Eigen::TensorOpCost(chunk_bytes * 4, chunk_bytes * 3,
+                              kMultiTensorChunkSize * 12),
+          [&](Eigen::Index first, Eigen::Index last) {
+            for (Eigen::Index c = first; c < last; ++c) {
+              const auto& slot = slots[chunks[c].first];
+              const int64 begin = chunks[c].second;
+              functor::ApplyAdamWeightDecayChunk(
+                  slot, begin,
+                  std::min(kMultiTensorChunkSize, slot.size - begin), params,
+                  use_amsgrad_);
+            }
+          });
+      return;
+    }
+
+    // LAMB: the trust ratio of a variable depends on the norms of the whole
+    // variable and update, so the update is computed with per-chunk partial
+    // norms first and applied once the norms are reduced.
+    Tensor update;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, TensorShape({total_size}),
+                                           &update));
+    float* update_data = update.flat<float>().data();
+    for (auto& slot : slots) {
+      slot.update = update_data;
+      update_data += slot.size;
+    }
+    std::vector<float> var_norms(num_chunks);
+    std::vector<float> update_norms(num_chunks);
+    device.parallelFor(
+        num_chunks,
+        Eigen::TensorOpCost(chunk_bytes * 4, chunk_bytes * 2 + 4 * chunk_bytes,
+                            kMultiTensorChunkSize * 16),
+        [&](Eigen::Index first, Eigen::Index last) {
+          for (Eigen::Index c = first; c < last; ++c) {
+            const auto& slot = slots[chunks[c].first];
+            const int64 begin = chunks[c].second;
+            functor::ComputeLAMBUpdateChunk(
+                slot, begin,
+                std::min(kMultiTensorChunkSize, slot.size - begin), params,
+                use_amsgrad_, &var_norms[c], &update_norms[c]);
+          }
+        });
+
+    std::vector<double> var_norm(num_vars_, 0.0);
+    std::vector<double> update_norm(num_vars_, 0.0);
+    for (int64 c = 0; c < num_chunks; ++c) {
+      var_norm[chunks[c].first] += var_norms[c];
+      update_norm[chunks[c].first] += update_norms[c];
+    }
+    std::vector<float> step(num_vars_);
+    for (int i = 0; i < num_vars_; ++i) {
+      float ratio = 1.0f;
+      if (slots[i].use_lamb && var_norm[i] != 0.0 && update_norm[i] != 0.0) {
+        ratio = static_cast<float>(std::sqrt(var_norm[i]) /
+                                   std::sqrt(update_norm[i]));
+      }
+      step[i] = ratio * params.lr;
+    }
+
+    device.parallelFor(
+        num_chunks,
+        Eigen::TensorOpCost(chunk_bytes + 4 * kMultiTensorChunkSize,
+                            chunk_bytes, kMultiTensorChunkSize * 2),
+        [&](Eigen::Index first, Eigen::Index last) {
+          for (Eigen::Index c = first; c < last; ++c) {
+            const int i = chunks[c].first;
+            const auto& slot = slots[i];
+            const int64 begin = chunks[c].second;
+            const int64 n = std::min(kMultiTensorChunkSize, slot.size - begin);
+            functor::AdamFlat<T> var(slot.var + begin, n);
+            var = (var.template cast<float>() -
+                   functor::AdamConstFlat<float>(slot.update + begin, n) *
+                       step[i])
+                      .template cast<T>();
+          }
+        });
+  }
+
+ private:
+  // Input indices, see the op definitions in training_ops.cc.
+  int VarInput(int i) const { return kMultiTensor ? i : 0; }
+  int MInput(int i) const { return kMultiTensor ? num_vars_ + i : 1; }
+  int VInput(int i) const { return kMultiTensor ? 2 * num_vars_ + i : 2; }
+  int VhatInput(int i) const { return kMultiTensor ? 3 * num_vars_ + i : 10; }
+  int GradInput(int i) const { return kMultiTensor ? 4 * num_vars_ + i : 11; }
+
+  bool use_exclusive_lock_;
+  bool use_amsgrad_;
+  int num_vars_ = 1;
+  std::vector<bool> use_weight_decay_;
+  std::vector<bool> use_lamb_;
+};
+
+#define REGISTER_CPU_KERNELS(T)                                             \
+  REGISTER_KERNEL_BUILDER(Name("ITEXResourceApplyAdamWithWeightDecay")      \
+                              .Device(DEVICE_CPU)                           \
+                              .TypeConstraint<T>("T"),                      \
+                          CpuApplyAdamOp<T, false, false>);                 \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("ITEXResourceMultiTensorApplyAdamWithWeightDecay")               \
+          .Device(DEVICE_CPU)                                               \
+          .TypeConstraint<T>("T"),                                          \
+      CpuApplyAdamOp<T, false, true>);                                      \
+  REGISTER_KERNEL_BUILDER(Name("ITEXResourceMultiTensorApplyLAMB")          \
+                              .Device(DEVICE_CPU)                           \
+                              .TypeConstraint<T>("T"),                      \
+                          CpuApplyAdamOp<T, true, true>);
+
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_bfloat16(REGISTER_CPU_KERNELS);
+#undef REGISTER_CPU_KERNELS
+
+// ITEXResourceApplyLAMB is only defined for float.
+REGISTER_KERNEL_BUILDER(Name("ITEXResourceApplyLAMB")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<float>("T"),
+                        CpuApplyAdamOp<float, true, false>);
+
+}  // namespace itex
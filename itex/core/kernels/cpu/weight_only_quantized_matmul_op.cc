@@ -0,0 +1,220 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "itex/core/kernels/cpu/cpu_blas.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/parallel.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace itex {
+
+// Rows of `a` computed together. Decoding batches usually fit in one block,
+// so every weight tile is dequantized once per token.
+constexpr int64 kWOQRowBlockSize = 64;
+// Columns of the output computed by one task.
+constexpr int64 kWOQColBlockSize = 64;
+// Rows of the weight dequantized at a time, the [kWOQDepthBlockSize,
+// kWOQColBlockSize] fp32 tile stays in L1/L2 for the gemm that consumes it.
+constexpr int64 kWOQDepthBlockSize = 256;
+
+namespace functor {
+
+// Dequantizes rows [k_begin, k_end) and columns [n_begin, n_begin + cols) of
+// the weight into `tile`, a row-major [k_end - k_begin, cols] buffer. See
+// _ITEXWeightOnlyQuantizedMatMul for the weight layout.
+template <int kBits, typename Tout>
+inline void DequantizeWeightTile(const int8* weight, const float* scales,
+                                 const int8* zero_points, int64 n,
+                                 int64 group_size, int64 k_begin, int64 k_end,
+                                 int64 n_begin, int64 cols, Tout* tile) {
+  constexpr int kDefaultZeroPoint = kBits == 4 ? 8 : 0;
+  for (int64 k = k_begin; k < k_end; ++k) {
+    const int64 group_offset = (k / group_size) * n + n_begin;
+    const float* scale = scales + group_offset;
+    const int8* zero_point =
+        zero_points != nullptr ? zero_points + group_offset : nullptr;
+    Tout* out = tile + (k - k_begin) * cols;
+    if (kBits == 8) {
+      const int8* q = weight + k * n + n_begin;
+      for (int64 j = 0; j < cols; ++j) {
+        const int zp = zero_point ? zero_point[j] : kDefaultZeroPoint;
+        out[j] = static_cast<Tout>((q[j] - zp) * scale[j]);
+      }
+    } else {
+      const uint8* q =
+          reinterpret_cast<const uint8*>(weight) + (k / 2) * n + n_begin;
+      const int shift = (k & 1) * 4;
+      for (int64 j = 0; j < cols; ++j) {
+        const int zp = zero_point ? zero_point[j] : kDefaultZeroPoint;
+        out[j] = static_cast<Tout>((((q[j] >> shift) & 0xF) - zp) * scale[j]);
+      }
+    }
+  }
+}
+
+}  // namespace functor
+
+// Weight-only quantized MatMul for memory bound LLM inference: the weight is
+// read as INT4/INT8 and dequantized tile by tile right before the gemm that
+// consumes it, so the full precision weight never goes through memory. Each
+// task owns a block of output rows and columns and accumulates in fp32.
+template <typename T>
+class WeightOnlyQuantizedMatMulOp : public OpKernel {
+ public:
+  explicit WeightOnlyQuantizedMatMulOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("bits", &bits_));
+    OP_REQUIRES_OK(context, context->GetAttr("group_size", &group_size_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("has_zero_point", &has_zero_point_));
+    OP_REQUIRES_OK(context, context->GetAttr("has_bias", &has_bias_));
+    OP_REQUIRES(context, bits_ == 4 || bits_ == 8,
+                errors::InvalidArgument(
+                    "WeightOnlyQuantizedMatMul only supports 4 or 8 bits, got ",
+                    bits_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& a = context->input(0);
+    const Tensor& weight = context->input(1);
+    const Tensor& scales = context->input(2);
+    const Tensor& zero_points = context->input(3);
+    const Tensor& bias = context->input(4);
+
+    OP_REQUIRES(context, a.dims() == 2 && weight.dims() == 2,
+                errors::InvalidArgument(
+                    "WeightOnlyQuantizedMatMul expects 2D a and weight, got ",
+                    a.shape().DebugString(), " and ",
+                    weight.shape().DebugString()));
+    const int64 m = a.dim_size(0);
+    const int64 k = a.dim_size(1);
+    const int64 n = weight.dim_size(1);
+    const int64 packed_k = bits_ == 4 ? (k + 1) / 2 : k;
+    OP_REQUIRES(context, weight.dim_size(0) == packed_k,
+                errors::InvalidArgument(
+                    "WeightOnlyQuantizedMatMul weight must be [", packed_k,
+                    ", N] for K = ", k, " and ", bits_, " bits, got ",
+                    weight.shape().DebugString()));
+    const int64 groups = (k + group_size_ - 1) / group_size_;
+    const TensorShape group_shape({groups, n});
+    OP_REQUIRES(context, scales.shape() == group_shape,
+                errors::InvalidArgument(
+                    "WeightOnlyQuantizedMatMul scales must be ",
+                    group_shape.DebugString(), ", got ",
+                    scales.shape().DebugString()));
+    OP_REQUIRES(context,
+                !has_zero_point_ || zero_points.shape() == group_shape,
+                errors::InvalidArgument(
+                    "WeightOnlyQuantizedMatMul zero_points must be ",
+                    group_shape.DebugString(), ", got ",
+                    zero_points.shape().DebugString()));
+    OP_REQUIRES(context,
+                !has_bias_ || (bias.dims() == 1 && bias.dim_size(0) == n),
+                errors::InvalidArgument(
+                    "WeightOnlyQuantizedMatMul bias must be [", n, "], got ",
+                    bias.shape().DebugString()));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, TensorShape({m, n}),
+                                                     &output));
+    if (output->NumElements() == 0) return;
+
+    T* a_data = const_cast<T*>(a.flat<T>().data());
+    const int8* weight_data = weight.flat<int8>().data();
+    const float* scales_data = scales.flat<float>().data();
+    const int8* zero_points_data =
+        has_zero_point_ ? zero_points.flat<int8>().data() : nullptr;
+    const T* bias_data = has_bias_ ? bias.flat<T>().data() : nullptr;
+    T* output_data = output->flat<T>().data();
+
+    const int64 row_blocks = (m + kWOQRowBlockSize - 1) / kWOQRowBlockSize;
+    const int64 col_blocks = (n + kWOQColBlockSize - 1) / kWOQColBlockSize;
+    const int64 task_rows = std::min(kWOQRowBlockSize, m);
+    const int64 task_cols = std::min(kWOQColBlockSize, n);
+    const Eigen::TensorOpCost cost(
+        k * task_cols * bits_ / 8 + task_rows * k * sizeof(T),
+        task_rows * task_cols * sizeof(T),
+        2.0 * task_rows * task_cols * k + 3.0 * k * task_cols);
+
+    // Column blocks are the inner dimension so consecutive tasks of a thread
+    // share the rows of `a`.
+    ParallelFor(
+        row_blocks * col_blocks, cost, [&](int64 begin, int64 end) {
+          std::vector<T> tile(kWOQDepthBlockSize * kWOQColBlockSize);
+          std::vector<float> acc(kWOQRowBlockSize * kWOQColBlockSize);
+          for (int64 task = begin; task < end; ++task) {
+            const int64 row = (task / col_blocks) * kWOQRowBlockSize;
+            const int64 col = (task % col_blocks) * kWOQColBlockSize;
+            const int64 rows = std::min(kWOQRowBlockSize, m - row);
+            const int64 cols = std::min(kWOQColBlockSize, n - col);
+
+            for (int64 depth = 0; depth < k; depth += kWOQDepthBlockSize) {
+              const int64 depth_end = std::min(depth + kWOQDepthBlockSize, k);
+              if (bits_ == 4) {
+                functor::DequantizeWeightTile<4>(
+                    weight_data, scales_data, zero_points_data, n, group_size_,
+                    depth, depth_end, col, cols, tile.data());
+              } else {
+                functor::DequantizeWeightTile<8>(
+                    weight_data, scales_data, zero_points_data, n, group_size_,
+                    depth, depth_end, col, cols, tile.data());
+              }
+              cpublas::gemm('N', 'N', rows, cols, depth_end - depth, 1.0f,
+                            a_data + row * k + depth, k, tile.data(), cols,
+                            depth == 0 ? 0.0f : 1.0f, acc.data(), cols);
+            }
+
+            for (int64 r = 0; r < rows; ++r) {
+              const float* acc_row = acc.data() + r * cols;
+              T* out_row = output_data + (row + r) * n + col;
+              for (int64 j = 0; j < cols; ++j) {
+                float value = acc_row[j];
+                if (bias_data != nullptr) {
+                  value += static_cast<float>(bias_data[col + j]);
+                }
+                out_row[j] = static_cast<T>(value);
+              }
+            }
+          }
+        });
+  }
+
+ private:
+  int bits_;
+  int group_size_;
+  bool has_zero_point_;
+  bool has_bias_;
+};
+
+#define REGISTER_WEIGHT_ONLY_QUANTIZED_MATMUL(T)                  \
+  REGISTER_KERNEL_BUILDER(Name("_ITEXWeightOnlyQuantizedMatMul")  \
+                              .Device(DEVICE_CPU)                 \
+                              .TypeConstraint<T>("T"),            \
+                          WeightOnlyQuantizedMatMulOp<T>);
+
+TF_CALL_float(REGISTER_WEIGHT_ONLY_QUANTIZED_MATMUL);
+TF_CALL_bfloat16(REGISTER_WEIGHT_ONLY_QUANTIZED_MATMUL);
+#undef REGISTER_WEIGHT_ONLY_QUANTIZED_MATMUL
+
+}  // namespace itex
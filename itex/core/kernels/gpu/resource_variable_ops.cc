@@ -15,11 +15,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-#include "itex/core/kernels/gpu/dense_update_functor.h"
+#include "itex/core/kernels/common/dense_update_functor.h"
+#include "itex/core/kernels/common/training_op_helpers.h"
 #include "itex/core/kernels/gpu/gather_functor.h"
 #include "itex/core/kernels/gpu/gather_nd_op.h"
 #include "itex/core/kernels/gpu/scatter_functor.h"
-#include "itex/core/kernels/gpu/training_op_helpers.h"
 #include "itex/core/utils/errors.h"
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/op_requires.h"
@@ -16,8 +16,8 @@ limitations under the License.
 ==============================================================================*/
 
 #include "itex/core/kernels/common/fill_functor.h"
+#include "itex/core/kernels/common/training_op_helpers.h"
 #include "itex/core/kernels/gpu/scatter_functor.h"
-#include "itex/core/kernels/gpu/training_op_helpers.h"
 #include "itex/core/utils/op_requires.h"
 #include "itex/core/utils/register_types.h"
 #include "itex/core/utils/util.h"
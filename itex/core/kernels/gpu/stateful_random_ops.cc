@@ -18,8 +18,8 @@ limitations under the License.
 #include "itex/core/kernels/gpu/stateful_random_ops.h"
 
 #include "itex/core/kernels/common/fill_functor.h"
+#include "itex/core/kernels/common/training_op_helpers.h"
 #include "itex/core/kernels/gpu/random_op_gpu.h"
-#include "itex/core/kernels/gpu/training_op_helpers.h"
 #include "itex/core/utils/bounds_check.h"
 #include "itex/core/utils/errors.h"
 #include "itex/core/utils/lib/random/philox_random.h"
@@ -15,8 +15,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "itex/core/kernels/common/training_op_helpers.h"
 #include "itex/core/kernels/gpu/full_reduction_kernels.h"
-#include "itex/core/kernels/gpu/training_op_helpers.h"
 #include "itex/core/kernels/gpu/training_ops.h"
 #include "itex/core/utils/op_requires.h"
 
@@ -13,7 +13,7 @@ limitations under the License.
 
 #include <sycl/sycl.hpp>
 
-#include "itex/core/kernels/gpu/training_op_helpers.h"
+#include "itex/core/kernels/common/training_op_helpers.h"
 #include "itex/core/kernels/gpu/training_ops.h"
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/register_types.h"
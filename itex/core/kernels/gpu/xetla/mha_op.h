@@ -216,6 +216,11 @@ class ScaledDotProductAttentionOp : public OpKernel {
     int f = query_shape.dim_size(2);
     int h = query_shape.dim_size(3);
     int t = key_shape.dim_size(2);
+    OP_REQUIRES(context, key_shape.dim_size(1) == n,
+                errors::Unimplemented("Grouped-query attention is not "
+                                      "supported by the GPU kernel, query has ",
+                                      n, " heads but key has ",
+                                      key_shape.dim_size(1)));
 
     Tensor* output = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(
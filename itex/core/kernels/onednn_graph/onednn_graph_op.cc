@@ -18,12 +18,28 @@ limitations under the License.
 #include "itex/core/devices/gpu/gpu_pool_allocator.h"
 #include "third_party/build_option/dpcpp/runtime/itex_gpu_runtime.h"
 #endif  // INTEL_CPU_ONLY
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "itex/core/utils/env_time.h"
+#include "itex/core/utils/env_var.h"
 #include "itex/core/utils/errors.h"
+#include "itex/core/utils/fingerprint.h"
+#include "itex/core/utils/mutex.h"
+#include "itex/core/utils/numbers.h"
 #include "itex/core/utils/onednn/onednn_graph_util.h"
 #include "itex/core/utils/onednn/onednn_layout_util.h"
+#include "itex/core/utils/onednn/onednn_primitive_cache.h"
 #include "itex/core/utils/onednn/onednn_util.h"
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/path.h"
+#include "itex/core/utils/str_util.h"
+#include "itex/core/utils/strcat.h"
 #include "itex/core/utils/types.h"
 
 namespace itex {
@@ -119,6 +135,236 @@ void GetInplaceIdMap(
   }
 }
 
+// Compiled partitions of one LLGA kernel, keyed by its input logical tensors
+// (id, data type, dims, layout id or strides, constant property). Compiling a
+// partition generates and JITs the fused kernel, which is far more expensive
+// than executing it, so models with a few dynamic shapes (varying batch or
+// sequence length) only compile each of them once instead of on every step.
+//
+// The capacity is controlled by `ITEX_ONEDNN_GRAPH_PARTITION_CACHE_CAPACITY`,
+// 0 disables the cache. oneDNN Graph can't serialize compiled partitions, so
+// when `ITEX_ONEDNN_GRAPH_PARTITION_CACHE_DIR` is set, the plain (strided)
+// input signatures seen by the kernel are recorded there instead, and compiled
+// ahead on the first execution of the next run. Persistence is off by default.
+// Each signature is recorded once and at most `capacity` of them are kept,
+// since compiling more than that ahead would only evict each other.
+class CompiledPartitionCache {
+ public:
+  struct Entry {
+    dnnl::graph::compiled_partition c_partition;
+    std::unordered_map<size_t, size_t> inplace_id_map;  // <output_id, input_id>
+  };
+
+  // `signature` identifies the kernel across runs, it names the on-disk file.
+  explicit CompiledPartitionCache(const string& signature)
+      : cache_(&Stats(), "ITEX_ONEDNN_GRAPH_PARTITION_CACHE_CAPACITY") {
+    string dir;
+    ITEX_CHECK_OK(ReadStringFromEnvVar("ITEX_ONEDNN_GRAPH_PARTITION_CACHE_DIR",
+                                       "", &dir));
+    if (!dir.empty() && cache_.IsEnabled()) {
+      persist_file_ = io::JoinPath(
+          dir,
+          strings::StrCat(strings::Hex(Fingerprint64(signature)), ".llga"));
+    }
+  }
+
+  // Returns the compiled partition for `inputs`, compiling it on a miss. The
+  // entry stays valid after it is evicted from the cache.
+  std::shared_ptr<const Entry> GetOrCompile(
+      const dnnl::graph::partition& partition,
+      const std::vector<dnnl::graph::logical_tensor>& inputs,
+      const std::vector<dnnl::graph::logical_tensor>& outputs,
+      const dnnl::engine& engine, const OpKernel& op) {
+    if (!cache_.IsEnabled()) {
+      return Compile(partition, inputs, outputs, engine, op);
+    }
+
+    mutex_lock lock(&mu_);
+    if (!warmed_up_) {
+      warmed_up_ = true;
+      WarmUp(partition, outputs, engine, op);
+    }
+
+    Key key = MakeKey(inputs);
+    std::shared_ptr<const Entry>* entry = cache_.Find(key);
+    if (entry != nullptr) return *entry;
+
+    std::shared_ptr<const Entry> compiled =
+        Compile(partition, inputs, outputs, engine, op);
+    cache_.Insert(key, compiled);
+    Persist(key);
+    return compiled;
+  }
+
+ private:
+  using Key = OneDnnPrimitiveCache<std::shared_ptr<const Entry>>::Key;
+  using LogicalTensor = dnnl::graph::logical_tensor;
+
+  static OneDnnPrimitiveCacheStats& Stats() {
+    static OneDnnPrimitiveCacheStats stats(
+        "oneDNN Graph compiled partition cache");
+    return stats;
+  }
+
+  static std::shared_ptr<const Entry> Compile(
+      const dnnl::graph::partition& partition,
+      const std::vector<LogicalTensor>& inputs,
+      const std::vector<LogicalTensor>& outputs, const dnnl::engine& engine,
+      const OpKernel& op) {
+    uint64 start = EnvTime::NowMicros();
+    auto entry = std::make_shared<Entry>(
+        Entry{partition.compile(inputs, outputs, engine), {}});
+    GetInplaceIdMap(entry->c_partition, inputs, outputs,
+                    &entry->inplace_id_map);
+    int64_t elapsed = static_cast<int64_t>(EnvTime::NowMicros() - start);
+
+    Stats().RecordCreationTime(elapsed);
+    if (IsVerboseEnabled()) {
+      ITEX_VLOG(0) << op.type() << "," << op.name() << ",compile," << elapsed
+                   << "us," << Stats().DebugString();
+    }
+    return entry;
+  }
+
+  // Encodes each logical tensor as
+  //   id, layout type, data type, property, ndims, dims..., layout
+  // where layout is the layout id for opaque tensors and the strides for
+  // strided ones, so that strided keys can be decoded back by `ParseKey`.
+  static Key MakeKey(const std::vector<LogicalTensor>& lts) {
+    Key key;
+    for (const auto& lt : lts) {
+      std::vector<int64_t> dims = lt.get_dims();
+      key.push_back(static_cast<int64>(lt.get_id()));
+      key.push_back(static_cast<int64>(lt.get_layout_type()));
+      key.push_back(static_cast<int64>(lt.get_data_type()));
+      key.push_back(static_cast<int64>(lt.get_property_type()));
+      key.push_back(static_cast<int64>(dims.size()));
+      key.insert(key.end(), dims.begin(), dims.end());
+      if (lt.get_layout_type() == LogicalTensor::layout_type::opaque) {
+        key.push_back(static_cast<int64>(lt.get_layout_id()));
+      } else if (lt.get_layout_type() == LogicalTensor::layout_type::strided) {
+        std::vector<int64_t> strides = lt.get_strides();
+        key.insert(key.end(), strides.begin(), strides.end());
+      }
+    }
+    return key;
+  }
+
+  // Decodes a key made of strided logical tensors only. Returns false on any
+  // other (or malformed) key.
+  static bool ParseKey(const Key& key, std::vector<LogicalTensor>* lts) {
+    if (key.empty()) return false;
+    size_t pos = 0;
+    while (pos < key.size()) {
+      if (pos + 5 > key.size()) return false;
+      size_t id = static_cast<size_t>(key[pos]);
+      auto layout = static_cast<LogicalTensor::layout_type>(key[pos + 1]);
+      auto dtype = static_cast<LogicalTensor::data_type>(key[pos + 2]);
+      auto property = static_cast<LogicalTensor::property_type>(key[pos + 3]);
+      int64 ndims = key[pos + 4];
+      pos += 5;
+      if (layout != LogicalTensor::layout_type::strided || ndims < 0 ||
+          pos + 2 * ndims > key.size()) {
+        return false;
+      }
+      std::vector<int64_t> dims(key.begin() + pos, key.begin() + pos + ndims);
+      std::vector<int64_t> strides(key.begin() + pos + ndims,
+                                   key.begin() + pos + 2 * ndims);
+      pos += 2 * ndims;
+      lts->emplace_back(id, dtype, dims, strides, property);
+    }
+    return true;
+  }
+
+  // Appends a new strided key to the on-disk signature file, unless it is
+  // already recorded or the file is full. Opaque layout ids are only
+  // meaningful within a process, so those keys are not persisted.
+  void Persist(const Key& key) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (persist_file_.empty() || persisted_keys_.count(key) != 0 ||
+        persisted_keys_.size() >= cache_.capacity()) {
+      return;
+    }
+    std::vector<LogicalTensor> lts;
+    if (!ParseKey(key, &lts)) return;
+
+    std::ofstream file(persist_file_, std::ios::app);
+    if (!file.is_open()) {
+      ITEX_VLOG(3) << "Failed to open " << persist_file_;
+      return;
+    }
+    file << str_util::Join(key, " ") << "\n";
+    persisted_keys_.insert(key);
+  }
+
+  // Rewrites the signature file with the recorded keys only.
+  void RewritePersistFile() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    std::ofstream file(persist_file_, std::ios::trunc);
+    if (!file.is_open()) {
+      ITEX_VLOG(3) << "Failed to open " << persist_file_;
+      return;
+    }
+    for (const Key& key : persisted_keys_) {
+      file << str_util::Join(key, " ") << "\n";
+    }
+  }
+
+  // Compiles the signatures persisted by previous runs. Duplicated, malformed
+  // or excess lines, e.g. from concurrent runs, are dropped from the file.
+  void WarmUp(const dnnl::graph::partition& partition,
+              const std::vector<LogicalTensor>& outputs,
+              const dnnl::engine& engine, const OpKernel& op)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (persist_file_.empty()) return;
+    std::ifstream file(persist_file_);
+    if (!file.is_open()) return;
+    string line;
+    bool needs_rewrite = false;
+    while (std::getline(file, line)) {
+      Key key;
+      for (const string& token : str_util::Split(line, " ")) {
+        int64 value;
+        if (!strings::safe_strto64(token, &value)) break;
+        key.push_back(value);
+      }
+      std::vector<LogicalTensor> inputs;
+      if (!ParseKey(key, &inputs) || persisted_keys_.count(key) != 0 ||
+          persisted_keys_.size() >= cache_.capacity()) {
+        needs_rewrite = true;
+        continue;
+      }
+      persisted_keys_.insert(key);
+      if (cache_.Find(key) != nullptr) continue;
+      try {
+        cache_.Insert(key, Compile(partition, inputs, outputs, engine, op));
+      } catch (dnnl::error& e) {
+        // The partition changed since the signature was recorded.
+        ITEX_VLOG(3) << "Skip stale LLGA signature of " << op.name() << ": "
+                     << e.what();
+        persisted_keys_.erase(key);
+        needs_rewrite = true;
+      }
+    }
+    file.close();
+    if (needs_rewrite) RewritePersistFile();
+  }
+
+  mutex mu_;
+  OneDnnPrimitiveCache<std::shared_ptr<const Entry>> cache_ TF_GUARDED_BY(mu_);
+  bool warmed_up_ TF_GUARDED_BY(mu_) = false;
+  string persist_file_;
+  // Keys recorded in `persist_file_`.
+  std::set<Key> persisted_keys_ TF_GUARDED_BY(mu_);
+};
+
+// Identifies a LLGA kernel across runs of the same model.
+string GetKernelSignature(const OpKernel& op,
+                          const std::vector<int64_t>& input_edge_ids,
+                          const std::vector<string>& framework_ops) {
+  return strings::StrCat(op.type(), ";", op.name(), ";",
+                         str_util::Join(input_edge_ids, ","), ";",
+                         str_util::Join(framework_ops, ","));
+}
+
 // Currently, LLGA kernels only works with Layout pass ON. Because meta tensor
 // is required to pass the LLGA layout information
 // TODO(itex): Enable LLGA with ITEX plain format.
@@ -135,6 +381,8 @@ class OneDnnGraphOp : public OpKernel {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("candidate_inplace_input_edge",
                                      &candidate_inplace_input_edge_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("framework_ops", &framework_ops_));
+    partition_cache_ = std::make_unique<CompiledPartitionCache>(
+        GetKernelSignature(*this, input_edge_ids_, framework_ops_));
   }
 
   void Compute(OpKernelContext* ctx) {
@@ -193,12 +441,13 @@ class OneDnnGraphOp : public OpKernel {
           dnnl::graph::logical_tensor::layout_type::strided));
     }
 
-    auto c_partition = partition->compile(
-        l_input_logical_tensor, l_output_logical_tensor, onednn_engine);
-
-    std::unordered_map<size_t, size_t> inplace_id_map;  // <output_id, input_id>
-    GetInplaceIdMap(c_partition, l_input_logical_tensor,
-                    l_output_logical_tensor, &inplace_id_map);
+    std::shared_ptr<const CompiledPartitionCache::Entry> entry =
+        partition_cache_->GetOrCompile(*partition, l_input_logical_tensor,
+                                       l_output_logical_tensor, onednn_engine,
+                                       *this);
+    const auto& c_partition = entry->c_partition;
+    // <output_id, input_id>
+    const auto& inplace_id_map = entry->inplace_id_map;
 
     // Prepare output tensors
     for (int index = 0; index < output_edge_ids_.size(); index++) {
@@ -210,11 +459,11 @@ class OneDnnGraphOp : public OpKernel {
       }
 
       if (inplace_id_map.find(index) != inplace_id_map.end() &&
-          candidate_inplace_input_edge_[inplace_id_map[index]] == true) {
+          candidate_inplace_input_edge_[inplace_id_map.at(index)] == true) {
         // TODO(itex): Check whether LLGA and TensorFlow inplace mechanism
         // are exacly the same
 
-        int input_index = inplace_id_map[index];
+        int input_index = inplace_id_map.at(index);
         const Tensor& input_tensor = ctx->input(input_index);
 
         if (input_tensor.dtype() != ctx->expected_output_dtype(index)) {
@@ -256,6 +505,7 @@ class OneDnnGraphOp : public OpKernel {
   std::vector<bool> is_constant_input_edge_;
   std::vector<bool> candidate_inplace_input_edge_;
   std::vector<string> framework_ops_;
+  std::unique_ptr<CompiledPartitionCache> partition_cache_;
 };
 
 #define MATCH_TYPE_AND_SIZE(TYPE) \
@@ -295,6 +545,8 @@ class OneDnnGraphWithLayoutOp : public OpKernel {
                                      &candidate_inplace_input_edge_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("framework_ops", &framework_ops_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("is_end_node", &is_end_node_));
+    partition_cache_ = std::make_unique<CompiledPartitionCache>(
+        GetKernelSignature(*this, input_edge_ids_, framework_ops_));
   }
 
   void Compute(OpKernelContext* ctx) {
@@ -378,12 +630,13 @@ class OneDnnGraphWithLayoutOp : public OpKernel {
             dnnl::graph::logical_tensor::layout_type::any));
     }
 
-    auto c_partition = partition->compile(
-        l_input_logical_tensor, l_output_logical_tensor, onednn_engine);
-
-    std::unordered_map<size_t, size_t> inplace_id_map;  // <output_id, input_id>
-    GetInplaceIdMap(c_partition, l_input_logical_tensor,
-                    l_output_logical_tensor, &inplace_id_map);
+    std::shared_ptr<const CompiledPartitionCache::Entry> entry =
+        partition_cache_->GetOrCompile(*partition, l_input_logical_tensor,
+                                       l_output_logical_tensor, onednn_engine,
+                                       *this);
+    const auto& c_partition = entry->c_partition;
+    // <output_id, input_id>
+    const auto& inplace_id_map = entry->inplace_id_map;
 
     // Prepare output tensors
     for (int index = 0; index < output_edge_ids_.size(); index++) {
@@ -423,10 +676,10 @@ class OneDnnGraphWithLayoutOp : public OpKernel {
       }
 
       if (inplace_id_map.find(index) != inplace_id_map.end() &&
-          candidate_inplace_input_edge_[inplace_id_map[index]] == true) {
+          candidate_inplace_input_edge_[inplace_id_map.at(index)] == true) {
         // TODO(itex): Check whether LLGA and TensorFlow inplace mechanism
         // are exacly the same
-        int input_index = inplace_id_map[index];
+        int input_index = inplace_id_map.at(index);
         const Tensor& input_tensor = ctx->input(input_index);
 
         if (input_tensor.dtype() != ctx->expected_output_dtype(index)) {
@@ -481,6 +734,7 @@ class OneDnnGraphWithLayoutOp : public OpKernel {
   std::vector<bool> candidate_inplace_input_edge_;
   std::vector<string> framework_ops_;
   std::vector<bool> is_end_node_;
+  std::unique_ptr<CompiledPartitionCache> partition_cache_;
 };
 
 #ifdef INTEL_CPU_ONLY
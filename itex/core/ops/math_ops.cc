@@ -217,3 +217,24 @@ void Register_ITEXFusedBinaryOp() {
         << "_ITEXFusedBinary op registration failed: ";
   }
 }
+
+void Register_ITEXFusedElementwiseOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXFusedElementwise");
+
+    TF_OpDefinitionBuilderAddInput(op_builder, "args: num_args * T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "output: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {half,bfloat16,float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "fused_ops: list(string) = []");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "acc_first: list(int) = []");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "alphas: list(float) = []");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "num_args: int >= 1");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unchanged_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXFusedElementwise op registration failed: ";
+  }
+}
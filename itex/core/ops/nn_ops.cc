@@ -3047,6 +3047,58 @@ void Register_ITEXRMSNormOp() {
   }
 }
 
+// `_ITEXFusedAddRMSNorm` computes `sum = x + residual` and `y = RMSNorm(sum)`,
+// the sum is the residual of the next layer.
+void Register_ITEXFusedAddRMSNormOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXFusedAddRMSNorm");
+    TF_OpDefinitionBuilderAddInput(op_builder, "x: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "residual: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "scale: U");
+    TF_OpDefinitionBuilderAddInput(op_builder, "offset: U");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "y: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "sum: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {half, bfloat16, float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "U: {float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "epsilon: float = 0.0001");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_scale: bool = true");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_center: bool = false");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &fused_add_norm_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXFusedAddRMSNorm op registration failed: ";
+  }
+}
+
+// `_ITEXFusedAddGroupNorm` computes `sum = x + residual` and
+// `y = GroupNorm(sum)`.
+void Register_ITEXFusedAddGroupNormOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXFusedAddGroupNorm");
+    TF_OpDefinitionBuilderAddInput(op_builder, "x: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "residual: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "scale: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "offset: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "y: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "sum: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {half, bfloat16, float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "num_groups: int");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "epsilon: float = 0.0001");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_scale: bool = true");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_center: bool = true");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &fused_add_norm_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXFusedAddGroupNorm op registration failed: ";
+  }
+}
+
 void Register_ITEXLayerNormOp() {
   itex::StatusUniquePtr status(TF_NewStatus());
   {
@@ -4756,6 +4808,7 @@ void Register_SDPInfOp() {
     TF_OpDefinitionBuilderAddAttr(op_builder, "use_mask: bool = false");
     TF_OpDefinitionBuilderAddAttr(op_builder, "use_causal: bool = false");
     TF_OpDefinitionBuilderAddAttr(op_builder, "is_inference: bool = true");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "num_kv_heads: int = 0");
 
     TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
                                                     &unknown_shape_fn);
@@ -4765,6 +4818,110 @@ void Register_SDPInfOp() {
   }
 }
 
+void Register_SDPKVCacheInfOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("ScaledDotProductAttentionKVCacheInference");
+    TF_OpDefinitionBuilderAddInput(op_builder, "query: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "key: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "value: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "key_cache: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "value_cache: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "cache_len: int32");
+    TF_OpDefinitionBuilderAddInput(op_builder, "atten_mask: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "output: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "key_cache_out: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "value_cache_out: T");
+    // Only the CPU kernel exists, registered for bfloat16 and float.
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_mask: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_causal: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "num_kv_heads: int = 0");
+
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "ScaledDotProductAttentionKVCacheInference op registration failed: ";
+  }
+}
+
+void Register_SDPVarLenInfOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("ScaledDotProductAttentionVarLenInference");
+    TF_OpDefinitionBuilderAddInput(op_builder, "query: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "key: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "value: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "cu_seqlens_q: int32");
+    TF_OpDefinitionBuilderAddInput(op_builder, "cu_seqlens_k: int32");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "output: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, half, float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_causal: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "num_kv_heads: int = 0");
+
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unchanged_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "ScaledDotProductAttentionVarLenInference op registration failed: ";
+  }
+}
+
+void Register_SDPFlashOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("ScaledDotProductAttentionFlash");
+    TF_OpDefinitionBuilderAddInput(op_builder, "query: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "key: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "value: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "atten_mask: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "output: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "softmax_lse: float");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, half, float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_mask: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_causal: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "num_kv_heads: int = 0");
+
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "ScaledDotProductAttentionFlash op registration failed: ";
+  }
+}
+
+void Register_SDPFlashGradOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("ScaledDotProductAttentionFlashGrad");
+    TF_OpDefinitionBuilderAddInput(op_builder, "query: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "key: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "value: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "atten_mask: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "output: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "softmax_lse: float");
+    TF_OpDefinitionBuilderAddInput(op_builder, "output_backprop: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "query_backprop: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "key_backprop: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "value_backprop: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, half, float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_mask: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_causal: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "num_kv_heads: int = 0");
+
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "ScaledDotProductAttentionFlashGrad op registration failed: ";
+  }
+}
+
 void Register_SDPGradOp() {
   itex::StatusUniquePtr status(TF_NewStatus());
   {
@@ -4833,6 +4990,103 @@ void Register_FusedDenseBiasAddGeluGradOp() {
   }
 }
 
+// `_ITEXFusedMLP` computes the feed-forward block of a transformer
+//   h = act(x @ w_up + b_up), or with `is_gated`
+//   h = act(x @ w_gate + b_gate) * (x @ w_up + b_up)
+//   y = h @ w_down + b_down
+// `args` holds w_gate, b_gate, b_up and b_down, in this order, when present.
+void Register_ITEXFusedMLPOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXFusedMLP");
+    TF_OpDefinitionBuilderAddInput(op_builder, "x: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "w_up: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "w_down: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "args: num_args * T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "y: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "num_args: int >= 0");
+    TF_OpDefinitionBuilderAddAttr(
+        op_builder,
+        "activation: {'GeluExact', 'GeluApproximate', 'Relu', 'Silu'}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "is_gated: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "has_gate_bias: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "has_up_bias: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "has_down_bias: bool = false");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &fused_mlp_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXFusedMLP op registration failed: ";
+  }
+}
+
+// Weight-only quantized MatMul: y = a @ dequantize(weight) + bias.
+// `weight` holds the quantized [K, N] weight in row-major order. For 8 bits
+// it is [K, N] int8, for 4 bits two rows are packed per byte, [K / 2, N],
+// row 2i in the low and row 2i + 1 in the high nibble as unsigned [0, 15].
+// Every `group_size` rows of a column share one scale and zero point:
+//   w[k, n] = (q[k, n] - zero_points[k / group_size, n]) *
+//             scales[k / group_size, n]
+// `zero_points` and `bias` are ignored unless has_zero_point and has_bias are
+// set. Without zero points, 4 bits weights are centered on 8 and 8 bits ones
+// on 0.
+void Register_ITEXWeightOnlyQuantizedMatMulOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXWeightOnlyQuantizedMatMul");
+    TF_OpDefinitionBuilderAddInput(op_builder, "a: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "weight: int8");
+    TF_OpDefinitionBuilderAddInput(op_builder, "scales: float");
+    TF_OpDefinitionBuilderAddInput(op_builder, "zero_points: int8");
+    TF_OpDefinitionBuilderAddInput(op_builder, "bias: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "product: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "bits: int = 4");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "group_size: int >= 1 = 128");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "has_zero_point: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "has_bias: bool = false");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(
+        op_builder, &weight_only_matmul_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXWeightOnlyQuantizedMatMul op registration failed: ";
+  }
+}
+
+// MatMul with dynamic INT8 quantization: `a` is quantized at runtime with
+// per-row (or per-tensor) symmetric scales computed from its values, the
+// constant `b` once with per-output-channel scales. The INT8 product is
+// dequantized to T. `b` is [K, N], or [N, K] if transpose_b, and `args` is
+// empty or the [N] bias. `a` may have any rank >= 2, its leading dims are
+// flattened into rows.
+void Register_ITEXDynamicQuantizedMatMulOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXDynamicQuantizedMatMul");
+    TF_OpDefinitionBuilderAddInput(op_builder, "a: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "b: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "args: num_args * T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "product: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "num_args: int >= 0 = 0");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "transpose_b: bool = false");
+    TF_OpDefinitionBuilderAddAttr(
+        op_builder, "granularity: {'per_row', 'per_tensor'} = 'per_row'");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXDynamicQuantizedMatMul op registration failed: ";
+  }
+}
+
 void Register_QKRotaryPositionalEmbeddingOp() {
   itex::StatusUniquePtr status(TF_NewStatus());
   {
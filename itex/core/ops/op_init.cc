@@ -79,6 +79,8 @@ void RegisterOps() {
   Register_ITEXFusedApplyAdamWithWeightDecayOp();
   Register_ITEXResourceApplyAdamWithWeightDecayOp();
   Register_ITEXResourceApplyLAMBOp();
+  Register_ITEXResourceMultiTensorApplyAdamWithWeightDecayOp();
+  Register_ITEXResourceMultiTensorApplyLAMBOp();
   Register_ITEXFusedApplyMomentumOp();
   Register_ITEXFusedResourceApplyAdamOp();
   Register_ITEXFusedResourceApplyAdamWithWeightDecayOp();
@@ -127,6 +129,7 @@ void RegisterOps() {
   Register_ITEXFusedQuantizedConv2DWithCastOp();
   Register_ITEXFusedRandomOP();
   Register_ITEXFusedBinaryOp();
+  Register_ITEXFusedElementwiseOp();
   Register_ITEXGreaterEqualWithCastOp();
   Register_ITEXGreaterWithCastOp();
   Register_ITEXInstanceNormOp();
@@ -187,6 +190,8 @@ void RegisterOps() {
   Register_ITEXLayerNormGradOp();
   Register_ITEXGroupNormOp();
   Register_ITEXRMSNormOp();
+  Register_ITEXFusedAddRMSNormOp();
+  Register_ITEXFusedAddGroupNormOp();
   Register_ITEXLeakyReluGradOp();
   Register_ITEXLeakyReluOp();
   Register_ITEXMatMul();
@@ -362,10 +367,17 @@ void RegisterOps() {
 
   Register_FusedDenseBiasAddGeluOp();
   Register_FusedDenseBiasAddGeluGradOp();
+  Register_ITEXFusedMLPOp();
+  Register_ITEXWeightOnlyQuantizedMatMulOp();
+  Register_ITEXDynamicQuantizedMatMulOp();
   // scaled_dot_product_attention
   Register_SDPOp();
   Register_SDPInfOp();
+  Register_SDPKVCacheInfOp();
+  Register_SDPVarLenInfOp();
   Register_SDPGradOp();
+  Register_SDPFlashOp();
+  Register_SDPFlashGradOp();
 
   // FP8 kernels
   Register_Fp8QuantizeOp();
@@ -33,6 +33,8 @@ void Register_ITEXFusedResourceApplyAdamWithWeightDecayOp();
 void Register_ITEXFusedResourceApplyMomentumOp();
 void Register_ITEXResourceApplyAdamWithWeightDecayOp();
 void Register_ITEXResourceApplyLAMBOp();
+void Register_ITEXResourceMultiTensorApplyAdamWithWeightDecayOp();
+void Register_ITEXResourceMultiTensorApplyLAMBOp();
 
 // Unupstreamed ops. These ops are only available in spr-base branch, not in
 // TF master.
@@ -81,6 +83,7 @@ void Register_ITEXFusedQuantizedConv2DWithDequantizeOp();
 void Register_ITEXFusedQuantizedConv2DWithCastOp();
 void Register_ITEXFusedRandomOP();
 void Register_ITEXFusedBinaryOp();
+void Register_ITEXFusedElementwiseOp();
 void Register_ITEXGreaterEqualWithCastOp();
 void Register_ITEXGreaterWithCastOp();
 void Register_ITEXRandomUniformOp();
@@ -110,6 +113,8 @@ void Register_ITEXTensorArraySize();
 void Register_ITEXTensorArrayClose();
 void Register_ITEXGroupNormOp();
 void Register_ITEXRMSNormOp();
+void Register_ITEXFusedAddRMSNormOp();
+void Register_ITEXFusedAddGroupNormOp();
 void Register_ITEXRnnOp();
 void Register_ITEXRnnGradOp();
 void Register_LayerNormOp();
@@ -330,9 +335,16 @@ void Register_OneDnnTransposeOp();
 
 void Register_FusedDenseBiasAddGeluOp();
 void Register_FusedDenseBiasAddGeluGradOp();
+void Register_ITEXFusedMLPOp();
+void Register_ITEXWeightOnlyQuantizedMatMulOp();
+void Register_ITEXDynamicQuantizedMatMulOp();
 void Register_SDPInfOp();
+void Register_SDPKVCacheInfOp();
+void Register_SDPVarLenInfOp();
 void Register_SDPOp();
 void Register_SDPGradOp();
+void Register_SDPFlashOp();
+void Register_SDPFlashGradOp();
 
 // FP8 kernels
 void Register_Fp8QuantizeOp();
@@ -117,6 +117,18 @@ void itex_layer_norm_grad_shape_fn(TF_ShapeInferenceContext* ctx,
   TF_DeleteShapeHandle(handle);
 }
 
+// Both the normalized output and the sum of the input and the residual have
+// the shape of the input.
+void fused_add_norm_shape_fn(TF_ShapeInferenceContext* ctx,
+                             TF_Status* status) {
+  TF_SetStatus(status, TF_OK, "");
+  TF_ShapeHandle* handle = TF_NewShapeHandle();
+  TF_ShapeInferenceContextGetInput(ctx, 0, handle, status);
+  TF_ShapeInferenceContextSetOutput(ctx, 0, handle, status);
+  TF_ShapeInferenceContextSetOutput(ctx, 1, handle, status);
+  TF_DeleteShapeHandle(handle);
+}
+
 void apply_adam_with_weight_decay_shape_fn(TF_ShapeInferenceContext* ctx,
                                            TF_Status* status) {
   TF_SetStatus(status, TF_OK, "");
@@ -137,3 +149,45 @@ void rotary_embedding_shape_fn(TF_ShapeInferenceContext* ctx,
   TF_ShapeInferenceContextSetOutput(ctx, 1, q_handle, status);
   TF_DeleteShapeHandle(q_handle);
 }
+
+// [m, k] x [k, h] x [h, n] -> [m, n]
+// Sets the output to [input 0 dim 0, input `weight_index` dim 1].
+static void matmul_like_shape_fn(TF_ShapeInferenceContext* ctx,
+                                 int weight_index, TF_Status* status) {
+  TF_SetStatus(status, TF_OK, "");
+  TF_ShapeHandle* x_handle = TF_NewShapeHandle();
+  TF_ShapeHandle* weight_handle = TF_NewShapeHandle();
+  TF_ShapeInferenceContextGetInput(ctx, 0, x_handle, status);
+  ITEX_CHECK_EQ(TF_OK, TF_GetCode(status));
+  TF_ShapeInferenceContextGetInput(ctx, weight_index, weight_handle, status);
+  ITEX_CHECK_EQ(TF_OK, TF_GetCode(status));
+
+  TF_ShapeHandle* m_handle = TF_NewShapeHandle();
+  TF_ShapeHandle* n_handle = TF_NewShapeHandle();
+  TF_ShapeHandle* output_handle = TF_NewShapeHandle();
+  TF_ShapeInferenceContextSubshape(ctx, x_handle, 0, 1, m_handle, status);
+  ITEX_CHECK_EQ(TF_OK, TF_GetCode(status));
+  TF_ShapeInferenceContextSubshape(ctx, weight_handle, 1, 2, n_handle, status);
+  ITEX_CHECK_EQ(TF_OK, TF_GetCode(status));
+  TF_ShapeInferenceContextConcatenateShapes(ctx, m_handle, n_handle,
+                                            output_handle, status);
+  ITEX_CHECK_EQ(TF_OK, TF_GetCode(status));
+  TF_ShapeInferenceContextSetOutput(ctx, 0, output_handle, status);
+
+  TF_DeleteShapeHandle(x_handle);
+  TF_DeleteShapeHandle(weight_handle);
+  TF_DeleteShapeHandle(m_handle);
+  TF_DeleteShapeHandle(n_handle);
+  TF_DeleteShapeHandle(output_handle);
+}
+
+void fused_mlp_shape_fn(TF_ShapeInferenceContext* ctx, TF_Status* status) {
+  // [x dim 0, w_down dim 1].
+  matmul_like_shape_fn(ctx, 2, status);
+}
+
+void weight_only_matmul_shape_fn(TF_ShapeInferenceContext* ctx,
+                                 TF_Status* status) {
+  // [a dim 0, weight dim 1].
+  matmul_like_shape_fn(ctx, 1, status);
+}
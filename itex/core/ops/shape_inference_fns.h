@@ -30,11 +30,16 @@ void layer_norm_shape_fn(TF_ShapeInferenceContext* ctx, TF_Status* status);
 void layer_norm_grad_shape_fn(TF_ShapeInferenceContext* ctx, TF_Status* status);
 void itex_layer_norm_grad_shape_fn(TF_ShapeInferenceContext* ctx,
                                    TF_Status* status);
+void fused_add_norm_shape_fn(TF_ShapeInferenceContext* ctx,
+                             TF_Status* status);
 
 void apply_adam_with_weight_decay_shape_fn(TF_ShapeInferenceContext* ctx,
                                            TF_Status* status);
 void rotary_embedding_shape_fn(TF_ShapeInferenceContext* ctx,
                                TF_Status* status);
+void fused_mlp_shape_fn(TF_ShapeInferenceContext* ctx, TF_Status* status);
+void weight_only_matmul_shape_fn(TF_ShapeInferenceContext* ctx,
+                                 TF_Status* status);
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,83 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/profiler/utils/op_profile_xplane.h"
+
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "itex/core/profiler/utils/xplane_builder.h"
+#include "itex/core/profiler/utils/xplane_utils.h"
+#include "itex/core/utils/env.h"
+#include "itex/core/utils/macros.h"
+
+namespace itex {
+namespace profiler {
+
+const char kOpProfilePlaneName[] = "/host:ITEX op profile";
+
+void ConvertOpProfileToXPlane(const std::vector<OpProfileEntry>& profile,
+                              XSpace* space) {
+  XPlaneBuilder plane(FindOrAddMutablePlaneWithName(space,
+                                                    kOpProfilePlaneName));
+  const XStatMetadata& shapes_stat = *plane.GetOrCreateStatMetadata("shapes");
+  const XStatMetadata& implementation_stat =
+      *plane.GetOrCreateStatMetadata("implementation");
+  const XStatMetadata& avg_stat = *plane.GetOrCreateStatMetadata("avg_ns");
+  const XStatMetadata& p50_stat = *plane.GetOrCreateStatMetadata("p50_ns");
+  const XStatMetadata& p99_stat = *plane.GetOrCreateStatMetadata("p99_ns");
+
+  // Line id and end offset of each op type.
+  absl::flat_hash_map<string, std::pair<int64, int64>> lines;
+  for (const auto& entry : profile) {
+    auto it = lines.try_emplace(entry.op_type, lines.size(), 0).first;
+    XLineBuilder line = plane.GetOrCreateLine(it->second.first);
+    line.SetNameIfEmpty(entry.op_type);
+
+    XEventBuilder event =
+        line.AddEvent(*plane.GetOrCreateEventMetadata(entry.op_type));
+    event.SetOffsetNs(it->second.second);
+    event.SetDurationNs(entry.total_ns);
+    event.SetNumOccurrences(entry.count);
+    event.AddStatValue(shapes_stat, entry.shapes);
+    if (!entry.implementation.empty()) {
+      event.AddStatValue(implementation_stat, entry.implementation);
+    }
+    event.AddStatValue(avg_stat, entry.total_ns / entry.count);
+    event.AddStatValue(p50_stat, entry.p50_ns);
+    event.AddStatValue(p99_stat, entry.p99_ns);
+    it->second.second += entry.total_ns;
+  }
+}
+
+namespace {
+
+Status WriteOpProfileXSpace(const std::vector<OpProfileEntry>& profile,
+                            const string& path) {
+  XSpace space;
+  ConvertOpProfileToXPlane(profile, &space);
+  return WriteStringToFile(Env::Default(), path, space.SerializeAsString());
+}
+
+TF_ATTRIBUTE_UNUSED static bool op_profile_xspace_writer_registered = [] {
+  RegisterOpProfileXSpaceWriter(WriteOpProfileXSpace);
+  return true;
+}();
+
+}  // namespace
+
+}  // namespace profiler
+}  // namespace itex
@@ -0,0 +1,38 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_PROFILER_UTILS_OP_PROFILE_XPLANE_H_
+#define ITEX_CORE_PROFILER_UTILS_OP_PROFILE_XPLANE_H_
+
+#include <vector>
+
+#include "itex/core/utils/op_profiler.h"
+#include "protos/xplane.pb.h"
+
+namespace itex {
+namespace profiler {
+
+extern const char kOpProfilePlaneName[];
+
+// Adds `profile` to `space` as a plane with one line per op type. Each entry
+// is one event lasting its total time, with its count and percentiles as
+// stats, laid out by decreasing total time.
+void ConvertOpProfileToXPlane(const std::vector<OpProfileEntry>& profile,
+                              XSpace* space);
+
+}  // namespace profiler
+}  // namespace itex
+
+#endif  // ITEX_CORE_PROFILER_UTILS_OP_PROFILE_XPLANE_H_
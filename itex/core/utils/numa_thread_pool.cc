@@ -0,0 +1,70 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/utils/numa_thread_pool.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "itex/core/utils/cpu_info.h"
+#include "itex/core/utils/env.h"
+#include "itex/core/utils/logging.h"
+#include "itex/core/utils/numa.h"
+#include "itex/core/utils/threadpool.h"
+
+namespace itex {
+
+namespace {
+
+struct NumaThreadPool {
+  NumaThreadPool(int node, int num_threads)
+      : pool(Env::Default(), MakeThreadOptions(node),
+             "itex_numa_" + std::to_string(node), num_threads),
+        device(pool.AsEigenThreadPool(),
+               std::max(1, (num_threads + port::NumHyperthreadsPerCore() - 1) /
+                               port::NumHyperthreadsPerCore())) {}
+
+  static ThreadOptions MakeThreadOptions(int node) {
+    ThreadOptions options;
+    options.numa_node = node;
+    return options;
+  }
+
+  thread::ThreadPool pool;
+  Eigen::ThreadPoolDevice device;
+};
+
+}  // namespace
+
+const Eigen::ThreadPoolDevice* GetNumaThreadPoolDevice(int node) {
+  static const auto* pools = [] {
+    auto* pools = new std::vector<std::unique_ptr<NumaThreadPool>>();
+    const int num_nodes = port::NUMANumNodes();
+    if (num_nodes <= 1) return pools;
+    for (int i = 0; i < num_nodes; ++i) {
+      const int num_threads = std::max(1, port::MaxParallelism(i));
+      ITEX_VLOG(1) << "Create thread pool with " << num_threads
+                   << " threads on NUMA node " << i;
+      pools->emplace_back(new NumaThreadPool(i, num_threads));
+    }
+    return pools;
+  }();
+  if (node < 0 || node >= static_cast<int>(pools->size())) return nullptr;
+  return &(*pools)[node]->device;
+}
+
+}  // namespace itex
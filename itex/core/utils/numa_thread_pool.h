@@ -0,0 +1,38 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_UTILS_NUMA_THREAD_POOL_H_
+#define ITEX_CORE_UTILS_NUMA_THREAD_POOL_H_
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace itex {
+
+// Node attribute holding the NUMA node a CPU kernel runs on. AutoShard sets
+// it on the nodes of each CPU shard when ITEX_SHARDING_CPU_NUMA is enabled.
+constexpr char kNumaNodeAttr[] = "_numa_node";
+
+// Returns the Eigen device of a thread pool whose threads are bound to the
+// CPUs of NUMA node `node`. The pools of all the nodes are created on first
+// use and never change, so the result can be cached by the caller. Since the
+// pages of a tensor are placed on the node of the thread that writes them
+// first, outputs computed on this pool are local to `node`.
+// Returns nullptr if `node` is not a valid NUMA node, or if the machine has a
+// single node, where the default CPU device already covers every CPU.
+const Eigen::ThreadPoolDevice* GetNumaThreadPoolDevice(int node);
+
+}  // namespace itex
+
+#endif  // ITEX_CORE_UTILS_NUMA_THREAD_POOL_H_
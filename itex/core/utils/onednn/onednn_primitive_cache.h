@@ -0,0 +1,178 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_UTILS_ONEDNN_ONEDNN_PRIMITIVE_CACHE_H_
+#define ITEX_CORE_UTILS_ONEDNN_ONEDNN_PRIMITIVE_CACHE_H_
+
+#include <atomic>
+#include <initializer_list>
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "itex/core/utils/env_var.h"
+#include "itex/core/utils/integral_types.h"
+#include "itex/core/utils/logging.h"
+#include "itex/core/utils/strcat.h"
+
+namespace itex {
+
+// Process-wide counters shared by a family of oneDNN object caches. They are
+// only updated when a kernel falls out of its fast path (input shape changed),
+// so the atomics are not on the hot path.
+class OneDnnPrimitiveCacheStats {
+ public:
+  explicit OneDnnPrimitiveCacheStats(std::string name)
+      : name_(std::move(name)) {}
+
+  // Counters of the primitive caches used by the regular oneDNN kernels.
+  static OneDnnPrimitiveCacheStats& Global() {
+    static OneDnnPrimitiveCacheStats stats("oneDNN primitive cache");
+    return stats;
+  }
+
+  void RecordHit() { hits_.fetch_add(1, std::memory_order_relaxed); }
+  void RecordMiss() { misses_.fetch_add(1, std::memory_order_relaxed); }
+  void RecordEviction() { evictions_.fetch_add(1, std::memory_order_relaxed); }
+  // Records the time spent creating an object on a miss, used to estimate the
+  // time saved by the hits.
+  void RecordCreationTime(int64_t micros) {
+    creations_.fetch_add(1, std::memory_order_relaxed);
+    creation_micros_.fetch_add(micros, std::memory_order_relaxed);
+  }
+
+  int64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+  int64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+  int64_t evictions() const {
+    return evictions_.load(std::memory_order_relaxed);
+  }
+
+  // Estimated creation time avoided by cache hits, in microseconds.
+  int64_t saved_micros() const {
+    int64_t creations = creations_.load(std::memory_order_relaxed);
+    if (creations == 0) return 0;
+    return hits() * creation_micros_.load(std::memory_order_relaxed) /
+           creations;
+  }
+
+  std::string DebugString() const {
+    std::string str =
+        strings::StrCat(name_, ": hits=", hits(), ", misses=", misses(),
+                        ", evictions=", evictions());
+    if (creations_.load(std::memory_order_relaxed) > 0) {
+      strings::StrAppend(&str, ", creation_us=",
+                         creation_micros_.load(std::memory_order_relaxed),
+                         ", est_saved_us=", saved_micros());
+    }
+    return str;
+  }
+
+ private:
+  const std::string name_;
+  std::atomic<int64_t> hits_{0};
+  std::atomic<int64_t> misses_{0};
+  std::atomic<int64_t> evictions_{0};
+  std::atomic<int64_t> creations_{0};
+  std::atomic<int64_t> creation_micros_{0};
+};
+
+// Bounded LRU cache of oneDNN objects (primitive, memory objects, reordered
+// weights...) created by a kernel for different input shapes. Kernels keep
+// their existing "last shape" fast path and only consult this cache when the
+// input shape changes, so dynamic batch/sequence lengths cycling through a
+// small set of shapes no longer re-create primitives on every step.
+//
+// The capacity is controlled by `ITEX_CACHE_ONEDNN_OBJECT_CAPACITY` (or the
+// env var given to the constructor), 0 disables the cache. It is not thread
+// safe, callers are expected to hold the kernel compute lock.
+template <typename Value>
+class OneDnnPrimitiveCache {
+ public:
+  using Key = std::vector<int64>;
+
+  explicit OneDnnPrimitiveCache(
+      OneDnnPrimitiveCacheStats* stats = &OneDnnPrimitiveCacheStats::Global(),
+      const char* capacity_env_var = "ITEX_CACHE_ONEDNN_OBJECT_CAPACITY")
+      : stats_(stats) {
+    int64_t capacity;
+    ITEX_CHECK_OK(
+        ReadInt64FromEnvVar(capacity_env_var, kDefaultCapacity, &capacity));
+    capacity_ = capacity > 0 ? static_cast<size_t>(capacity) : 0;
+  }
+
+  bool IsEnabled() const { return capacity_ > 0; }
+  size_t capacity() const { return capacity_; }
+  size_t size() const { return entries_.size(); }
+
+  // Returns the cached value for `key` and marks it as most recently used, or
+  // nullptr if not found.
+  Value* Find(const Key& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      stats_->RecordMiss();
+      ITEX_VLOG(3) << stats_->DebugString();
+      return nullptr;
+    }
+    stats_->RecordHit();
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+  }
+
+  // Inserts or replaces the value for `key`, evicting the least recently used
+  // entry if the cache is full.
+  void Insert(const Key& key, Value value) {
+    if (!IsEnabled()) return;
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      it->second->second = std::move(value);
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return;
+    }
+    if (entries_.size() >= capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+      stats_->RecordEviction();
+    }
+    entries_.emplace_front(key, std::move(value));
+    index_.emplace(key, entries_.begin());
+  }
+
+  // Builds a cache key from several dims lists, e.g. the dims of all inputs
+  // that affect primitive creation.
+  static Key MakeKey(std::initializer_list<const std::vector<int64>*> dims) {
+    Key key;
+    for (const auto* d : dims) {
+      key.insert(key.end(), d->begin(), d->end());
+      // Separator, so that {[1, 2], [3]} and {[1], [2, 3]} differ.
+      key.push_back(-1);
+    }
+    return key;
+  }
+
+ private:
+  static constexpr int64_t kDefaultCapacity = 32;
+
+  using Entry = std::pair<Key, Value>;
+  OneDnnPrimitiveCacheStats* stats_;
+  size_t capacity_ = 0;
+  std::list<Entry> entries_;
+  std::map<Key, typename std::list<Entry>::iterator> index_;
+};
+
+}  // namespace itex
+
+#endif  // ITEX_CORE_UTILS_ONEDNN_ONEDNN_PRIMITIVE_CACHE_H_
@@ -16,8 +16,12 @@ limitations under the License.
 #ifndef ITEX_BUILD_JAX
 #include "itex/core/utils/onednn/onednn_util.h"
 
+#include <algorithm>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
+#include "itex/core/utils/env_var.h"
 #include "itex/core/utils/register_types.h"
 
 namespace itex {
@@ -38,12 +42,114 @@ void ReorderMemory(const OpKernelContext& context,
 // short length datatype, ensure the it is divisible by allocated buffer.
 using ShortDT = uint8;
 
+SharedWeightStore& SharedWeightStore::Global() {
+  static SharedWeightStore* store = new SharedWeightStore();
+  return *store;
+}
+
+bool SharedWeightStore::IsEnabled() {
+  static bool enabled = [] {
+    bool share_weight = true;
+    ITEX_CHECK_OK(
+        ReadBoolFromEnvVar("ITEX_SHARE_WEIGHT_CACHE", true, &share_weight));
+    return share_weight;
+  }();
+  return enabled;
+}
+
+std::shared_ptr<SharedWeightStore::Entry> SharedWeightStore::GetOrCreate(
+    OpKernelContext* context, DataType dtype,
+    const dnnl::memory::desc& original_md,
+    const dnnl::memory::desc& expected_md, void* weight_data,
+    const dnnl::engine& onednn_engine) TF_LOCKS_EXCLUDED(mu_) {
+  // Content fingerprint, the memory descs are compared below to tell apart
+  // weights with the same bytes but different shape or format.
+  const Fprint128 key = Fingerprint128(StringPiece(
+      static_cast<const char*>(weight_data), original_md.get_size()));
+
+  // Weights locked below may lose their last other user meanwhile. They are
+  // destroyed after `lock` is released, since `Release` acquires `mu_`.
+  std::vector<std::shared_ptr<Entry>> mismatched;
+  mutex_lock lock(&mu_);
+  auto& candidates = entries_[key];
+  for (const auto& candidate : candidates) {
+    std::shared_ptr<Entry> entry = candidate.lock();
+    if (!entry) continue;
+    if (entry->original_md == original_md &&
+        entry->expected_md == expected_md &&
+        entry->numa_node == context->numa_node()) {
+      ++hits_;
+      bytes_saved_ += expected_md.get_size();
+      ITEX_VLOG(3) << DebugStringLocked();
+      return entry;
+    }
+    mismatched.push_back(std::move(entry));
+  }
+
+  auto new_entry = std::make_unique<Entry>();
+  Tensor* weight_cached_tensor = nullptr;
+  TensorShape weight_tf_shape;
+  weight_tf_shape.AddDim(expected_md.get_size() / DataTypeSize(dtype));
+  Status s = context->allocate_persistent(
+      dtype, weight_tf_shape, &new_entry->data, &weight_cached_tensor);
+  if (!s.ok()) {
+    if (candidates.empty()) entries_.erase(key);
+    return nullptr;
+  }
+
+  dnnl::memory weight_mem =
+      CreateDnnlMemory(original_md, onednn_engine, weight_data);
+  dnnl::memory weight_reorder_mem = CreateDnnlMemory(
+      expected_md, onednn_engine, weight_cached_tensor->data());
+  ReorderMemory(*context, &weight_mem, &weight_reorder_mem, onednn_engine);
+
+  new_entry->original_md = original_md;
+  new_entry->expected_md = expected_md;
+  new_entry->numa_node = context->numa_node();
+  std::shared_ptr<Entry> entry(new_entry.release(), [this, key](Entry* e) {
+    Release(key);
+    delete e;
+  });
+  candidates.push_back(entry);
+  ++misses_;
+  ITEX_VLOG(3) << DebugStringLocked();
+  return entry;
+}
+
+void SharedWeightStore::Release(const Fprint128& key) TF_LOCKS_EXCLUDED(mu_) {
+  mutex_lock lock(&mu_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) return;
+  auto& candidates = it->second;
+  candidates.erase(
+      std::remove_if(candidates.begin(), candidates.end(),
+                     [](const std::weak_ptr<Entry>& e) { return e.expired(); }),
+      candidates.end());
+  if (candidates.empty()) entries_.erase(it);
+  ITEX_VLOG(3) << DebugStringLocked();
+}
+
+string SharedWeightStore::DebugString() TF_LOCKS_EXCLUDED(mu_) {
+  mutex_lock lock(&mu_);
+  return DebugStringLocked();
+}
+
+string SharedWeightStore::DebugStringLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  int64 num_live = 0;
+  for (const auto& it : entries_) {
+    for (const auto& entry : it.second) num_live += !entry.expired();
+  }
+  return strings::StrCat("Shared weight store: hits=", hits_,
+                         ", misses=", misses_, ", bytes saved=", bytes_saved_,
+                         ", live weights=", num_live);
+}
+
 template <typename T>
 bool WeightCacheManager<T>::IsEmpty() TF_LOCKS_EXCLUDED(mu_) {
   tf_shared_lock lock(&mu_);
   // TODO(itex): investigate why weight_cached_data_.NumElements() == 1
   // instead of 0,  while weight_cached_data_.IsInitialized() == True
-  return (!weight_cached_data_.IsInitialized());
+  return (!weight_cached_data_.IsInitialized() && shared_weight_ == nullptr);
 }
 
 template <typename T>
@@ -53,10 +159,19 @@ void WeightCacheManager<T>::SetCache(
     const dnnl::engine& onednn_engine) TF_LOCKS_EXCLUDED(mu_) {
   mutex_lock lock(&mu_);
 
-  if (weight_cached_data_.IsInitialized()) {
+  if (weight_cached_data_.IsInitialized() || shared_weight_ != nullptr) {
     return;
   }
 
+  // Weights on host can be fingerprinted and shared with other kernels.
+  if (onednn_engine.get_kind() == dnnl::engine::kind::cpu &&
+      SharedWeightStore::IsEnabled()) {
+    shared_weight_ = SharedWeightStore::Global().GetOrCreate(
+        context, DataTypeToEnum<T>::value, weight_original_md,
+        weight_expected_md, weight_data, onednn_engine);
+    if (shared_weight_ != nullptr) return;
+  }
+
   // Create original memory
   dnnl::memory weight_mem =
       CreateDnnlMemory(weight_original_md, onednn_engine, weight_data);
@@ -101,6 +216,11 @@ T* WeightCacheManager<T>::GetCache(OpKernelContext* context,
                                    const dnnl::memory::desc& expected_md)
     TF_LOCKS_EXCLUDED(mu_) {
   tf_shared_lock lock(&mu_);
+  if (shared_weight_ != nullptr) {
+    if (shared_weight_->expected_md != expected_md) return nullptr;
+    return static_cast<T*>(shared_weight_->data.AccessTensor(context)->data());
+  }
+
   const Tensor* weight_cached_data = weight_cached_data_.AccessTensor(context);
   const Tensor* weight_cached_md = weight_cached_md_.AccessTensor(context);
 
@@ -19,7 +19,9 @@ limitations under the License.
 #include <dlfcn.h>
 
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -29,9 +31,11 @@ limitations under the License.
 #include "dnnl_sycl.hpp"  // NOLINT(build/include_subdir)
 #endif                    // INTEL_CPU_ONLY
 
+#include "itex/core/utils/fingerprint.h"
 #include "itex/core/utils/logging.h"
 #include "itex/core/utils/onednn/mkl_threadpool.h"
 #include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_profiler.h"
 #include "itex/core/utils/op_requires.h"
 #include "itex/core/utils/status.h"
 #include "itex/core/utils/strcat.h"
@@ -223,11 +227,10 @@ inline dnnl::engine& CreateDnnlEngine<GPUDevice>(const OpKernelContext& ctx) {
 
 template <>
 inline dnnl::engine& CreateDnnlEngine<CPUDevice>(const OpKernelContext& ctx) {
-  // Right now ITEX doesn't own proper TF CPU device and NUMA info is
-  // unavailable, so simply consider ITEX only have 1 CPU device.
+  // Right now ITEX doesn't own proper TF CPU device, so simply consider ITEX
+  // only have 1 CPU device. Kernels pinned to a NUMA node share this engine,
+  // their streams run on the thread pool of the node instead.
   // TODO(itex): Check NUMA after integrating new CPU device.
-  ITEX_CHECK(&(ctx.eigen_cpu_device()) == &(ctx.eigen_cpu_device_singleton()))
-      << "Global oneDNN CPU engine mismatched with current context";
   static dnnl::engine cpu_engine = dnnl::engine(dnnl::engine::kind::cpu, 0);
   return cpu_engine;
 }
@@ -558,11 +561,78 @@ inline dnnl::memory::desc CreatePlainMemDescWithFormatTag(
                               dnnl::memory::format_tag::abcdefghijkl);
 }
 
+// Reports the implementation oneDNN picked for `primitive` to the op profiler,
+// see SetOpProfileImplementation().
+inline void ReportPrimitiveImplementation(const dnnl::primitive& primitive) {
+  if (!IsOpProfilerEnabled()) return;
+  const char* impl_info = nullptr;
+  if (dnnl_primitive_desc_query(primitive.get_primitive_desc(),
+                                dnnl_query_impl_info_str, 0,
+                                &impl_info) == dnnl_success &&
+      impl_info != nullptr) {
+    SetOpProfileImplementation(impl_info);
+  }
+}
+
 // Reorder src memory to expected memory
 void ReorderMemory(const OpKernelContext& context,
                    const dnnl::memory* src_memory, dnnl::memory* reorder_memory,
                    const dnnl::engine& onednn_engine);
 
+// Process-wide store of reordered constant weights. Identical constant weights
+// reordered to the same memory desc, e.g. by several replicas of one SavedModel
+// or by fused MatMuls sharing one constant after remapping, are reordered once
+// and share a single buffer instead of one copy per kernel instance. Entries
+// are refcounted by the kernels using them and released with the last user.
+//
+// Weights are identified by a fingerprint of their content, so only weights
+// accessible from host (CPU engine) are shared. Kernels pinned to different
+// NUMA nodes don't share weights, so each node reads a local copy. Set
+// `ITEX_SHARE_WEIGHT_CACHE` to 0 to disable it.
+class SharedWeightStore {
+ public:
+  struct Entry {
+    PersistentTensor data;
+    dnnl::memory::desc original_md;
+    dnnl::memory::desc expected_md;
+    int numa_node;
+  };
+
+  static SharedWeightStore& Global();
+  static bool IsEnabled();
+
+  // Returns the weight in `weight_data` reordered from `original_md` to
+  // `expected_md`, the reorder is only executed if no identical weight is
+  // alive in the store. Returns nullptr if the buffer can't be allocated.
+  std::shared_ptr<Entry> GetOrCreate(OpKernelContext* context, DataType dtype,
+                                     const dnnl::memory::desc& original_md,
+                                     const dnnl::memory::desc& expected_md,
+                                     void* weight_data,
+                                     const dnnl::engine& onednn_engine)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  string DebugString() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  SharedWeightStore() = default;
+  TF_DISALLOW_COPY_AND_ASSIGN(SharedWeightStore);
+
+  string DebugStringLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Called when the last kernel using a weight with fingerprint `key` is
+  // destroyed, drops the released weights of `key` from `entries_`.
+  void Release(const Fprint128& key) TF_LOCKS_EXCLUDED(mu_);
+
+  mutex mu_;
+  std::unordered_map<Fprint128, std::vector<std::weak_ptr<Entry>>,
+                     Fprint128Hasher>
+      entries_ TF_GUARDED_BY(mu_);
+  int64 hits_ TF_GUARDED_BY(mu_) = 0;
+  int64 misses_ TF_GUARDED_BY(mu_) = 0;
+  // Bytes of reordered weights that were not allocated thanks to sharing.
+  int64 bytes_saved_ TF_GUARDED_BY(mu_) = 0;
+};
+
 // Weight cache is used to avoid weight reorder repetitively when target weight
 // block md is different frome original weight plain md.
 template <typename T>
@@ -590,6 +660,8 @@ class WeightCacheManager {
   mutex mu_;
   PersistentTensor weight_cached_data_ TF_GUARDED_BY(mu_);
   PersistentTensor weight_cached_md_ TF_GUARDED_BY(mu_);
+  // Used instead of the 2 tensors above if the weight is shared process-wide.
+  std::shared_ptr<SharedWeightStore::Entry> shared_weight_ TF_GUARDED_BY(mu_);
 };
 
 // Bias cache is used to avoid scale the bias tensor repetitively in INT8 kernel
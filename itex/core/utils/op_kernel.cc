@@ -20,11 +20,14 @@ limitations under the License.
 
 #include <iostream>
 #include <string>
+#include <utility>
 
+#include "absl/strings/str_cat.h"
 #include "itex/core/graph/config_util.h"
 #ifndef INTEL_CPU_ONLY
 #include "itex/core/utils/gpu_resource_mgr_pool.h"
 #endif
+#include "itex/core/utils/env_time.h"
 #include "itex/core/utils/kernel_def_util.h"
 #include "itex/core/utils/op_requires.h"
 #include "itex/core/utils/padding.h"
@@ -72,6 +75,44 @@ void EmptyCopyFunctor(TF_OpKernelContext* tf_ctx, TF_Tensor* tf_source,
   return;
 }
 
+namespace {
+
+// Statuses released by the OpKernelContexts destroyed on this thread.
+struct StatusPool {
+  static constexpr int kMaxSize = 16;
+  ~StatusPool() {
+    for (TF_Status* status : statuses) TF_DeleteStatus(status);
+  }
+  gtl::InlinedVector<TF_Status*, kMaxSize> statuses;
+};
+
+StatusPool* GetStatusPool() {
+  static thread_local StatusPool pool;
+  return &pool;
+}
+
+}  // namespace
+
+/* static */ TF_Status* OpKernelContext::AcquireStatus() {
+  StatusPool* pool = GetStatusPool();
+  if (pool->statuses.empty()) return TF_NewStatus();
+  TF_Status* status = pool->statuses.back();
+  pool->statuses.pop_back();
+  return status;
+}
+
+// Async kernels may destroy the context on another thread, the status then
+// moves to that thread's pool.
+/* static */ void OpKernelContext::ReleaseStatus(TF_Status* status) {
+  StatusPool* pool = GetStatusPool();
+  if (pool->statuses.size() >= StatusPool::kMaxSize) {
+    TF_DeleteStatus(status);
+    return;
+  }
+  TF_SetStatus(status, TF_OK, "");
+  pool->statuses.push_back(status);
+}
+
 int OpKernelContext::num_inputs() const { return TF_NumInputs(ctx_); }
 
 bool OpKernelContext::input_is_ref(int index) const {
@@ -79,8 +120,9 @@ bool OpKernelContext::input_is_ref(int index) const {
 }
 
 DataType OpKernelContext::input_dtype(int index) const {
-  if (inputs_ != nullptr && inputs_->at(index) != nullptr) {
-    return inputs_->at(index)->dtype();
+  if (index < static_cast<int>(inputs_.size()) &&
+      inputs_[index].has_value()) {
+    return inputs_[index]->dtype();
   } else {
     ITEX_CHECK(false)
         << "please call ctx.input_dtype() after calling ctx.input() or "
@@ -103,13 +145,11 @@ DataType OpKernelContext::expected_output_dtype(int index) const {
 }
 
 const Tensor& OpKernelContext::input(int index) const {
+  if (inputs_.empty()) inputs_.resize(num_inputs());
   ITEX_CHECK_GE(index, 0);
-  ITEX_CHECK_LT(index, num_inputs());
-  if (inputs_ == nullptr) {
-    inputs_ = new gtl::InlinedVector<std::shared_ptr<Tensor>, 4>(num_inputs());
-  }
+  ITEX_CHECK_LT(index, static_cast<int>(inputs_.size()));
 
-  if (!inputs_->at(index)) {
+  if (!inputs_[index].has_value()) {
     TF_Tensor* tensor = nullptr;
     TF_GetInput(ctx_, index, &tensor, status_);
     TensorShape shape;
@@ -117,12 +157,10 @@ const Tensor& OpKernelContext::input(int index) const {
     for (auto j = 0; j < dims; ++j) {
       shape.AddDim(TF_Dim(tensor, j));
     }
-    std::shared_ptr<Tensor> ptr = std::make_shared<Tensor>(
-        static_cast<DataType>(TF_TensorType(tensor)), shape, tensor);
-    inputs_->at(index) = std::move(ptr);
+    inputs_[index].emplace(static_cast<DataType>(TF_TensorType(tensor)), shape,
+                           tensor);
   }
-  ITEX_CHECK_NE(inputs_, nullptr);
-  return *inputs_->at(index);
+  return *inputs_[index];
 }
 
 #ifndef INTEL_CPU_ONLY
@@ -139,49 +177,34 @@ ResourceMgr* OpKernelContext::resource_manager() {
 #endif
 
 Status OpKernelContext::input(StringPiece name, const Tensor** tensor) {
-  TF_Status* status = TF_NewStatus();
-  if (inputsMap_.find(name) == inputsMap_.end()) {
-    TF_Tensor* tensor = nullptr;
-    TF_GetInputByName(ctx_, std::string(name).c_str(), &tensor, status);
-    Status cc_status = StatusFromTF_Status(status);
-    if (!cc_status.ok()) {
-      return cc_status;
-    }
-
-    inputsMap_[name] = std::make_shared<Tensor>(tensor);
+  auto it = inputsMap_.find(name);
+  if (it == inputsMap_.end()) {
+    TF_Tensor* tf_tensor = nullptr;
+    // A local status, so that a missing input the caller handles doesn't
+    // leave the pooled `status_` of the kernel in the error state.
+    StatusUniquePtr status(TF_NewStatus());
+    TF_GetInputByName(ctx_, std::string(name).c_str(), &tf_tensor,
+                      status.get());
+    TF_RETURN_IF_ERROR(StatusFromTF_Status(status.get()));
+    it = inputsMap_.emplace(name, std::make_shared<Tensor>(tf_tensor)).first;
   }
 
-  *tensor = inputsMap_[name].get();
-  Status cc_status = StatusFromTF_Status(status);
-  TF_DeleteStatus(status);
-  return cc_status;
+  *tensor = it->second.get();
+  return Status::OK();
 }
 
 void* OpKernelContext::tensor_data(int index) {
-  TF_Tensor* tensor = nullptr;
-  TF_GetInput(ctx_, index, &tensor, status_);
-  void* data = TF_TensorData(tensor);
-  TF_DeleteTensor(tensor);
-  return data;
+  return TF_TensorData(input(index).GetTFTensor());
 }
 
-bool OpKernelContext::is_input_same(int index, std::vector<int64> shape) {
-  TF_Tensor* tensor = nullptr;
-  TF_GetInput(ctx_, index, &tensor, status_);
-  int dims = TF_NumDims(tensor);
-  if (dims != static_cast<int>(shape.size())) {
-    TF_DeleteTensor(tensor);
-    return false;
-  }
+bool OpKernelContext::is_input_same(int index,
+                                    const std::vector<int64>& shape) {
+  const TensorShape& input_shape = input(index).shape();
+  if (input_shape.dims() != static_cast<int>(shape.size())) return false;
 
-  for (int i = 0; i < dims; ++i) {
-    if (shape[i] != TF_Dim(tensor, i)) {
-      TF_DeleteTensor(tensor);
-      return false;
-    }
+  for (int i = 0; i < input_shape.dims(); ++i) {
+    if (shape[i] != input_shape.dim_size(i)) return false;
   }
-
-  TF_DeleteTensor(tensor);
   return true;
 }
 
@@ -225,14 +248,13 @@ Status OpKernelContext::forward_input_or_allocate_output(
       candidate_input_indices.size(), output_index,
       output_shape.dim_sizes().data(), output_shape.dims(), forwarded_input,
       status_);
-  if (outputs_[output_index] == nullptr) {
-    std::shared_ptr<Tensor> ptr = std::make_shared<Tensor>(
+  if (!outputs_[output_index].has_value()) {
+    outputs_[output_index].emplace(
         static_cast<DataType>(expected_output_dtype(output_index)),
         output_shape, tensor);
-    outputs_[output_index] = std::move(ptr);
   }
 
-  *output = outputs_[output_index].get();
+  *output = &*outputs_[output_index];
   return StatusFromTF_Status(status_);
 }
 
@@ -246,17 +268,15 @@ Tensor* OpKernelContext::mutable_output(int index) {
   ITEX_DCHECK_GE(index, 0);
   ITEX_DCHECK_LT(index, num_outputs());
 
-  return outputs_[index].get();
+  return outputs_[index].has_value() ? &*outputs_[index] : nullptr;
 }
 
 Tensor& OpKernelContext::mutable_input(int index, bool lock_held) {
+  if (inputs_.empty()) inputs_.resize(num_inputs());
   ITEX_CHECK_GE(index, 0);
-  ITEX_CHECK_LT(index, num_inputs());
-  if (inputs_ == nullptr) {
-    inputs_ = new gtl::InlinedVector<std::shared_ptr<Tensor>, 4>(num_inputs());
-  }
+  ITEX_CHECK_LT(index, static_cast<int>(inputs_.size()));
 
-  if (!inputs_->at(index)) {
+  if (!inputs_[index].has_value()) {
     TF_Tensor* tensor = nullptr;
     TF_GetInputTensorFromVariable(
         ctx_, index, lock_held, /* isVariantType unused */ false,
@@ -269,13 +289,11 @@ Tensor& OpKernelContext::mutable_input(int index, bool lock_held) {
     for (auto j = 0; j < dims; ++j) {
       shape.AddDim(TF_Dim(tensor, j));
     }
-    std::shared_ptr<Tensor> ptr = std::make_shared<Tensor>(
-        static_cast<DataType>(TF_TensorType(tensor)), shape, tensor);
-    inputs_->at(index) = std::move(ptr);
+    inputs_[index].emplace(static_cast<DataType>(TF_TensorType(tensor)), shape,
+                           tensor);
   }
 
-  ITEX_CHECK_NE(inputs_, nullptr);
-  return *inputs_->at(index);
+  return *inputs_[index];
 }
 
 Status OpKernelContext::output_list(StringPiece name, OpOutputList* list) {
@@ -292,12 +310,10 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
   TF_Tensor* output = TF_AllocateOutput(
       ctx_, index, static_cast<TF_DataType>(out_type), shape.dim_sizes().data(),
       shape.dims(), shape.num_elements() * DataTypeSize(out_type), status_);
-  if (outputs_[index] == nullptr) {
-    std::shared_ptr<Tensor> ptr = std::make_shared<Tensor>(
-        static_cast<DataType>(expected_output_dtype(index)), shape, output);
-    outputs_[index] = std::move(ptr);
+  if (!outputs_[index].has_value()) {
+    outputs_[index].emplace(out_type, shape, output);
   }
-  *tensor = outputs_[index].get();
+  *tensor = &*outputs_[index];
 
   return StatusFromTF_Status(status_);
 }
@@ -339,9 +355,8 @@ void OpKernelContext::set_output(int index, const Tensor& tensor) {
       << " Index out of range while setting output";
   TF_SetOutput(ctx_, index, tensor.GetTFTensor(), status_);
   ITEX_CHECK_EQ(TF_OK, TF_GetCode(status_)) << " Error while setting output";
-  ITEX_CHECK_EQ(outputs_[index], nullptr);
-  std::shared_ptr<Tensor> ptr = std::make_shared<Tensor>(tensor);
-  outputs_[index] = std::move(ptr);
+  ITEX_CHECK(!outputs_[index].has_value());
+  outputs_[index].emplace(tensor);
   return;
 }
 
@@ -605,7 +620,22 @@ const char* OpKernelConstruction::OpName() const {
 }
 
 OpKernel::OpKernel(OpKernelConstruction* context)
-    : op_name(context->OpName()) {}
+    : op_name(context->OpName()) {
+#ifdef INTEL_CPU_ONLY
+  if (context->HasAttr(kNumaNodeAttr)) {
+    int numa_node = port::kNUMANoAffinity;
+    if (context->GetAttr(kNumaNodeAttr, &numa_node).ok()) {
+      numa_device_ = GetNumaThreadPoolDevice(numa_node);
+      if (numa_device_ != nullptr) {
+        numa_node_ = numa_node;
+      } else {
+        ITEX_VLOG(1) << "NUMA node " << numa_node << " of " << op_name
+                     << " has no thread pool, using the default one.";
+      }
+    }
+  }
+#endif  // INTEL_CPU_ONLY
+}
 
 OpKernel::~OpKernel() {}
 
@@ -814,6 +844,82 @@ bool IsSyncExecEnabled() {
   return sync_exec_enabled;
 }
 
+absl::string_view GetOpProfileShapes(OpKernelContext* context) {
+  static thread_local string shapes;
+  shapes.clear();
+  for (int i = 0; i < context->num_inputs(); ++i) {
+    if (i > 0) shapes += ';';
+    const TensorShape& shape = context->input(i).shape();
+    shapes += '[';
+    for (int d = 0; d < shape.dims(); ++d) {
+      if (d > 0) shapes += ',';
+      absl::StrAppend(&shapes, shape.dim_size(d));
+    }
+    shapes += ']';
+  }
+  return shapes;
+}
+
+#ifdef INTEL_CPU_ONLY
+void RunWithOpProfiler(OpKernelContext* context, OpKernel* op,
+                       AsyncOpKernel::DoneCallback* callback) {
+  if (callback) {
+    // The context may be gone once the kernel is done, keep the shapes. The
+    // implementation is reported on this thread while `done` may run on
+    // another one, before or after ComputeAsync returns, so it is taken here
+    // once the kernel is dispatched and the later of the two records.
+    struct AsyncProfile {
+      mutex mu;
+      string op_type;
+      string shapes;
+      string implementation TF_GUARDED_BY(mu);
+      int64 elapsed TF_GUARDED_BY(mu) = -1;
+      bool dispatched TF_GUARDED_BY(mu) = false;
+    };
+    auto profile = std::make_shared<AsyncProfile>();
+    profile->op_type = string(op->type());
+    profile->shapes = string(GetOpProfileShapes(context));
+    uint64 start = EnvTime::NowNanos();
+    AsyncOpKernel::DoneCallback done = [profile, start,
+                                        callback = *callback]() {
+      const int64 elapsed = EnvTime::NowNanos() - start;
+      bool dispatched;
+      string implementation;
+      {
+        mutex_lock lock(&profile->mu);
+        profile->elapsed = elapsed;
+        dispatched = profile->dispatched;
+        if (dispatched) implementation = profile->implementation;
+      }
+      if (dispatched) {
+        RecordOpProfile(profile->op_type, profile->shapes, implementation,
+                        elapsed);
+      }
+      callback();
+    };
+    reinterpret_cast<AsyncOpKernel*>(op)->ComputeAsync(context, done);
+    string implementation = TakeOpProfileImplementation();
+    int64 elapsed;
+    {
+      mutex_lock lock(&profile->mu);
+      profile->implementation = implementation;
+      profile->dispatched = true;
+      elapsed = profile->elapsed;
+    }
+    if (elapsed >= 0) {
+      RecordOpProfile(profile->op_type, profile->shapes, implementation,
+                      elapsed);
+    }
+    return;
+  }
+
+  uint64 start = EnvTime::NowNanos();
+  op->Compute(context);
+  int64 elapsed = EnvTime::NowNanos() - start;
+  RecordOpProfile(op->type(), GetOpProfileShapes(context), elapsed);
+}
+#endif  // INTEL_CPU_ONLY
+
 namespace {
 
 // Label defaults to empty if not found in NodeDef.
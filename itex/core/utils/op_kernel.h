@@ -26,6 +26,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
 #include "itex/core/utils/allocator.h"
 #include "itex/core/utils/annotated_traceme.h"
 #include "itex/core/utils/control_flow.h"
@@ -35,6 +36,9 @@ limitations under the License.
 #include "itex/core/utils/logging.h"
 #include "itex/core/utils/mutex.h"
 #include "itex/core/utils/notification.h"
+#include "itex/core/utils/numa.h"
+#include "itex/core/utils/numa_thread_pool.h"
+#include "itex/core/utils/op_profiler.h"
 #include "itex/core/utils/plugin_tensor.h"
 #include "itex/core/utils/types.h"
 #include "protos/node_def.pb.h"
@@ -180,23 +184,19 @@ class OpKernelContext {
   explicit OpKernelContext(TF_OpKernelContext* ctx)
       : ctx_(ctx),
         outputs_(TF_NumOutputs(ctx_)),
-        status_(TF_NewStatus()),
+        status_(AcquireStatus()),
         device_(ctx_, status_),
         resource_mgr(nullptr) {}
 #else
   explicit OpKernelContext(TF_OpKernelContext* ctx)
       : ctx_(ctx),
         outputs_(TF_NumOutputs(ctx_)),
-        status_(TF_NewStatus()),
+        status_(AcquireStatus()),
         device_(ctx_, status_) {}
 #endif
 
   ~OpKernelContext() {
-    if (inputs_ != nullptr) {
-      delete inputs_;
-    }
-
-    TF_DeleteStatus(status_);
+    ReleaseStatus(status_);
     status_ = nullptr;
   }
 
@@ -218,7 +218,7 @@ class OpKernelContext {
 
   void* tensor_data(int index);
 
-  bool is_input_same(int index, std::vector<int64> shape);
+  bool is_input_same(int index, const std::vector<int64>& shape);
   int64_t step_id() const;
 
   //  Status input_list(StringPiece name, OpInputList* list);
@@ -337,10 +337,22 @@ class OpKernelContext {
   const Eigen::ThreadPoolDevice& eigen_cpu_device() const {
     // TODO(itex): CPU should get thread pool device from local device:
     // *device()->eigen_cpu_device();
-    // This helps to identity NUMA affinity.
+    // Until then, kernels of a NUMA-pinned AutoShard replica use the thread
+    // pool bound to their node, see set_numa_device().
+    if (numa_cpu_device_ != nullptr) return *numa_cpu_device_;
     return eigen_cpu_device_singleton();
   }
 
+  // Runs the CPU work of this kernel on `device`, the thread pool bound to
+  // NUMA node `node`, see OpKernel::numa_device().
+  void set_numa_device(int node, const Eigen::ThreadPoolDevice* device) {
+    numa_cpu_device_ = device;
+    numa_node_ = node;
+  }
+
+  // NUMA node the CPU work of this kernel runs on, kNUMANoAffinity if none.
+  int numa_node() const { return numa_node_; }
+
 #ifndef INTEL_CPU_ONLY
   const Eigen::GpuDevice& eigen_gpu_device() const {
     return device_.eigen_gpu_device_;
@@ -392,11 +404,18 @@ class OpKernelContext {
   OpKernelContext() = delete;
   OpKernelContext(const OpKernelContext&) = delete;
   const OpKernelContext& operator=(const OpKernelContext&) = delete;
+  // A context lives for one Compute, so the statuses are recycled through a
+  // small per-thread pool instead of a heap allocation per op.
+  static TF_Status* AcquireStatus();
+  static void ReleaseStatus(TF_Status* status);
+
   TF_OpKernelContext* ctx_;
   // We use single vector inputs_ to store all kinds of input tensors:
-  // normal/ref/resource
-  mutable gtl::InlinedVector<std::shared_ptr<Tensor>, 4>* inputs_ = nullptr;
-  gtl::InlinedVector<std::shared_ptr<Tensor>, 4> outputs_;
+  // normal/ref/resource. The wrappers are constructed in place on the first
+  // access and keep their TF_Tensor handle until the end of Compute. Sized
+  // once, so references returned by input() stay valid.
+  mutable gtl::InlinedVector<absl::optional<Tensor>, 4> inputs_;
+  gtl::InlinedVector<absl::optional<Tensor>, 4> outputs_;
   std::map<StringPiece, std::shared_ptr<Tensor>> inputsMap_;
   TF_Status* status_;
   class InternalDevice {
@@ -429,6 +448,9 @@ class OpKernelContext {
 #endif  // INTEL_CPU_ONLY
   };
   InternalDevice device_;
+  // Thread pool bound to the NUMA node of the kernel, if any.
+  const Eigen::ThreadPoolDevice* numa_cpu_device_ = nullptr;
+  int numa_node_ = port::kNUMANoAffinity;
 #ifndef INTEL_CPU_ONLY
   ResourceMgr* resource_mgr;
 #endif
@@ -591,6 +613,12 @@ class OpKernel {
 
   void set_type(absl::string_view type) { op_type = type; }
 
+  // NUMA node set by the `_numa_node` attr, kNUMANoAffinity if none or if
+  // the node has no dedicated thread pool (see GetNumaThreadPoolDevice).
+  int numa_node() const { return numa_node_; }
+  // Thread pool of numa_node(), resolved once at construction.
+  const Eigen::ThreadPoolDevice* numa_device() const { return numa_device_; }
+
   std::string ShapeTraceString(const OpKernelContext& ctx) const;
 
   std::string TraceString(const OpKernelContext& ctx) const;
@@ -598,6 +626,8 @@ class OpKernel {
  private:
   absl::string_view op_name;
   absl::string_view op_type;
+  int numa_node_ = port::kNUMANoAffinity;
+  const Eigen::ThreadPoolDevice* numa_device_ = nullptr;
 };
 
 class AsyncOpKernel : public OpKernel {
@@ -776,6 +806,16 @@ inline void RunWithSyncHandler(
 }
 #endif
 
+// Input shapes of `context` for RecordOpProfile(), e.g. "[32,64];[64,128]".
+// Valid until the next call on the same thread.
+absl::string_view GetOpProfileShapes(OpKernelContext* context);
+
+#ifdef INTEL_CPU_ONLY
+// Runs `op` and records its latency, see IsOpProfilerEnabled().
+void RunWithOpProfiler(OpKernelContext* context, OpKernel* op,
+                       AsyncOpKernel::DoneCallback* callback);
+#endif  // INTEL_CPU_ONLY
+
 inline void RunOrWaitUntilFinish(
     OpKernelContext* context, OpKernel* op,
     AsyncOpKernel::DoneCallback* callback = nullptr) {
@@ -806,6 +846,9 @@ inline void RunOrWaitUntilFinish(
     if (IsVerboseEnabled()) {
       ITEX_VLOG(0) << op->type() << "," << op->name() << "," << elapsed;
     }
+    if (IsOpProfilerEnabled()) {
+      RecordOpProfile(op->type(), GetOpProfileShapes(context), elapsed);
+    }
   } else {
     if (IsVerboseEnabled()) {
       auto start = std::chrono::steady_clock::now();
@@ -820,6 +863,13 @@ inline void RunOrWaitUntilFinish(
     }
   }
 #else
+  if (op->numa_device() != nullptr) {
+    context->set_numa_device(op->numa_node(), op->numa_device());
+  }
+  if (IsOpProfilerEnabled()) {
+    RunWithOpProfiler(context, op, callback);
+    return;
+  }
   if (callback) {
     reinterpret_cast<AsyncOpKernel*>(op)->ComputeAsync(context, *callback);
   } else {
@@ -0,0 +1,273 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/utils/op_profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <tuple>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "itex/core/utils/env.h"
+#include "itex/core/utils/env_var.h"
+#include "itex/core/utils/errors.h"
+#include "itex/core/utils/logging.h"
+#include "itex/core/utils/mutex.h"
+#include "itex/core/utils/stringprintf.h"
+
+namespace itex {
+
+namespace {
+
+// Latencies below 8ns have their own bucket, above they are split into 8
+// buckets per power of 2, up to 2^40ns.
+constexpr int kMaxLatencyLog2 = 40;
+constexpr int kNumBuckets = (kMaxLatencyLog2 - 2) * 8;
+
+int LatencyBucket(int64 nanos) {
+  if (nanos < 8) return std::max<int64>(nanos, 0);
+  int log2 = 63 - __builtin_clzll(static_cast<uint64>(nanos));
+  if (log2 >= kMaxLatencyLog2) return kNumBuckets - 1;
+  int sub_bucket = (nanos >> (log2 - 3)) & 7;
+  return (log2 - 2) * 8 + sub_bucket;
+}
+
+// Middle of the latencies of `bucket`.
+int64 LatencyOfBucket(int bucket) {
+  if (bucket < 8) return bucket;
+  int log2 = bucket / 8 + 2;
+  int64 lower = static_cast<int64>(8 + bucket % 8) << (log2 - 3);
+  int64 upper = static_cast<int64>(9 + bucket % 8) << (log2 - 3);
+  return (lower + upper) / 2;
+}
+
+// Aggregated executions of one key on one thread. Only written by the owner
+// thread, read by GetOpProfile() from any thread.
+struct OpStats {
+  OpStats(absl::string_view op_type, absl::string_view shapes,
+          absl::string_view implementation)
+      : op_type(op_type), shapes(shapes), implementation(implementation) {
+    for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+  }
+
+  const string op_type;
+  const string shapes;
+  const string implementation;
+  std::atomic<int64> count{0};
+  std::atomic<int64> total_ns{0};
+  std::atomic<uint32> buckets[kNumBuckets];
+};
+
+// The stats of all threads. Never freed so they outlive the threads and can
+// be dumped at exit.
+struct OpStatsRegistry {
+  mutex mu;
+  std::vector<std::unique_ptr<OpStats>> stats TF_GUARDED_BY(mu);
+};
+
+OpStatsRegistry* GetOpStatsRegistry() {
+  static OpStatsRegistry* registry = new OpStatsRegistry;
+  return registry;
+}
+
+struct ThreadOpProfile {
+  absl::flat_hash_map<string, OpStats*> stats;
+  // Reused so building the key doesn't allocate once warmed up.
+  string key;
+  string implementation;
+};
+
+ThreadOpProfile* GetThreadOpProfile() {
+  static thread_local ThreadOpProfile profile;
+  return &profile;
+}
+
+OpProfileXSpaceWriter* GetOpProfileXSpaceWriter() {
+  static OpProfileXSpaceWriter* writer = new OpProfileXSpaceWriter;
+  return writer;
+}
+
+void DumpOpProfileAtExit() {
+  string path;
+  ITEX_CHECK_OK(ReadStringFromEnvVar("ITEX_OP_PROFILER_OUTPUT", "", &path));
+  if (path.empty()) {
+    ITEX_LOG(INFO) << "ITEX op profile:\n"
+                   << FormatOpProfileTable(GetOpProfile());
+    return;
+  }
+  Status s = DumpOpProfile(path);
+  if (!s.ok()) {
+    ITEX_LOG(WARNING) << "Failed to write the op profile to " << path << ": "
+                      << s;
+  }
+}
+
+}  // namespace
+
+bool IsOpProfilerEnabled() {
+  static std::once_flag profiler_flag;
+  static bool profiler_enabled;
+  std::call_once(profiler_flag, [&]() {
+    ITEX_CHECK_OK(
+        ReadBoolFromEnvVar("ITEX_OP_PROFILER", false, &profiler_enabled));
+    if (profiler_enabled) std::atexit(DumpOpProfileAtExit);
+  });
+
+  return profiler_enabled;
+}
+
+void RecordOpProfile(absl::string_view op_type, absl::string_view shapes,
+                     int64 nanos) {
+  ThreadOpProfile* profile = GetThreadOpProfile();
+  RecordOpProfile(op_type, shapes, profile->implementation, nanos);
+  profile->implementation.clear();
+}
+
+void RecordOpProfile(absl::string_view op_type, absl::string_view shapes,
+                     absl::string_view implementation, int64 nanos) {
+  ThreadOpProfile* profile = GetThreadOpProfile();
+  string& key = profile->key;
+  key.clear();
+  absl::StrAppend(&key, op_type, "\n", shapes, "\n", implementation);
+
+  OpStats* stats;
+  auto it = profile->stats.find(key);
+  if (it != profile->stats.end()) {
+    stats = it->second;
+  } else {
+    auto new_stats =
+        std::make_unique<OpStats>(op_type, shapes, implementation);
+    stats = new_stats.get();
+    OpStatsRegistry* registry = GetOpStatsRegistry();
+    {
+      mutex_lock lock(&registry->mu);
+      registry->stats.push_back(std::move(new_stats));
+    }
+    profile->stats.emplace(key, stats);
+  }
+
+  stats->count.fetch_add(1, std::memory_order_relaxed);
+  stats->total_ns.fetch_add(nanos, std::memory_order_relaxed);
+  stats->buckets[LatencyBucket(nanos)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void SetOpProfileImplementation(absl::string_view implementation) {
+  if (!IsOpProfilerEnabled()) return;
+  GetThreadOpProfile()->implementation.assign(implementation.data(),
+                                              implementation.size());
+}
+
+string TakeOpProfileImplementation() {
+  string implementation;
+  GetThreadOpProfile()->implementation.swap(implementation);
+  return implementation;
+}
+
+std::vector<OpProfileEntry> GetOpProfile() {
+  struct Merged {
+    OpProfileEntry entry;
+    std::vector<int64> buckets = std::vector<int64>(kNumBuckets);
+  };
+  std::map<std::tuple<string, string, string>, Merged> merged;
+  OpStatsRegistry* registry = GetOpStatsRegistry();
+  {
+    mutex_lock lock(&registry->mu);
+    for (const auto& stats : registry->stats) {
+      Merged& m = merged[std::make_tuple(stats->op_type, stats->shapes,
+                                         stats->implementation)];
+      m.entry.count += stats->count.load(std::memory_order_relaxed);
+      m.entry.total_ns += stats->total_ns.load(std::memory_order_relaxed);
+      for (int i = 0; i < kNumBuckets; ++i) {
+        m.buckets[i] += stats->buckets[i].load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::vector<OpProfileEntry> profile;
+  for (auto& [key, m] : merged) {
+    if (m.entry.count == 0) continue;
+    OpProfileEntry& entry = m.entry;
+    std::tie(entry.op_type, entry.shapes, entry.implementation) = key;
+    // The count may be ahead of the buckets if a thread is recording.
+    int64 num_samples = 0;
+    for (int64 n : m.buckets) num_samples += n;
+    int64 seen = 0;
+    for (int i = 0; i < kNumBuckets; ++i) {
+      seen += m.buckets[i];
+      if (entry.p50_ns == 0 && seen * 2 >= num_samples) {
+        entry.p50_ns = LatencyOfBucket(i);
+      }
+      if (seen * 100 >= num_samples * 99) {
+        entry.p99_ns = LatencyOfBucket(i);
+        break;
+      }
+    }
+    profile.push_back(std::move(entry));
+  }
+  std::sort(profile.begin(), profile.end(),
+            [](const OpProfileEntry& a, const OpProfileEntry& b) {
+              return a.total_ns > b.total_ns;
+            });
+  return profile;
+}
+
+string FormatOpProfileTable(const std::vector<OpProfileEntry>& profile) {
+  int64 total_ns = 0;
+  for (const auto& entry : profile) total_ns += entry.total_ns;
+
+  string table = strings::Printf(
+      "%-32s %10s %12s %6s %10s %10s %10s  %-24s %s\n", "Op", "Count",
+      "Total(ms)", "%", "Avg(us)", "p50(us)", "p99(us)", "Implementation",
+      "Shapes");
+  for (const auto& entry : profile) {
+    strings::Appendf(
+        &table, "%-32s %10lld %12.3f %6.2f %10.2f %10.2f %10.2f  %-24s %s\n",
+        entry.op_type.c_str(), static_cast<long long>(entry.count),  // NOLINT
+        entry.total_ns / 1e6,
+        total_ns > 0 ? 100.0 * entry.total_ns / total_ns : 0.0,
+        entry.total_ns / 1e3 / entry.count, entry.p50_ns / 1e3,
+        entry.p99_ns / 1e3,
+        entry.implementation.empty() ? "-" : entry.implementation.c_str(),
+        entry.shapes.c_str());
+  }
+  return table;
+}
+
+Status DumpOpProfile(const string& path) {
+  std::vector<OpProfileEntry> profile = GetOpProfile();
+  if (absl::EndsWith(path, ".pb")) {
+    const OpProfileXSpaceWriter& writer = *GetOpProfileXSpaceWriter();
+    if (!writer) {
+      return errors::Unimplemented(
+          "No XSpace writer is linked, can't write the op profile to ", path);
+    }
+    return writer(profile, path);
+  }
+  return WriteStringToFile(Env::Default(), path,
+                           FormatOpProfileTable(profile));
+}
+
+void RegisterOpProfileXSpaceWriter(OpProfileXSpaceWriter writer) {
+  *GetOpProfileXSpaceWriter() = std::move(writer);
+}
+
+}  // namespace itex
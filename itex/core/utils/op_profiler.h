@@ -0,0 +1,88 @@
+/* Copyright (c) 2023 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_UTILS_OP_PROFILER_H_
+#define ITEX_CORE_UTILS_OP_PROFILER_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "itex/core/utils/status.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+
+// Per-op latency profiler, enabled with `ITEX_OP_PROFILER=1`.
+//
+// Every kernel execution is aggregated by (op type, input shapes, oneDNN
+// implementation) into count, total, p50 and p99 latency. Kernels record into
+// buffers owned by their thread with relaxed atomics only; a lock is taken
+// the first time a thread sees a key. The profile is written at exit to
+// `ITEX_OP_PROFILER_OUTPUT`, as an XSpace if the path ends with ".pb" and as a
+// text table otherwise, or logged if unset. DumpOpProfile() writes it on
+// demand.
+bool IsOpProfilerEnabled();
+
+struct OpProfileEntry {
+  string op_type;
+  // Input shapes separated by ';', e.g. "[32,64];[64,128]".
+  string shapes;
+  // oneDNN implementation reported by the kernel, e.g. "brg:avx512_core".
+  string implementation;
+  int64 count = 0;
+  int64 total_ns = 0;
+  // Percentiles from a histogram with 8 buckets per power of 2, so within
+  // ~6% of the exact value.
+  int64 p50_ns = 0;
+  int64 p99_ns = 0;
+};
+
+// Records one execution of `op_type` with input `shapes` taking `nanos`, with
+// the implementation reported on this thread since the last record.
+void RecordOpProfile(absl::string_view op_type, absl::string_view shapes,
+                     int64 nanos);
+
+// Same as above with an explicit `implementation`, for kernels finishing on
+// another thread than the one they were computed on.
+void RecordOpProfile(absl::string_view op_type, absl::string_view shapes,
+                     absl::string_view implementation, int64 nanos);
+
+// Returns and clears the implementation reported on this thread.
+string TakeOpProfileImplementation();
+
+// Reports the oneDNN implementation (primitive_desc::impl_info_str()) of the
+// op running on this thread. Cheap no-op when the profiler is disabled.
+void SetOpProfileImplementation(absl::string_view implementation);
+
+// Returns the aggregated profile of all threads, by decreasing total time.
+std::vector<OpProfileEntry> GetOpProfile();
+
+// Formats `profile` as a fixed width table.
+string FormatOpProfileTable(const std::vector<OpProfileEntry>& profile);
+
+// Writes the current profile to `path`, see IsOpProfilerEnabled().
+Status DumpOpProfile(const string& path);
+
+// Writes a profile as a serialized XSpace. Registered by the XPlane exporter
+// library, which depends on the profiler utils.
+using OpProfileXSpaceWriter = std::function<Status(
+    const std::vector<OpProfileEntry>& profile, const string& path)>;
+void RegisterOpProfileXSpaceWriter(OpProfileXSpaceWriter writer);
+
+}  // namespace itex
+
+#endif  // ITEX_CORE_UTILS_OP_PROFILER_H_
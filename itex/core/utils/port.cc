@@ -27,7 +27,10 @@ limitations under the License.
 #include <cpuid.h>
 #endif
 
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
+#include <string>
 #if defined(__FreeBSD__)
 #include <thread>  // NOLINT(build/c++11)
 #endif
@@ -158,6 +161,41 @@ hwloc_obj_t GetHWLocTypeIndex(hwloc_obj_type_t tp, int index) {
   return obj;
 }
 }  // namespace
+#elif defined(__linux__)
+namespace {
+// Without hwloc, the NUMA topology is read from sysfs, where the CPUs of
+// each node are listed as ranges, e.g. "0-27,56-83".
+bool ReadNodeCpuSet(int node, cpu_set_t* cpuset) {
+  if (node < 0) return false;
+  const std::string path = "/sys/devices/system/node/node" +
+                           std::to_string(node) + "/cpulist";
+  FILE* file = fopen(path.c_str(), "r");
+  if (file == nullptr) return false;
+  char buf[4096];
+  const bool read = fgets(buf, sizeof(buf), file) != nullptr;
+  fclose(file);
+  if (!read) return false;
+
+  CPU_ZERO(cpuset);
+  const char* p = buf;
+  while (*p != '\0' && *p != '\n') {
+    char* end = nullptr;
+    const int first = strtol(p, &end, 10);
+    if (end == p) return false;
+    int last = first;
+    p = end;
+    if (*p == '-') {
+      last = strtol(p + 1, &end, 10);
+      p = end;
+    }
+    for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+      CPU_SET(cpu, cpuset);
+    }
+    if (*p == ',') ++p;
+  }
+  return CPU_COUNT(cpuset) > 0;
+}
+}  // namespace
 #endif  // TENSORFLOW_USE_NUMA
 
 bool NUMAEnabled() { return (NUMANumNodes() > 1); }
@@ -171,6 +209,14 @@ int NUMANumNodes() {
   } else {
     return 1;
   }
+#elif defined(__linux__)
+  static const int num_numanodes = []() {
+    int num_nodes = 0;
+    cpu_set_t cpuset;
+    while (ReadNodeCpuSet(num_nodes, &cpuset)) ++num_nodes;
+    return std::max(1, num_nodes);
+  }();
+  return num_numanodes;
 #else
   return 1;
 #endif  // TENSORFLOW_USE_NUMA
@@ -188,6 +234,11 @@ void NUMASetThreadNodeAffinity(int node) {
       LOG(ERROR) << "Could not find hwloc NUMA node " << node;
     }
   }
+#elif defined(__linux__)
+  cpu_set_t cpuset;
+  if (ReadNodeCpuSet(node, &cpuset)) {
+    sched_setaffinity(0, sizeof(cpu_set_t), &cpuset);
+  }
 #endif  // TENSORFLOW_USE_NUMA
 }
 
@@ -210,6 +261,20 @@ int NUMAGetThreadNodeAffinity() {
     }
     hwloc_bitmap_free(thread_cpuset);
   }
+#elif defined(__linux__)
+  cpu_set_t thread_cpuset;
+  if (sched_getaffinity(0, sizeof(cpu_set_t), &thread_cpuset) == 0) {
+    cpu_set_t node_cpuset;
+    cpu_set_t common;
+    for (int node = 0; node < NUMANumNodes(); ++node) {
+      if (!ReadNodeCpuSet(node, &node_cpuset)) continue;
+      CPU_AND(&common, &thread_cpuset, &node_cpuset);
+      if (CPU_EQUAL(&common, &thread_cpuset)) {
+        node_index = node;
+        break;
+      }
+    }
+  }
 #endif  // TENSORFLOW_USE_NUMA
   return node_index;
 }
@@ -24,3 +24,5 @@ from intel_extension_for_tensorflow.python.ops.rms_norm import RMSNormalization
 from intel_extension_for_tensorflow.python.ops.recurrent import ItexLSTM
 from intel_extension_for_tensorflow.python.ops.mlp import FusedDenseBiasAddGelu
 from intel_extension_for_tensorflow.python.ops.multi_head_attention import scaled_dot_product_attention
+from intel_extension_for_tensorflow.python.ops.multi_head_attention import scaled_dot_product_attention_varlen
+from intel_extension_for_tensorflow.python.ops.multi_head_attention import scaled_dot_product_attention_kv_cache
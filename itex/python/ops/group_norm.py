@@ -15,6 +15,7 @@
 """Group normalization layer"""
 
 import tensorflow.compat.v2 as tf
+from intel_extension_for_tensorflow.python.device import get_backend
 from intel_extension_for_tensorflow.python.ops.load_ops_library import load_ops_library
 from tensorflow.python.framework import config
 from tensorflow.python.framework import dtypes
@@ -125,9 +126,11 @@ class GroupNormalization(Layer):
         self.axis = (self.axis + rank) % rank
         self.use_gpu = config.list_logical_devices('XPU')
         
-        # fused_group_norm only support GPU backend and NHWC and axis=-1 currently
+        # fused_group_norm only support XPU and the CPU build, NHWC and axis=-1
+        # currently
         # TODO(itex): support channel first and rank==any
-        self.use_fused_group_norm = self.use_gpu and (rank == 4) and (self.axis == rank - 1)
+        has_fused_kernel = self.use_gpu or get_backend() == b"CPU"
+        self.use_fused_group_norm = has_fused_kernel and (rank == 4) and (self.axis == rank - 1)
 
         dim = input_shape[self.axis]
         if dim is None:
@@ -75,8 +75,10 @@ def scaled_dot_product_attention(query,
 
         Args:
             query: Projected query `Tensor` of shape `(B, N, F, head_size)`.
-            key: Projected key `Tensor` of shape `(B, N, T, head_size)`.
-            value: Projected value `Tensor` of shape `(B, N, T, head_size)`.
+            key: Projected key `Tensor` of shape `(B, N_kv, T, head_size)`. N_kv
+                may be smaller than N for grouped-query / multi-query attention,
+                as long as N is a multiple of N_kv.
+            value: Projected value `Tensor` of shape `(B, N_kv, T, head_size)`.
             atten_mask (optinal Tensor): a boolean mask of shape `(B, F, T)`, that prevents
                 attention to certain positions. It is generally not needed if
                 the `query` and `value` (and/or `key`) are masked.
@@ -92,18 +94,29 @@ def scaled_dot_product_attention(query,
     q_seq_len = query.shape[2]
     head_size = query.shape[3]
     use_xpu = config.list_logical_devices('XPU')
-    # If run on cpu, fast sdp kernel only support inference. If run on xpu, fmha can properly run in the forward kernel,
-    # but in the backward kernel, it can be only available when the q_seq_len <= 512 and head_size <= 128.
-    can_use_fast_sdp = (not use_xpu and not is_training) or \
+    num_heads = query.shape[1]
+    num_kv_heads = key.shape[1]
+    use_gqa = num_kv_heads is not None and num_heads is not None and \
+              num_kv_heads != num_heads
+    # If run on cpu, fast sdp kernel supports float and bfloat16 inference and training without dropout.
+    # If run on xpu, fmha can properly run in the forward kernel, but in the backward kernel, it can be
+    # only available when the q_seq_len <= 512 and head_size <= 128.
+    can_use_fast_sdp = (not use_xpu and (query.dtype == tf.float32 or query.dtype == tf.bfloat16) and \
+                        (not is_training or dropout_p == 0.0)) or \
                         (use_xpu and is_xehpc() and \
                         (query.dtype == tf.bfloat16 or query.dtype == tf.float16) and \
-                        is_causal == False and \
+                        is_causal == False and not use_gqa and \
                         (not is_training or (q_seq_len <= 512 and head_size <= 128)))
 
     def sdp():
         i_dtype = query.dtype
-        
-        atten_scores = tf.matmul(query, key, transpose_b=True)
+        key_, value_ = key, value
+        if use_gqa:
+            # Share every key/value head with its group of query heads.
+            key_ = tf.repeat(key, num_heads // num_kv_heads, axis=1)
+            value_ = tf.repeat(value, num_heads // num_kv_heads, axis=1)
+
+        atten_scores = tf.matmul(query, key_, transpose_b=True)
         head_size = query.shape[3]
         head_scale = 1.0 / tf.sqrt(float(head_size))
         atten_scores = tf.multiply(atten_scores, tf.cast(head_scale, i_dtype))
@@ -125,7 +138,7 @@ def scaled_dot_product_attention(query,
 
 
 # `atten_output` =[B, N, F, H]
-        atten_output = tf.matmul(atten_probs, value)
+        atten_output = tf.matmul(atten_probs, value_)
 
 # `output` =[B, F, N, H]
         output  = tf.transpose(a=atten_output, perm=[0, 2, 1, 3])  
@@ -159,7 +172,19 @@ def scaled_dot_product_attention(query,
                 atten_mask=actual_atten_mask, 
                 use_mask=use_mask,
                 use_causal=False,
-                is_inference=True)
+                is_inference=True,
+                num_kv_heads=num_kv_heads if use_gqa else 0)
+        elif not use_xpu:
+            # The backward recomputes the scores blockwise from the saved
+            # log-sum-exp instead of keeping the attention probabilities.
+            output, _ = load_ops_library.scaled_dot_product_attention_flash(
+                query=query,
+                key=key,
+                value=value,
+                atten_mask=actual_atten_mask,
+                use_mask=use_mask,
+                use_causal=False,
+                num_kv_heads=num_kv_heads if use_gqa else 0)
         else:
             output, atten, atten_dp = load_ops_library.scaled_dot_product_attention(
                 query=query, 
@@ -176,4 +201,90 @@ def scaled_dot_product_attention(query,
         output = fast_sdp()
     else:
         output = sdp()      
-    return output
\ No newline at end of file
+    return output
+
+
+def scaled_dot_product_attention_varlen(query,
+                                        key,
+                                        value,
+                                        cu_seqlens_q,
+                                        cu_seqlens_k,
+                                        is_causal=False):
+    """Applies Dot-product attention to a packed batch of variable-length sequences.
+
+        Sequences are concatenated along the first axis instead of being padded to
+        the longest one, so no compute is spent on padding. Only supported on CPU.
+
+        Args:
+            query: Packed query `Tensor` of shape `(total_q, N, head_size)`.
+            key: Packed key `Tensor` of shape `(total_k, N_kv, head_size)`, N must be
+                a multiple of N_kv.
+            value: Packed value `Tensor` of shape `(total_k, N_kv, head_size)`.
+            cu_seqlens_q: int32 `Tensor` of shape `(B + 1,)`, sequence `b` owns query
+                rows `[cu_seqlens_q[b], cu_seqlens_q[b + 1])`.
+            cu_seqlens_k: int32 `Tensor` of shape `(B + 1,)`, same for key/value.
+            is_causal (bool): If true, applies causal masking aligned to the end of
+                every sequence.
+
+        Returns:
+          atten_output: Packed outputs of shape `(total_q, N, head_size)`.
+    """
+    num_kv_heads = key.shape[1]
+    return load_ops_library.scaled_dot_product_attention_var_len_inference(
+        query=query,
+        key=key,
+        value=value,
+        cu_seqlens_q=tf.cast(cu_seqlens_q, tf.int32),
+        cu_seqlens_k=tf.cast(cu_seqlens_k, tf.int32),
+        use_causal=is_causal,
+        num_kv_heads=num_kv_heads if num_kv_heads is not None else 0)
+
+def scaled_dot_product_attention_kv_cache(query,
+                                          key,
+                                          value,
+                                          key_cache,
+                                          value_cache,
+                                          cache_len,
+                                          atten_mask=None,
+                                          is_causal=False):
+    """Applies Dot-product attention for one decoding step with a preallocated KV cache.
+
+        The new key/value are written into the caches at row `cache_len` and the
+        query attends to the first `cache_len + T` rows. When the cache has room for
+        the new step and its buffer isn't shared, the cache is updated in place, so a
+        step only copies the new rows. Only supported on CPU.
+
+        Args:
+            query: Projected query `Tensor` of shape `(B, N, F, head_size)`.
+            key: Key of the current step, `Tensor` of shape `(B, N_kv, T, head_size)`.
+            value: Value of the current step, `Tensor` of shape `(B, N_kv, T, head_size)`.
+            key_cache: Key cache `Tensor` of shape `(B, N_kv, capacity, head_size)`.
+            value_cache: Value cache `Tensor` of shape `(B, N_kv, capacity, head_size)`.
+            cache_len: int32 scalar, the number of valid rows in the caches. A
+                negative value means the whole cache is valid, the caches then grow
+                like a concat on the sequence axis.
+            atten_mask (optional Tensor): additive mask of shape
+                `(B, 1, F, cache_len + T)`.
+            is_causal (bool): If true, applies causal masking aligned to the end of
+                the valid keys.
+
+        Returns:
+          A tuple `(atten_output, key_cache, value_cache)`, the output of shape
+          `(B, F, N, head_size)` and the updated caches.
+    """
+    num_heads = query.shape[1]
+    num_kv_heads = key.shape[1]
+    use_gqa = num_kv_heads is not None and num_heads is not None and \
+              num_kv_heads != num_heads
+    use_mask = atten_mask is not None
+    return load_ops_library.scaled_dot_product_attention_kv_cache_inference(
+        query=query,
+        key=key,
+        value=value,
+        key_cache=key_cache,
+        value_cache=value_cache,
+        cache_len=tf.cast(cache_len, tf.int32),
+        atten_mask=atten_mask if use_mask else 0,
+        use_mask=use_mask,
+        use_causal=is_causal,
+        num_kv_heads=num_kv_heads if use_gqa else 0)
@@ -108,6 +108,21 @@ def _scaled_dot_product_attention_grad(op, *grad):
       dropout_prob=op.get_attr("dropout_prob"))
   return (dq, dk, dv, None, None)
 
+@ops.RegisterGradient("ScaledDotProductAttentionFlash")
+def _scaled_dot_product_attention_flash_grad(op, *grad):
+  dq, dk, dv = load_ops_library.scaled_dot_product_attention_flash_grad(
+      query=op.inputs[0],
+      key=op.inputs[1],
+      value=op.inputs[2],
+      atten_mask=op.inputs[3],
+      output=op.outputs[0],
+      softmax_lse=op.outputs[1],
+      output_backprop=grad[0],
+      use_mask=op.get_attr("use_mask"),
+      use_causal=op.get_attr("use_causal"),
+      num_kv_heads=op.get_attr("num_kv_heads"))
+  return (dq, dk, dv, None)
+
       
 @ops.RegisterGradient("FusedDenseBiasAddGelu")
 def _itex_fused_dense_bias_add_gelu_grad(op, *grad):
@@ -122,3 +137,33 @@ def _itex_fused_dense_bias_add_gelu_grad(op, *grad):
   dweights = math_ops.matmul(feature, dgelu, transpose_a=True)
   dfeature = math_ops.matmul(dgelu, weights, transpose_b=True)
   return dfeature, dweights, dbias
+
+@ops.RegisterGradient("QKRotaryPositionalEmbedding")
+def _qk_rotary_positional_embedding_grad(op, *grad):
+  # The op is linear in query and key, so the gradient is the transposed
+  # rotation: dx = dy * cos + rotate(dy * sin), where rotate maps v[2i + 1] to
+  # 2i and -v[2i] to 2i + 1. The pass-through part takes dy as is. Inputs may
+  # be [batch, length, heads * head_dim], so dy is viewed as 4-D first.
+  rotary_dim = op.get_attr("rotary_dim")
+  num_heads = op.get_attr("num_attention_heads")
+  head_dim = op.get_attr("head_dim")
+  x_shape = array_ops.shape(op.inputs[0])
+  rotary_shape = array_ops.stack(
+      (array_ops.shape(op.inputs[2])[0], x_shape[1], 1, rotary_dim))
+  sin = array_ops.reshape(op.inputs[2], rotary_shape)
+  cos = array_ops.reshape(op.inputs[3], rotary_shape)
+
+  def _rotary_grad(x, dy):
+    dy = array_ops.reshape(
+        dy, array_ops.stack((x_shape[0], x_shape[1], num_heads, head_dim)))
+    dy_rot = dy[:, :, :, :rotary_dim]
+    dy_sin = dy_rot * sin
+    dy_sin = array_ops.reshape(
+        array_ops.stack((dy_sin[:, :, :, 1::2], -dy_sin[:, :, :, ::2]),
+                        axis=-1), array_ops.shape(dy_rot))
+    dx = array_ops.concat((dy_rot * cos + dy_sin, dy[:, :, :, rotary_dim:]),
+                          axis=-1)
+    return array_ops.reshape(dx, array_ops.shape(x))
+
+  return (_rotary_grad(op.inputs[0], grad[0]),
+          _rotary_grad(op.inputs[1], grad[1]), None, None)
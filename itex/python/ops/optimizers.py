@@ -21,11 +21,36 @@ from __future__ import print_function
 import re
 import warnings
 import tensorflow as tf
+from intel_extension_for_tensorflow.python.device import get_backend
 from intel_extension_for_tensorflow.python.ops.load_ops_library import load_ops_library
 from keras.src.optimizers import optimizer as kerasoptimizer
 from keras.src.optimizers import utils as optimizer_utils
 from tensorflow.python.ops import math_ops
 
+def _use_multi_tensor_apply(optimizer, grads_and_vars):
+    """Returns whether the multi-tensor op can update all the variables.
+
+    The CPU backend updates all the variables of a step with one op instead
+    of one op per variable. It requires dense gradients and resource variables
+    of the same dtype, outside of a distribution strategy. The op bypasses
+    `_internal_apply_gradients`, so optimizers using EMA or XLA keep the
+    per-variable path.
+    """
+    if get_backend() != b"CPU" or tf.distribute.has_strategy():
+        return False
+    if optimizer.use_ema or optimizer.jit_compile:
+        return False
+    dtype = grads_and_vars[0][1].dtype
+    if dtype not in (tf.float32, tf.bfloat16):
+        return False
+    for grad, variable in grads_and_vars:
+        if isinstance(grad, tf.IndexedSlices) or variable.dtype != dtype:
+            return False
+        if not hasattr(variable, "handle"):
+            return False
+    return True
+
+
 class AdamWithWeightDecayOptimizer(kerasoptimizer.Optimizer):
     r"""Optimizer that implements the AdamW algorithm.
 
@@ -228,6 +253,40 @@ class AdamWithWeightDecayOptimizer(kerasoptimizer.Optimizer):
                 use_locking=False,
                 use_amsgrad=self.amsgrad)
 
+    def _multi_tensor_apply_gradients(self, grads_and_vars):
+        """Updates all the variables with one multi-tensor op."""
+        grads, variables = zip(*grads_and_vars)
+        dtype = variables[0].dtype
+        local_step = tf.cast(self.iterations + 1, dtype)
+        m, v, v_hat = [], [], []
+        for variable in variables:
+            index = self._index_dict[self._var_key(variable)]
+            m.append(self._momentums[index].handle)
+            v.append(self._velocities[index].handle)
+            if self.amsgrad:
+                v_hat.append(self._velocity_hats[index].handle)
+            else:
+                v_hat.append(v[-1])  # just a placeholder
+        load_ops_library.itex_resource_multi_tensor_apply_adam_with_weight_decay(
+            [variable.handle for variable in variables],
+            m,
+            v,
+            v_hat,
+            list(grads),
+            tf.pow(tf.cast(self.beta_1, dtype), local_step),
+            tf.pow(tf.cast(self.beta_2, dtype), local_step),
+            tf.cast(self.learning_rate, dtype),
+            math_ops.cast(self.beta_1, dtype),
+            math_ops.cast(self.beta_2, dtype),
+            math_ops.cast(self.epsilon, dtype),
+            math_ops.cast(self.weight_decay, dtype),
+            use_locking=False,
+            use_amsgrad=self.amsgrad,
+            use_weight_decay=[
+                self._use_weight_decay(variable) for variable in variables
+            ])
+        return self.iterations.assign_add(1)
+
     def apply_gradients(self, grads_and_vars, name=None):
         """Apply gradients to variables.
 
@@ -268,7 +327,10 @@ class AdamWithWeightDecayOptimizer(kerasoptimizer.Optimizer):
             grads = self._deduplicate_sparse_grad(grads)
             # self._apply_weight_decay(trainable_variables) # when dense, calculate in adamw kernel
             grads_and_vars = list(zip(grads, trainable_variables))
-            iteration = self._internal_apply_gradients(grads_and_vars)
+            if _use_multi_tensor_apply(self, grads_and_vars):
+                iteration = self._multi_tensor_apply_gradients(grads_and_vars)
+            else:
+                iteration = self._internal_apply_gradients(grads_and_vars)
 
             # Apply variable constraints after applying gradients.
             for variable in trainable_variables:
@@ -541,6 +603,43 @@ class LAMBOptimizer(kerasoptimizer.Optimizer):
                 return False
         return True
 
+    def _multi_tensor_apply_gradients(self, grads_and_vars):
+        """Updates all the variables with one multi-tensor op."""
+        grads, variables = zip(*grads_and_vars)
+        dtype = variables[0].dtype
+        local_step = tf.cast(self.iterations + 1, dtype)
+        m, v, v_hat = [], [], []
+        for variable in variables:
+            index = self._index_dict[self._var_key(variable)]
+            m.append(self._momentums[index].handle)
+            v.append(self._velocities[index].handle)
+            if self.amsgrad:
+                v_hat.append(self._velocity_hats[index].handle)
+            else:
+                v_hat.append(v[-1])  # just a placeholder
+        load_ops_library.itex_resource_multi_tensor_apply_lamb(
+            [variable.handle for variable in variables],
+            m,
+            v,
+            v_hat,
+            list(grads),
+            tf.pow(tf.cast(self.beta_1, dtype), local_step),
+            tf.pow(tf.cast(self.beta_2, dtype), local_step),
+            tf.cast(self.learning_rate, dtype),
+            math_ops.cast(self.beta_1, dtype),
+            math_ops.cast(self.beta_2, dtype),
+            math_ops.cast(self.epsilon, dtype),
+            math_ops.cast(self.weight_decay, dtype),
+            use_locking=False,
+            use_amsgrad=self.amsgrad,
+            use_weight_decay=[
+                self._use_weight_decay(variable) for variable in variables
+            ],
+            use_lamb=[
+                self._use_layer_adaptation(variable) for variable in variables
+            ])
+        return self.iterations.assign_add(1)
+
     def apply_gradients(self, grads_and_vars, name=None):
         """Apply gradients to variables.
 
@@ -581,7 +680,10 @@ class LAMBOptimizer(kerasoptimizer.Optimizer):
             grads = self._deduplicate_sparse_grad(grads)
             # self._apply_weight_decay(trainable_variables) # when dense, calculate in adamw kernel
             grads_and_vars = list(zip(grads, trainable_variables))
-            iteration = self._internal_apply_gradients(grads_and_vars)
+            if _use_multi_tensor_apply(self, grads_and_vars):
+                iteration = self._multi_tensor_apply_gradients(grads_and_vars)
+            else:
+                iteration = self._internal_apply_gradients(grads_and_vars)
 
             # Apply variable constraints after applying gradients.
             for variable in trainable_variables:
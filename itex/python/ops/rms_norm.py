@@ -25,6 +25,7 @@ from __future__ import division
 from __future__ import print_function
 
 import tensorflow as tf
+from intel_extension_for_tensorflow.python.device import get_backend
 from intel_extension_for_tensorflow.python.ops.load_ops_library import load_ops_library
 from tensorflow.python import keras
 from tensorflow.python.framework import dtypes
@@ -239,8 +240,9 @@ class RMSNormalization(Layer):
       self._beta_const = K.constant(
           0.0, dtype=self._param_dtype, shape=param_shape)
 
-    # fused_rms_norm only support XPU backend currently
-    self.use_fused_rms_norm = tf.config.list_logical_devices('XPU')
+    # fused_rms_norm is supported on XPU and in the CPU build.
+    self.use_fused_rms_norm = bool(tf.config.list_logical_devices('XPU')) or \
+        get_backend() == b"CPU"
     self.built = True
 
   def call(self, inputs, training=False): # pylint: disable=arguments-differ
@@ -265,7 +267,7 @@ class RMSNormalization(Layer):
     inputs = array_ops.reshape(inputs, squeezed_shape)
     # Compute RMS normalization.
     if self.use_fused_rms_norm and not training:
-        # fused kernel only support inference on xpu.
+        # fused kernel only support inference.
         outputs = load_ops_library.itex_rms_norm(
                                     inputs,
                                     gamma,
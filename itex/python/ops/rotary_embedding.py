@@ -21,6 +21,7 @@ import tensorflow as tf
 from tensorflow.python import keras
 from tensorflow.python.framework import ops
 from typing import List, Optional, Union
+from intel_extension_for_tensorflow.python.device import get_backend
 from intel_extension_for_tensorflow.python.ops.load_ops_library import load_ops_library
 from tensorflow.python.framework import config
 
@@ -57,7 +58,8 @@ def apply_rotary_pos_emb(tensor,sin,cos):
 
 @keras.utils.generic_utils.register_keras_serializable(package="Itex")
 def qk_rotary_positional_embedding(q,k,sin,cos, rotary_dim=64,num_attention_heads=16,head_dim=256, name=None):
-  if config.list_logical_devices('XPU'):
+  # The fused op is supported on XPU and in the CPU build.
+  if config.list_logical_devices('XPU') or get_backend() == b"CPU":
     with ops.name_scope(name, "qk_rotary_positional_embedding", [q,k,sin,cos]):
       q = ops.convert_to_tensor(q, name="query")
       k = ops.convert_to_tensor(k, name="key")
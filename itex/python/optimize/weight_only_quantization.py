@@ -0,0 +1,265 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Weight-only INT4/INT8 quantization of MatMul weights for CPU inference.
+
+The weights of MatMul nodes are rounded to INT4/INT8 with one scale (and
+zero point) per group of `group_size` input channels of every output
+channel. Activations stay in float/bfloat16, so no calibration data is
+needed. The MatMul nodes are replaced by _ITEXWeightOnlyQuantizedMatMul,
+which dequantizes the weight inside the GEMM.
+
+Usage:
+  from intel_extension_for_tensorflow.python.optimize import weight_only_quantization
+  weight_only_quantization.convert_saved_model(
+      "/path/to/float_model", "/path/to/int4_model", bits=4, group_size=128)
+"""
+
+import numpy as np
+import tensorflow as tf
+
+from tensorflow.core.framework import attr_value_pb2
+from tensorflow.core.framework import graph_pb2
+from tensorflow.core.framework import node_def_pb2
+from tensorflow.python.framework import convert_to_constants
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import tensor_util
+
+_QUANTIZED_MATMUL_OP = "_ITEXWeightOnlyQuantizedMatMul"
+
+
+def quantize_weight(weight, bits=4, group_size=128, symmetric=True):
+  """Quantizes a float [K, N] weight group-wise along K.
+
+  Args:
+    weight: 2D numpy array, [input channels, output channels].
+    bits: 4 or 8.
+    group_size: number of input channels sharing a scale and zero point.
+    symmetric: quantize around zero without zero points if True.
+
+  Returns:
+    (packed_weight, scales, zero_points) in the layout expected by
+    _ITEXWeightOnlyQuantizedMatMul. zero_points is None when symmetric.
+  """
+  if bits not in (4, 8):
+    raise ValueError("bits must be 4 or 8, got %d" % bits)
+  weight = np.asarray(weight, dtype=np.float32)
+  k, n = weight.shape
+  groups = (k + group_size - 1) // group_size
+  padded = np.zeros((groups * group_size, n), dtype=np.float32)
+  padded[:k] = weight
+  grouped = padded.reshape(groups, group_size, n)
+
+  q_max = 2 ** bits - 1
+  if symmetric:
+    # 4 bits values are stored unsigned around 8, 8 bits ones signed.
+    half = 2 ** (bits - 1) - 1
+    scales = np.abs(grouped).max(axis=1) / half
+    scales[scales == 0] = 1.0
+    offset = 8 if bits == 4 else 0
+    q = np.clip(np.round(grouped / scales[:, None, :]), -half, half) + offset
+    zero_points = None
+  else:
+    w_min = np.minimum(grouped.min(axis=1), 0.0)
+    w_max = np.maximum(grouped.max(axis=1), 0.0)
+    scales = (w_max - w_min) / q_max
+    scales[scales == 0] = 1.0
+    if bits == 4:
+      zero_points = np.clip(np.round(-w_min / scales), 0, q_max)
+      q = np.clip(np.round(grouped / scales[:, None, :]) +
+                  zero_points[:, None, :], 0, q_max)
+    else:
+      zero_points = np.clip(np.round(-w_min / scales) - 128, -128, 127)
+      q = np.clip(np.round(grouped / scales[:, None, :]) +
+                  zero_points[:, None, :], -128, 127)
+    zero_points = zero_points.astype(np.int8)
+
+  q = q.reshape(groups * group_size, n)[:k].astype(np.int32)
+  if bits == 4:
+    if k % 2:
+      q = np.concatenate([q, np.full((1, n), 8 if symmetric else 0)], axis=0)
+    packed = (q[0::2] & 0xF) | ((q[1::2] & 0xF) << 4)
+    packed = packed.astype(np.uint8).view(np.int8)
+  else:
+    packed = q.astype(np.int8)
+  return packed, scales.astype(np.float32), zero_points
+
+
+def _const_node(name, value, dtype, device):
+  node = node_def_pb2.NodeDef(name=name, op="Const", device=device)
+  node.attr["dtype"].CopyFrom(
+      attr_value_pb2.AttrValue(type=dtype.as_datatype_enum))
+  value = np.asarray(value).astype(dtype.as_numpy_dtype)
+  node.attr["value"].CopyFrom(attr_value_pb2.AttrValue(
+      tensor=tensor_util.make_tensor_proto(value, dtype=dtype)))
+  return node
+
+
+def _bool_attr(node, name):
+  return name in node.attr and node.attr[name].b
+
+
+def _node_name(tensor_name):
+  name = tensor_name[1:] if tensor_name.startswith("^") else tensor_name
+  return name.split(":")[0]
+
+
+def convert_graph_def(graph_def, bits=4, group_size=128, symmetric=True,
+                      min_weight_elements=4096):
+  """Rewrites the MatMul nodes of a frozen GraphDef with constant weights.
+
+  MatMul(a, Const) and MatMul(a, Const) + BiasAdd(Const), with float or
+  bfloat16 data type, are replaced by _ITEXWeightOnlyQuantizedMatMul. Weights
+  with fewer than `min_weight_elements` elements are kept in float.
+
+  Returns:
+    The converted GraphDef.
+  """
+  nodes = {node.name: node for node in graph_def.node}
+  consumers = {}
+  for node in graph_def.node:
+    for tensor in node.input:
+      consumers.setdefault(_node_name(tensor), []).append(node)
+
+  def const_input(tensor_name):
+    node = nodes.get(_node_name(tensor_name))
+    while node is not None and node.op == "Identity":
+      node = nodes.get(_node_name(node.input[0]))
+    if node is None or node.op != "Const":
+      return None
+    return tensor_util.MakeNdarray(node.attr["value"].tensor)
+
+  replaced = {}
+  removed = set()
+  for node in graph_def.node:
+    if node.op != "MatMul" or _bool_attr(node, "transpose_a"):
+      continue
+    dtype = dtypes.as_dtype(node.attr["T"].type)
+    if dtype not in (dtypes.float32, dtypes.bfloat16):
+      continue
+    weight = const_input(node.input[1])
+    if weight is None or weight.ndim != 2 or weight.size < min_weight_elements:
+      continue
+    weight = weight.astype(np.float32)
+    if _bool_attr(node, "transpose_b"):
+      weight = weight.T
+
+    # Fuse the bias if the MatMul only feeds a BiasAdd with constant bias.
+    bias = None
+    root = node
+    users = consumers.get(node.name, [])
+    if (len(users) == 1 and users[0].op == "BiasAdd" and
+        users[0].input[0] == node.name and
+        ("data_format" not in users[0].attr or
+         users[0].attr["data_format"].s == b"NHWC")):
+      bias = const_input(users[0].input[1])
+      if bias is not None:
+        root = users[0]
+        removed.add(node.name)
+
+    packed, scales, zero_points = quantize_weight(weight, bits, group_size,
+                                                  symmetric)
+    prefix = root.name + "/weight_only_quantized"
+    fused = node_def_pb2.NodeDef(name=root.name, op=_QUANTIZED_MATMUL_OP,
+                                 device=node.device)
+    fused.input.extend([
+        node.input[0], prefix + "/weight", prefix + "/scales",
+        prefix + "/zero_points", prefix + "/bias"
+    ])
+    fused.input.extend(
+        t for t in sorted(set(node.input) | set(root.input))
+        if t.startswith("^"))
+    fused.attr["T"].CopyFrom(node.attr["T"])
+    fused.attr["bits"].i = bits
+    fused.attr["group_size"].i = group_size
+    fused.attr["has_zero_point"].b = zero_points is not None
+    fused.attr["has_bias"].b = bias is not None
+    replaced[root.name] = [
+        fused,
+        _const_node(prefix + "/weight", packed, dtypes.int8, node.device),
+        _const_node(prefix + "/scales", scales, dtypes.float32, node.device),
+        _const_node(prefix + "/zero_points",
+                    zero_points if zero_points is not None else
+                    np.zeros([0], np.int8), dtypes.int8, node.device),
+        _const_node(prefix + "/bias",
+                    bias if bias is not None else np.zeros([0]), dtype,
+                    node.device),
+    ]
+
+  output = graph_pb2.GraphDef()
+  output.versions.CopyFrom(graph_def.versions)
+  output.library.CopyFrom(graph_def.library)
+  for node in graph_def.node:
+    if node.name in replaced:
+      output.node.extend(replaced[node.name])
+    elif node.name not in removed:
+      output.node.add().CopyFrom(node)
+  return _remove_unused_consts(output, set(consumers))
+
+
+def _remove_unused_consts(graph_def, originally_used):
+  """Drops the float weights, and Identity chains to them, left unused."""
+  while True:
+    used = set()
+    for node in graph_def.node:
+      used.update(_node_name(tensor) for tensor in node.input)
+    # Nodes without consumers in the original graph may be outputs.
+    unused = [
+        node.name for node in graph_def.node
+        if node.op in ("Const", "Identity") and node.name not in used and
+        node.name in originally_used
+    ]
+    if not unused:
+      return graph_def
+    unused = set(unused)
+    kept = [node for node in graph_def.node if node.name not in unused]
+    del graph_def.node[:]
+    graph_def.node.extend(kept)
+
+
+def convert_saved_model(input_saved_model_dir, output_saved_model_dir,
+                        signature_key="serving_default", tags=("serve",),
+                        bits=4, group_size=128, symmetric=True,
+                        min_weight_elements=4096):
+  """Converts a float SavedModel to a weight-only quantized one.
+
+  The signature `signature_key` is frozen, its MatMul weights are quantized
+  with convert_graph_def(), and the result is saved with the same signature
+  to `output_saved_model_dir`.
+  """
+  loaded = tf.saved_model.load(input_saved_model_dir, tags=list(tags))
+  func = loaded.signatures[signature_key]
+  frozen_func = convert_to_constants.convert_variables_to_constants_v2(func)
+  graph_def = convert_graph_def(frozen_func.graph.as_graph_def(), bits,
+                                group_size, symmetric, min_weight_elements)
+
+  # Flattened inputs and outputs follow the sorted keys of the signature.
+  input_keys = sorted(func.structured_input_signature[1].keys())
+  output_keys = sorted(func.structured_outputs.keys())
+  with tf.Graph().as_default() as graph:
+    tf.compat.v1.import_graph_def(graph_def, name="")
+    inputs = {
+        key: graph.get_tensor_by_name(tensor.name)
+        for key, tensor in zip(input_keys, frozen_func.inputs)
+    }
+    outputs = {
+        key: graph.get_tensor_by_name(tensor.name)
+        for key, tensor in zip(output_keys, frozen_func.outputs)
+    }
+    signature = tf.compat.v1.saved_model.predict_signature_def(inputs, outputs)
+    with tf.compat.v1.Session(graph=graph) as sess:
+      builder = tf.compat.v1.saved_model.Builder(output_saved_model_dir)
+      builder.add_meta_graph_and_variables(
+          sess, list(tags), signature_def_map={signature_key: signature})
+      builder.save()
@@ -0,0 +1,81 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+"""Dispatch overhead per op, from long chains of ops on tiny tensors.
+
+The kernels do almost no work, so the time per op is dominated by the
+OpKernelContext setup and the input/output wrappers.
+"""
+
+import time
+
+import tensorflow as tf
+from tensorflow.python.framework import dtypes
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+
+try:
+    from intel_extension_for_tensorflow.python.test_func import test
+except ImportError:
+    from tensorflow.python.platform import test
+
+CHAIN_LENGTH = 1000
+WARMUP = 10
+ITERATION = 100
+
+
+def _add_chain(x):
+    for _ in range(CHAIN_LENGTH):
+        x = math_ops.add(x, x)
+    return x
+
+
+# The Mul keeps grappler from folding consecutive Reshapes.
+def _reshape_chain(x):
+    for i in range(CHAIN_LENGTH):
+        x = array_ops.reshape(x, [2, 2] if i % 2 == 0 else [4])
+        x = math_ops.multiply(x, x)
+    return x
+
+
+def _gather_chain(x):
+    params = tf.ones([16, 4])
+    for _ in range(CHAIN_LENGTH):
+        x = array_ops.gather(params, math_ops.cast(x[:1], dtypes.int32))[0]
+    return x
+
+
+class OpDispatchOverheadTest(test.TestCase):
+    def _benchmark(self, name, chain, num_ops_per_link):
+        x = tf.zeros([4])
+        fn = tf.function(chain)
+        for _ in range(WARMUP):
+            fn(x)
+        start = time.perf_counter()
+        for _ in range(ITERATION):
+            fn(x)
+        elapsed = time.perf_counter() - start
+        num_ops = ITERATION * CHAIN_LENGTH * num_ops_per_link
+        print("%-8s %8.2f us/op" % (name, elapsed / num_ops * 1e6))
+
+    def testOpDispatchOverhead(self):
+        self._benchmark("AddV2", _add_chain, 1)
+        self._benchmark("Reshape", _reshape_chain, 2)
+        # StridedSlice, Cast, GatherV2 and StridedSlice.
+        self._benchmark("GatherV2", _gather_chain, 4)
+
+if __name__ == '__main__':
+    test.main()
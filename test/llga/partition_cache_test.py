@@ -0,0 +1,114 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the compiled partition cache of the oneDNN Graph kernels."""
+
+import glob
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+from intel_extension_for_tensorflow.python.test_func import test as test_lib
+
+# Runs a MatMul + BiasAdd + Relu partition over a sequence of batch sizes and
+# checks every result. The cache statistics are logged on each miss.
+_CHILD = r'''
+import sys
+import numpy as np
+import tensorflow.compat.v1 as tf
+from tensorflow.python.ops import array_ops
+
+tf.disable_eager_execution()
+np.random.seed(0)
+w_np = np.random.normal(size=(16, 32)).astype(np.float32)
+b_np = np.random.normal(size=(32,)).astype(np.float32)
+x = tf.placeholder(tf.float32, shape=(None, 16))
+y = array_ops.identity(tf.nn.relu(tf.nn.bias_add(tf.matmul(x, w_np), b_np)))
+with tf.Session() as sess:
+  for batch in [int(b) for b in sys.argv[1:]]:
+    x_np = np.random.normal(size=(batch, 16)).astype(np.float32)
+    np.testing.assert_allclose(sess.run(y, feed_dict={x: x_np}),
+                               np.maximum(np.matmul(x_np, w_np) + b_np, 0),
+                               rtol=1e-4, atol=1e-4)
+'''
+
+_STATS_RE = re.compile(r'oneDNN Graph compiled partition cache: '
+                       r'hits=(\d+), misses=(\d+), evictions=(\d+)')
+
+
+class PartitionCacheTest(test_lib.TestCase):
+
+  def _runBatches(self, batches, capacity, cache_dir=''):
+    env = dict(os.environ)
+    env['ITEX_ONEDNN_GRAPH'] = '1'
+    env['_ITEX_ONEDNN_GRAPH_ALL_TYPE'] = '1'
+    env['ITEX_LAYOUT_OPT'] = '1'
+    env['ITEX_ONEDNN_GRAPH_PARTITION_CACHE_CAPACITY'] = str(capacity)
+    env['ITEX_ONEDNN_GRAPH_PARTITION_CACHE_DIR'] = cache_dir
+    env['TF_CPP_VMODULE'] = 'onednn_primitive_cache=3'
+    result = subprocess.run(
+        [sys.executable, '-c', _CHILD] + [str(b) for b in batches],
+        env=env, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+        universal_newlines=True, check=False)
+    self.assertEqual(result.returncode, 0, result.stderr)
+    stats = _STATS_RE.findall(result.stderr)
+    self.assertTrue(stats, result.stderr)
+    # Statistics at the last miss.
+    return tuple(int(v) for v in stats[-1])
+
+  def _readSignatures(self, cache_dir):
+    files = glob.glob(os.path.join(cache_dir, '*.llga'))
+    self.assertEqual(len(files), 1)
+    with open(files[0]) as signature_file:
+      return files[0], [line for line in signature_file.read().splitlines()
+                        if line]
+
+  def testHitMissAndEviction(self):
+    # 1, 8 and 16 miss, 16 evicts 1, 8 hits, 1 misses again.
+    hits, misses, evictions = self._runBatches([1, 8, 16, 8, 1], capacity=2)
+    self.assertEqual(hits, 1)
+    self.assertEqual(misses, 4)
+    self.assertEqual(evictions, 1)
+
+  def testPersistedSignaturesDedupAndCap(self):
+    cache_dir = tempfile.mkdtemp()
+    self._runBatches([1, 8, 1, 8, 16, 32], capacity=2, cache_dir=cache_dir)
+    path, signatures = self._readSignatures(cache_dir)
+    # Each signature once, no more than the capacity.
+    self.assertEqual(len(signatures), 2)
+    self.assertEqual(len(set(signatures)), 2)
+
+    # Duplicated and malformed lines, e.g. from concurrent runs, are dropped
+    # when the next run compiles the signatures ahead.
+    with open(path, 'a') as signature_file:
+      signature_file.write(signatures[0] + '\n')
+      signature_file.write('not a signature\n')
+    self._runBatches([1, 8], capacity=2, cache_dir=cache_dir)
+    _, rewritten = self._readSignatures(cache_dir)
+    self.assertEqual(sorted(rewritten), sorted(signatures))
+
+  def testWarmUpCompilesPersistedSignatures(self):
+    cache_dir = tempfile.mkdtemp()
+    self._runBatches([1, 8], capacity=2, cache_dir=cache_dir)
+    # Both shapes are compiled ahead, the only misses are the lookups of the
+    # warm up and every execution hits.
+    hits, misses, _ = self._runBatches([1, 8, 1, 8], capacity=2,
+                                       cache_dir=cache_dir)
+    self.assertEqual(hits, 0)
+    self.assertEqual(misses, 2)
+
+if __name__ == '__main__':
+  test_lib.main()
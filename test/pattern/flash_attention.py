@@ -162,5 +162,70 @@ class MHAPatternWithMulAndAddTest(test_util.TensorFlowTestCase):
             self.assertAllCloseAccordingToType(real, predict, half_atol=2e-2, bfloat16_rtol=2e-2)
 
 
+
+class MHAPatternWithKVCacheConcatTest(test_util.TensorFlowTestCase):
+
+    def testMHAPatternWithKVCacheConcat(self):
+        if config.list_logical_devices('XPU'):
+            self.skipTest("KV cache attention is only supported on CPU.")
+        tf.random.set_seed(0)
+        datatypes = [tf.float32, tf.bfloat16]
+
+        q_in = np.random.rand(2, 8, 1, 64)
+        past_k_in = np.random.rand(2, 8, 31, 64)
+        past_v_in = np.random.rand(2, 8, 31, 64)
+        k_in = np.random.rand(2, 8, 1, 64)
+        v_in = np.random.rand(2, 8, 1, 64)
+        mask_in = np.random.rand(2, 1, 1, 32)
+
+        run_options = config_pb2.RunOptions(output_partition_graphs=True)
+        metadata = config_pb2.RunMetadata()
+
+        for dtype in datatypes:
+            q = tf.constant(q_in, dtype=dtype)
+            k = tf.constant(k_in, dtype=dtype)
+            v = tf.constant(v_in, dtype=dtype)
+            mask = tf.constant(mask_in, dtype=dtype)
+            # Feed the cache so that the concat is not constant folded.
+            past_k = tf.compat.v1.placeholder(dtype, shape=past_k_in.shape)
+            past_v = tf.compat.v1.placeholder(dtype, shape=past_v_in.shape)
+            feed_dict = {past_k: past_k_in, past_v: past_v_in}
+
+            # Decoding step: append current K/V to the cache by concat.
+            present_k = tf.concat([past_k, k], axis=2)
+            present_v = tf.concat([past_v, v], axis=2)
+            qk = tf.matmul(q, present_k, transpose_b=True)
+            qk = qk * 0.125
+            qk = qk + mask
+            qk = tf.nn.softmax(qk)
+            qk = tf.matmul(qk, present_v)
+            out = tf.transpose(qk, [0, 2, 1, 3])
+            out = tf.identity(out)
+            present_k = tf.identity(present_k)
+            present_v = tf.identity(present_v)
+
+            os.environ['ITEX_REMAPPER'] = '0'
+            with self.session(use_gpu=False) as sess:
+                real = sess.run([out, present_k, present_v], feed_dict=feed_dict)
+
+            os.environ['ITEX_REMAPPER'] = '1'
+            with self.session(use_gpu=False) as sess:
+                predict = sess.run([out, present_k, present_v], feed_dict=feed_dict,
+                                   options=run_options, run_metadata=metadata)
+
+            graph = metadata.partition_graphs[0]
+            found_fused_op = False
+            for node in graph.node:
+                if "ScaledDotProductAttentionKVCacheInference" in node.op:
+                    found_fused_op = True
+                    break
+            self.assertTrue(found_fused_op,
+                            "Not found fused ScaledDotProductAttentionKVCacheInference op")
+            self.assertAllCloseAccordingToType(real[0], predict[0], half_atol=2e-2,
+                                               bfloat16_rtol=2e-2)
+            self.assertAllEqual(real[1], predict[1])
+            self.assertAllEqual(real[2], predict[2])
+
+
 if __name__ == '__main__':
     test.main()
@@ -20,6 +20,7 @@ import numpy as np
 import keras
 import tensorflow as tf
 from intel_extension_for_tensorflow.python.ops import AdamWithWeightDecayOptimizer as itex_AdamW
+from intel_extension_for_tensorflow.python.device import get_backend
 from intel_extension_for_tensorflow.python.test_func import test
 from intel_extension_for_tensorflow.python.test_func import test_util
 import intel_extension_for_tensorflow as itex
@@ -108,44 +109,80 @@ class AdamWeightDecayOptimizerTest(test_util.TensorFlowTestCase):
                 self.assertAllCloseAccordingToType(itex_var1.numpy(), var1_np)
 
     def testBasicAdamW(self):
-        '''ResourceApplyAdamWithWeightDecay is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyAdamWithWeightDecay then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyAdamWithWeightDecay is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         self.doTestBasic()
 
     def testCallableParamsAdamW(self):
-        '''ResourceApplyAdamWithWeightDecay is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyAdamWithWeightDecay then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyAdamWithWeightDecay is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         self.doTestBasic(use_callable_params=True)
 
     def testAmsgradAdamW(self):
-        '''ResourceApplyAdamWithWeightDecay is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyAdamWithWeightDecay then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyAdamWithWeightDecay is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         self.doTestBasic(do_amsgrad=True)
 
     def testSparseAdamW(self):
-        '''ResourceApplyAdamWithWeightDecay is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyAdamWithWeightDecay then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyAdamWithWeightDecay is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         self.doTestBasic(do_sparse=True)
         self.doTestBasic(do_sparse=True, do_amsgrad=False)
 
+    def testLargeVariablesAdamW(self):
+        '''Variables larger than one chunk of the CPU multi-tensor kernel.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
+        np.random.seed(0)
+        vars_np = [np.random.rand(5000).astype(np.float32),
+                   np.random.rand(3, 7).astype(np.float32)]
+        grads_np = [np.random.rand(5000).astype(np.float32),
+                    np.random.rand(3, 7).astype(np.float32)]
+        slot_vars = [{}, {}]
+        itex_vars = [tf.Variable(v) for v in vars_np]
+        grads = [constant_op.constant(g) for g in grads_np]
+        opt = itex_AdamW(weight_decay=WEIGHT_DECAY, learning_rate=0.01)
+        for _ in range(3):
+            opt.apply_gradients(zip(grads, itex_vars))
+            for i in range(2):
+                vars_np[i], slot_vars[i] = adamw_update_numpy(
+                    vars_np[i], grads_np[i], slot_vars[i], learning_rate=0.01,
+                    beta_1=0.9, beta_2=0.999, epsilon=1e-7,
+                    weight_decay=WEIGHT_DECAY, amsgrad=False)
+            for i in range(2):
+                self.assertAllCloseAccordingToType(itex_vars[i].numpy(), vars_np[i])
+
+    def testEMAAdamW(self):
+        '''EMA isn't applied by the CPU multi-tensor kernel, so it must be skipped.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
+        var_np = np.array([1.0, 2.0], dtype=np.float32)
+        grad_np = np.array([0.1, 0.1], dtype=np.float32)
+        average_np = var_np.copy()
+        slot_vars = {}
+        itex_var = tf.Variable(var_np)
+        opt = itex_AdamW(weight_decay=WEIGHT_DECAY, learning_rate=0.01,
+                         use_ema=True, ema_momentum=0.5)
+        for _ in range(3):
+            opt.apply_gradients(zip([constant_op.constant(grad_np)], [itex_var]))
+            var_np, slot_vars = adamw_update_numpy(
+                var_np, grad_np, slot_vars, learning_rate=0.01, beta_1=0.9,
+                beta_2=0.999, epsilon=1e-7, weight_decay=WEIGHT_DECAY,
+                amsgrad=False)
+            average_np = 0.5 * average_np + 0.5 * var_np
+        average = opt._model_variables_moving_average[
+            opt._index_dict[opt._var_key(itex_var)]]
+        self.assertAllCloseAccordingToType(itex_var.numpy(), var_np)
+        self.assertAllCloseAccordingToType(average.numpy(), average_np)
+
     def testExcludeWeightDecayAdamW(self):
-        '''ResourceApplyAdamWithWeightDecay is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyAdamWithWeightDecay then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyAdamWithWeightDecay is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         grads, var1, var2, var3 = (
             tf.Variable(tf.zeros(())),
             tf.Variable(2.0),
@@ -168,11 +205,9 @@ class AdamWeightDecayOptimizerTest(test_util.TensorFlowTestCase):
         self.assertAllCloseAccordingToType(var3.numpy(), 2.0)
 
     def testKerasFit(self):
-        '''ResourceApplyAdamWithWeightDecay is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyAdamWithWeightDecay then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyAdamWithWeightDecay is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         """Check if calling model.fit works."""
         model = tf.keras.models.Sequential([tf.keras.layers.Dense(2)])
         loss = tf.keras.losses.SparseCategoricalCrossentropy(from_logits=True)
@@ -182,11 +217,9 @@ class AdamWeightDecayOptimizerTest(test_util.TensorFlowTestCase):
         model.fit(x, y, epochs=1)
 
     def test_clip_norm(self):
-        '''ResourceApplyAdamWithWeightDecay is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyAdamWithWeightDecay then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyAdamWithWeightDecay is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         for dtype in DATA_TYPES:
             optimizer = itex_AdamW(clipnorm=1)
             grad = [np.array([100.0, 100.0], dtype=dtype.as_numpy_dtype)]
@@ -194,11 +227,9 @@ class AdamWeightDecayOptimizerTest(test_util.TensorFlowTestCase):
             self.assertAllClose(clipped_grad[0], [2**0.5 / 2, 2**0.5 / 2])
 
     def test_clip_value(self):
-        '''ResourceApplyAdamWithWeightDecay is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyAdamWithWeightDecay then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyAdamWithWeightDecay is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         for dtype in DATA_TYPES:    
             optimizer = itex_AdamW(clipvalue=1)
             grad = [np.array([100.0, 100.0], dtype=dtype.as_numpy_dtype)]
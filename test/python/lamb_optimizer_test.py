@@ -18,6 +18,7 @@
 
 import numpy as np
 import tensorflow as tf
+from intel_extension_for_tensorflow.python.device import get_backend
 from intel_extension_for_tensorflow.python.test_func import test
 from intel_extension_for_tensorflow.python.test_func import test_util
 import intel_extension_for_tensorflow as itex
@@ -66,8 +67,8 @@ def LAMB_update_numpy(
 class LAMBOptimizerTest(test_util.TensorFlowTestCase):
 
     def doTestBasic(self, use_callable_params=False, do_sparse=False, do_amsgrad=False):
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         for dtype in DATA_TYPES:
             # Initialize variables for numpy implementation.
             np_slot_vars0, np_slot_vars1 = {}, {}
@@ -122,44 +123,34 @@ class LAMBOptimizerTest(test_util.TensorFlowTestCase):
                 self.assertAllCloseAccordingToType(itex_var1.numpy(), var1_np)
 
     def testBasicLAMB(self):
-        '''ResourceApplyLAMB is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyLAMB then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyLAMB is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         self.doTestBasic()
 
     def testCallableParamsLAMB(self):
-        '''ResourceApplyLAMB is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyLAMB then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyLAMB is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         self.doTestBasic(use_callable_params=True)
 
     def testAmsgradLAMB(self):
-        '''ResourceApplyLAMB is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyLAMB then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyLAMB is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         self.doTestBasic(do_amsgrad=True)
 
     def testSparseLAMB(self):
-        '''ResourceApplyLAMB is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyLAMB then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyLAMB is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         self.doTestBasic(do_sparse=True)
         self.doTestBasic(do_sparse=True, do_amsgrad=True)
 
     def testExcludeWeightDecayAdamW(self):
-        '''ResourceApplyLAMB is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyLAMB then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyLAMB is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         grads, var1, var2, var3 = (
             tf.Variable(tf.zeros(())),
             tf.Variable(2.0),
@@ -182,11 +173,9 @@ class LAMBOptimizerTest(test_util.TensorFlowTestCase):
         self.assertAllCloseAccordingToType(var3.numpy(), 2.0)
     
     def testExcludeLayerAdaptationLAMB(self):
-        '''ResourceApplyLAMB is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyLAMB then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyLAMB is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         grads, var1, var2, var3 = (
             tf.Variable(tf.zeros(())),
             tf.Variable(2.0),
@@ -210,11 +199,9 @@ class LAMBOptimizerTest(test_util.TensorFlowTestCase):
         self.assertAllCloseAccordingToType(var3.numpy(), 1.9992)
 
     def testKerasFit(self):
-        '''ResourceApplyLAMB is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyLAMB then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyLAMB is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         """Check if calling model.fit works."""
         model = tf.keras.models.Sequential([tf.keras.layers.Dense(2)])
         loss = tf.keras.losses.SparseCategoricalCrossentropy(from_logits=True)
@@ -224,11 +211,9 @@ class LAMBOptimizerTest(test_util.TensorFlowTestCase):
         model.fit(x, y, epochs=1)
 
     def test_clip_norm(self):
-        '''ResourceApplyLAMB is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyLAMB then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyLAMB is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         for dtype in DATA_TYPES:
             optimizer = itex_LAMB(clipnorm=1)
             grad = [np.array([100.0, 100.0], dtype=dtype.as_numpy_dtype)]
@@ -236,11 +221,9 @@ class LAMBOptimizerTest(test_util.TensorFlowTestCase):
             self.assertAllClose(clipped_grad[0], [2**0.5 / 2, 2**0.5 / 2])
 
     def test_clip_value(self):
-        '''ResourceApplyLAMB is a DPCPP op, don't have cpu registration 
-            TODO: waiting for CPU registration of ResourceApplyLAMB then enable
-            this test case on CPU'''
-        if not test.is_gpu_available():
-            self.skipTest("No GPU available")
+        '''ResourceApplyLAMB is registered on GPU and on the CPU backend.'''
+        if not test.is_gpu_available() and get_backend() != b"CPU":
+            self.skipTest("No GPU or CPU kernel available")
         for dtype in DATA_TYPES: 
             optimizer = itex_LAMB(clipvalue=1)
             grad = [np.array([100.0, 100.0], dtype=dtype.as_numpy_dtype)]
@@ -0,0 +1,60 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+"""Tests for the per-op profiler enabled by ITEX_OP_PROFILER."""
+
+import os
+import subprocess
+import sys
+
+from intel_extension_for_tensorflow.python.device import get_backend
+from intel_extension_for_tensorflow.python.test_func import test
+from intel_extension_for_tensorflow.python.test_func import test_util
+
+# The profile is written at exit, so the model runs in a child process.
+_MODEL = """
+import tensorflow as tf
+x = tf.random.normal([16, 32])
+w = tf.random.normal([32, 48])
+for _ in range(5):
+  y = tf.linalg.matmul(x, w)
+print(y.shape)
+"""
+
+
+class OpProfilerTest(test_util.TensorFlowTestCase):
+
+  def testTableAtExit(self):
+    if get_backend() != b"CPU":
+      self.skipTest("Ops are only timed in sync mode on GPU.")
+    path = os.path.join(self.get_temp_dir(), "op_profile.txt")
+    env = dict(os.environ, ITEX_OP_PROFILER="1",
+               ITEX_OP_PROFILER_OUTPUT=path)
+    subprocess.check_call([sys.executable, "-c", _MODEL], env=env)
+
+    with open(path) as f:
+      lines = f.read().splitlines()
+    self.assertTrue(lines[0].startswith("Op"))
+    matmuls = [line.split() for line in lines[1:]
+               if line.split()[0] == "MatMul"]
+    self.assertEqual(len(matmuls), 1)
+    # Count, then the input shapes last.
+    self.assertEqual(int(matmuls[0][1]), 5)
+    self.assertEqual(matmuls[0][-1], "[16,32];[32,48]")
+
+
+if __name__ == "__main__":
+  test.main()
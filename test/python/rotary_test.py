@@ -68,6 +68,42 @@ class RotaryTest(test_util.TensorFlowTestCase):
             d,t=i
             self._testForwardPass((1,1024,16,256), (1,1024,1,64),d,t)
             self._testForwardPass((3,1024,16,256), (3,1024,1,64),d,t)
+            self._testForwardPass((2,32,16,256), (1,32,1,64),d,t)
+
+    def testGradient(self):
+        # 4-D inputs, and 3-D [batch, length, heads * head_dim] ones.
+        for shape in [(2, 32, 16, 256), (2, 32, 16 * 256)]:
+            q = tf.random.uniform(shape)
+            k = tf.random.uniform(shape)
+            sin = tf.random.uniform((1, 32, 1, 64))
+            cos = tf.random.uniform((1, 32, 1, 64))
+            dq = tf.random.uniform(shape)
+            dk = tf.random.uniform(shape)
+
+            with tf.GradientTape(persistent=True) as tape:
+                tape.watch([q, k])
+                output_q, output_k = itex.ops.qk_rotary_positional_embedding(
+                    q, k, sin, cos, rotary_dim=64, num_attention_heads=16,
+                    head_dim=256)
+                loss = (tf.reduce_sum(output_q * dq) +
+                        tf.reduce_sum(output_k * dk))
+                q_4d = tf.reshape(q, (2, 32, 16, 256))
+                k_4d = tf.reshape(k, (2, 32, 16, 256))
+                q_rot = apply_rotary_pos_emb(q_4d[:, :, :, :64], sin, cos)
+                k_rot = apply_rotary_pos_emb(k_4d[:, :, :, :64], sin, cos)
+                result_q = tf.reshape(
+                    tf.concat((q_rot, q_4d[:, :, :, 64:]), axis=-1), shape)
+                result_k = tf.reshape(
+                    tf.concat((k_rot, k_4d[:, :, :, 64:]), axis=-1), shape)
+                expected_loss = (tf.reduce_sum(result_q * dq) +
+                                 tf.reduce_sum(result_k * dk))
+
+            grads = tape.gradient(loss, [q, k])
+            expected_grads = tape.gradient(expected_loss, [q, k])
+            self.assertAllClose(grads[0], expected_grads[0], rtol=1e-5,
+                                atol=1e-5)
+            self.assertAllClose(grads[1], expected_grads[1], rtol=1e-5,
+                                atol=1e-5)
 
 
 if __name__ == "__main__":
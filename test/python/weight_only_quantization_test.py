@@ -0,0 +1,93 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+"""Tests for weight-only INT4/INT8 quantization of MatMul."""
+
+import numpy as np
+import tensorflow.compat.v1 as tf
+from intel_extension_for_tensorflow.python.device import get_backend
+from intel_extension_for_tensorflow.python.optimize import weight_only_quantization
+from intel_extension_for_tensorflow.python.test_func import test
+from intel_extension_for_tensorflow.python.test_func import test_util
+
+
+def dequantize_numpy(packed, scales, zero_points, bits, group_size, k):
+  if bits == 4:
+    unpacked = packed.view(np.uint8).astype(np.int32)
+    q = np.empty((unpacked.shape[0] * 2, unpacked.shape[1]), np.int32)
+    q[0::2] = unpacked & 0xF
+    q[1::2] = unpacked >> 4
+    q = q[:k]
+  else:
+    q = packed.astype(np.int32)
+  if zero_points is None:
+    zero_points = np.full(scales.shape, 8 if bits == 4 else 0)
+  groups = np.arange(k) // group_size
+  return (q - zero_points[groups]) * scales[groups]
+
+
+class WeightOnlyQuantizationTest(test_util.TensorFlowTestCase):
+
+  def _testConvert(self, bits, symmetric, transpose_b, with_bias):
+    if get_backend() != b"CPU":
+      self.skipTest("Weight-only quantized MatMul is only on CPU.")
+    k, n, group_size = 200, 96, 64
+    x_np = np.random.normal(size=(5, k)).astype(np.float32)
+    w_np = np.random.normal(size=(k, n)).astype(np.float32)
+    b_np = np.random.normal(size=(n,)).astype(np.float32)
+
+    with tf.Graph().as_default() as graph:
+      x = tf.placeholder(tf.float32, shape=x_np.shape, name="x")
+      w = tf.constant(w_np.T if transpose_b else w_np)
+      y = tf.matmul(x, w, transpose_b=transpose_b)
+      if with_bias:
+        y = tf.nn.bias_add(y, b_np)
+      tf.identity(y, name="y")
+    graph_def = weight_only_quantization.convert_graph_def(
+        graph.as_graph_def(), bits=bits, group_size=group_size,
+        symmetric=symmetric)
+
+    ops = [node.op for node in graph_def.node]
+    self.assertIn("_ITEXWeightOnlyQuantizedMatMul", ops)
+    self.assertNotIn("MatMul", ops)
+    self.assertNotIn("BiasAdd", ops)
+
+    with tf.Graph().as_default(), self.session(use_gpu=False) as sess:
+      tf.import_graph_def(graph_def, name="")
+      output = sess.run("y:0", feed_dict={"x:0": x_np})
+
+    packed, scales, zero_points = weight_only_quantization.quantize_weight(
+        w_np, bits, group_size, symmetric)
+    expected = np.matmul(
+        x_np, dequantize_numpy(packed, scales, zero_points, bits, group_size,
+                               k))
+    if with_bias:
+      expected += b_np
+    self.assertAllClose(output, expected, rtol=1e-4, atol=1e-3)
+
+  def testInt4Symmetric(self):
+    self._testConvert(4, True, False, True)
+
+  def testInt4AsymmetricTransposed(self):
+    self._testConvert(4, False, True, False)
+
+  def testInt8(self):
+    self._testConvert(8, True, False, False)
+    self._testConvert(8, False, True, True)
+
+
+if __name__ == "__main__":
+  test.main()
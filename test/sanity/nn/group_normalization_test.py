@@ -323,6 +323,49 @@ class GroupNormalizationTest(test_combinations.TestCase):
         x_shape = [1, 6, 6, 6]
         self._runtests(x_shape)
 
+    def testInferenceWithResidual(self):
+        # Add + GroupNorm is fused into _ITEXFusedAddGroupNorm on CPU, the sum
+        # is still fetched as the residual stream.
+        x_shape = [2, 16, 16, 64]
+        groups = 32
+        epsilon = 1e-3
+        np.random.seed(1)
+        x_val = np.random.random_sample(x_shape).astype(np.float32)
+        r_val = np.random.random_sample(x_shape).astype(np.float32)
+        layer = itex.ops.GroupNormalization(
+            groups=groups, axis=-1, input_shape=x_shape, epsilon=epsilon
+        )
+        layer.build(x_shape)
+
+        @tf.function
+        def add_norm(x, r):
+            s = x + r
+            return layer(s, training=False), s
+
+        outputs, sum_outputs = add_norm(tf.constant(x_val), tf.constant(r_val))
+        ref_outputs = self.ref_group_norm(x_val + r_val, groups, -1,
+                                          layer.get_gamma(), layer.get_beta(),
+                                          epsilon)
+        self.assertAllClose(sum_outputs, x_val + r_val)
+        self.assertAllClose(outputs, ref_outputs, atol=3e-3, rtol=1e-4)
+
+    def testInferenceLargeMean(self):
+        # The variance is tiny compared to the squared mean, so it is lost if
+        # computed as E[x^2] - mean^2 in float.
+        x_shape = [2, 16, 16, 64]
+        groups = 32
+        epsilon = 1e-5
+        np.random.seed(1)
+        x_val = (100.0 + 0.1 * np.random.random_sample(x_shape)).astype(
+            np.float32)
+        layer = itex.ops.GroupNormalization(
+            groups=groups, axis=-1, input_shape=x_shape, epsilon=epsilon
+        )
+        outputs = layer(tf.constant(x_val))
+        ref_outputs = self.ref_group_norm(x_val, groups, -1, layer.get_gamma(),
+                                          layer.get_beta(), epsilon)
+        self.assertAllClose(outputs, ref_outputs, atol=1e-2, rtol=1e-3)
+
     
 if __name__ == "__main__":
     tf.test.main()
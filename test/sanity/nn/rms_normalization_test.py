@@ -25,6 +25,7 @@ except ImportError:
   from keras.src.testing_infra import test_utils
 import intel_extension_for_tensorflow as itex
 from intel_extension_for_tensorflow.python.ops import RMSNormalization
+from intel_extension_for_tensorflow.python.ops.load_ops_library import load_ops_library
 
 def _build_rms_normalization_model(norm):
     model = keras.models.Sequential()
@@ -149,6 +150,36 @@ class RMSNormalizationTest(test_combinations.TestCase):
         for shape in shapes:
             self._runtests(shape)
 
+    def testInferenceWithResidual(self):
+        # Add + ItexRmsNorm is fused into _ITEXFusedAddRMSNorm on CPU, the sum
+        # is still fetched as the residual stream.
+        shape = [4, 16, 256]
+        epsilon = 1e-6
+        np.random.seed(1)
+        x_val = np.random.random_sample(shape).astype(np.float32)
+        r_val = np.random.random_sample(shape).astype(np.float32)
+        gamma_val = np.random.random_sample(shape[-1:]).astype(np.float32)
+        beta_val = np.zeros(shape[-1:], dtype=np.float32)
+
+        @tf.function
+        def add_norm(x, r):
+            s = x + r
+            y = load_ops_library.itex_rms_norm(
+                s, gamma_val, beta_val, epsilon=epsilon, use_scale=True,
+                use_center=False)
+            return y, s
+
+        for dtype in [tf.float32, tf.bfloat16]:
+            outputs, sum_outputs = add_norm(
+                tf.constant(x_val, dtype=dtype), tf.constant(r_val, dtype=dtype))
+            s_val = tf.cast(tf.constant(x_val + r_val, dtype=dtype),
+                            tf.float32).numpy()
+            ref_outputs = s_val / np.sqrt(
+                np.mean(s_val ** 2, axis=-1, keepdims=True) + epsilon) * gamma_val
+            tol = 1e-5 if dtype == tf.float32 else 2e-2
+            self.assertAllClose(sum_outputs, s_val, atol=tol, rtol=tol)
+            self.assertAllClose(outputs, ref_outputs, atol=tol, rtol=tol)
+
 
 if __name__ == "__main__":
     tf.test.main()
@@ -12,7 +12,10 @@ from tensorflow.python.ops import gen_math_ops
 from tensorflow.python.ops import stateless_random_ops
 from intel_extension_for_tensorflow.python.ops.multi_head_attention import (
     scaled_dot_product_attention,
+    scaled_dot_product_attention_varlen,
+    scaled_dot_product_attention_kv_cache,
 )
+from intel_extension_for_tensorflow.python.ops.load_ops_library import load_ops_library
 
 seed = (0, 1)
 
@@ -64,16 +67,18 @@ def test_func(
     dtype,
     use_mask=False,
     use_dropout=False,
+    num_kv_heads=None,
 ):
     np.random.seed(0)
+    num_kv_heads = num_kv_heads or num_heads
 
     q = np.random.normal(size=[batch_size, num_heads, from_seq_len, head_size]).astype(
         np.float32
     )
-    k = np.random.normal(size=[batch_size, num_heads, to_seq_len, head_size]).astype(
+    k = np.random.normal(size=[batch_size, num_kv_heads, to_seq_len, head_size]).astype(
         np.float32
     )
-    v = np.random.normal(size=[batch_size, num_heads, to_seq_len, head_size]).astype(
+    v = np.random.normal(size=[batch_size, num_kv_heads, to_seq_len, head_size]).astype(
         np.float32
     )
 
@@ -115,16 +120,20 @@ def test_func(
 
     np.testing.assert_allclose(outputs, ref_outputs, rtol=rtol, atol=atol)
     np.testing.assert_allclose(dv, ref_dv, rtol=rtol, atol=atol)
-    try:
+    if config.list_logical_devices('XPU'):
+        try:
+            np.testing.assert_allclose(dq, ref_dq, rtol=rtol, atol=atol)
+        except AssertionError as err:
+            print("dq accuracy verify failed")        
+            print(err)
+        try:
+            np.testing.assert_allclose(dk, ref_dk, rtol=rtol, atol=atol)
+        except AssertionError as err:
+            print("dk accuracy verify failed")
+            print(err)
+    else:
         np.testing.assert_allclose(dq, ref_dq, rtol=rtol, atol=atol)
-    except AssertionError as err:
-        print("dq accuracy verify failed")        
-        print(err)
-    try:
         np.testing.assert_allclose(dk, ref_dk, rtol=rtol, atol=atol)
-    except AssertionError as err:
-        print("dk accuracy verify failed")
-        print(err)
 
     ref_outputs = spd_inference(
         q, k, v, seed, dtype, use_fast_attention=False
@@ -143,6 +152,162 @@ def test_func(
 
     np.testing.assert_allclose(outputs, ref_outputs, rtol=rtol, atol=atol)
 
+def test_gqa_inference(
+    batch_size,
+    from_seq_len,
+    to_seq_len,
+    num_heads,
+    num_kv_heads,
+    head_size,
+    dtype,
+):
+    np.random.seed(0)
+
+    q = np.random.normal(size=[batch_size, num_heads, from_seq_len, head_size]).astype(
+        np.float32
+    )
+    # Key/value heads are shared by groups of query heads.
+    k = np.random.normal(size=[batch_size, num_kv_heads, to_seq_len, head_size]).astype(
+        np.float32
+    )
+    v = np.random.normal(size=[batch_size, num_kv_heads, to_seq_len, head_size]).astype(
+        np.float32
+    )
+
+    ref_outputs = spd_inference(
+        q, k, v, seed, dtype, use_fast_attention=False
+    )
+
+    outputs = spd_inference(
+        q, k, v, seed, dtype, use_fast_attention=True
+    )
+
+    if dtype == tf.float16 or dtype == tf.bfloat16:
+        outputs = tf.cast(outputs, tf.float32)
+        ref_outputs = tf.cast(ref_outputs, tf.float32)
+        atol = rtol = 1e-2
+    else:
+        atol = rtol = 1e-5
+
+    np.testing.assert_allclose(outputs, ref_outputs, rtol=rtol, atol=atol)
+
+def test_causal_inference(batch_size, from_seq_len, to_seq_len, num_heads,
+                          head_size, dtype):
+    np.random.seed(0)
+
+    q = np.random.normal(size=[batch_size, num_heads, from_seq_len, head_size]).astype(np.float32)
+    k = np.random.normal(size=[batch_size, num_heads, to_seq_len, head_size]).astype(np.float32)
+    v = np.random.normal(size=[batch_size, num_heads, to_seq_len, head_size]).astype(np.float32)
+
+    outputs = load_ops_library.scaled_dot_product_attention_inference(
+        query=tf.constant(q, dtype=dtype),
+        key=tf.constant(k, dtype=dtype),
+        value=tf.constant(v, dtype=dtype),
+        atten_mask=0,
+        use_mask=False,
+        use_causal=True,
+        is_inference=True)
+    outputs = tf.cast(outputs, tf.float32)
+
+    # The causal mask is aligned to the end of the keys: query row r sees the
+    # keys up to to_seq_len - from_seq_len + r, rows that see no key give 0.
+    q_ref = tf.cast(tf.constant(q, dtype=dtype), tf.float32).numpy()
+    k_ref = tf.cast(tf.constant(k, dtype=dtype), tf.float32).numpy()
+    v_ref = tf.cast(tf.constant(v, dtype=dtype), tf.float32).numpy()
+    scores = np.matmul(q_ref, np.swapaxes(k_ref, -1, -2)) / np.sqrt(head_size)
+    visible = np.tril(np.ones([from_seq_len, to_seq_len]), to_seq_len - from_seq_len) > 0
+    scores = np.where(visible, scores, -np.inf)
+    probs = np.exp(scores - np.max(scores, -1, keepdims=True, initial=-1e30))
+    probs = probs / np.maximum(np.sum(probs, -1, keepdims=True), 1e-30)
+    ref = np.transpose(np.matmul(probs, v_ref), [0, 2, 1, 3])
+
+    if dtype == tf.bfloat16:
+        atol = rtol = 1e-2
+    else:
+        atol = rtol = 1e-5
+    np.testing.assert_allclose(outputs, ref, rtol=rtol, atol=atol)
+
+def test_varlen_inference(seq_lens, num_heads, num_kv_heads, head_size, dtype,
+                          is_causal=False):
+    np.random.seed(0)
+
+    cu_seqlens = np.cumsum([0] + seq_lens).astype(np.int32)
+    total = int(cu_seqlens[-1])
+    q = np.random.normal(size=[total, num_heads, head_size]).astype(np.float32)
+    k = np.random.normal(size=[total, num_kv_heads, head_size]).astype(np.float32)
+    v = np.random.normal(size=[total, num_kv_heads, head_size]).astype(np.float32)
+
+    outputs = scaled_dot_product_attention_varlen(
+        tf.constant(q, dtype=dtype),
+        tf.constant(k, dtype=dtype),
+        tf.constant(v, dtype=dtype),
+        cu_seqlens,
+        cu_seqlens,
+        is_causal=is_causal,
+    )
+    outputs = tf.cast(outputs, tf.float32)
+
+    # Reference: every sequence on its own with the unfused implementation.
+    group = num_heads // num_kv_heads
+    for b in range(len(seq_lens)):
+        start, end = cu_seqlens[b], cu_seqlens[b + 1]
+        if start == end:
+            continue
+        q_b = tf.transpose(tf.constant(q[start:end], dtype=dtype), [1, 0, 2])
+        k_b = tf.repeat(tf.transpose(tf.constant(k[start:end], dtype=dtype), [1, 0, 2]), group, axis=0)
+        v_b = tf.repeat(tf.transpose(tf.constant(v[start:end], dtype=dtype), [1, 0, 2]), group, axis=0)
+        scores = tf.matmul(q_b, k_b, transpose_b=True) * tf.cast(1.0 / np.sqrt(head_size), dtype)
+        if is_causal:
+            causal = np.tril(np.ones([end - start, end - start]))
+            scores += tf.cast((1 - causal) * -1e9, dtype)
+        ref = tf.matmul(tf.nn.softmax(scores, -1), v_b)
+        ref = tf.cast(tf.transpose(ref, [1, 0, 2]), tf.float32)
+
+        if dtype == tf.bfloat16:
+            atol = rtol = 1e-2
+        else:
+            atol = rtol = 1e-5
+        np.testing.assert_allclose(outputs[start:end], ref, rtol=rtol, atol=atol)
+
+def test_kv_cache_inference(batch_size, new_len, cache_len, capacity, num_heads,
+                            num_kv_heads, head_size, dtype):
+    np.random.seed(0)
+
+    q = np.random.normal(size=[batch_size, num_heads, new_len, head_size]).astype(np.float32)
+    k = np.random.normal(size=[batch_size, num_kv_heads, new_len, head_size]).astype(np.float32)
+    v = np.random.normal(size=[batch_size, num_kv_heads, new_len, head_size]).astype(np.float32)
+    # Rows past cache_len are stale and must be ignored.
+    key_cache = np.random.normal(size=[batch_size, num_kv_heads, capacity, head_size]).astype(np.float32)
+    value_cache = np.random.normal(size=[batch_size, num_kv_heads, capacity, head_size]).astype(np.float32)
+
+    @tf.function
+    def step(q, k, v, key_cache, value_cache):
+        return scaled_dot_product_attention_kv_cache(
+            q, k, v, key_cache, value_cache, cache_len)
+
+    outputs, key_cache_out, value_cache_out = step(
+        *[tf.constant(t, dtype=dtype) for t in [q, k, v, key_cache, value_cache]])
+    total_len = cache_len + new_len
+    assert key_cache_out.shape[2] == max(capacity, total_len)
+
+    key_ref = np.concatenate([key_cache[:, :, :cache_len], k], axis=2)
+    value_ref = np.concatenate([value_cache[:, :, :cache_len], v], axis=2)
+    ref_outputs = spd_inference(q, key_ref, value_ref, seed, dtype,
+                                use_fast_attention=False)
+
+    outputs, ref_outputs, key_cache_out, value_cache_out = [
+        tf.cast(t, tf.float32)
+        for t in [outputs, ref_outputs, key_cache_out, value_cache_out]]
+    if dtype == tf.bfloat16:
+        atol = rtol = 1e-2
+    else:
+        atol = rtol = 1e-5
+    np.testing.assert_allclose(outputs, ref_outputs, rtol=rtol, atol=atol)
+    np.testing.assert_allclose(key_cache_out[:, :, :total_len],
+                               tf.cast(tf.cast(key_ref, dtype), tf.float32))
+    np.testing.assert_allclose(value_cache_out[:, :, :total_len],
+                               tf.cast(tf.cast(value_ref, dtype), tf.float32))
+
 def test_perf(
     batch_size,
     from_seq_len,
@@ -190,4 +355,21 @@ if __name__ == "__main__":
         # test_func(1, 256, 256, 8, 160, dtype, False, False)
         # test_func(1, 1024, 1024, 8, 80, dtype, False, False)
         test_func(1, 512, 512, 2, 64, dtype, True, True)
+        if not config.list_logical_devices('XPU'):
+            # Training without dropout runs the blockwise backward, use
+            # lengths that span several q/kv blocks.
+            test_func(2, 300, 600, 4, 64, dtype, True, False)
+            # Grouped-query and multi-query attention.
+            test_func(2, 100, 200, 8, 64, dtype, True, False, num_kv_heads=2)
+            test_gqa_inference(2, 64, 128, 8, 2, 64, dtype)
+            test_gqa_inference(2, 1, 128, 8, 1, 64, dtype)
+            # Packed variable-length batch, including an empty sequence.
+            test_varlen_inference([5, 70, 0, 300], 8, 2, 64, dtype)
+            test_varlen_inference([5, 70, 0, 300], 4, 4, 64, dtype, is_causal=True)
+            # Causal with more queries than keys, the leading query tiles
+            # see no key at all.
+            test_causal_inference(2, 300, 100, 4, 64, dtype)
+            # Decoding with a preallocated cache, in place and growing.
+            test_kv_cache_inference(2, 1, 37, 64, 8, 2, 64, dtype)
+            test_kv_cache_inference(2, 4, 62, 64, 4, 4, 64, dtype)
         # test_func(1, 512, 512, 2, 64, dtype, True, True)
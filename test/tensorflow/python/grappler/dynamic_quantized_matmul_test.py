@@ -0,0 +1,88 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import os
+
+import numpy as np
+
+import tensorflow.compat.v1 as tf
+
+try:
+  from intel_extension_for_tensorflow.python.test_func import test as test_lib
+except ImportError:
+  from tensorflow.python.platform import test as test_lib
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import nn_ops
+from tensorflow.core.protobuf import config_pb2
+
+os.environ['ITEX_DYNAMIC_QUANTIZATION'] = '1'
+
+
+class DynamicQuantizedMatMulTest(test_lib.TestCase):
+
+  def _runAndCheckFusion(self, y, feed_dict, num_args, transpose_b):
+    run_options = config_pb2.RunOptions(output_partition_graphs=True)
+    metadata = config_pb2.RunMetadata()
+    with self.session(use_gpu=False) as sess:
+      output_val = sess.run(y, options=run_options, run_metadata=metadata,
+                            feed_dict=feed_dict)
+      graph = metadata.partition_graphs[0]
+
+    found_fused_op = False
+    for node in graph.node:
+      if node.op == '_ITEXDynamicQuantizedMatMul':
+        found_fused_op = True
+        self.assertEqual(node.attr['num_args'].i, num_args)
+        self.assertEqual(node.attr['transpose_b'].b, transpose_b)
+        break
+    self.assertTrue(found_fused_op)
+    return output_val
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testMatMulWithBias(self):
+    x_np = np.random.normal(size=(24, 96)).astype(np.float32)
+    w_np = np.random.normal(size=(96, 80)).astype(np.float32) * 0.1
+    b_np = np.random.normal(size=(80,)).astype(np.float32)
+
+    x = tf.placeholder(tf.float32, shape=x_np.shape)
+    with tf.device('/cpu:0'):
+      y = nn_ops.bias_add(tf.matmul(x, w_np), b_np)
+      y = array_ops.identity(y)
+
+    output_val = self._runAndCheckFusion(y, {x: x_np}, 1, False)
+    expected = np.matmul(x_np, w_np) + b_np
+    # INT8 activation and weight, relative to the magnitude of the output.
+    self.assertAllClose(output_val, expected, rtol=0.05, atol=0.05)
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testBatchMatMulAdjY(self):
+    x_np = np.random.normal(size=(2, 12, 64)).astype(np.float32)
+    w_np = np.random.normal(size=(48, 64)).astype(np.float32) * 0.1
+
+    x = tf.placeholder(tf.float32, shape=x_np.shape)
+    with tf.device('/cpu:0'):
+      y = tf.linalg.matmul(x, w_np, adjoint_b=True)
+      y = array_ops.identity(y)
+
+    output_val = self._runAndCheckFusion(y, {x: x_np}, 0, True)
+    expected = np.matmul(x_np, w_np.T)
+    self.assertAllClose(output_val, expected, rtol=0.05, atol=0.05)
+
+if __name__ == "__main__":
+  test_lib.main()
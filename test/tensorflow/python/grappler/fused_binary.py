@@ -27,6 +27,10 @@ from tensorflow.python.framework import test_util
 from tensorflow.python.ops import array_ops
 from tensorflow.core.protobuf import config_pb2
 
+# Binary chains are fused into the more general _ITEXFusedElementwise on CPU.
+FUSED_OP = ('ITEXFusedBinary' if tf.config.list_physical_devices('XPU')
+            else 'ITEXFusedElementwise')
+
 
 class FusedBinaryTest(test_lib.TestCase):
 
@@ -57,7 +61,7 @@ class FusedBinaryTest(test_lib.TestCase):
 
       existing_pattern = False
       for node in graph.node:
-        if 'ITEXFusedBinary' in node.op:
+        if FUSED_OP in node.op:
           existing_pattern = True
           break
       self.assertTrue(existing_pattern)
@@ -102,7 +106,7 @@ class FusedBinaryTest(test_lib.TestCase):
 
       existing_pattern = False
       for node in graph.node:
-        if 'ITEXFusedBinary' in node.op:
+        if FUSED_OP in node.op:
           existing_pattern = True
           break
       self.assertTrue(existing_pattern)
@@ -156,7 +160,7 @@ class FusedBinaryTest(test_lib.TestCase):
         existing_pattern = False
         if os.getenv('ITEX_REMAPPER') == '1':
           for node in graph.node:
-            if 'ITEXFusedBinary' in node.op:
+            if FUSED_OP in node.op:
               existing_pattern = True
               break
           self.assertTrue(existing_pattern)
@@ -0,0 +1,92 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import numpy as np
+
+import tensorflow.compat.v1 as tf
+
+try:
+  from intel_extension_for_tensorflow.python.test_func import test as test_lib
+except ImportError:
+  from tensorflow.python.platform import test as test_lib
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import nn_ops
+from tensorflow.core.protobuf import config_pb2
+
+
+class FusedElementwiseTest(test_lib.TestCase):
+
+  def _runAndCheckFusion(self, x, feed_dict, num_fused_ops):
+    run_options = config_pb2.RunOptions(output_partition_graphs=True)
+    metadata = config_pb2.RunMetadata()
+    with self.session(use_gpu=False) as sess:
+      output_val = sess.run(x, options=run_options, run_metadata=metadata,
+                            feed_dict=feed_dict)
+      graph = metadata.partition_graphs[0]
+
+    fused_ops = []
+    for node in graph.node:
+      if 'ITEXFusedElementwise' in node.op:
+        fused_ops = node.attr['fused_ops'].list.s
+        break
+    self.assertEqual(len(fused_ops), num_fused_ops)
+    return output_val
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testBiasGeluScale(self):
+    shape = (64, 128)
+    x_np = np.random.normal(size=shape).astype(np.float32)
+    bias_np = np.random.normal(size=shape[-1:]).astype(np.float32)
+    scale_np = np.random.normal(size=shape[-1:]).astype(np.float32)
+
+    x = tf.placeholder(tf.float32, shape=shape)
+    with tf.device('/cpu:0'):
+      y = nn_ops.bias_add(x, bias_np)
+      y = tf.nn.gelu(y, approximate=True)
+      y = y * scale_np
+      y = 2.0 - y
+      y = array_ops.identity(y)
+
+    output_val = self._runAndCheckFusion(y, {x: x_np}, 4)
+
+    expected = x_np + bias_np
+    expected = 0.5 * expected * (1.0 + np.tanh(
+        np.sqrt(2.0 / np.pi) * (expected + 0.044715 * np.power(expected, 3))))
+    expected = 2.0 - expected * scale_np
+    self.assertAllClose(output_val, expected, rtol=1e-5, atol=1e-5)
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testUnaryAndScalarChain(self):
+    shape = (8, 16, 33)
+    x_np = np.random.normal(size=shape).astype(np.float32)
+
+    x = tf.placeholder(tf.float32, shape=shape)
+    with tf.device('/cpu:0'):
+      y = tf.math.tanh(x * 0.5)
+      y = tf.math.sqrt(y + 1.0)
+      y = tf.math.minimum(y, 2.0)
+      y = array_ops.identity(y)
+
+    output_val = self._runAndCheckFusion(y, {x: x_np}, 5)
+
+    expected = np.minimum(np.sqrt(np.tanh(x_np * 0.5) + 1.0), 2.0)
+    self.assertAllClose(output_val, expected, rtol=1e-5, atol=1e-5)
+
+if __name__ == "__main__":
+  test_lib.main()
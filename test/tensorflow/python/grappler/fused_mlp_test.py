@@ -0,0 +1,133 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import os
+
+import numpy as np
+
+import tensorflow.compat.v1 as tf
+
+try:
+  from intel_extension_for_tensorflow.python.test_func import test as test_lib
+except ImportError:
+  from tensorflow.python.platform import test as test_lib
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import nn_ops
+from tensorflow.core.framework import types_pb2
+from tensorflow.core.protobuf import config_pb2
+
+
+class FusedMLPTest(test_lib.TestCase):
+
+  def _runAndCheckFusion(self, y, feed_dict, activation, is_gated,
+                         dtype=types_pb2.DT_FLOAT):
+    run_options = config_pb2.RunOptions(output_partition_graphs=True)
+    metadata = config_pb2.RunMetadata()
+    with self.session(use_gpu=False) as sess:
+      output_val = sess.run(y, options=run_options, run_metadata=metadata,
+                            feed_dict=feed_dict)
+      graph = metadata.partition_graphs[0]
+
+    found_fused_op = False
+    for node in graph.node:
+      if node.op == '_ITEXFusedMLP':
+        found_fused_op = True
+        self.assertEqual(node.attr['activation'].s, activation)
+        self.assertEqual(node.attr['is_gated'].b, is_gated)
+        self.assertEqual(node.attr['T'].type, dtype)
+        break
+    self.assertTrue(found_fused_op)
+    return output_val
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testDenseGeluDense(self):
+    x_np = np.random.normal(size=(48, 64)).astype(np.float32)
+    w_up = np.random.normal(size=(64, 300)).astype(np.float32) * 0.1
+    b_up = np.random.normal(size=(300,)).astype(np.float32)
+    w_down = np.random.normal(size=(300, 64)).astype(np.float32) * 0.1
+    b_down = np.random.normal(size=(64,)).astype(np.float32)
+
+    x = tf.placeholder(tf.float32, shape=x_np.shape)
+    with tf.device('/cpu:0'):
+      h = nn_ops.bias_add(tf.matmul(x, w_up), b_up)
+      h = tf.nn.gelu(h, approximate=False)
+      y = nn_ops.bias_add(tf.matmul(h, w_down), b_down)
+      y = array_ops.identity(y)
+
+    output_val = self._runAndCheckFusion(y, {x: x_np}, b'GeluExact', False)
+
+    with self.session(use_gpu=False):
+      h = tf.nn.gelu(np.matmul(x_np, w_up) + b_up, approximate=False)
+      expected = np.matmul(self.evaluate(h), w_down) + b_down
+    self.assertAllClose(output_val, expected, rtol=1e-4, atol=1e-4)
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testGatedSiLU(self):
+    x_np = np.random.normal(size=(40, 64)).astype(np.float32)
+    w_gate = np.random.normal(size=(64, 272)).astype(np.float32) * 0.1
+    w_up = np.random.normal(size=(64, 272)).astype(np.float32) * 0.1
+    w_down = np.random.normal(size=(272, 64)).astype(np.float32) * 0.1
+
+    x = tf.placeholder(tf.float32, shape=x_np.shape)
+    with tf.device('/cpu:0'):
+      gate = tf.matmul(x, w_gate)
+      h = gate * tf.math.sigmoid(gate) * tf.matmul(x, w_up)
+      y = tf.matmul(h, w_down)
+      y = array_ops.identity(y)
+
+    output_val = self._runAndCheckFusion(y, {x: x_np}, b'Silu', True)
+
+    gate = np.matmul(x_np, w_gate)
+    h = gate / (1.0 + np.exp(-gate)) * np.matmul(x_np, w_up)
+    expected = np.matmul(h, w_down)
+    self.assertAllClose(output_val, expected, rtol=1e-4, atol=1e-4)
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testDenseGeluDenseAutoMixedPrecision(self):
+    x_np = np.random.normal(size=(48, 64)).astype(np.float32)
+    w_up = np.random.normal(size=(64, 256)).astype(np.float32) * 0.1
+    b_up = np.random.normal(size=(256,)).astype(np.float32)
+    w_down = np.random.normal(size=(256, 64)).astype(np.float32) * 0.1
+    b_down = np.random.normal(size=(64,)).astype(np.float32)
+
+    x = tf.placeholder(tf.float32, shape=x_np.shape)
+    with tf.device('/cpu:0'):
+      h = nn_ops.bias_add(tf.matmul(x, w_up), b_up)
+      h = tf.nn.gelu(h, approximate=True)
+      y = nn_ops.bias_add(tf.matmul(h, w_down), b_down)
+      y = array_ops.identity(y)
+
+    # The remapper runs first, so the fused op itself must be converted.
+    os.environ['ITEX_AUTO_MIXED_PRECISION'] = '1'
+    os.environ['ITEX_AUTO_MIXED_PRECISION_DATA_TYPE'] = 'BFLOAT16'
+    try:
+      output_val = self._runAndCheckFusion(y, {x: x_np}, b'GeluApproximate',
+                                           False, types_pb2.DT_BFLOAT16)
+    finally:
+      del os.environ['ITEX_AUTO_MIXED_PRECISION']
+      del os.environ['ITEX_AUTO_MIXED_PRECISION_DATA_TYPE']
+
+    with self.session(use_gpu=False):
+      h = tf.nn.gelu(np.matmul(x_np, w_up) + b_up, approximate=True)
+      expected = np.matmul(self.evaluate(h), w_down) + b_down
+    self.assertAllClose(output_val, expected, rtol=5e-2, atol=5e-2)
+
+if __name__ == "__main__":
+  test_lib.main()
@@ -0,0 +1,89 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import json
+import os
+import tempfile
+
+import numpy as np
+
+import tensorflow.compat.v1 as tf
+
+try:
+  from intel_extension_for_tensorflow.python.test_func import test as test_lib
+except ImportError:
+  from tensorflow.python.platform import test as test_lib
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import array_ops
+
+# The report path is read once per process.
+_REPORT_PATH = os.path.join(tempfile.mkdtemp(), 'report.json')
+os.environ['ITEX_GRAPH_OPTIMIZATION_REPORT'] = _REPORT_PATH
+os.environ['ITEX_MEMORY_PLANNER'] = '1'
+os.environ['ITEX_LAYOUT_OPT'] = '0'
+
+# Bytes of one [256, 256] float tensor, a multiple of the plan alignment.
+_TENSOR_BYTES = 256 * 256 * 4
+
+
+class MemoryPlannerTest(test_lib.TestCase):
+
+  def _runAndGetArenaBytes(self, y, feed_dict):
+    open(_REPORT_PATH, 'w').close()
+    with self.session(use_gpu=False) as sess:
+      output_val = sess.run(y, feed_dict=feed_dict)
+    plans = []
+    with open(_REPORT_PATH) as report_file:
+      for line in report_file:
+        plans.extend(json.loads(line).get('memory_plans', []))
+    self.assertTrue(plans)
+    # int64 fields are serialized as strings.
+    return output_val, max(int(plan['arena_bytes']) for plan in plans)
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testChainReusesBuffers(self):
+    x_np = np.random.normal(size=(256, 256)).astype(np.float32)
+    x = tf.placeholder(tf.float32, shape=x_np.shape)
+    with tf.device('/cpu:0'):
+      # Each tensor dies when the next one is produced, so the tensors two
+      # steps apart share an offset and at most two are in the arena.
+      y = array_ops.identity(tf.math.exp(tf.math.cos(tf.math.sin(x))))
+
+    output_val, arena_bytes = self._runAndGetArenaBytes(y, {x: x_np})
+    self.assertGreater(arena_bytes, 0)
+    self.assertLessEqual(arena_bytes, 2 * _TENSOR_BYTES)
+    self.assertAllClose(output_val, np.exp(np.cos(np.sin(x_np))), rtol=1e-5)
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testOverlappingLifetimesDoNotShare(self):
+    x_np = np.random.normal(size=(256, 256)).astype(np.float32)
+    x = tf.placeholder(tf.float32, shape=x_np.shape)
+    with tf.device('/cpu:0'):
+      # The three unary outputs are all alive until the Muls read them.
+      s = tf.math.sin(x)
+      c = tf.math.cos(x)
+      e = tf.math.exp(x)
+      y = array_ops.identity(tf.math.multiply(tf.math.multiply(s, c), e))
+
+    output_val, arena_bytes = self._runAndGetArenaBytes(y, {x: x_np})
+    self.assertGreaterEqual(arena_bytes, 3 * _TENSOR_BYTES)
+    self.assertAllClose(
+        output_val, np.sin(x_np) * np.cos(x_np) * np.exp(x_np), rtol=1e-5)
+
+if __name__ == "__main__":
+  test_lib.main()
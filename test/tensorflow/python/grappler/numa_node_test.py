@@ -0,0 +1,96 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import os
+
+import numpy as np
+
+import tensorflow.compat.v1 as tf
+
+try:
+  from intel_extension_for_tensorflow.python.test_func import test as test_lib
+except ImportError:
+  from tensorflow.python.platform import test as test_lib
+from intel_extension_for_tensorflow.python.device import get_backend
+from tensorflow.core.framework import attr_value_pb2
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import array_ops
+
+os.environ['ITEX_LAYOUT_OPT'] = '0'
+
+
+def _num_numa_nodes():
+  node_dir = '/sys/devices/system/node'
+  if not os.path.isdir(node_dir):
+    return 1
+  nodes = [d for d in os.listdir(node_dir)
+           if d.startswith('node') and d[4:].isdigit()]
+  return max(1, len(nodes))
+
+
+class NumaNodeTest(test_lib.TestCase):
+  """`_numa_node` pins CPU kernels to the thread pool of one NUMA node."""
+
+  def _runMatMulBiasRelu(self, numa_node):
+    np.random.seed(0)
+    x_np = np.random.normal(size=(64, 128)).astype(np.float32)
+    w_np = np.random.normal(size=(128, 32)).astype(np.float32)
+    b_np = np.random.normal(size=(32,)).astype(np.float32)
+    attr = {}
+    if numa_node is not None:
+      attr['_numa_node'] = attr_value_pb2.AttrValue(i=numa_node)
+    graph = tf.Graph()
+    with graph.as_default(), tf.device('/cpu:0'):
+      x = tf.placeholder(tf.float32, shape=x_np.shape)
+      # pylint: disable=protected-access
+      with graph._attr_scope(attr):
+        y = tf.nn.relu(tf.nn.bias_add(tf.matmul(x, w_np), b_np))
+      y = array_ops.identity(y)
+
+    run_options = config_pb2.RunOptions(output_partition_graphs=True)
+    metadata = config_pb2.RunMetadata()
+    with self.session(graph=graph, use_gpu=False) as sess:
+      output_val = sess.run(y, options=run_options, run_metadata=metadata,
+                            feed_dict={x: x_np})
+    return output_val, metadata.partition_graphs[0]
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testNumaNodeKeptOnFusedNode(self):
+    if get_backend() != b'CPU':
+      self.skipTest('NUMA pinning is only supported in the CPU build.')
+    expected, _ = self._runMatMulBiasRelu(None)
+    output_val, graph = self._runMatMulBiasRelu(0)
+    fused = [node for node in graph.node if node.op == '_ITEXFusedMatMul']
+    self.assertEqual(len(fused), 1)
+    self.assertEqual(fused[0].attr['_numa_node'].i, 0)
+    self.assertAllClose(output_val, expected)
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testFallbackToDefaultThreadPool(self):
+    if get_backend() != b'CPU':
+      self.skipTest('NUMA pinning is only supported in the CPU build.')
+    expected, _ = self._runMatMulBiasRelu(None)
+    # Node 0 falls back to the default pool on a single-node machine, the
+    # other nodes don't exist, the kernels still run there.
+    for numa_node in [0, _num_numa_nodes(), 1000]:
+      output_val, _ = self._runMatMulBiasRelu(numa_node)
+      self.assertAllClose(output_val, expected)
+
+if __name__ == "__main__":
+  test_lib.main()
@@ -0,0 +1,69 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import os
+
+import numpy as np
+
+import tensorflow.compat.v1 as tf
+
+try:
+  from intel_extension_for_tensorflow.python.test_func import test as test_lib
+except ImportError:
+  from tensorflow.python.platform import test as test_lib
+from intel_extension_for_tensorflow.python.device import get_backend
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import array_ops
+from tensorflow.core.protobuf import config_pb2
+
+os.environ['ITEX_LAYOUT_OPT'] = '1'
+
+
+class OneDnnLayoutCostModelTest(test_lib.TestCase):
+
+  def _runWithCostModel(self, y, feed_dict, enabled):
+    os.environ['ITEX_LAYOUT_COST_MODEL'] = '1' if enabled else '0'
+    run_options = config_pb2.RunOptions(output_partition_graphs=True)
+    metadata = config_pb2.RunMetadata()
+    with self.session(use_gpu=False) as sess:
+      output_val = sess.run(y, options=run_options, run_metadata=metadata,
+                            feed_dict=feed_dict)
+    return output_val, [node.op for node in metadata.partition_graphs[0].node]
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testMatMulLeftInPlainLayout(self):
+    if get_backend() != b'CPU':
+      self.skipTest('MatMul is only rewritten to block layout on CPU.')
+    x_np = np.random.normal(size=(32, 64)).astype(np.float32)
+    w_np = np.random.normal(size=(64, 48)).astype(np.float32)
+
+    x = tf.placeholder(tf.float32, shape=x_np.shape)
+    with tf.device('/cpu:0'):
+      y = array_ops.identity(tf.matmul(x, w_np))
+
+    expected, ops = self._runWithCostModel(y, {x: x_np}, False)
+    self.assertIn('_OneDnnMatMul', ops)
+    self.assertIn('_OneDnnToTf', ops)
+
+    # The MatMul alone saves no reorder but needs one to feed the Identity.
+    output_val, ops = self._runWithCostModel(y, {x: x_np}, True)
+    self.assertNotIn('_OneDnnMatMul', ops)
+    self.assertNotIn('_OneDnnToTf', ops)
+    self.assertAllClose(output_val, expected)
+
+if __name__ == "__main__":
+  test_lib.main()
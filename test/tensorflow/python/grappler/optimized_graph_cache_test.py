@@ -0,0 +1,109 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the on-disk cache of optimized graphs."""
+
+import glob
+import os
+import subprocess
+import sys
+import tempfile
+
+from intel_extension_for_tensorflow.python.test_func import test as test_lib
+
+# Runs MatMul + BiasAdd + Relu with the weight scaled by the first argument and
+# checks the result.
+_CHILD = r'''
+import sys
+import numpy as np
+import tensorflow.compat.v1 as tf
+from tensorflow.python.ops import array_ops
+
+tf.disable_eager_execution()
+np.random.seed(0)
+w_np = np.random.normal(size=(16, 32)).astype(np.float32) * float(sys.argv[1])
+b_np = np.random.normal(size=(32,)).astype(np.float32)
+x_np = np.random.normal(size=(8, 16)).astype(np.float32)
+x = tf.placeholder(tf.float32, shape=x_np.shape)
+y = array_ops.identity(tf.nn.relu(tf.nn.bias_add(tf.matmul(x, w_np), b_np)))
+with tf.Session() as sess:
+  np.testing.assert_allclose(sess.run(y, feed_dict={x: x_np}),
+                             np.maximum(np.matmul(x_np, w_np) + b_np, 0),
+                             rtol=1e-4, atol=1e-4)
+'''
+
+_LOADED = 'Load optimized graph from'
+_CORRUPTED = 'Ignoring corrupted optimized graph cache'
+
+
+class OptimizedGraphCacheTest(test_lib.TestCase):
+
+  def _run(self, cache_dir, scale=1.0, extra_env=None):
+    env = dict(os.environ)
+    env['ITEX_OPTIMIZED_GRAPH_CACHE_DIR'] = cache_dir
+    env['ITEX_ONEDNN_GRAPH'] = '0'
+    env['TF_CPP_MIN_LOG_LEVEL'] = '0'
+    env['TF_CPP_VMODULE'] = 'xpu_optimizer=1'
+    env.update(extra_env or {})
+    result = subprocess.run(
+        [sys.executable, '-c', _CHILD, str(scale)], env=env,
+        stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+        universal_newlines=True, check=False)
+    self.assertEqual(result.returncode, 0, result.stderr)
+    return result.stderr
+
+  def _cachedGraphs(self, cache_dir):
+    return sorted(glob.glob(os.path.join(cache_dir, '*.pb')))
+
+  def testHitOnRestart(self):
+    cache_dir = tempfile.mkdtemp()
+    self.assertNotIn(_LOADED, self._run(cache_dir))
+    cached = self._cachedGraphs(cache_dir)
+    self.assertTrue(cached)
+    # The restarted process loads the stored graphs and stores nothing new.
+    self.assertIn(_LOADED, self._run(cache_dir))
+    self.assertEqual(self._cachedGraphs(cache_dir), cached)
+
+  def testInvalidatedByGraphChange(self):
+    cache_dir = tempfile.mkdtemp()
+    self._run(cache_dir)
+    cached = self._cachedGraphs(cache_dir)
+    # A different weight changes the input graph, hence the fingerprint.
+    self.assertNotIn(_LOADED, self._run(cache_dir, scale=2.0))
+    self.assertGreater(len(self._cachedGraphs(cache_dir)), len(cached))
+
+  def testInvalidatedByEnvironment(self):
+    cache_dir = tempfile.mkdtemp()
+    self._run(cache_dir)
+    cached = self._cachedGraphs(cache_dir)
+    # Any ITEX_* variable may tune the passes, so it is part of the key.
+    self.assertNotIn(_LOADED, self._run(
+        cache_dir, extra_env={'ITEX_REMAPPER': '0'}))
+    self.assertGreater(len(self._cachedGraphs(cache_dir)), len(cached))
+
+  def testCorruptedFileIgnored(self):
+    cache_dir = tempfile.mkdtemp()
+    self._run(cache_dir)
+    cached = self._cachedGraphs(cache_dir)
+    for path in cached:
+      with open(path, 'wb') as graph_file:
+        graph_file.write(b'\xff' * 7)
+    # The graphs are optimized again, which rewrites the cache files.
+    stderr = self._run(cache_dir)
+    self.assertIn(_CORRUPTED, stderr)
+    self.assertNotIn(_LOADED, stderr)
+    self.assertIn(_LOADED, self._run(cache_dir))
+
+if __name__ == '__main__':
+  test_lib.main()
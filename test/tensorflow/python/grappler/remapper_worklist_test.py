@@ -0,0 +1,145 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import os
+
+import numpy as np
+
+import tensorflow.compat.v1 as tf
+
+try:
+  from intel_extension_for_tensorflow.python.test_func import test as test_lib
+except ImportError:
+  from tensorflow.python.platform import test as test_lib
+from intel_extension_for_tensorflow.python.device import get_backend
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.framework import test_util
+from tensorflow.python.ops import array_ops
+
+
+class RemapperWorklistTest(test_lib.TestCase):
+  """Later remapper runs only revisit the nodes near the previous rewrites.
+
+  They must still find every fusion a full rescan finds
+  (`ITEX_REMAPPER_WORKLIST=0`).
+  """
+
+  def setUp(self):
+    super(RemapperWorklistTest, self).setUp()
+    if get_backend() != b'CPU':
+      self.skipTest('The graphs are built for the CPU kernels.')
+    self._worklist_env = os.environ.get('ITEX_REMAPPER_WORKLIST')
+
+  def tearDown(self):
+    if self._worklist_env is None:
+      os.environ.pop('ITEX_REMAPPER_WORKLIST', None)
+    else:
+      os.environ['ITEX_REMAPPER_WORKLIST'] = self._worklist_env
+    super(RemapperWorklistTest, self).tearDown()
+
+  def _run(self, build_graph, worklist):
+    os.environ['ITEX_REMAPPER_WORKLIST'] = '1' if worklist else '0'
+    graph = tf.Graph()
+    with graph.as_default(), tf.device('/cpu:0'):
+      outputs, feed_dict = build_graph()
+    run_options = config_pb2.RunOptions(output_partition_graphs=True)
+    metadata = config_pb2.RunMetadata()
+    with self.session(graph=graph, use_gpu=False) as sess:
+      output_vals = sess.run(outputs, options=run_options,
+                             run_metadata=metadata, feed_dict=feed_dict)
+    nodes = sorted(
+        (node.name, node.op, tuple(node.attr['fused_ops'].list.s))
+        for node in metadata.partition_graphs[0].node)
+    return output_vals, nodes
+
+  def _checkSameFusions(self, build_graph):
+    expected_vals, expected_nodes = self._run(build_graph, worklist=False)
+    output_vals, nodes = self._run(build_graph, worklist=True)
+    self.assertEqual(nodes, expected_nodes)
+    for output_val, expected_val in zip(output_vals, expected_vals):
+      self.assertAllClose(output_val, expected_val)
+    return nodes
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testFusionsFarFromRewrites(self):
+    np.random.seed(0)
+    x_np = np.random.normal(size=(2, 8, 8, 4)).astype(np.float32)
+    a_np = np.random.normal(size=(64, 32)).astype(np.float32)
+    filters = [(np.random.normal(size=(3, 3, 4, 4)).astype(np.float32),
+                np.random.normal(size=(4,)).astype(np.float32))
+               for _ in range(3)]
+
+    def build_graph():
+      x = tf.placeholder(tf.float32, shape=x_np.shape)
+      y = x
+      for w, b in filters:
+        y = tf.nn.relu(tf.nn.bias_add(
+            tf.nn.conv2d(y, w, strides=[1, 1, 1, 1], padding='SAME'), b))
+      # Binary ops, fused only by the second run, on a branch further from
+      # the convolutions rewritten by the first run than any pattern spans.
+      a = tf.placeholder(tf.float32, shape=a_np.shape)
+      z = a
+      for _ in range(12):
+        z = tf.math.tanh(z)
+      z = (z + 1.0) * 0.5 - a
+      return ([array_ops.identity(y), array_ops.identity(z)],
+              {x: x_np, a: a_np})
+
+    nodes = self._checkSameFusions(build_graph)
+    self.assertTrue(any('FusedConv2D' in op for _, op, _ in nodes))
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testLargeRegisteredPattern(self):
+    # The attention pattern of Keras stable diffusion spans more hops than any
+    # hand-written pattern, and its query is rewritten by a MatMul fusion.
+    np.random.seed(0)
+    batch, time, num_heads, head_size = 1, 64, 2, 16
+    x_np = np.random.normal(
+        size=(batch * time, num_heads * head_size)).astype(np.float32)
+    w_np = np.random.normal(
+        size=(num_heads * head_size,) * 2).astype(np.float32)
+    b_np = np.random.normal(size=(num_heads * head_size,)).astype(np.float32)
+    k_np = np.random.normal(
+        size=(batch, time, num_heads, head_size)).astype(np.float32)
+    v_np = np.random.normal(
+        size=(batch, time, num_heads, head_size)).astype(np.float32)
+
+    def td_dot(a, b):
+      aa = tf.reshape(a, (-1, a.shape[2], a.shape[3]))
+      bb = tf.reshape(b, (-1, b.shape[2], b.shape[3]))
+      cc = tf.matmul(aa, bb)
+      return tf.reshape(cc, (-1, a.shape[1], cc.shape[1], cc.shape[2]))
+
+    def build_graph():
+      x = tf.placeholder(tf.float32, shape=x_np.shape)
+      k = tf.placeholder(tf.float32, shape=k_np.shape)
+      v = tf.placeholder(tf.float32, shape=v_np.shape)
+      q = tf.nn.relu(tf.nn.bias_add(tf.matmul(x, w_np), b_np))
+      q = tf.reshape(q, (batch, time, num_heads, head_size))
+      q = tf.transpose(q, (0, 2, 1, 3))
+      score = td_dot(q, tf.transpose(k, (0, 2, 3, 1))) * head_size**-0.5
+      attn = td_dot(tf.nn.softmax(score), tf.transpose(v, (0, 2, 1, 3)))
+      out = tf.transpose(attn, (0, 2, 1, 3))
+      return [array_ops.identity(out)], {x: x_np, k: k_np, v: v_np}
+
+    nodes = self._checkSameFusions(build_graph)
+    self.assertTrue(
+        any(op == 'ScaledDotProductAttentionInference' for _, op, _ in nodes))
+
+if __name__ == "__main__":
+  test_lib.main()
@@ -0,0 +1,84 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import os
+
+import numpy as np
+
+import tensorflow.compat.v1 as tf
+
+try:
+  from intel_extension_for_tensorflow.python.test_func import test as test_lib
+except ImportError:
+  from tensorflow.python.platform import test as test_lib
+from tensorflow.python.framework import test_util
+from tensorflow.core.protobuf import config_pb2
+
+os.environ['ITEX_LAYOUT_OPT'] = '0'
+
+
+class RematerializationTest(test_lib.TestCase):
+
+  def _runWithBudget(self, fetches, feed_dict, budget_mb):
+    if budget_mb is None:
+      os.environ.pop('ITEX_REMAT_MEMORY_BUDGET_MB', None)
+    else:
+      os.environ['ITEX_REMAT_MEMORY_BUDGET_MB'] = str(budget_mb)
+    run_options = config_pb2.RunOptions(output_partition_graphs=True)
+    metadata = config_pb2.RunMetadata()
+    try:
+      with self.session(use_gpu=False) as sess:
+        sess.run(tf.global_variables_initializer())
+        output_val = sess.run(fetches, options=run_options,
+                              run_metadata=metadata, feed_dict=feed_dict)
+    finally:
+      os.environ.pop('ITEX_REMAT_MEMORY_BUDGET_MB', None)
+    return output_val, metadata.partition_graphs[0]
+
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def testRecomputeSquareInBackward(self):
+    x_np = np.random.normal(size=(512, 1024)).astype(np.float32)
+    x = tf.placeholder(tf.float32, shape=x_np.shape)
+    with tf.device('/cpu:0'):
+      w = tf.Variable(np.random.normal(size=(1024, 16)).astype(np.float32))
+      # The 2MB output of the Square is kept for the gradient of w, and its
+      # input for the gradient of x.
+      square = tf.math.square(x, name='square')
+      loss = tf.reduce_sum(tf.matmul(square, w))
+      grads = tf.gradients(loss, [w, x])
+
+    expected, graph = self._runWithBudget(grads, {x: x_np}, None)
+    self.assertNotIn('square/_remat', [node.name for node in graph.node])
+
+    output_val, graph = self._runWithBudget(grads, {x: x_np}, 1)
+    nodes = {node.name: node for node in graph.node}
+    self.assertIn('square/_remat', nodes)
+    self.assertEqual(nodes['square/_remat'].op, 'Square')
+    # The backward consumers read the copy, the forward MatMul the original.
+    remat_consumers = [
+        node.name for node in graph.node
+        if any(inp.split(':')[0] == 'square/_remat' for inp in node.input)]
+    self.assertTrue(remat_consumers)
+    for name in remat_consumers:
+      self.assertTrue(name.startswith('gradients'), name)
+    for node in graph.node:
+      if node.name.startswith('gradients'):
+        self.assertNotIn('square', [inp.split(':')[0] for inp in node.input])
+    self.assertAllClose(output_val, expected)
+
+if __name__ == "__main__":
+  test_lib.main()
@@ -0,0 +1,82 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the multi-shape oneDNN primitive cache of MatMul."""
+
+import os
+import re
+import subprocess
+import sys
+
+from intel_extension_for_tensorflow.python.test_func import test as test_lib
+
+# Runs one MatMul with a constant weight over a sequence of batch sizes and
+# checks every result. The cache statistics are logged on each miss.
+_CHILD = r'''
+import sys
+import numpy as np
+import tensorflow.compat.v1 as tf
+from tensorflow.python.ops import array_ops
+
+tf.disable_eager_execution()
+np.random.seed(0)
+w_np = np.random.normal(size=(64, 128)).astype(np.float32)
+x = tf.placeholder(tf.float32, shape=(None, 64))
+with tf.device('/cpu:0'):
+  y = array_ops.identity(tf.matmul(x, w_np))
+with tf.Session() as sess:
+  for batch in [int(b) for b in sys.argv[1:]]:
+    x_np = np.random.normal(size=(batch, 64)).astype(np.float32)
+    np.testing.assert_allclose(sess.run(y, feed_dict={x: x_np}),
+                               np.matmul(x_np, w_np), rtol=1e-4, atol=1e-4)
+'''
+
+_STATS_RE = re.compile(
+    r'oneDNN primitive cache: hits=(\d+), misses=(\d+), evictions=(\d+)')
+
+
+class MatMulPrimitiveCacheTest(test_lib.TestCase):
+
+  def _runBatches(self, batches, capacity):
+    env = dict(os.environ)
+    env['ITEX_CACHE_ONEDNN_OBJECT'] = '1'
+    env['ITEX_CACHE_ONEDNN_OBJECT_CAPACITY'] = str(capacity)
+    env['ITEX_LAYOUT_OPT'] = '0'
+    env['TF_CPP_VMODULE'] = 'onednn_primitive_cache=3'
+    result = subprocess.run(
+        [sys.executable, '-c', _CHILD] + [str(b) for b in batches],
+        env=env, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+        universal_newlines=True, check=False)
+    self.assertEqual(result.returncode, 0, result.stderr)
+    stats = _STATS_RE.findall(result.stderr)
+    self.assertTrue(stats, result.stderr)
+    # Statistics at the last miss.
+    return tuple(int(v) for v in stats[-1])
+
+  def testHitMissAndEviction(self):
+    # 1, 8 and 16 miss, 16 evicts 1, 8 hits, 1 misses again.
+    hits, misses, evictions = self._runBatches([1, 8, 16, 8, 1], capacity=2)
+    self.assertEqual(hits, 1)
+    self.assertEqual(misses, 4)
+    self.assertEqual(evictions, 1)
+
+  def testSharedWeightAcrossShapes(self):
+    # The shapes reuse the weight reordered for the first one with the same
+    # layout, every result must still be right after evictions.
+    hits, misses, _ = self._runBatches([1, 2, 4, 1, 2, 4, 8, 1], capacity=2)
+    self.assertEqual(hits, 0)
+    self.assertEqual(misses, 8)
+
+if __name__ == '__main__':
+  test_lib.main()
@@ -0,0 +1,108 @@
+# Copyright (c) 2023 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the process-wide store of reordered constant weights."""
+
+import os
+import re
+import subprocess
+import sys
+
+from intel_extension_for_tensorflow.python.device import get_backend
+from intel_extension_for_tensorflow.python.test_func import test as test_lib
+
+_SESSION_CLOSED = 'SESSION_CLOSED'
+
+# Runs two convolutions with the same constant filter in one session, closes
+# it, then runs them again in a new session. The store statistics are logged
+# whenever a weight is looked up or released.
+_CHILD = r'''
+import gc
+import sys
+import numpy as np
+import tensorflow.compat.v1 as tf
+from tensorflow.python.ops import array_ops
+
+tf.disable_eager_execution()
+np.random.seed(0)
+w_np = np.random.normal(size=(3, 3, 16, 32)).astype(np.float32)
+x_np = np.random.normal(size=(1, 8, 8, 16)).astype(np.float32)
+
+
+def run():
+  graph = tf.Graph()
+  with graph.as_default(), tf.device('/cpu:0'):
+    # Separate inputs, so the two convolutions aren't merged into one.
+    x1 = tf.placeholder(tf.float32, shape=x_np.shape)
+    x2 = tf.placeholder(tf.float32, shape=x_np.shape)
+    y1 = tf.nn.relu(tf.nn.conv2d(x1, w_np, strides=[1, 1, 1, 1],
+                                 padding='SAME'))
+    y2 = tf.nn.relu(tf.nn.conv2d(x2, w_np, strides=[1, 1, 1, 1],
+                                 padding='SAME'))
+    y1, y2 = array_ops.identity(y1), array_ops.identity(y2)
+  sess = tf.Session(graph=graph)
+  out1, out2 = sess.run([y1, y2], feed_dict={x1: x_np, x2: x_np})
+  np.testing.assert_allclose(out1, out2)
+  sess.close()
+  del sess
+  gc.collect()
+
+
+run()
+sys.stderr.write('%s\n')
+sys.stderr.flush()
+run()
+''' % _SESSION_CLOSED
+
+_STATS_RE = re.compile(r'Shared weight store: hits=(\d+), misses=(\d+), '
+                       r'bytes saved=\d+, live weights=(\d+)')
+
+
+class SharedWeightStoreTest(test_lib.TestCase):
+
+  def _runChild(self):
+    if get_backend() != b'CPU':
+      self.skipTest('The shared weight store is only used by CPU kernels.')
+    env = dict(os.environ)
+    env['ITEX_SHARE_WEIGHT_CACHE'] = '1'
+    env['TF_CPP_VMODULE'] = 'onednn_util=3'
+    result = subprocess.run(
+        [sys.executable, '-c', _CHILD], env=env, stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE, universal_newlines=True, check=False)
+    self.assertEqual(result.returncode, 0, result.stderr)
+    first, _, second = result.stderr.partition(_SESSION_CLOSED)
+    return ([tuple(int(v) for v in s) for s in _STATS_RE.findall(first)],
+            [tuple(int(v) for v in s) for s in _STATS_RE.findall(second)])
+
+  def testKernelsShareOneBuffer(self):
+    first, _ = self._runChild()
+    self.assertTrue(first)
+    # The first convolution reorders the filter, the second one reuses it,
+    # so a single buffer is ever alive.
+    hits, misses, _ = first[-1]
+    self.assertEqual((hits, misses), (1, 1))
+    self.assertEqual(max(live for _, _, live in first), 1)
+
+  def testBufferReleasedWithLastUser(self):
+    first, second = self._runChild()
+    self.assertTrue(first)
+    self.assertTrue(second)
+    # Closing the session destroyed both kernels, which freed the buffer.
+    self.assertEqual(first[-1][2], 0)
+    # The new session reorders the filter again.
+    hits, misses, _ = second[-1]
+    self.assertEqual((hits, misses), (2, 2))
+
+if __name__ == '__main__':
+  test_lib.main()